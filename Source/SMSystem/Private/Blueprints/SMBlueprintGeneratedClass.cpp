@@ -2,6 +2,13 @@
 
 #include "Blueprints/SMBlueprintGeneratedClass.h"
 #include "SMInstance.h"
+#include "SMStateMachineDefinition.h"
+
+#if WITH_EDITOR
+#include "Interfaces/ITargetPlatform.h"
+
+USMBlueprintGeneratedClass::FOnPreCookSave USMBlueprintGeneratedClass::OnPreCookSaveEvent;
+#endif
 
 USMBlueprintGeneratedClass::USMBlueprintGeneratedClass(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -32,13 +39,52 @@ void USMBlueprintGeneratedClass::PurgeClass(bool bRecompilingOnLoad)
 	Super::PurgeClass(bRecompilingOnLoad);
 
 	RootGuid.Invalidate();
+	StateMachineDefinition.Reset();
+	bStateMachineDefinitionBuilt = false;
+}
+
+#if WITH_EDITOR
+void USMBlueprintGeneratedClass::PreSave(const ITargetPlatform* TargetPlatform)
+{
+	Super::PreSave(TargetPlatform);
+
+	if (TargetPlatform && !TargetPlatform->HasEditorOnlyData())
+	{
+		OnPreCookSaveEvent.Broadcast(this, TargetPlatform);
+	}
 }
+#endif
 
 void USMBlueprintGeneratedClass::SetRootGuid(const FGuid& Guid)
 {
 	RootGuid = Guid;
 }
 
+TSharedPtr<const FSMStateMachineDefinition> USMBlueprintGeneratedClass::GetStateMachineDefinition()
+{
+	check(IsInGameThread());
+
+#if WITH_EDITORONLY_DATA
+	if (bStateMachineDefinitionBuilt && StateMachineDefinitionDefaults.Get() != GetDefaultObject(false))
+	{
+		StateMachineDefinition.Reset();
+		bStateMachineDefinitionBuilt = false;
+	}
+#endif
+	
+	if (!bStateMachineDefinitionBuilt)
+	{
+		// A failed build is kept as well so it isn't retried and reported on every initialize.
+		StateMachineDefinition = FSMStateMachineDefinition::Build(this);
+		bStateMachineDefinitionBuilt = true;
+#if WITH_EDITORONLY_DATA
+		StateMachineDefinitionDefaults = GetDefaultObject(false);
+#endif
+	}
+
+	return StateMachineDefinition;
+}
+
 
 USMNodeBlueprintGeneratedClass::USMNodeBlueprintGeneratedClass(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -6,6 +6,17 @@
 #include "SMStateMachineInstance.h"
 #include "SMTransitionInstance.h"
 
+FSMNodeClassPathHierarchy FSMNodeClassPathHierarchy::FromClass(const UClass* Class)
+{
+	FSMNodeClassPathHierarchy Hierarchy;
+	for (const UClass* SuperClass = Class; SuperClass; SuperClass = SuperClass->GetSuperClass())
+	{
+		Hierarchy.ClassPaths.Add(FSoftObjectPath(SuperClass));
+	}
+
+	return Hierarchy;
+}
+
 FSMNodeClassRule::FSMNodeClassRule(): bIncludeChildren(true), bNOT(false)
 {
 }
@@ -18,6 +29,14 @@ bool FSMNodeClassRule::IsBaseClass(UClass* Class)
 		Class == USMTransitionInstance::StaticClass() || Class == USMConduitInstance::StaticClass();
 }
 
+bool FSMNodeClassRule::IsBaseClass(const FSoftObjectPath& ClassPath)
+{
+	return ClassPath.IsNull() ||
+		ClassPath == FSoftObjectPath(USMNodeInstance::StaticClass()) || ClassPath == FSoftObjectPath(USMStateInstance_Base::StaticClass()) ||
+		ClassPath == FSoftObjectPath(USMStateInstance::StaticClass()) || ClassPath == FSoftObjectPath(USMStateMachineInstance::StaticClass()) ||
+		ClassPath == FSoftObjectPath(USMTransitionInstance::StaticClass()) || ClassPath == FSoftObjectPath(USMConduitInstance::StaticClass());
+}
+
 UClass* FSMStateClassRule::GetClass() const
 {
 	return StateClass.Get();
@@ -50,6 +69,25 @@ bool FSMNodeConnectionRule::DoesClassMatch(UClass* ExpectedClass, UClass* Actual
 	return Rule.bNOT ? !bResult : bResult;
 }
 
+bool FSMNodeConnectionRule::DoesClassMatch(const FSoftObjectPath& ExpectedClass, const FSMNodeClassPathHierarchy& ActualClass,
+	const FSMNodeClassRule& Rule)
+{
+	if (ExpectedClass.IsNull())
+	{
+		// None implies all.
+		return true;
+	}
+
+	if (!ActualClass.IsSet())
+	{
+		// Check if we're expecting a base class which means no class may be set.
+		return FSMNodeClassRule::IsBaseClass(ExpectedClass) ? !Rule.bNOT : Rule.bNOT;
+	}
+
+	const bool bResult = Rule.bIncludeChildren ? ActualClass.IsChildOf(ExpectedClass) : ActualClass.GetClassPath() == ExpectedClass;
+	return Rule.bNOT ? !bResult : bResult;
+}
+
 bool FSMTransitionConnectionValidator::IsConnectionValid(UClass* FromClass, UClass* ToClass, UClass* StateMachineClass, bool bPassOnNoRules) const
 {
 	// No rules makes this action always valid.
@@ -73,6 +111,30 @@ bool FSMTransitionConnectionValidator::IsConnectionValid(UClass* FromClass, UCla
 	return false;
 }
 
+bool FSMTransitionConnectionValidator::IsConnectionValid(const FSMNodeClassPathHierarchy& FromClass, const FSMNodeClassPathHierarchy& ToClass,
+	const FSMNodeClassPathHierarchy& StateMachineClass, bool bPassOnNoRules) const
+{
+	// No rules makes this action always valid.
+	if ((AllowedConnections.Num() == 0 || (!FromClass.IsSet() && !ToClass.IsSet())) && bPassOnNoRules)
+	{
+		return true;
+	}
+
+	for (const FSMNodeConnectionRule& Rule : AllowedConnections)
+	{
+		if (!FSMNodeConnectionRule::DoesRuleMatch(Rule.InStateMachine, StateMachineClass) ||
+			!FSMNodeConnectionRule::DoesRuleMatch(Rule.FromState, FromClass) ||
+			!FSMNodeConnectionRule::DoesRuleMatch(Rule.ToState, ToClass))
+		{
+			continue;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
 bool FSMStateConnectionValidator::IsInboundConnectionValid(UClass* FromClass,
 	UClass* StateMachineClass) const
 {
@@ -89,6 +151,13 @@ bool FSMStateConnectionValidator::IsInboundConnectionValid(UClass* FromClass,
 	return true;
 }
 
+bool FSMStateConnectionValidator::IsInboundConnectionValid(const FSMNodeClassPathHierarchy& FromClass,
+	const FSMNodeClassPathHierarchy& StateMachineClass) const
+{
+	return FSMNodeConnectionRule::DoRulesPass<FSMStateMachineClassRule>(StateMachineClass, AllowedInStateMachines) &&
+		FSMNodeConnectionRule::DoRulesPass<FSMStateClassRule>(FromClass, AllowedInboundStates);
+}
+
 bool FSMStateConnectionValidator::IsOutboundConnectionValid(UClass* ToClass,
 	UClass* StateMachineClass) const
 {
@@ -115,3 +184,8 @@ bool FSMStateMachineNodePlacementValidator::IsStateAllowed(UClass* StateClass) c
 {
 	return FSMNodeConnectionRule::DoRulesPass<FSMStateClassRule>(StateClass, AllowedStates);
 }
+
+bool FSMStateMachineNodePlacementValidator::IsStateAllowed(const FSMNodeClassPathHierarchy& StateClass) const
+{
+	return FSMNodeConnectionRule::DoRulesPass<FSMStateClassRule>(StateClass, AllowedStates);
+}
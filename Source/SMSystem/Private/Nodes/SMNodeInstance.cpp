@@ -13,7 +13,7 @@
 
 DEFINE_STAT(STAT_NodeInstances);
 
-USMNodeInstance::USMNodeInstance() : Super(), bAutoEvalExposedProperties(true), bResetVariablesOnInitialize(false), OwningNode(nullptr), bIsInitialized(false)
+USMNodeInstance::USMNodeInstance() : Super(), bAutoEvalExposedProperties(true), bResetVariablesOnInitialize(false), OwningNode(nullptr), bIsInitialized(false), bHasSearchedResetArchetype(false)
 {
 	INC_DWORD_STAT(STAT_NodeInstances)
 	
@@ -243,7 +243,8 @@ void USMNodeInstance::DisableInput()
 		return;
 	}
 	
-	USMUtils::DisableInput(World, InputComponent);
+	// Nodes are frequently re-entered so keep the bound component for the next EnableInput.
+	USMUtils::DisableInput(World, InputComponent, false);
 
 	if (UGameInstance* GameInstance = World->GetGameInstance())
 	{
@@ -351,34 +352,161 @@ void USMNodeInstance::WithExecutionEnvironment(ESMExecutionEnvironment& Executio
 	ExecutionEnvironment = IsEditorExecution() ? ESMExecutionEnvironment::EditorExecution : ESMExecutionEnvironment::GameExecution;
 }
 
+/** The properties of a node class ResetVariables restores from the archetype. */
+struct FSMNodeResetPlan
+{
+	/** A run of contiguous plain old data copied at once. */
+	struct FBlock
+	{
+		int32 Offset;
+		int32 Size;
+	};
+
+	TArray<FBlock> Blocks;
+
+	/** Properties which can't be copied as raw memory. */
+	TArray<FProperty*> Properties;
+
+#if WITH_EDITOR
+	/** Recompiling replaces the CDO and may change the class layout. */
+	TWeakObjectPtr<UObject> ClassDefaults;
+#endif
+};
+
+static bool ShouldResetProperty(const FProperty* Property)
+{
+	if (Property->ContainsInstancedObjectProperty() || Property->IsA<FDelegateProperty>() || Property->IsA<FMulticastDelegateProperty>())
+	{
+		return false;
+	}
+
+	if (const FStructProperty* StructProperty = CastField<FStructProperty>(Property))
+	{
+		if (StructProperty->Struct->IsChildOf(FSMGraphProperty_Base::StaticStruct())
+			|| StructProperty->GetFName() == TEXT("TemplateGuid"))
+		{
+			// Graph properties don't need to be reset.
+			return false;
+		}
+	}
+
+	// The input component is created by EnableInput and would be lost.
+	if (Property->GetFName() == TEXT("InputComponent") && Property->GetOwnerClass() == USMNodeInstance::StaticClass())
+	{
+		return false;
+	}
+
+	return true;
+}
+
+static const FSMNodeResetPlan& GetResetPlan(UClass* Class)
+{
+	check(IsInGameThread());
+
+	static TMap<TWeakObjectPtr<UClass>, TSharedRef<FSMNodeResetPlan>> CachedPlans;
+
+	if (const TSharedRef<FSMNodeResetPlan>* ExistingPlan = CachedPlans.Find(Class))
+	{
+#if WITH_EDITOR
+		if ((*ExistingPlan)->ClassDefaults.Get() == Class->GetDefaultObject(false))
+#endif
+		{
+			return ExistingPlan->Get();
+		}
+	}
+
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMNodeInstance::BuildResetPlan"), STAT_SMNodeInstance_BuildResetPlan, STATGROUP_LogicDriver);
+
+	// Drop plans of unloaded classes.
+	for (auto It = CachedPlans.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+	
+	TSharedRef<FSMNodeResetPlan> Plan = MakeShared<FSMNodeResetPlan>();
+#if WITH_EDITOR
+	Plan->ClassDefaults = Class->GetDefaultObject(false);
+#endif
+
+	TArray<FProperty*> PlainProperties;
+	for (TFieldIterator<FProperty> Prop(Class); Prop; ++Prop)
+	{
+		if (!ShouldResetProperty(*Prop))
+		{
+			continue;
+		}
+
+		// Bitfields share bytes with other members and need masking.
+		const FBoolProperty* BoolProperty = CastField<FBoolProperty>(*Prop);
+		if (Prop->HasAnyPropertyFlags(CPF_IsPlainOldData) && (!BoolProperty || BoolProperty->IsNativeBool()))
+		{
+			PlainProperties.Add(*Prop);
+		}
+		else
+		{
+			Plan->Properties.Add(*Prop);
+		}
+	}
+
+	PlainProperties.Sort([](const FProperty& A, const FProperty& B)
+	{
+		return A.GetOffset_ForInternal() < B.GetOffset_ForInternal();
+	});
+
+	for (const FProperty* Property : PlainProperties)
+	{
+		const int32 Offset = Property->GetOffset_ForInternal();
+		const int32 Size = Property->GetSize();
+		if (Plan->Blocks.Num() > 0 && Plan->Blocks.Last().Offset + Plan->Blocks.Last().Size == Offset)
+		{
+			Plan->Blocks.Last().Size += Size;
+		}
+		else
+		{
+			Plan->Blocks.Add({ Offset, Size });
+		}
+	}
+
+	return CachedPlans.Add(Class, Plan).Get();
+}
+
 void USMNodeInstance::ResetVariables()
 {
 	check(OwningNode);
 
-	if (USMInstance* SMInstance = GetStateMachineInstance())
+	if (!bHasSearchedResetArchetype)
 	{
-		if (UObject* Archetype = USMUtils::FindTemplateFromInstance(SMInstance, OwningNode->GetTemplateName()))
+		if (USMInstance* SMInstance = GetStateMachineInstance())
 		{
-			for (TFieldIterator<FProperty> Prop(GetClass()); Prop; ++Prop)
-			{
-				if (!Prop->ContainsInstancedObjectProperty() && !Prop->IsA<FDelegateProperty>()
-					&& !Prop->IsA<FMulticastDelegateProperty>())
-				{
-					if (FStructProperty* StructProperty = CastField<FStructProperty>(*Prop))
-					{
-						if (StructProperty->Struct->IsChildOf(FSMGraphProperty_Base::StaticStruct())
-							|| StructProperty->GetFName() == TEXT("TemplateGuid"))
-						{
-							// Graph properties don't need to be reset.
-							continue;
-						}
-					}
-
-					Prop->CopyCompleteValue_InContainer(this, Archetype);
-				}
-			}
+			ResetArchetype = USMUtils::FindTemplateFromInstance(SMInstance, OwningNode->GetTemplateName());
+			bHasSearchedResetArchetype = true;
 		}
 	}
+
+	UObject* Archetype = ResetArchetype.Get();
+	if (Archetype == nullptr || !ensure(Archetype->IsA(GetClass())))
+	{
+		return;
+	}
+
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMNodeInstance::ResetVariables"), STAT_SMNodeInstance_ResetVariables, STATGROUP_LogicDriver);
+	
+	const FSMNodeResetPlan& Plan = GetResetPlan(GetClass());
+
+	uint8* Destination = reinterpret_cast<uint8*>(this);
+	const uint8* Source = reinterpret_cast<const uint8*>(Archetype);
+	for (const FSMNodeResetPlan::FBlock& Block : Plan.Blocks)
+	{
+		FMemory::Memcpy(Destination + Block.Offset, Source + Block.Offset, Block.Size);
+	}
+
+	for (const FProperty* Property : Plan.Properties)
+	{
+		Property->CopyCompleteValue_InContainer(this, Archetype);
+	}
 }
 
 #if WITH_EDITORONLY_DATA
@@ -4,12 +4,14 @@
 #include "SMUtils.h"
 #include "SMLogging.h"
 #include "SMNodeInstance.h"
+#include "SMInstanceSnapshot.h"
 
 
 FSMNode_Base::FSMNode_Base() : TimeInState(0), bIsInEndState(false), bHasUpdated(false), DuplicateId(0),
                                NodePosition(ForceInitToZero), OwnerNode(nullptr),
                                OwningInstance(nullptr), NodeInstance(nullptr), NodeInstanceClass(nullptr),
-                               ServerTimeInState(SM_ACTIVE_TIME_NOT_SET), bInitialized(false), bIsActive(false)
+                               ServerTimeInState(SM_ACTIVE_TIME_NOT_SET), bInitialized(false), bIsActive(false),
+                               bCreateNodeInstanceOnDemand(false), bInitializeNodeInstanceOnDemand(false)
 {
 	/*
 	 * Originally the Guid was initialized here. This caused warnings to show up during packaging because
@@ -33,8 +35,19 @@ void FSMNode_Base::Initialize(UObject* Instance)
 	{
 		FunctionHandler.Initialize(Instance);
 	}
-	
-	CreateNodeInstance();
+
+	bCreateNodeInstanceOnDemand = CanCreateNodeInstanceOnDemand();
+	bInitializeNodeInstanceOnDemand = false;
+	if (bCreateNodeInstanceOnDemand)
+	{
+		// Any instance from a previous initialization is discarded the same as if it were recreated.
+		NodeInstance = nullptr;
+		GraphProperties.Reset();
+	}
+	else
+	{
+		CreateNodeInstance();
+	}
 }
 
 void FSMNode_Base::Reset()
@@ -117,7 +130,13 @@ void FSMNode_Base::CreateNodeInstance()
 	}
 
 	UObject* TemplateInstance = nullptr;
-	if (TemplateName != NAME_None && OwningInstance)
+	const FSMNode_Base* PrototypeNode = OwningInstance ? OwningInstance->FindPrototypeNode(*this) : nullptr;
+	if (PrototypeNode && PrototypeNode->NodeInstance && PrototypeNode->NodeInstance->GetClass() == NodeInstanceClass)
+	{
+		// Copy the prototype's node instance which already has its template values and construction script results.
+		TemplateInstance = PrototypeNode->NodeInstance;
+	}
+	else if (TemplateName != NAME_None && OwningInstance)
 	{
 		TemplateInstance = USMUtils::FindTemplateFromInstance(OwningInstance, TemplateName);
 		if (TemplateInstance == nullptr)
@@ -140,11 +159,104 @@ void FSMNode_Base::CreateNodeInstance()
 	CreateGraphProperties();
 }
 
+bool FSMNode_Base::CanCreateNodeInstanceOnDemand() const
+{
+	if (OwningInstance == nullptr || !OwningInstance->ShouldCreateNodeInstancesOnDemand())
+	{
+		return false;
+	}
+
+	if (TemplateName != NAME_None || StackTemplateNames.Num() > 0 || TemplateVariableGraphProperties.Num() > 0)
+	{
+		return false;
+	}
+
+	return NodeInstanceClass == nullptr || NodeInstanceClass == GetDefaultNodeInstanceClass();
+}
+
+#if WITH_EDITOR
+/** While set nodes add themselves when their node instance is accessed. */
+static TSet<const FSMNode_Base*>* NodeInstanceReadTracker = nullptr;
+
+void FSMNode_Base::RecordNodeInstanceRead() const
+{
+	if (NodeInstanceReadTracker)
+	{
+		NodeInstanceReadTracker->Add(this);
+	}
+}
+
+TSet<const FSMNode_Base*>* FSMNode_Base::SetNodeInstanceReadTracker(TSet<const FSMNode_Base*>* NewTracker)
+{
+	check(IsInGameThread());
+	
+	TSet<const FSMNode_Base*>* PreviousTracker = NodeInstanceReadTracker;
+	NodeInstanceReadTracker = NewTracker;
+	return PreviousTracker;
+}
+#endif
+
+USMNodeInstance* FSMNode_Base::GetNodeInstance() const
+{
+#if WITH_EDITOR
+	RecordNodeInstanceRead();
+#endif
+	
+	if (bCreateNodeInstanceOnDemand && NodeInstance == nullptr && bInitialized)
+	{
+		DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMNode_Base::CreateNodeInstanceOnDemand"), STAT_SMNode_Base_CreateNodeInstanceOnDemand, STATGROUP_LogicDriver);
+		check(IsInGameThread());
+
+		FSMNode_Base* MutableThis = const_cast<FSMNode_Base*>(this);
+		MutableThis->CreateNodeInstance();
+
+		// The owning instance may have formed a cluster since initializing.
+		USMUtils::AddToOwnerGCCluster(NodeInstance, OwningInstance);
+
+		if (bInitializeNodeInstanceOnDemand && NodeInstance)
+		{
+			NodeInstance->NativeInitialize();
+		}
+	}
+
+	return NodeInstance;
+}
+
+void FSMNode_Base::InitializeNodeInstance()
+{
+	if (NodeInstance)
+	{
+		NodeInstance->NativeInitialize();
+	}
+	else
+	{
+		// Default instances have no logic to run, so only create one if something asks for it.
+		bInitializeNodeInstanceOnDemand = bCreateNodeInstanceOnDemand;
+	}
+}
+
+void FSMNode_Base::ShutdownNodeInstance()
+{
+	bInitializeNodeInstanceOnDemand = false;
+	if (NodeInstance)
+	{
+		NodeInstance->NativeShutdown();
+	}
+}
+
 void FSMNode_Base::CreateStackInstances()
 {
-	for (const FName& StackTemplateName : StackTemplateNames)
+	const FSMNode_Base* PrototypeNode = OwningInstance ? OwningInstance->FindPrototypeNode(*this) : nullptr;
+	if (PrototypeNode && PrototypeNode->StackNodeInstances.Num() != StackTemplateNames.Num())
+	{
+		PrototypeNode = nullptr;
+	}
+	
+	for (int32 StackIndex = 0; StackIndex < StackTemplateNames.Num(); ++StackIndex)
 	{
-		UObject* TemplateInstance = USMUtils::FindTemplateFromInstance(OwningInstance, StackTemplateName);
+		const FName& StackTemplateName = StackTemplateNames[StackIndex];
+		UObject* TemplateInstance = PrototypeNode && PrototypeNode->StackNodeInstances[StackIndex] ? PrototypeNode->StackNodeInstances[StackIndex] :
+			USMUtils::FindTemplateFromInstance(OwningInstance, StackTemplateName);
 		if (TemplateInstance == nullptr)
 		{
 			LD_LOG_ERROR(TEXT("Could not find node stack template %s for use on node %s from package %s."), *StackTemplateName.ToString(), *GetNodeName(), *OwningInstance->GetName());
@@ -257,6 +369,50 @@ void FSMNode_Base::EditorShutdown()
 
 #endif
 
+#if WITH_EDITORONLY_DATA
+
+void FSMNode_Base::PublishDebugState()
+{
+	if (OwningInstance == nullptr || DebugNodeIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	FSMDebugStateMachine& DebugStateMachine = OwningInstance->GetDebugStateMachine();
+	if (DebugStateMachine.IsBeingWatched() && DebugStateMachine.GetIndexedNode(DebugNodeIndex) == this)
+	{
+		if (FSMDebugNodeState* DebugState = DebugStateMachine.GetLiveNodeState(DebugNodeIndex))
+		{
+			UpdateDebugNodeState(*DebugState);
+		}
+	}
+}
+
+void FSMNode_Base::RecordDebugEvent(ESMDebugEventType Type, bool bResult)
+{
+	if (OwningInstance == nullptr || DebugNodeIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	FSMDebugStateMachine& DebugStateMachine = OwningInstance->GetDebugStateMachine();
+	if (FSMDebugRecorder* Recorder = DebugStateMachine.GetRecorder())
+	{
+		if (DebugStateMachine.GetIndexedNode(DebugNodeIndex) == this)
+		{
+			Recorder->Record(DebugNodeIndex, Type, bResult);
+		}
+	}
+}
+
+void FSMNode_Base::UpdateDebugNodeState(FSMDebugNodeState& InOutState) const
+{
+	InOutState.bIsActive = bIsActive;
+	InOutState.bWasActive |= bWasActive;
+}
+
+#endif
+
 void FSMNode_Base::Execute()
 {
 	if (!bInitialized)
@@ -266,20 +422,96 @@ void FSMNode_Base::Execute()
 
 	UpdateReadStates();
 
+	SM_PROFILE_NODE_SCOPE(*this, ESMProfileCategory::GraphFunction);
 	USMUtils::ExecuteGraphFunctions(GraphEvaluator);
 }
 
+bool FSMNode_Base::CaptureSnapshot(FSMNodeSnapshot& OutSnapshot) const
+{
+	OutSnapshot.Guid = GetGuid();
+	OutSnapshot.TimeInState = TimeInState;
+	OutSnapshot.ServerTimeInState = ServerTimeInState;
+	OutSnapshot.SetFlag(FSMNodeSnapshot::Active, bIsActive);
+	OutSnapshot.SetFlag(FSMNodeSnapshot::HasUpdated, bHasUpdated);
+	OutSnapshot.SetFlag(FSMNodeSnapshot::InEndState, bIsInEndState);
+
+	if (NodeInstance && FSMInstanceSnapshot::HasSaveGameProperties(NodeInstance->GetClass()))
+	{
+		FSMInstanceSnapshot::SaveSaveGameProperties(NodeInstance, OutSnapshot.NodeInstanceData);
+	}
+
+	return OutSnapshot.Flags != 0 || TimeInState != 0.f || ServerTimeInState != SM_ACTIVE_TIME_NOT_SET ||
+		OutSnapshot.NodeInstanceData.Num() > 0;
+}
+
+void FSMNode_Base::RestoreSnapshot(const FSMNodeSnapshot& InSnapshot)
+{
+	TimeInState = InSnapshot.TimeInState;
+	ServerTimeInState = InSnapshot.ServerTimeInState;
+	bHasUpdated = InSnapshot.HasFlag(FSMNodeSnapshot::HasUpdated);
+	bIsInEndState = InSnapshot.HasFlag(FSMNodeSnapshot::InEndState);
+	SetActive(InSnapshot.HasFlag(FSMNodeSnapshot::Active));
+
+	if (InSnapshot.NodeInstanceData.Num() > 0)
+	{
+		if (USMNodeInstance* Instance = GetNodeInstance())
+		{
+			FSMInstanceSnapshot::LoadSaveGameProperties(Instance, InSnapshot.NodeInstanceData);
+		}
+	}
+}
+
+SIZE_T FSMNode_Base::GetAllocatedSize() const
+{
+	return GraphEvaluator.GetAllocatedSize() + TransitionInitializedGraphEvaluators.GetAllocatedSize() +
+		TransitionShutdownGraphEvaluators.GetAllocatedSize() + NodeName.GetAllocatedSize() + StackTemplateNames.GetAllocatedSize() +
+		StackNodeInstances.GetAllocatedSize() + GraphProperties.GetAllocatedSize();
+}
+
+SIZE_T FSMNode_Base::GetGraphPropertiesAllocatedSize() const
+{
+	SIZE_T Size = 0;
+	for (const FSMGraphProperty_Base_Runtime* GraphProperty : GraphProperties)
+	{
+		if (GraphProperty)
+		{
+			Size += sizeof(FSMGraphProperty_Base_Runtime) + GraphProperty->GraphEvaluator.GetAllocatedSize();
+		}
+	}
+
+	Size += TemplateVariableGraphProperties.GetAllocatedSize();
+	for (const TPair<FGuid, FSMGraphPropertyTemplateOwner>& KeyVal : TemplateVariableGraphProperties)
+	{
+		Size += KeyVal.Value.VariableGraphProperties.GetAllocatedSize();
+		for (const FSMGraphProperty_Base_Runtime& GraphProperty : KeyVal.Value.VariableGraphProperties)
+		{
+			Size += GraphProperty.GraphEvaluator.GetAllocatedSize();
+		}
+	}
+
+	return Size;
+}
+
 void FSMNode_Base::SetActive(bool bValue)
 {
 #if WITH_EDITORONLY_DATA
 	bWasActive = bIsActive;
+	if (bIsActive != bValue)
+	{
+		RecordDebugEvent(bValue ? ESMDebugEventType::Activated : ESMDebugEventType::Deactivated);
+	}
 #endif
 	bIsActive = bValue;
+	
+#if WITH_EDITORONLY_DATA
+	PublishDebugState();
+#endif
 }
 
 bool FSMNode_Base::TryExecuteGraphProperties(uint32 OnEvent)
 {
-	if (USMStateInstance_Base* StateInstance = Cast<USMStateInstance_Base>(GetNodeInstance()))
+	// On demand instances never have graph properties.
+	if (USMStateInstance_Base* StateInstance = Cast<USMStateInstance_Base>(NodeInstance))
 	{
 		if (CanExecuteGraphProperties(OnEvent, StateInstance))
 		{
@@ -294,6 +526,7 @@ bool FSMNode_Base::TryExecuteGraphProperties(uint32 OnEvent)
 void FSMNode_Base::ExecuteGraphProperties(const FGuid* ForTemplateGuid)
 {
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMNode_Base::ExecuteGraphProperties"), STAT_SMNode_Base_ExecuteGraphProperties, STATGROUP_LogicDriver);
+	SM_PROFILE_NODE_SCOPE(*this, ESMProfileCategory::GraphProperties);
 
 	auto EvaluateProperties = [](FSMGraphPropertyTemplateOwner* TemplateOwner)
 	{
@@ -25,10 +25,10 @@ void FSMConduit::ExecuteInitializeNodes()
 {
 	TryExecuteGraphProperties(GRAPH_PROPERTY_EVAL_CONDUIT_INIT);
 
-	if (NodeInstance && bEvalWithTransitions)
+	if (bEvalWithTransitions)
 	{
 		// NativeInitialize is called OnStateBegin when not configured as a transition.
-		NodeInstance->NativeInitialize();
+		InitializeNodeInstance();
 	}
 	
 	Super::ExecuteInitializeNodes();
@@ -36,10 +36,10 @@ void FSMConduit::ExecuteInitializeNodes()
 
 void FSMConduit::ExecuteShutdownNodes()
 {
-	if (NodeInstance && bEvalWithTransitions)
+	if (bEvalWithTransitions)
 	{
 		// NativeShutdown is called OnStateEnd when not configured as a transition.
-		NodeInstance->NativeShutdown();
+		ShutdownNodeInstance();
 	}
 
 	Super::ExecuteShutdownNodes();
@@ -77,13 +77,18 @@ UClass* FSMConduit::GetDefaultNodeInstanceClass() const
 	return USMConduitInstance::StaticClass();
 }
 
+SIZE_T FSMConduit::GetAllocatedSize() const
+{
+	return Super::GetAllocatedSize() + ConduitEnteredGraphEvaluator.GetAllocatedSize();
+}
+
 bool FSMConduit::StartState()
 {
 	const bool bResult = Super::StartState();
 
 	USMUtils::ExecuteGraphFunctions(ConduitEnteredGraphEvaluator);
 	
-	if(USMConduitInstance* ConduitInstance = Cast<USMConduitInstance>(GetNodeInstance()))
+	if(USMConduitInstance* ConduitInstance = Cast<USMConduitInstance>(NodeInstance))
 	{
 		ConduitInstance->OnStateBegin();
 	}
@@ -95,7 +100,7 @@ bool FSMConduit::UpdateState(float DeltaSeconds)
 {
 	const bool bResult = Super::UpdateState(DeltaSeconds);
 
-	if (USMConduitInstance* ConduitInstance = Cast<USMConduitInstance>(GetNodeInstance()))
+	if (USMConduitInstance* ConduitInstance = Cast<USMConduitInstance>(NodeInstance))
 	{
 		ConduitInstance->OnStateUpdate(DeltaSeconds);
 	}
@@ -107,7 +112,7 @@ bool FSMConduit::EndState(float DeltaSeconds, const FSMTransition* TransitionToT
 {
 	const bool bResult = Super::EndState(DeltaSeconds, TransitionToTake);
 
-	if (USMConduitInstance* ConduitInstance = Cast<USMConduitInstance>(GetNodeInstance()))
+	if (USMConduitInstance* ConduitInstance = Cast<USMConduitInstance>(NodeInstance))
 	{
 		ConduitInstance->OnStateEnd();
 	}
@@ -115,6 +120,15 @@ bool FSMConduit::EndState(float DeltaSeconds, const FSMTransition* TransitionToT
 	return bResult;
 }
 
+#if WITH_EDITORONLY_DATA
+void FSMConduit::UpdateDebugNodeState(FSMDebugNodeState& InOutState) const
+{
+	Super::UpdateDebugNodeState(InOutState);
+	InOutState.bIsEvaluating = bIsEvaluating;
+	InOutState.bWasEvaluating |= bWasEvaluating;
+}
+#endif
+
 bool FSMConduit::GetValidTransition(TArray<TArray<FSMTransition*>>& Transitions)
 {
 	if (bCheckedForTransitions || !bCanEvaluate)
@@ -124,7 +138,7 @@ bool FSMConduit::GetValidTransition(TArray<TArray<FSMTransition*>>& Transitions)
 
 	bIsEvaluating = true;
 #if WITH_EDITORONLY_DATA
-	bWasEvaluating = true; // Will be set to false from the editor.
+	bWasEvaluating = true;
 #endif
 	
 	// First check that the conduit passes.
@@ -132,6 +146,10 @@ bool FSMConduit::GetValidTransition(TArray<TArray<FSMTransition*>>& Transitions)
 	Execute();
 
 	bIsEvaluating = false;
+#if WITH_EDITORONLY_DATA
+	PublishDebugState();
+	RecordDebugEvent(ESMDebugEventType::Evaluated, bCanEnterTransition);
+#endif
 	
 	if(!bCanEnterTransition)
 	{
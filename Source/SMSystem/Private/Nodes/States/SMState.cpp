@@ -5,6 +5,8 @@
 #include "SMStateInstance.h"
 #include "SMUtils.h"
 #include "SMLogging.h"
+#include "SMInstanceSnapshot.h"
+#include "SMTrace.h"
 
 void FSMState_Base::UpdateReadStates()
 {
@@ -63,6 +65,47 @@ void FSMState_Base::ExecuteInitializeNodes()
 	Super::ExecuteInitializeNodes();
 }
 
+SIZE_T FSMState_Base::GetAllocatedSize() const
+{
+	return Super::GetAllocatedSize() +
+		OnRootStateMachineStartedGraphEvaluator.GetAllocatedSize() + OnRootStateMachineStoppedGraphEvaluator.GetAllocatedSize() +
+		IncomingTransitions.GetAllocatedSize() + OutgoingTransitions.GetAllocatedSize();
+}
+
+bool FSMState_Base::CaptureSnapshot(FSMNodeSnapshot& OutSnapshot) const
+{
+	OutSnapshot.StartTime = StartTime;
+	return Super::CaptureSnapshot(OutSnapshot) || StartTime.GetTicks() != 0;
+}
+
+void FSMState_Base::RestoreSnapshot(const FSMNodeSnapshot& InSnapshot)
+{
+	StartTime = InSnapshot.StartTime;
+
+	const bool bWasActive = IsActive();
+	const bool bRestoreActive = InSnapshot.HasFlag(FSMNodeSnapshot::Active);
+
+	if (bWasActive && !bRestoreActive)
+	{
+		// The state stops without running end logic, but what was initialized when it started still needs shutting down.
+		ShutdownTransitions();
+		ShutdownNodeInstance();
+	}
+	else if (!bWasActive && bRestoreActive)
+	{
+		// Initialize before restoring so reset variables don't override saved values.
+		InitializeNodeInstance();
+	}
+
+	Super::RestoreSnapshot(InSnapshot);
+
+	if (!bWasActive && bRestoreActive)
+	{
+		// Transitions need to be ready for evaluation, but the state has already begun so no begin logic runs.
+		InitializeTransitions();
+	}
+}
+
 void FSMState_Base::GetAllTransitionChains(TArray<FSMTransition*>& OutTransitions) const
 {
 	for (FSMTransition* Transition : OutgoingTransitions)
@@ -81,6 +124,7 @@ bool FSMState_Base::StartState()
 	}
 
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMState_Base::StartState"), STAT_SMState_Start, STATGROUP_LogicDriver);
+	SM_TRACE_NODE_SCOPE(*this, ESMTraceNodeScope::StateStart);
 	
 	SetStartTime(FDateTime::UtcNow());
 
@@ -90,10 +134,7 @@ bool FSMState_Base::StartState()
 	StartCycle = FPlatformTime::Cycles64();
 #endif
 
-	if (NodeInstance)
-	{
-		NodeInstance->NativeInitialize();
-	}
+	InitializeNodeInstance();
 	
 	TryExecuteGraphProperties(GRAPH_PROPERTY_EVAL_ON_START);
 
@@ -117,6 +158,8 @@ bool FSMState_Base::UpdateState(float DeltaSeconds)
 	}
 
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMState_Base::UpdateState"), STAT_SMState_Update, STATGROUP_LogicDriver);
+	SM_TRACE_NODE_SCOPE(*this, ESMTraceNodeScope::StateUpdate);
+	SM_PROFILE_NODE_SCOPE(*this, ESMProfileCategory::StateUpdate);
 
 	TimeInState += DeltaSeconds;
 	UpdateReadStates();
@@ -139,6 +182,7 @@ bool FSMState_Base::EndState(float DeltaSeconds, const FSMTransition* Transition
 	}
 
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMState_Base::EndState"), STAT_SMState_End, STATGROUP_LogicDriver);
+	SM_TRACE_NODE_SCOPE(*this, ESMTraceNodeScope::StateEnd);
 
 	SetTransitionToTake(TransitionToTake);
 
@@ -164,10 +208,7 @@ bool FSMState_Base::EndState(float DeltaSeconds, const FSMTransition* Transition
 	SetActive(false);
 	ShutdownTransitions();
 
-	if (NodeInstance)
-	{
-		NodeInstance->NativeShutdown();
-	}
+	ShutdownNodeInstance();
 	
 	return true;
 }
@@ -424,6 +465,12 @@ void FSMState::ExecuteShutdownNodes()
 	}
 }
 
+SIZE_T FSMState::GetAllocatedSize() const
+{
+	return Super::GetAllocatedSize() +
+		UpdateStateGraphEvaluator.GetAllocatedSize() + EndStateGraphEvaluator.GetAllocatedSize();
+}
+
 bool FSMState::StartState()
 {
 	if(!Super::StartState())
@@ -5,6 +5,8 @@
 #include "SMLogging.h"
 #include "SMUtils.h"
 #include "SMStateMachineInstance.h"
+#include "SMStateMachineDefinition.h"
+#include "SMInstanceSnapshot.h"
 
 
 FSMStateMachine::FSMStateMachine() : Super(), bHasAdditionalLogic(false), bReuseCurrentState(false),
@@ -414,6 +416,11 @@ void FSMStateMachine::RemoveActiveState(FSMState_Base* State, bool bReplicate)
 	}
 }
 
+void FSMStateMachine::RestoreActiveStates(const TArray<FSMState_Base*>& InStates)
+{
+	ActiveStates = InStates;
+}
+
 void FSMStateMachine::SetCurrentState(FSMState_Base* ToState, FSMState_Base* FromState, FSMState_Base* SourceState)
 {
 	if (FromState && !FromState->bStayActiveOnStateChange)
@@ -937,6 +944,10 @@ USMNodeInstance* FSMStateMachine::GetNodeInstance() const
 {
 	if (ReferencedStateMachine)
 	{
+#if WITH_EDITOR
+		RecordNodeInstanceRead();
+#endif
+
 		return ReferencedStateMachine->GetRootStateMachine().GetNodeInstance();
 	}
 
@@ -978,11 +989,71 @@ void FSMStateMachine::SetServerTimeInState(float InTime)
 	}
 }
 
+bool FSMStateMachine::CaptureSnapshot(FSMNodeSnapshot& OutSnapshot) const
+{
+	OutSnapshot.ActiveStates.Reserve(ActiveStates.Num());
+	for (const FSMState_Base* State : ActiveStates)
+	{
+		OutSnapshot.ActiveStates.Add(State->GetGuid());
+	}
+
+	return Super::CaptureSnapshot(OutSnapshot) || OutSnapshot.ActiveStates.Num() > 0;
+}
+
+SIZE_T FSMStateMachine::GetAllocatedSize() const
+{
+	SIZE_T ProcessingStatesSize = ProcessingStates.GetAllocatedSize();
+	for (const TPair<FGuid, TSet<FSMState_Base*>>& KeyVal : ProcessingStates)
+	{
+		ProcessingStatesSize += KeyVal.Value.GetAllocatedSize();
+	}
+	
+	return Super::GetAllocatedSize() +
+		UpdateStateGraphEvaluator.GetAllocatedSize() + EndStateGraphEvaluator.GetAllocatedSize() +
+		States.GetAllocatedSize() + Transitions.GetAllocatedSize() + PreviousTransactions.GetAllocatedSize() +
+		EntryStates.GetAllocatedSize() + TemporaryEntryStates.GetAllocatedSize() + ActiveStates.GetAllocatedSize() +
+		ProcessingStatesSize;
+}
+
 void FSMStateMachine::AddState(FSMState_Base* State)
 {
 	State->SetOwnerNode(this);
 	States.AddUnique(State);
-	StateNameMap.Add(State->GetNodeName(), State);
+}
+
+FSMState_Base* FSMStateMachine::FindStateByName(const FName& StateName) const
+{
+	const USMInstance* Instance = GetOwningInstance();
+	if (const FSMStateMachineDefinition* Definition = Instance ? Instance->GetStateMachineDefinition() : nullptr)
+	{
+		const FSMStateMachineLayout* Layout = Definition->FindLayout(GetNodeGuid());
+		const FSMNodeLayout* StateLayout = Layout ? Layout->FindState(StateName) : nullptr;
+		return StateLayout ? StateLayout->Property->ContainerPtrToValuePtr<FSMState_Base>(const_cast<USMInstance*>(Instance)) : nullptr;
+	}
+
+	// The last state with a matching name wins to match definition lookups.
+	const FString StateNameString = StateName.ToString();
+	for (int32 Idx = States.Num() - 1; Idx >= 0; --Idx)
+	{
+		if (States[Idx]->GetNodeName() == StateNameString)
+		{
+			return States[Idx];
+		}
+	}
+
+	return nullptr;
+}
+
+TMap<FString, FSMState_Base*> FSMStateMachine::GetStateNameMap() const
+{
+	TMap<FString, FSMState_Base*> StateNameMap;
+	StateNameMap.Reserve(States.Num());
+	for (FSMState_Base* State : States)
+	{
+		StateNameMap.Add(State->GetNodeName(), State);
+	}
+
+	return StateNameMap;
 }
 
 void FSMStateMachine::AddTransition(FSMTransition* Transition)
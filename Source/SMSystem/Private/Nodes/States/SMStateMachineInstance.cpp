@@ -24,12 +24,18 @@ void USMStateMachineInstance::GetAllStateInstances(TArray<USMStateInstance_Base*
 
 USMStateInstance_Base* USMStateMachineInstance::GetContainedStateByName(const FString& StateName) const
 {
+	// A name which was never created can't belong to a state. Avoids adding it to the name table.
+	const FName StateFName(*StateName, FNAME_Find);
+	if (StateFName.IsNone())
+	{
+		return nullptr;
+	}
+
 	if (FSMStateMachine* StateMachineOwner = (FSMStateMachine*)GetOwningNode())
 	{
-		const TMap<FString, FSMState_Base*>& StateStructMap = StateMachineOwner->GetStateNameMap();
-		if (FSMState_Base* const* StateBase = StateStructMap.Find(StateName))
+		if (FSMState_Base* StateBase = StateMachineOwner->FindStateByName(StateFName))
 		{
-			return Cast<USMStateInstance_Base>((*StateBase)->GetNodeInstance());
+			return Cast<USMStateInstance_Base>(StateBase->GetNodeInstance());
 		}
 	}
 
@@ -6,6 +6,7 @@
 #include "SMTransitionInstance.h"
 #include "SMLogging.h"
 #include "SMUtils.h"
+#include "SMTrace.h"
 
 struct TransitionEvaluatorHelper
 {
@@ -23,7 +24,9 @@ struct TransitionEvaluatorHelper
 		{
 			TransitionPtr->bIsEvaluating = false;
 #if WITH_EDITORONLY_DATA
-			TransitionPtr->bWasEvaluating = true; // Will be set to false from the editor.
+			TransitionPtr->bWasEvaluating = true;
+			TransitionPtr->PublishDebugState();
+			TransitionPtr->RecordDebugEvent(ESMDebugEventType::Evaluated, TransitionPtr->bCanEnterTransition);
 #endif
 		}
 	}
@@ -56,6 +59,10 @@ void FSMTransition::Initialize(UObject* Instance)
 	USMUtils::InitializeGraphFunctions(TransitionEnteredGraphEvaluator, Instance);
 	USMUtils::InitializeGraphFunctions(TransitionPreEvaluateGraphEvaluator, Instance);
 	USMUtils::InitializeGraphFunctions(TransitionPostEvaluateGraphEvaluator, Instance);
+
+	// Node instances created on demand are always the default class which has no trigger events.
+	const USMTransitionInstance* TransitionInstance = Cast<USMTransitionInstance>(NodeInstance);
+	TriggerEvents = TransitionInstance ? TransitionInstance->GetTriggerEvents() : TArray<FName>();
 }
 
 void FSMTransition::Reset()
@@ -81,10 +88,7 @@ void FSMTransition::ExecuteInitializeNodes()
 	// Possible this could be true if multiple transitions out of the same state were triggered by the same event.
 	bCanEnterTransitionFromEvent = false;
 	
-	if (NodeInstance)
-	{
-		NodeInstance->NativeInitialize();
-	}
+	InitializeNodeInstance();
 	
 	Super::ExecuteInitializeNodes();
 
@@ -94,20 +98,26 @@ void FSMTransition::ExecuteInitializeNodes()
 	}
 }
 
+#if WITH_EDITORONLY_DATA
+void FSMTransition::UpdateDebugNodeState(FSMDebugNodeState& InOutState) const
+{
+	Super::UpdateDebugNodeState(InOutState);
+	InOutState.bIsEvaluating = bIsEvaluating;
+	InOutState.bWasEvaluating |= bWasEvaluating;
+}
+#endif
+
 void FSMTransition::ExecuteShutdownNodes()
 {
 	bIsEvaluating = false;
 	bCanEnterTransitionFromEvent = false;
 #if WITH_EDITORONLY_DATA
-	bWasEvaluating = false; // Will be set to false from the editor.
+	bWasEvaluating = false;
 #endif
 	
 	Super::ExecuteShutdownNodes();
 
-	if (NodeInstance)
-	{
-		NodeInstance->NativeShutdown();
-	}
+	ShutdownNodeInstance();
 	
 	if (ToState->IsConduit())
 	{
@@ -115,8 +125,20 @@ void FSMTransition::ExecuteShutdownNodes()
 	}
 }
 
+SIZE_T FSMTransition::GetAllocatedSize() const
+{
+	return Super::GetAllocatedSize() + TransitionEnteredGraphEvaluator.GetAllocatedSize() +
+		TransitionPreEvaluateGraphEvaluator.GetAllocatedSize() + TransitionPostEvaluateGraphEvaluator.GetAllocatedSize() +
+		TriggerEvents.GetAllocatedSize();
+}
+
 void FSMTransition::TakeTransition()
 {
+#if WITH_EDITORONLY_DATA
+	RecordDebugEvent(ESMDebugEventType::TransitionTaken);
+#endif
+	SM_TRACE_TRANSITION_TAKEN(*this);
+	
 	SetActive(true);
 
 	if (USMTransitionInstance* TransitionInstance = Cast<USMTransitionInstance>(NodeInstance))
@@ -157,13 +179,21 @@ bool FSMTransition::DoesTransitionPass()
 	{
 		return false;
 	}
+
+	// Transitions waiting on posted events are skipped entirely, including pre and post evaluate graphs, until a matching event arrives.
+	if (TriggerEvents.Num() > 0 && !bCanEnterTransitionFromEvent && FindTriggeringEvent() == nullptr)
+	{
+		return false;
+	}
 	
 	TransitionEvaluatorHelper Evaluator(this);	// Sets bIsEvaluating = false on destruct.
+	SM_PROFILE_NODE_SCOPE(*this, ESMProfileCategory::TransitionPass);
 
 	if (CanEvaluateFromEvent() && bCanEnterTransitionFromEvent)
 	{
 		bCanEnterTransitionFromEvent = false;
 		bCanEnterTransition = true;
+		SM_PROFILE_NODE_SCOPE_PASSED(true);
 		return true;
 	}
 	
@@ -189,6 +219,7 @@ bool FSMTransition::DoesTransitionPass()
 		bCanEnterTransition = false;
 	}
 
+	SM_PROFILE_NODE_SCOPE_PASSED(bCanEnterTransition);
 	return bCanEnterTransition;
 }
 
@@ -199,7 +230,8 @@ bool FSMTransition::CanTransitionFromEvent()
 	{
 		bIsEvaluating = false;
 #if WITH_EDITORONLY_DATA
-		bWasEvaluating = true; // Will be set to false from the editor.
+		bWasEvaluating = true;
+		PublishDebugState();
 #endif
 	}
 	
@@ -209,6 +241,7 @@ bool FSMTransition::CanTransitionFromEvent()
 bool FSMTransition::CanTransition(TArray<FSMTransition*>& Transitions)
 {
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMTransition::CanTransition"), STAT_SMTransition_CanTransition, STATGROUP_LogicDriver);
+	SM_TRACE_NODE_SCOPE(*this, ESMTraceNodeScope::TransitionEvaluate);
 	
 	if (!DoesTransitionPass())
 	{
@@ -288,6 +321,26 @@ bool FSMTransition::CanEvaluateFromEvent() const
 	return bCanEvaluateFromEvent;
 }
 
+const FSMEvent* FSMTransition::FindTriggeringEvent() const
+{
+	if (TriggerEvents.Num() == 0 || OwningInstance == nullptr)
+	{
+		return nullptr;
+	}
+
+	// Events are drained by the instance being updated, which for references is the master owner.
+	const USMInstance* EventOwner = OwningInstance->GetMasterReferenceOwnerConst();
+	for (const FName& EventName : TriggerEvents)
+	{
+		if (const FSMEvent* Event = EventOwner->FindCurrentEvent(EventName))
+		{
+			return Event;
+		}
+	}
+
+	return nullptr;
+}
+
 void FSMTransition::SetFromState(FSMState_Base* State)
 {
 	FromState = State;
@@ -109,6 +109,29 @@ void USMTransitionInstance::EvaluateFromManuallyBoundEvent()
 	SetCanEvaluate(false);
 }
 
+void USMTransitionInstance::SetTriggerEvents(const TArray<FName>& Value)
+{
+	TriggerEvents = Value;
+	if (FSMTransition* Transition = (FSMTransition*)GetOwningNode())
+	{
+		Transition->TriggerEvents = Value;
+	}
+}
+
+bool USMTransitionInstance::GetTriggeringEvent(FSMEvent& OutEvent) const
+{
+	if (FSMTransition* Transition = (FSMTransition*)GetOwningNode())
+	{
+		if (const FSMEvent* Event = Transition->FindTriggeringEvent())
+		{
+			OutEvent = *Event;
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void USMTransitionInstance::SetCanEvaluate(const bool bValue)
 {
 	SET_NODE_DEFAULT_VALUE(FSMTransition, bCanEvaluate, bValue);
@@ -20,7 +20,7 @@ void FSMExposedFunctionHandler::Initialize(UObject* StateMachineObject)
 
 	if (BoundFunction != NAME_None)
 	{
-		// Optimization from UE -- FProperty gets copied on new instances so we don't have to look up the function.
+		// Reuse the function if this handler was copied from one already resolved. The editor always looks it up since the class may have been recompiled.
 #if !WITH_EDITOR
 		if (Function == nullptr)
 #endif
@@ -0,0 +1,154 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#include "SMDebugRecorder.h"
+
+#if WITH_EDITORONLY_DATA
+
+#include "SMNode_Base.h"
+
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarDebugRecorderAutoRecord(
+	TEXT("LogicDriver.DebugRecorder.AutoRecord"),
+	0,
+	TEXT("When enabled every state machine instance records node events as it initializes so past frames can be debugged."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarDebugRecorderCapacity(
+	TEXT("LogicDriver.DebugRecorder.Capacity"),
+	4096,
+	TEXT("Number of events each state machine instance can record before the oldest events are overwritten."),
+	ECVF_Default);
+
+FSMDebugRecorder::FSMDebugRecorder(int32 InCapacity) : WriteCount(0), StartCycles(FPlatformTime::Cycles64())
+{
+	const uint32 Capacity = FMath::RoundUpToPowerOfTwo(static_cast<uint32>(FMath::Max(InCapacity, 2)));
+	Events.SetNumUninitialized(Capacity);
+	CapacityMask = Capacity - 1;
+}
+
+int32 FSMDebugRecorder::FindLastEventAtFrame(uint32 Frame) const
+{
+	// Events are recorded in frame order.
+	int32 Low = 0;
+	int32 High = Num() - 1;
+	int32 Result = INDEX_NONE;
+
+	while (Low <= High)
+	{
+		const int32 Mid = Low + (High - Low) / 2;
+		if (GetEvent(Mid).Frame <= Frame)
+		{
+			Result = Mid;
+			Low = Mid + 1;
+		}
+		else
+		{
+			High = Mid - 1;
+		}
+	}
+
+	return Result;
+}
+
+void FSMDebugRecorder::ReplayTo(int32 EventIndex, TArray<FSMDebugNodeState>& InOutNodeStates, TArray<float>* OutTimesInState) const
+{
+	for (FSMDebugNodeState& NodeState : InOutNodeStates)
+	{
+		NodeState = FSMDebugNodeState();
+	}
+
+	// Times are measured from activation, so the activation time is kept while a node is active.
+	TArray<float> ActivatedTimes;
+	if (OutTimesInState)
+	{
+		OutTimesInState->Reset();
+		OutTimesInState->SetNumZeroed(InOutNodeStates.Num());
+		ActivatedTimes.SetNumZeroed(InOutNodeStates.Num());
+	}
+
+	EventIndex = FMath::Min(EventIndex, Num() - 1);
+	if (EventIndex < 0)
+	{
+		return;
+	}
+
+	for (int32 Idx = 0; Idx <= EventIndex; ++Idx)
+	{
+		const FSMDebugEvent& Event = GetEvent(Idx);
+		if (!InOutNodeStates.IsValidIndex(Event.NodeIndex))
+		{
+			continue;
+		}
+
+		FSMDebugNodeState& NodeState = InOutNodeStates[Event.NodeIndex];
+		if (Event.Type == ESMDebugEventType::Activated)
+		{
+			NodeState.bIsActive = true;
+			if (OutTimesInState)
+			{
+				ActivatedTimes[Event.NodeIndex] = Event.Time;
+				(*OutTimesInState)[Event.NodeIndex] = 0.f;
+			}
+		}
+		else if (Event.Type == ESMDebugEventType::Deactivated)
+		{
+			if (OutTimesInState && NodeState.bIsActive)
+			{
+				(*OutTimesInState)[Event.NodeIndex] = Event.Time - ActivatedTimes[Event.NodeIndex];
+			}
+			NodeState.bIsActive = false;
+		}
+	}
+
+	if (OutTimesInState)
+	{
+		const float TargetTime = GetEvent(EventIndex).Time;
+		for (int32 Idx = 0; Idx < InOutNodeStates.Num(); ++Idx)
+		{
+			if (InOutNodeStates[Idx].bIsActive)
+			{
+				(*OutTimesInState)[Idx] = TargetTime - ActivatedTimes[Idx];
+			}
+		}
+	}
+
+	// Flag everything which happened on the target frame so changes within a single frame are visible.
+	const uint32 TargetFrame = GetEvent(EventIndex).Frame;
+	for (int32 Idx = EventIndex; Idx >= 0 && GetEvent(Idx).Frame == TargetFrame; --Idx)
+	{
+		const FSMDebugEvent& Event = GetEvent(Idx);
+		if (!InOutNodeStates.IsValidIndex(Event.NodeIndex))
+		{
+			continue;
+		}
+
+		FSMDebugNodeState& NodeState = InOutNodeStates[Event.NodeIndex];
+		if (Event.Type == ESMDebugEventType::Evaluated)
+		{
+			NodeState.bWasEvaluating = true;
+		}
+		else if (Event.Type != ESMDebugEventType::Activated)
+		{
+			NodeState.bWasActive = true;
+		}
+	}
+}
+
+void FSMDebugRecorder::Reset()
+{
+	WriteCount = 0;
+	StartCycles = FPlatformTime::Cycles64();
+}
+
+bool FSMDebugRecorder::ShouldAutoRecord()
+{
+	return CVarDebugRecorderAutoRecord.GetValueOnGameThread() != 0;
+}
+
+int32 FSMDebugRecorder::GetDefaultCapacity()
+{
+	return CVarDebugRecorderCapacity.GetValueOnGameThread();
+}
+
+#endif
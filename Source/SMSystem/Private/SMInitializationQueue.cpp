@@ -0,0 +1,103 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#include "SMInitializationQueue.h"
+#include "SMStateMachineComponent.h"
+#include "SMLogging.h"
+
+#include "Algo/BinarySearch.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<float> CVarDeferredInitBudgetMs(
+	TEXT("LogicDriver.DeferredInit.BudgetMs"),
+	2.f,
+	TEXT("Milliseconds per frame spent initializing state machine components with deferred initialization."),
+	ECVF_Default);
+
+FSMInitializationQueue& FSMInitializationQueue::Get()
+{
+	static FSMInitializationQueue InitializationQueue;
+	return InitializationQueue;
+}
+
+void FSMInitializationQueue::Enqueue(USMStateMachineComponent* Component, int32 Priority)
+{
+	check(IsInGameThread());
+	check(Component);
+
+	Remove(Component);
+
+	FEntry NewEntry;
+	NewEntry.Component = Component;
+	NewEntry.Priority = Priority;
+	NewEntry.Order = NextOrder++;
+
+	// Lowest priority and newest first so the next entry is at the end.
+	const int32 InsertIndex = Algo::UpperBound(Entries, NewEntry, [](const FEntry& A, const FEntry& B)
+	{
+		return A.Priority != B.Priority ? A.Priority < B.Priority : A.Order > B.Order;
+	});
+	Entries.Insert(NewEntry, InsertIndex);
+}
+
+void FSMInitializationQueue::Remove(const USMStateMachineComponent* Component)
+{
+	Entries.RemoveAll([Component](const FEntry& Entry)
+	{
+		return Entry.Component.Get() == Component;
+	});
+}
+
+bool FSMInitializationQueue::Contains(const USMStateMachineComponent* Component) const
+{
+	return Entries.ContainsByPredicate([Component](const FEntry& Entry)
+	{
+		return Entry.Component.Get() == Component;
+	});
+}
+
+int32 FSMInitializationQueue::ProcessQueue(double BudgetSeconds)
+{
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInitializationQueue::ProcessQueue"), STAT_SMInitializationQueue_ProcessQueue, STATGROUP_LogicDriver);
+
+	const double StartTime = FPlatformTime::Seconds();
+	int32 NumInitialized = 0;
+
+	while (Entries.Num() > 0)
+	{
+		USMStateMachineComponent* Component = Entries.Pop(false).Component.Get();
+		if (Component == nullptr || Component->IsPendingKillOrUnreachable() || Component->IsBeingDestroyed())
+		{
+			continue;
+		}
+
+		Component->ProcessDeferredInitialization();
+		NumInitialized++;
+
+		if (FPlatformTime::Seconds() - StartTime >= BudgetSeconds)
+		{
+			break;
+		}
+	}
+
+	return NumInitialized;
+}
+
+void FSMInitializationQueue::Flush()
+{
+	ProcessQueue(TNumericLimits<double>::Max());
+}
+
+double FSMInitializationQueue::GetFrameBudgetSeconds()
+{
+	return FMath::Max(CVarDeferredInitBudgetMs.GetValueOnGameThread(), 0.f) / 1000.0;
+}
+
+void FSMInitializationQueue::Tick(float DeltaTime)
+{
+	ProcessQueue(GetFrameBudgetSeconds());
+}
+
+TStatId FSMInitializationQueue::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(SMInitializationQueue, STATGROUP_LogicDriver);
+}
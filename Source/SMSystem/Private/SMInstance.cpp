@@ -4,12 +4,17 @@
 #include "SMLogging.h"
 #include "SMUtils.h"
 #include "SMStateMachineComponent.h"
+#include "SMStateMachineDefinition.h"
+#include "SMTrace.h"
+#include "Blueprints/SMBlueprintGeneratedClass.h"
 
 #include "Engine/InputDelegateBinding.h"
 #include "Engine/NetDriver.h"
 #include "Net/UnrealNetwork.h"
 #include "Kismet/GameplayStatics.h"
 #include "GameFramework/Pawn.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "UObject/UObjectArray.h"
 
 
 #define LOCTEXT_NAMESPACE "SMInstance"
@@ -40,6 +45,7 @@ USMInstance::USMInstance() : Super()
 	bCanTakeTransitionsLocally = true;
 	bCanExecuteStateLogic = true;
 	bInitialized = false;
+	bIsPrototype = false;
 	R_bLoadFromStatesCalled = false;
 }
 
@@ -102,18 +108,127 @@ void USMInstance::BeginDestroy()
 	Super::BeginDestroy();
 }
 
+/** Collect the nodes of a state machine without entering references, which are recorded by their own instance. */
+static void GetOwnedNodes(FSMStateMachine& StateMachine, TArray<FSMNode_Base*>& OutNodes)
+{
+	OutNodes.Add(&StateMachine);
+	if (StateMachine.GetInstanceReference())
+	{
+		return;
+	}
+
+	for (FSMState_Base* State : StateMachine.GetStates())
+	{
+		if (State->IsStateMachine())
+		{
+			GetOwnedNodes(*static_cast<FSMStateMachine*>(State), OutNodes);
+		}
+		else
+		{
+			OutNodes.Add(State);
+		}
+	}
+
+	OutNodes.Append(StateMachine.GetTransitions());
+}
+
+/** States owned by this instance, including the state machine itself. */
+static void GetOwnedStates(FSMStateMachine& StateMachine, TArray<FSMState_Base*>& OutStates)
+{
+	OutStates.Add(&StateMachine);
+	if (StateMachine.GetInstanceReference())
+	{
+		return;
+	}
+
+	for (FSMState_Base* State : StateMachine.GetStates())
+	{
+		if (State->IsStateMachine())
+		{
+			GetOwnedStates(*static_cast<FSMStateMachine*>(State), OutStates);
+		}
+		else
+		{
+			OutStates.Add(State);
+		}
+	}
+}
+
 void USMInstance::Initialize(UObject* Context)
 {
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::Initialize"), STAT_SMInstance_Initialize, STATGROUP_LogicDriver);
-	
+	DoInitialize(Context, nullptr);
+}
+
+void USMInstance::InitializeFromPrototype(USMInstance* Prototype, UObject* Context)
+{
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::InitializeFromPrototype"), STAT_SMInstance_InitializeFromPrototype, STATGROUP_LogicDriver);
+
+	if (!Prototype || Prototype == this || Prototype->GetClass() != GetClass() || !Prototype->IsInitialized() || Prototype->IsActive())
+	{
+		LD_LOG_WARNING(TEXT("Prototype %s can't be used to initialize State Machine Instance %s. It must be an initialized instance of the same class which isn't running."),
+			Prototype ? *Prototype->GetName() : TEXT("None"), *GetName());
+		DoInitialize(Context, nullptr);
+		return;
+	}
+
+	DoInitialize(Context, Prototype);
+}
+
+void USMInstance::InitializeAsPrototype(UObject* Context)
+{
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::InitializeAsPrototype"), STAT_SMInstance_InitializeAsPrototype, STATGROUP_LogicDriver);
+	DoInitialize(Context, nullptr, true);
+}
+
+const FSMNode_Base* USMInstance::FindPrototypeNode(const FSMNode_Base& Node) const
+{
+	if (!InitializingPrototype)
+	{
+		return nullptr;
+	}
+
+	// Nodes are properties of the instance so the prototype's node is at the same offset.
+	const UPTRINT NodeAddress = reinterpret_cast<UPTRINT>(&Node);
+	const UPTRINT InstanceAddress = reinterpret_cast<UPTRINT>(this);
+	if (NodeAddress < InstanceAddress || NodeAddress - InstanceAddress >= static_cast<UPTRINT>(GetClass()->GetPropertiesSize()))
+	{
+		return nullptr;
+	}
+
+	return reinterpret_cast<const FSMNode_Base*>(reinterpret_cast<const uint8*>(InitializingPrototype) + (NodeAddress - InstanceAddress));
+}
+
+void USMInstance::DoInitialize(UObject* Context, USMInstance* Prototype, bool bAsPrototype)
+{
 	Shutdown();
 
+	bIsPrototype = bAsPrototype;
+
 	// Context is what the instance will run under. This also sets the World the state machine operates in.
 	SetContext(Context);
 
+	// The topology shared by all instances of this class is always used for name lookups.
+	StateMachineDefinition.Reset();
+	if (Prototype)
+	{
+		StateMachineDefinition = Prototype->StateMachineDefinition;
+	}
+	else if (USMBlueprintGeneratedClass* BlueprintClass = Cast<USMBlueprintGeneratedClass>(GetClass()))
+	{
+		StateMachineDefinition = BlueprintClass->GetStateMachineDefinition();
+	}
+
+	// Link nodes from the shared topology if possible. Copies always link from it since the prototype was already validated.
+	const FSMStateMachineDefinition* Definition = bUseSharedDefinition || Prototype ? StateMachineDefinition.Get() : nullptr;
+	
 	// Locate the properties for this state machine. This could be either from a blueprint or native class.
 	TSet<FStructProperty*> Properties;
-	if (!USMUtils::TryGetStateMachinePropertiesForClass(GetClass(), Properties, RootStateMachineGuid))
+	if (Definition)
+	{
+		RootStateMachineGuid = Definition->RootGuid;
+	}
+	else if (!USMUtils::TryGetStateMachinePropertiesForClass(GetClass(), Properties, RootStateMachineGuid))
 	{
 		return;
 	}
@@ -126,10 +241,14 @@ void USMInstance::Initialize(UObject* Context)
 	RootStateMachine.SetNodeGuid(RootStateMachineGuid);
 	RootStateMachine.SetNodeName("Root");
 	RootStateMachine.SetNodeInstanceClass(StateMachineClass);
+
+	// References and node instances are copied from the prototype while it's set.
+	InitializingPrototype = Prototype;
 	
 	// Build the run-time state machine.
-	if (!USMUtils::GenerateStateMachine(this, RootStateMachine, Properties))
+	if (!USMUtils::GenerateStateMachine(this, RootStateMachine, Definition ? Definition->Properties : Properties, false, Definition))
 	{
+		InitializingPrototype = nullptr;
 		LD_LOG_ERROR(TEXT("Error generating state machine %s. Please try recompiling the blueprint."), *GetName());
 		return;
 	}
@@ -137,16 +256,34 @@ void USMInstance::Initialize(UObject* Context)
 	// Initialize the graph function calls.
 	RootStateMachine.Initialize(this);
 
-	// Calculate path guids now that the instance is initialized and all node owners set.
-	TMap<FString, int32> Paths;
-	RootStateMachine.CalculatePathGuid(Paths);
+	if (Prototype)
+	{
+		// Path guids only depend on the layout, which matches the prototype. References copied their own.
+		TArray<FSMNode_Base*> Nodes;
+		GetOwnedNodes(RootStateMachine, Nodes);
+		for (FSMNode_Base* Node : Nodes)
+		{
+			if (const FSMNode_Base* PrototypeNode = FindPrototypeNode(*Node))
+			{
+				Node->CopyPathGuid(*PrototypeNode);
+			}
+		}
+	}
+	else
+	{
+		// Calculate path guids now that the instance is initialized and all node owners set.
+		TMap<FString, int32> Paths;
+		RootStateMachine.CalculatePathGuid(Paths);
+	}
+
+	InitializingPrototype = nullptr;
 
 	/* Build out a map of the state machine to use with node retrieval. */
 	TSet<USMInstance*> InstancesMapped;
 	BuildStateMachineMap(&RootStateMachine, InstancesMapped);
 
-	// Configure input.
-	if (GetWorld() && AutoReceiveInput != ESMStateMachineInput::Disabled && UInputDelegateBinding::SupportsInputDelegate(GetClass()))
+	// Configure input. Prototypes are never run so they don't receive input.
+	if (!bAsPrototype && GetWorld() && AutoReceiveInput != ESMStateMachineInput::Disabled && UInputDelegateBinding::SupportsInputDelegate(GetClass()))
 	{
 		if (APlayerController* PlayerController = GetInputController())
 		{
@@ -163,12 +300,24 @@ void USMInstance::Initialize(UObject* Context)
 		}
 	}
 	
-	// Construction scripts need to run after all nodes are initialized.
-	RootStateMachine.RunConstructionScripts();
+	// Construction scripts need to run after all nodes are initialized. Node instances copied from a prototype already have their results.
+	if (!Prototype)
+	{
+		RootStateMachine.RunConstructionScripts();
+	}
 	
 #if WITH_EDITORONLY_DATA
-	// Load debug object for this instance.
+	// Load debug object for this instance. Initialize can run on async initialization threads.
+	static FThreadSafeCounter DebugGeneration;
+	const bool bWasRecording = DebugStateMachine.GetRecorder() != nullptr;
 	DebugStateMachine = FSMDebugStateMachine();
+	DebugStateMachine.Generation = static_cast<uint32>(DebugGeneration.Increment());
+
+	// Node indices change on initialize so any previous recording can't be kept.
+	if (bWasRecording || FSMDebugRecorder::ShouldAutoRecord())
+	{
+		DebugStateMachine.StartRecording();
+	}
 	for (const auto& KeyVal : GuidNodeMap)
 	{
 		DebugStateMachine.UpdateRuntimeNode(KeyVal.Value);
@@ -176,6 +325,16 @@ void USMInstance::Initialize(UObject* Context)
 #endif
 
 	bInitialized = true;
+
+	// All owned objects exist now so the cluster can be formed.
+	CreateGCCluster();
+
+	if (bAsPrototype)
+	{
+		return;
+	}
+
+	SM_TRACE_INSTANCE_EVENT(*this, ESMTraceInstanceEvent::Initialized);
 	
 	OnStateMachineInitialized();
 	OnStateMachineInitializedEvent.Broadcast(this);
@@ -196,6 +355,8 @@ void USMInstance::Start()
 
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::Start"), STAT_SMInstance_Start, STATGROUP_LogicDriver);
 
+	SM_TRACE_INSTANCE_EVENT(*this, ESMTraceInstanceEvent::Started);
+
 	DoStart();
 
 	R_bHasStarted = true;
@@ -250,12 +411,23 @@ void USMInstance::Internal_Update(float DeltaSeconds)
 	}
 
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::Update"), STAT_SMInstance_Update, STATGROUP_LogicDriver);
+	SM_TRACE_INSTANCE_SCOPE(*this);
+	FSMScopedSyncLoadCheck SyncLoadCheck(this);
+
+	// Drain once so every transition evaluated this update sees the same events.
+	FSMPendingEvent PendingEvent;
+	while (PendingEvents.Dequeue(PendingEvent))
+	{
+		CurrentEvents.Emplace(PendingEvent.Name, PendingEvent.Payload.Get());
+	}
 
 	OnStateMachineUpdate(DeltaSeconds);
 	OnStateMachineUpdatedEvent.Broadcast(this, DeltaSeconds);
 
 	RootStateMachine.UpdateState(DeltaSeconds);
 
+	CurrentEvents.Reset();
+
 	if (NetworkInterface.GetObject() && ActiveTransactions.Num())
 	{
 		NetworkInterface->ProcessTransaction(ActiveTransactions);
@@ -297,6 +469,7 @@ void USMInstance::Stop()
 	}
 
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::Stop"), STAT_SMInstance_Stop, STATGROUP_LogicDriver);
+	SM_TRACE_INSTANCE_EVENT(*this, ESMTraceInstanceEvent::Stopped);
 	
 	RootStateMachine.EndState(0.f);
 
@@ -312,6 +485,10 @@ void USMInstance::Stop()
 	ReplicateStates();
 	R_bLoadFromStatesCalled = false;
 	R_bHasStarted = false;
+
+	// Events posted to a stopped machine shouldn't carry over to the next run.
+	PendingEvents.Empty();
+	CurrentEvents.Reset();
 }
 
 void USMInstance::Restart()
@@ -328,6 +505,7 @@ void USMInstance::Shutdown()
 	}
 
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::Shutdown"), STAT_SMInstance_Shutdown, STATGROUP_LogicDriver);
+	SM_TRACE_INSTANCE_EVENT(*this, ESMTraceInstanceEvent::Shutdown);
 
 	UObject* Context = GetContext();
 	const bool bContextDestroyed = Context == nullptr || Context->IsPendingKillOrUnreachable();
@@ -381,6 +559,8 @@ void USMInstance::Shutdown()
 	GuidStateMap.Empty();
 	GuidTransitionMap.Empty();
 
+	ReleaseGCCluster();
+
 	bInitialized = false;
 }
 
@@ -399,6 +579,22 @@ void USMInstance::EvaluateTransitions()
 	StateMachineInstance->GetRootStateMachine().ProcessStates(0.f, true);
 }
 
+void USMInstance::PostEvent(FName EventName, UObject* Payload)
+{
+	// Reference owners are set once during initialization so reading them from another thread is safe.
+	USMInstance* EventOwner = GetMasterReferenceOwner();
+	check(EventOwner);
+	EventOwner->PendingEvents.Enqueue({ EventName, Payload });
+}
+
+const FSMEvent* USMInstance::FindCurrentEvent(FName EventName) const
+{
+	return CurrentEvents.FindByPredicate([EventName](const FSMEvent& Event)
+	{
+		return Event.Name == EventName;
+	});
+}
+
 void USMInstance::LoadFromState(const FGuid& FromGuid, bool bAllParents)
 {
 	if (!FromGuid.IsValid())
@@ -441,6 +637,280 @@ void USMInstance::OnStateMachineInitialStateLoaded_Implementation(const FGuid& S
 {
 }
 
+void USMInstance::CaptureSnapshot(FSMInstanceSnapshot& OutSnapshot) const
+{
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::CaptureSnapshot"), STAT_SMInstance_CaptureSnapshot, STATGROUP_LogicDriver);
+
+	OutSnapshot = FSMInstanceSnapshot();
+	OutSnapshot.ClassPath = GetClass()->GetPathName();
+
+	CaptureInstanceRecord(OutSnapshot.Instances.AddDefaulted_GetRef());
+	for (const USMInstance* Reference : GetAllReferencedInstances(true))
+	{
+		Reference->CaptureInstanceRecord(OutSnapshot.Instances.AddDefaulted_GetRef());
+	}
+}
+
+bool USMInstance::RestoreSnapshot(const FSMInstanceSnapshot& InSnapshot)
+{
+	if (!CheckIsInitialized())
+	{
+		return false;
+	}
+
+	if (IsActive())
+	{
+		LD_LOG_WARNING(TEXT("Attempted to restore a snapshot to State Machine Instance %s while it was running."), *GetName());
+		return false;
+	}
+
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::RestoreSnapshot"), STAT_SMInstance_RestoreSnapshot, STATGROUP_LogicDriver);
+
+	if (!ForEachInstanceRecord(InSnapshot, [](USMInstance& Instance, const FSMInstanceRecord& Record)
+	{
+		Instance.RestoreInstanceRecord(Record);
+	}))
+	{
+		return false;
+	}
+
+	TimeSinceAllowedTick = 0.f;
+	UpdateTime();
+	ReplicateStates();
+
+	return true;
+}
+
+bool USMInstance::RollbackToSnapshot(const FSMInstanceSnapshot& InSnapshot)
+{
+	if (!CheckIsInitialized())
+	{
+		return false;
+	}
+
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::RollbackToSnapshot"), STAT_SMInstance_RollbackToSnapshot, STATGROUP_LogicDriver);
+
+	return ForEachInstanceRecord(InSnapshot, [](USMInstance& Instance, const FSMInstanceRecord& Record)
+	{
+		Instance.RollbackInstanceRecord(Record);
+	});
+}
+
+bool USMInstance::ForEachInstanceRecord(const FSMInstanceSnapshot& InSnapshot, TFunctionRef<void(USMInstance&, const FSMInstanceRecord&)> Func)
+{
+	if (InSnapshot.ClassPath != GetClass()->GetPathName())
+	{
+		LD_LOG_WARNING(TEXT("Attempted to restore a snapshot of class %s to State Machine Instance %s of class %s."), *InSnapshot.ClassPath,
+			*GetName(), *GetClass()->GetPathName());
+		return false;
+	}
+
+	TMap<FGuid, USMInstance*> Instances;
+	Instances.Add(RootStateMachine.GetGuid(), this);
+	for (USMInstance* Reference : GetAllReferencedInstances(true))
+	{
+		Instances.Add(Reference->GetRootStateMachine().GetGuid(), Reference);
+	}
+
+	for (const FSMInstanceRecord& Record : InSnapshot.Instances)
+	{
+		if (USMInstance** Instance = Instances.Find(Record.RootGuid))
+		{
+			Func(**Instance, Record);
+		}
+		else
+		{
+			LD_LOG_WARNING(TEXT("Could not find the state machine reference %s when restoring a snapshot to State Machine Instance %s."),
+				*Record.RootGuid.ToString(), *GetName());
+		}
+	}
+
+	return true;
+}
+
+void USMInstance::SaveSnapshotToBytes(TArray<uint8>& OutBytes) const
+{
+	FSMInstanceSnapshot Snapshot;
+	CaptureSnapshot(Snapshot);
+	Snapshot.SaveToBytes(OutBytes);
+}
+
+bool USMInstance::RestoreSnapshotFromBytes(const TArray<uint8>& InBytes)
+{
+	FSMInstanceSnapshot Snapshot;
+	if (!Snapshot.LoadFromBytes(InBytes))
+	{
+		LD_LOG_WARNING(TEXT("Could not read snapshot data for State Machine Instance %s."), *GetName());
+		return false;
+	}
+
+	return RestoreSnapshot(Snapshot);
+}
+
+void USMInstance::CaptureInstanceRecord(FSMInstanceRecord& OutRecord) const
+{
+	OutRecord.RootGuid = RootStateMachine.GetGuid();
+	OutRecord.bHasStarted = R_bHasStarted;
+	OutRecord.StateHistory = StateHistory;
+
+	if (FSMInstanceSnapshot::HasSaveGameProperties(GetClass()))
+	{
+		FSMInstanceSnapshot::SaveSaveGameProperties(const_cast<USMInstance*>(this), OutRecord.InstanceData);
+	}
+
+	TArray<FSMNode_Base*> Nodes;
+	GetOwnedNodes(const_cast<FSMStateMachine&>(RootStateMachine), Nodes);
+
+	OutRecord.Nodes.Reserve(Nodes.Num());
+	for (const FSMNode_Base* Node : Nodes)
+	{
+		FSMNodeSnapshot NodeSnapshot;
+		if (Node->CaptureSnapshot(NodeSnapshot))
+		{
+			OutRecord.Nodes.Add(MoveTemp(NodeSnapshot));
+		}
+	}
+}
+
+void USMInstance::RestoreInstanceRecord(const FSMInstanceRecord& InRecord)
+{
+	R_bHasStarted = InRecord.bHasStarted;
+	StateHistory = InRecord.StateHistory;
+
+	if (InRecord.InstanceData.Num() > 0)
+	{
+		FSMInstanceSnapshot::LoadSaveGameProperties(this, InRecord.InstanceData);
+	}
+
+	TMap<FGuid, const FSMNodeSnapshot*> NodeSnapshots;
+	NodeSnapshots.Reserve(InRecord.Nodes.Num());
+	for (const FSMNodeSnapshot& NodeSnapshot : InRecord.Nodes)
+	{
+		NodeSnapshots.Add(NodeSnapshot.Guid, &NodeSnapshot);
+	}
+
+	TArray<FSMNode_Base*> Nodes;
+	GetOwnedNodes(RootStateMachine, Nodes);
+
+	// Nodes at their defaults aren't recorded. Reset them in case this instance has run before.
+	FSMNodeSnapshot DefaultSnapshot;
+	DefaultSnapshot.ServerTimeInState = SM_ACTIVE_TIME_NOT_SET;
+
+	for (FSMNode_Base* Node : Nodes)
+	{
+		if (const FSMNodeSnapshot* NodeSnapshot = NodeSnapshots.FindRef(Node->GetGuid()))
+		{
+			Node->RestoreSnapshot(*NodeSnapshot);
+		}
+		else
+		{
+			DefaultSnapshot.Guid = Node->GetGuid();
+			Node->RestoreSnapshot(DefaultSnapshot);
+		}
+	}
+
+	TArray<FSMState_Base*> OwnedStates;
+	GetOwnedStates(RootStateMachine, OwnedStates);
+
+	TMap<FGuid, FSMState_Base*> States;
+	TArray<FSMStateMachine*> StateMachines;
+	for (FSMState_Base* State : OwnedStates)
+	{
+		States.Add(State->GetGuid(), State);
+		if (State->IsStateMachine())
+		{
+			StateMachines.Add(static_cast<FSMStateMachine*>(State));
+		}
+	}
+
+	// Active lists are set once every state is restored. Only state machines record active states.
+	for (FSMStateMachine* StateMachine : StateMachines)
+	{
+		TArray<FSMState_Base*> ActiveStates;
+		if (const FSMNodeSnapshot* NodeSnapshot = NodeSnapshots.FindRef(StateMachine->GetGuid()))
+		{
+			ActiveStates.Reserve(NodeSnapshot->ActiveStates.Num());
+			for (const FGuid& StateGuid : NodeSnapshot->ActiveStates)
+			{
+				if (FSMState_Base* State = States.FindRef(StateGuid))
+				{
+					ActiveStates.Add(State);
+				}
+			}
+		}
+
+		StateMachine->RestoreActiveStates(ActiveStates);
+	}
+}
+
+void USMInstance::RollbackInstanceRecord(const FSMInstanceRecord& InRecord)
+{
+	StateHistory = InRecord.StateHistory;
+
+	TMap<FGuid, const FSMNodeSnapshot*> NodeSnapshots;
+	NodeSnapshots.Reserve(InRecord.Nodes.Num());
+	for (const FSMNodeSnapshot& NodeSnapshot : InRecord.Nodes)
+	{
+		NodeSnapshots.Add(NodeSnapshot.Guid, &NodeSnapshot);
+	}
+
+	TArray<FSMState_Base*> OwnedStates;
+	GetOwnedStates(RootStateMachine, OwnedStates);
+
+	TMap<FGuid, FSMState_Base*> States;
+	TArray<FSMStateMachine*> StateMachines;
+	for (FSMState_Base* State : OwnedStates)
+	{
+		States.Add(State->GetGuid(), State);
+		if (State->IsStateMachine())
+		{
+			StateMachines.Add(static_cast<FSMStateMachine*>(State));
+		}
+	}
+
+	FSMNodeSnapshot InactiveSnapshot;
+	InactiveSnapshot.ServerTimeInState = SM_ACTIVE_TIME_NOT_SET;
+
+	for (FSMState_Base* State : OwnedStates)
+	{
+		const FSMNodeSnapshot* NodeSnapshot = NodeSnapshots.FindRef(State->GetGuid());
+		const bool bShouldBeActive = NodeSnapshot && NodeSnapshot->HasFlag(FSMNodeSnapshot::Active);
+		if (bShouldBeActive == State->IsActive())
+		{
+			continue;
+		}
+
+		// Restoring never runs begin or end logic.
+		if (NodeSnapshot)
+		{
+			State->RestoreSnapshot(*NodeSnapshot);
+		}
+		else
+		{
+			InactiveSnapshot.Guid = State->GetGuid();
+			State->RestoreSnapshot(InactiveSnapshot);
+		}
+	}
+
+	for (FSMStateMachine* StateMachine : StateMachines)
+	{
+		TArray<FSMState_Base*> ActiveStates;
+		if (const FSMNodeSnapshot* NodeSnapshot = NodeSnapshots.FindRef(StateMachine->GetGuid()))
+		{
+			ActiveStates.Reserve(NodeSnapshot->ActiveStates.Num());
+			for (const FGuid& StateGuid : NodeSnapshot->ActiveStates)
+			{
+				if (FSMState_Base* State = States.FindRef(StateGuid))
+				{
+					ActiveStates.Add(State);
+				}
+			}
+		}
+
+		StateMachine->RestoreActiveStates(ActiveStates);
+	}
+}
+
 FString USMInstance::GetActiveStateName() const
 {
 	if (FSMState_Base* CurrentState = GetSingleActiveState())
@@ -755,6 +1225,88 @@ FSMState_Base* USMInstance::FindStateByGuid(const FGuid& Guid) const
 	return RootStateMachine.FindState(Guid);
 }
 
+FSMStatePathHandle USMInstance::ResolveStatePath(const FString& QualifiedName) const
+{
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::ResolveStatePath"), STAT_SMInstance_ResolveStatePath, STATGROUP_LogicDriver);
+
+	FSMStatePathHandle Handle;
+	Handle.Path = *QualifiedName;
+	
+	if (!AppendStatePathHops(QualifiedName, Handle))
+	{
+		Handle.Hops.Reset();
+		LD_LOG_WARNING(TEXT("Could not resolve state path %s from state machine %s."), *QualifiedName, *GetName());
+	}
+
+	return Handle;
+}
+
+USMStateInstance_Base* USMInstance::GetStateInstanceByHandle(const FSMStatePathHandle& Handle) const
+{
+	if (FSMState_Base* State = GetStateByHandle(Handle))
+	{
+		return Cast<USMStateInstance_Base>(State->GetNodeInstance());
+	}
+
+	return nullptr;
+}
+
+FSMState_Base* USMInstance::GetStateByHandle(const FSMStatePathHandle& Handle) const
+{
+	const USMInstance* Instance = this;
+	FSMState_Base* State = nullptr;
+	
+	for (const FSMStatePathHandle::FHop& Hop : Handle.Hops)
+	{
+		// Properties are only valid on instances of the class they were resolved from.
+		if (Instance == nullptr || !Instance->StateMachineDefinition.IsValid() || !Hop.Definition.HasSameObject(Instance->StateMachineDefinition.Get()))
+		{
+			return nullptr;
+		}
+
+		State = Hop.Property->ContainerPtrToValuePtr<FSMState_Base>(const_cast<USMInstance*>(Instance));
+		Instance = State->IsStateMachine() ? ((FSMStateMachine*)State)->GetInstanceReference() : nullptr;
+	}
+
+	return State;
+}
+
+bool USMInstance::AppendStatePathHops(const FString& QualifiedName, FSMStatePathHandle& Handle) const
+{
+	const FSMStateMachineDefinition* Definition = StateMachineDefinition.Get();
+	if (Definition == nullptr)
+	{
+		return false;
+	}
+
+	// Try the full name first, otherwise enter the deepest state machine reference along the path.
+	int32 SeparatorIndex = QualifiedName.Len();
+	do
+	{
+		const FName Prefix(*QualifiedName.Left(SeparatorIndex), FNAME_Find);
+		if (const FSMNodeLayout* Layout = Definition->FindStatePath(Prefix))
+		{
+			FSMStatePathHandle::FHop& Hop = Handle.Hops.AddDefaulted_GetRef();
+			Hop.Definition = StateMachineDefinition;
+			Hop.Property = Layout->Property;
+
+			if (SeparatorIndex == QualifiedName.Len())
+			{
+				return true;
+			}
+
+			const USMInstance* Reference = Layout->bIsStateMachine ?
+				Layout->Property->ContainerPtrToValuePtr<FSMStateMachine>(this)->GetInstanceReference() : nullptr;
+			return Reference && Reference->AppendStatePathHops(QualifiedName.RightChop(SeparatorIndex + 1), Handle);
+		}
+
+		SeparatorIndex = QualifiedName.Find(TEXT("."), ESearchCase::CaseSensitive, ESearchDir::FromEnd, SeparatorIndex);
+	}
+	while (SeparatorIndex != INDEX_NONE);
+
+	return false;
+}
+
 USMStateMachineInstance* USMInstance::GetRootStateMachineInstance() const
 {
 	return Cast<USMStateMachineInstance>(const_cast<FSMStateMachine&>(RootStateMachine).GetNodeInstance());
@@ -857,6 +1409,43 @@ bool USMInstance::IsReferenceTemplate() const
 	return HasAnyFlags(RF_ArchetypeObject) && !HasAnyFlags(RF_ClassDefaultObject) && GetName().StartsWith("TEMPLATE");
 }
 
+bool USMInstance::IsGCClusterRoot() const
+{
+	const FUObjectItem* ObjectItem = GUObjectArray.ObjectToObjectItem(this);
+	return ObjectItem && ObjectItem->HasAnyFlags(EInternalObjectFlags::ClusterRoot);
+}
+
+void USMInstance::CreateGCCluster()
+{
+	// References are included in the cluster of the primary instance.
+	if (!bCreateGCCluster || GIsEditor || ReferenceOwner != nullptr || IsTemplate())
+	{
+		return;
+	}
+
+	if (USMUtils::IsObjectInGCCluster(this))
+	{
+		return;
+	}
+
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::CreateGCCluster"), STAT_SMInstance_CreateGCCluster, STATGROUP_LogicDriver);
+	CreateCluster();
+}
+
+void USMInstance::ReleaseGCCluster()
+{
+	// The garbage collector handles clusters of objects being destroyed.
+	if (IsUnreachable() || HasAnyFlags(RF_BeginDestroyed) || !IsGCClusterRoot())
+	{
+		return;
+	}
+
+	if (FUObjectCluster* Cluster = GUObjectClusters.GetObjectCluster(this))
+	{
+		GUObjectClusters.DissolveCluster(*Cluster);
+	}
+}
+
 void USMInstance::SetReferenceOwner(USMInstance* Owner)
 {
 	ReferenceOwner = Owner;
@@ -1242,6 +1831,101 @@ void USMInstance::DoStart()
 	ReplicateStates();
 }
 
+/** Function handlers belong to each class and are never copied between a native node and its blueprint node. */
+static bool IsNodeFunctionHandlerArray(const FProperty* Property)
+{
+	const FArrayProperty* ArrayProperty = CastField<FArrayProperty>(Property);
+	const FStructProperty* InnerProperty = ArrayProperty ? CastField<FStructProperty>(ArrayProperty->Inner) : nullptr;
+	return InnerProperty && InnerProperty->Struct == FSMExposedFunctionHandler::StaticStruct();
+}
+
+bool USMInstance::ExecuteBlueprintNodeFunction(FSMNode_Base& Node, FName HandlerName, int32 HandlerIndex, void* Params)
+{
+	const TTuple<FGuid, FName, int32> Key(Node.GetNodeGuid(), HandlerName, HandlerIndex);
+	const TTuple<FStructProperty*, UFunction*>* BlueprintNodeFunction = BlueprintNodeFunctions.Find(Key);
+	if (BlueprintNodeFunction == nullptr)
+	{
+		BlueprintNodeFunction = &BlueprintNodeFunctions.Add(Key, FindBlueprintNodeFunction(Node, HandlerName, HandlerIndex));
+		if (BlueprintNodeFunction->Value == nullptr)
+		{
+			LD_LOG_ERROR(TEXT("%s has no graph function for %s of node %s. Reparent the blueprint the native class was generated from to it."),
+				*GetClass()->GetName(), *HandlerName.ToString(), *Node.GetNodeName());
+		}
+	}
+
+	FStructProperty* NodeProperty = BlueprintNodeFunction->Key;
+	UFunction* Function = BlueprintNodeFunction->Value;
+	if (Function == nullptr)
+	{
+		return false;
+	}
+
+	// Graphs read and write the blueprint node by property, so it mirrors the native node while the function runs.
+	FSMNode_Base* BlueprintNode = NodeProperty->ContainerPtrToValuePtr<FSMNode_Base>(this);
+	for (TFieldIterator<FProperty> It(NodeProperty->Struct); It; ++It)
+	{
+		if (!IsNodeFunctionHandlerArray(*It))
+		{
+			It->CopyCompleteValue_InContainer(BlueprintNode, &Node);
+		}
+	}
+
+	ProcessEvent(Function, Params);
+
+	for (TFieldIterator<FProperty> It(NodeProperty->Struct); It; ++It)
+	{
+		if (!IsNodeFunctionHandlerArray(*It) && !It->Identical_InContainer(BlueprintNode, &Node))
+		{
+			It->CopyCompleteValue_InContainer(&Node, BlueprintNode);
+		}
+	}
+
+	return true;
+}
+
+TTuple<FStructProperty*, UFunction*> USMInstance::FindBlueprintNodeFunction(const FSMNode_Base& Node, FName HandlerName, int32 HandlerIndex) const
+{
+	// The struct of the native node. Values are only copied between nodes of the same struct.
+	const UScriptStruct* NativeStruct = nullptr;
+	for (TFieldIterator<FStructProperty> It(GetClass()); It; ++It)
+	{
+		if (It->GetOwnerClass()->HasAnyClassFlags(CLASS_Native) && It->ContainerPtrToValuePtr<FSMNode_Base>(this) == &Node)
+		{
+			NativeStruct = It->Struct;
+			break;
+		}
+	}
+
+	for (TFieldIterator<FStructProperty> It(GetClass()); NativeStruct && It; ++It)
+	{
+		FStructProperty* Property = *It;
+		if (Property->Struct != NativeStruct || Property->GetOwnerClass()->HasAnyClassFlags(CLASS_Native))
+		{
+			continue;
+		}
+
+		const FSMNode_Base* BlueprintNode = Property->ContainerPtrToValuePtr<FSMNode_Base>(this);
+		if (BlueprintNode->GetNodeGuid() != Node.GetNodeGuid())
+		{
+			continue;
+		}
+
+		const FArrayProperty* HandlerProperty = FindFProperty<FArrayProperty>(Property->Struct, HandlerName);
+		if (HandlerProperty && IsNodeFunctionHandlerArray(HandlerProperty))
+		{
+			const TArray<FSMExposedFunctionHandler>& Handlers = *HandlerProperty->ContainerPtrToValuePtr<TArray<FSMExposedFunctionHandler>>(BlueprintNode);
+			if (Handlers.IsValidIndex(HandlerIndex))
+			{
+				return TTuple<FStructProperty*, UFunction*>(Property, FindFunction(Handlers[HandlerIndex].BoundFunction));
+			}
+		}
+
+		break;
+	}
+
+	return TTuple<FStructProperty*, UFunction*>(nullptr, nullptr);
+}
+
 void USMInstance::REP_StartChanged()
 {
 	if (IsInitialized())
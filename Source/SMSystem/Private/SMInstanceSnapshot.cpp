@@ -0,0 +1,121 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#include "SMInstanceSnapshot.h"
+
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+#include "UObject/UnrealType.h"
+
+FArchive& operator<<(FArchive& Ar, FSMNodeSnapshot& Snapshot)
+{
+	Ar << Snapshot.Guid;
+	Ar << Snapshot.TimeInState;
+	Ar << Snapshot.ServerTimeInState;
+	Ar << Snapshot.StartTime;
+	Ar << Snapshot.Flags;
+	Ar << Snapshot.ActiveStates;
+	Ar << Snapshot.NodeInstanceData;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FSMInstanceRecord& Record)
+{
+	Ar << Record.RootGuid;
+
+	uint8 bHasStarted = Record.bHasStarted;
+	Ar << bHasStarted;
+	Record.bHasStarted = bHasStarted != 0;
+
+	int32 NumHistory = Record.StateHistory.Num();
+	Ar << NumHistory;
+	if (Ar.IsLoading())
+	{
+		Record.StateHistory.SetNum(NumHistory);
+	}
+
+	for (FSMStateHistory& History : Record.StateHistory)
+	{
+		Ar << History.StateGuid;
+		Ar << History.StartTime;
+		Ar << History.TimeInState;
+		Ar << History.ServerTimeInState;
+	}
+
+	Ar << Record.InstanceData;
+	Ar << Record.Nodes;
+	return Ar;
+}
+
+void FSMInstanceSnapshot::Serialize(FArchive& Ar)
+{
+	Ar << Version;
+	if (Ar.IsLoading() && (Version <= 0 || Version > static_cast<int32>(ESMInstanceSnapshotVersion::LatestVersion)))
+	{
+		Ar.SetError();
+		return;
+	}
+
+	Ar << ClassPath;
+	Ar << Instances;
+}
+
+void FSMInstanceSnapshot::SaveToBytes(TArray<uint8>& OutBytes)
+{
+	OutBytes.Reset();
+	FMemoryWriter Writer(OutBytes);
+	Serialize(Writer);
+}
+
+bool FSMInstanceSnapshot::LoadFromBytes(const TArray<uint8>& InBytes)
+{
+	FMemoryReader Reader(InBytes);
+	Serialize(Reader);
+
+	if (Reader.IsError())
+	{
+		Instances.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+bool FSMInstanceSnapshot::HasSaveGameProperties(const UClass* Class)
+{
+	if (Class)
+	{
+		for (TFieldIterator<FProperty> It(Class); It; ++It)
+		{
+			if (It->HasAnyPropertyFlags(CPF_SaveGame))
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void FSMInstanceSnapshot::SaveSaveGameProperties(UObject* Object, TArray<uint8>& OutBytes)
+{
+	check(IsInGameThread());
+
+	OutBytes.Reset();
+	FMemoryWriter Writer(OutBytes);
+	FObjectAndNameAsStringProxyArchive Ar(Writer, true);
+	Ar.ArIsSaveGame = true;
+	Ar.ArNoDelta = true;
+	Object->SerializeScriptProperties(Ar);
+}
+
+void FSMInstanceSnapshot::LoadSaveGameProperties(UObject* Object, const TArray<uint8>& InBytes)
+{
+	check(IsInGameThread());
+
+	FMemoryReader Reader(InBytes);
+	FObjectAndNameAsStringProxyArchive Ar(Reader, true);
+	Ar.ArIsSaveGame = true;
+	Ar.ArNoDelta = true;
+	Object->SerializeScriptProperties(Ar);
+}
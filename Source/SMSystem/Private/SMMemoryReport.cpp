@@ -0,0 +1,225 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#include "SMMemoryReport.h"
+#include "SMInstance.h"
+#include "SMLogging.h"
+
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/ArchiveCountMem.h"
+#include "UObject/UObjectIterator.h"
+
+static FAutoConsoleCommand MemReportCommand(
+	TEXT("LogicDriver.MemReport"),
+	TEXT("Log the estimated memory of live state machine instances per class. Usage: LogicDriver.MemReport [Rows=20] [-Csv[=File]]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		int32 MaxRows = 20;
+		FString CsvFilename;
+		for (const FString& Arg : Args)
+		{
+			if (FParse::Value(*Arg, TEXT("Rows="), MaxRows))
+			{
+				continue;
+			}
+			if (Arg.StartsWith(TEXT("-Csv")))
+			{
+				if (!Arg.Split(TEXT("="), nullptr, &CsvFilename))
+				{
+					CsvFilename = FSMMemoryReport::GetDefaultCsvFilename();
+				}
+			}
+		}
+
+		const TArray<FSMMemoryUsage> Usages = FSMMemoryReport::GetClassMemoryUsage();
+		LD_LOG_INFO(TEXT("%s%s"), LINE_TERMINATOR, *FSMMemoryReport::ToTable(Usages, MaxRows));
+
+		if (!CsvFilename.IsEmpty())
+		{
+			if (FFileHelper::SaveStringToFile(FSMMemoryReport::ToCsv(Usages), *CsvFilename))
+			{
+				LD_LOG_INFO(TEXT("Saved memory report to %s."), *CsvFilename);
+			}
+			else
+			{
+				LD_LOG_WARNING(TEXT("Could not save memory report to %s."), *CsvFilename);
+			}
+		}
+	}));
+
+/** The object's class size and the memory its serialized containers allocate. */
+static SIZE_T GetObjectBytes(UObject* Object)
+{
+	if (Object == nullptr)
+	{
+		return 0;
+	}
+
+	FArchiveCountMem CountMem(Object);
+	return Object->GetClass()->GetStructureSize() + CountMem.GetMax();
+}
+
+void FSMMemoryUsage::Accumulate(const FSMMemoryUsage& Other)
+{
+	NumInstances += Other.NumInstances;
+	NumReferenceInstances += Other.NumReferenceInstances;
+	NumNodes += Other.NumNodes;
+	NumNodeInstances += Other.NumNodeInstances;
+	InstanceBytes += Other.InstanceBytes;
+	NodeStructBytes += Other.NodeStructBytes;
+	NodeInstanceBytes += Other.NodeInstanceBytes;
+	GraphPropertyBytes += Other.GraphPropertyBytes;
+	GuidMapBytes += Other.GuidMapBytes;
+	StateHistoryBytes += Other.StateHistoryBytes;
+}
+
+FSMMemoryUsage FSMMemoryReport::GetInstanceMemoryUsage(const USMInstance* Instance)
+{
+	FSMMemoryUsage Usage;
+	if (Instance == nullptr)
+	{
+		return Usage;
+	}
+
+	Usage.ClassName = Instance->GetClass()->GetName();
+	Usage.NumInstances = 1;
+	Usage.NumReferenceInstances = Instance->GetReferenceOwnerConst() != nullptr ? 1 : 0;
+
+	// Compiled nodes are properties of the instance. Their struct size is reported with the nodes instead of the instance.
+	const SIZE_T ClassSize = Instance->GetClass()->GetStructureSize();
+	const UPTRINT InstanceStart = reinterpret_cast<UPTRINT>(Instance);
+	SIZE_T EmbeddedNodeBytes = 0;
+	
+	TSet<const UObject*> CountedNodeInstances;
+	for (const TPair<FGuid, FSMNode_Base*>& KeyVal : Instance->GetNodeMap())
+	{
+		const FSMNode_Base* Node = KeyVal.Value;
+		if (Node == nullptr || Node->GetOwningInstance() != Instance)
+		{
+			continue;
+		}
+
+		Usage.NumNodes++;
+		const SIZE_T NodeStructSize = Node->GetNodeStructSize();
+		Usage.NodeStructBytes += NodeStructSize + Node->GetAllocatedSize();
+
+		const UPTRINT NodeStart = reinterpret_cast<UPTRINT>(Node);
+		if (NodeStart >= InstanceStart && NodeStart + NodeStructSize <= InstanceStart + ClassSize)
+		{
+			EmbeddedNodeBytes += NodeStructSize;
+		}
+
+		Usage.GraphPropertyBytes += Node->GetGraphPropertiesAllocatedSize();
+
+		TArray<USMNodeInstance*, TInlineAllocator<4>> NodeInstances;
+		NodeInstances.Add(Node->GetNodeInstanceIfCreated());
+		NodeInstances.Append(Node->GetStackInstances());
+		for (USMNodeInstance* NodeInstance : NodeInstances)
+		{
+			if (NodeInstance && !CountedNodeInstances.Contains(NodeInstance))
+			{
+				CountedNodeInstances.Add(NodeInstance);
+				Usage.NumNodeInstances++;
+				Usage.NodeInstanceBytes += GetObjectBytes(NodeInstance);
+			}
+		}
+	}
+
+	Usage.InstanceBytes = ClassSize - FMath::Min(EmbeddedNodeBytes, ClassSize);
+	Usage.GuidMapBytes = Instance->GetNodeMap().GetAllocatedSize() + Instance->GetStateMap().GetAllocatedSize() +
+		Instance->GetTransitionMap().GetAllocatedSize();
+	Usage.StateHistoryBytes = Instance->GetStateHistory().GetAllocatedSize();
+
+	return Usage;
+}
+
+TArray<FSMMemoryUsage> FSMMemoryReport::GetClassMemoryUsage()
+{
+	TMap<const UClass*, FSMMemoryUsage> ClassUsages;
+	for (TObjectIterator<USMInstance> It(RF_ClassDefaultObject | RF_ArchetypeObject, true, EInternalObjectFlags::PendingKill); It; ++It)
+	{
+		const USMInstance* Instance = *It;
+
+		const FSMMemoryUsage InstanceUsage = GetInstanceMemoryUsage(Instance);
+
+		FSMMemoryUsage& ClassUsage = ClassUsages.FindOrAdd(Instance->GetClass());
+		ClassUsage.ClassName = InstanceUsage.ClassName;
+		ClassUsage.Accumulate(InstanceUsage);
+	}
+
+	TArray<FSMMemoryUsage> Usages;
+	ClassUsages.GenerateValueArray(Usages);
+	Usages.Sort([](const FSMMemoryUsage& A, const FSMMemoryUsage& B)
+	{
+		return A.GetTotalBytes() > B.GetTotalBytes();
+	});
+
+	return Usages;
+}
+
+FSMMemoryUsage FSMMemoryReport::GetTotal(const TArray<FSMMemoryUsage>& Usages)
+{
+	FSMMemoryUsage Total;
+	Total.ClassName = TEXT("Total");
+	for (const FSMMemoryUsage& Usage : Usages)
+	{
+		Total.Accumulate(Usage);
+	}
+
+	return Total;
+}
+
+static FString ToKB(SIZE_T Bytes)
+{
+	return FString::Printf(TEXT("%.1f"), Bytes / 1024.0);
+}
+
+FString FSMMemoryReport::ToTable(const TArray<FSMMemoryUsage>& Usages, int32 MaxRows)
+{
+	TArray<FString> Lines;
+	Lines.Add(FString::Printf(TEXT("%-40s %9s %6s %7s %9s %12s %12s %12s %12s %12s %12s %12s"), TEXT("Class"), TEXT("Instances"),
+		TEXT("Refs"), TEXT("Nodes"), TEXT("NodeInsts"), TEXT("Total(KB)"), TEXT("Instance(KB)"), TEXT("Nodes(KB)"), TEXT("NodeInst(KB)"),
+		TEXT("GraphProp(KB)"), TEXT("GuidMaps(KB)"), TEXT("History(KB)")));
+
+	auto AddRow = [&Lines](const FSMMemoryUsage& Usage)
+	{
+		Lines.Add(FString::Printf(TEXT("%-40s %9d %6d %7d %9d %12s %12s %12s %12s %12s %12s %12s"), *Usage.ClassName, Usage.NumInstances,
+			Usage.NumReferenceInstances, Usage.NumNodes, Usage.NumNodeInstances, *ToKB(Usage.GetTotalBytes()), *ToKB(Usage.InstanceBytes),
+			*ToKB(Usage.NodeStructBytes), *ToKB(Usage.NodeInstanceBytes), *ToKB(Usage.GraphPropertyBytes), *ToKB(Usage.GuidMapBytes),
+			*ToKB(Usage.StateHistoryBytes)));
+	};
+
+	const int32 NumRows = MaxRows > 0 ? FMath::Min(MaxRows, Usages.Num()) : Usages.Num();
+	for (int32 Idx = 0; Idx < NumRows; ++Idx)
+	{
+		AddRow(Usages[Idx]);
+	}
+
+	AddRow(GetTotal(Usages));
+	Lines.Add(FString::Printf(TEXT("%d of %d state machine classes."), NumRows, Usages.Num()));
+
+	return FString::Join(Lines, LINE_TERMINATOR);
+}
+
+FString FSMMemoryReport::ToCsv(const TArray<FSMMemoryUsage>& Usages)
+{
+	TArray<FString> Lines;
+	Lines.Add(TEXT("Class,Instances,ReferenceInstances,Nodes,NodeInstances,TotalBytes,InstanceBytes,NodeStructBytes,NodeInstanceBytes,GraphPropertyBytes,GuidMapBytes,StateHistoryBytes"));
+
+	for (const FSMMemoryUsage& Usage : Usages)
+	{
+		Lines.Add(FString::Printf(TEXT("%s,%d,%d,%d,%d,%llu,%llu,%llu,%llu,%llu,%llu,%llu"), *Usage.ClassName, Usage.NumInstances,
+			Usage.NumReferenceInstances, Usage.NumNodes, Usage.NumNodeInstances, static_cast<uint64>(Usage.GetTotalBytes()),
+			static_cast<uint64>(Usage.InstanceBytes), static_cast<uint64>(Usage.NodeStructBytes), static_cast<uint64>(Usage.NodeInstanceBytes),
+			static_cast<uint64>(Usage.GraphPropertyBytes), static_cast<uint64>(Usage.GuidMapBytes), static_cast<uint64>(Usage.StateHistoryBytes)));
+	}
+
+	return FString::Join(Lines, LINE_TERMINATOR);
+}
+
+FString FSMMemoryReport::GetDefaultCsvFilename()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("LogicDriver"), TEXT("MemReports"),
+		FString::Printf(TEXT("MemReport-%s.csv"), *FDateTime::Now().ToString()));
+}
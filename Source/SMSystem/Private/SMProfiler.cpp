@@ -0,0 +1,312 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#include "SMProfiler.h"
+#include "SMLogging.h"
+
+#include "HAL/PlatformTime.h"
+
+double FSMProfileStat::GetTotalMs() const
+{
+	return static_cast<double>(TotalCycles) * FPlatformTime::GetSecondsPerCycle64() * 1000.0;
+}
+
+double FSMProfileStat::GetSelfMs() const
+{
+	return static_cast<double>(SelfCycles) * FPlatformTime::GetSecondsPerCycle64() * 1000.0;
+}
+
+double FSMProfileStat::GetPeakMs() const
+{
+	return static_cast<double>(PeakCycles) * FPlatformTime::GetSecondsPerCycle64() * 1000.0;
+}
+
+double FSMProfileStat::GetAverageMs() const
+{
+	return Count > 0 ? GetTotalMs() / Count : 0.0;
+}
+
+#if LOGICDRIVER_PROFILER_ENABLED
+
+#include "SMNode_Base.h"
+#include "SMInstance.h"
+
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+static FAutoConsoleCommand ProfileCommand(
+	TEXT("LogicDriver.Profile"),
+	TEXT("Profile state machine nodes across all instances. Usage: LogicDriver.Profile Start|Stop|Dump [Rows=20] [Sort=TransitionPass|StateUpdate|GraphProperties|GraphFunction] [-Csv[=File]]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		FSMProfiler& Profiler = FSMProfiler::Get();
+
+		const FString Action = Args.Num() > 0 ? Args[0] : FString(TEXT("Dump"));
+		if (Action.Equals(TEXT("Start"), ESearchCase::IgnoreCase))
+		{
+			Profiler.Start();
+			LD_LOG_INFO(TEXT("Logic Driver profiling started."));
+			return;
+		}
+
+		if (Action.Equals(TEXT("Stop"), ESearchCase::IgnoreCase))
+		{
+			Profiler.Stop();
+			LD_LOG_INFO(TEXT("Logic Driver profiling stopped."));
+		}
+		else if (!Action.Equals(TEXT("Dump"), ESearchCase::IgnoreCase))
+		{
+			LD_LOG_WARNING(TEXT("Unknown profile action %s. Use Start, Stop or Dump."), *Action);
+			return;
+		}
+
+		int32 MaxRows = 20;
+		ESMProfileCategory SortCategory = ESMProfileCategory::Max;
+		FString CsvFilename;
+		for (int32 Idx = 1; Idx < Args.Num(); ++Idx)
+		{
+			const FString& Arg = Args[Idx];
+			FString Value;
+			if (FParse::Value(*Arg, TEXT("Rows="), MaxRows))
+			{
+				continue;
+			}
+			if (FParse::Value(*Arg, TEXT("Sort="), Value))
+			{
+				for (uint8 Category = 0; Category < static_cast<uint8>(ESMProfileCategory::Max); ++Category)
+				{
+					if (Value.Equals(FSMProfiler::GetCategoryName(static_cast<ESMProfileCategory>(Category)), ESearchCase::IgnoreCase))
+					{
+						SortCategory = static_cast<ESMProfileCategory>(Category);
+					}
+				}
+			}
+			else if (Arg.StartsWith(TEXT("-Csv")))
+			{
+				if (!Arg.Split(TEXT("="), nullptr, &CsvFilename))
+				{
+					CsvFilename = FSMProfiler::GetDefaultCsvFilename();
+				}
+			}
+		}
+
+		LD_LOG_INFO(TEXT("%s%s"), LINE_TERMINATOR, *Profiler.ToTable(MaxRows, SortCategory));
+
+		if (!CsvFilename.IsEmpty())
+		{
+			if (FFileHelper::SaveStringToFile(Profiler.ToCsv(SortCategory), *CsvFilename))
+			{
+				LD_LOG_INFO(TEXT("Saved profile to %s."), *CsvFilename);
+			}
+			else
+			{
+				LD_LOG_WARNING(TEXT("Could not save profile to %s."), *CsvFilename);
+			}
+		}
+	}));
+
+bool FSMProfiler::bIsProfiling = false;
+
+FSMProfiler& FSMProfiler::Get()
+{
+	static FSMProfiler Profiler;
+	return Profiler;
+}
+
+void FSMProfiler::Start()
+{
+	check(IsInGameThread());
+
+	FScopeLock Lock(&CriticalSection);
+	Session++;
+	ProfileMap.Reset();
+	Profiles.Reset();
+	bIsProfiling = true;
+}
+
+void FSMProfiler::Stop()
+{
+	bIsProfiling = false;
+}
+
+FSMProfileScope*& FSMProfiler::GetCurrentScope()
+{
+	static thread_local FSMProfileScope* CurrentScope = nullptr;
+	return CurrentScope;
+}
+
+void FSMProfiler::Record(const FSMNode_Base& Node, ESMProfileCategory Category, int64 Cycles, int64 SelfCycles, bool bPassed)
+{
+	const USMInstance* Instance = Node.GetOwningInstance();
+	FSMNodeProfile* Profile = Node.CachedProfile;
+	if (Profile == nullptr || Node.CachedProfileSession != Session || Instance == nullptr || Profile->InstanceClass != Instance->GetClass())
+	{
+		Profile = FindOrAddProfile(Node);
+		if (Profile == nullptr)
+		{
+			return;
+		}
+
+		Node.CachedProfile = Profile;
+		Node.CachedProfileSession = Session;
+	}
+
+	FSMProfileStat& Stat = Profile->Stats[static_cast<uint8>(Category)];
+	FPlatformAtomics::InterlockedIncrement(&Stat.Count);
+	FPlatformAtomics::InterlockedAdd(&Stat.TotalCycles, Cycles);
+	FPlatformAtomics::InterlockedAdd(&Stat.SelfCycles, SelfCycles);
+	if (bPassed)
+	{
+		FPlatformAtomics::InterlockedIncrement(&Stat.Passes);
+	}
+
+	int64 Peak = Stat.PeakCycles;
+	while (Cycles > Peak)
+	{
+		const int64 Previous = FPlatformAtomics::InterlockedCompareExchange(&Stat.PeakCycles, Cycles, Peak);
+		if (Previous == Peak)
+		{
+			break;
+		}
+		Peak = Previous;
+	}
+}
+
+FSMNodeProfile* FSMProfiler::FindOrAddProfile(const FSMNode_Base& Node)
+{
+	const USMInstance* Instance = Node.GetOwningInstance();
+	if (Instance == nullptr)
+	{
+		return nullptr;
+	}
+
+	const TPair<const UClass*, FGuid> Key(Instance->GetClass(), Node.GetGuid());
+
+	FScopeLock Lock(&CriticalSection);
+	if (FSMNodeProfile** ExistingProfile = ProfileMap.Find(Key))
+	{
+		return *ExistingProfile;
+	}
+
+	TUniquePtr<FSMNodeProfile>& NewProfile = Profiles.Add_GetRef(MakeUnique<FSMNodeProfile>());
+	NewProfile->InstanceClass = Key.Key;
+	NewProfile->ClassName = Key.Key->GetName();
+	NewProfile->NodeName = Node.GetNodeName();
+	NewProfile->NodeGuid = Key.Value;
+
+	return ProfileMap.Add(Key, NewProfile.Get());
+}
+
+TArray<const FSMNodeProfile*> FSMProfiler::GetSortedProfiles(ESMProfileCategory SortCategory) const
+{
+	TArray<const FSMNodeProfile*> SortedProfiles;
+
+	FScopeLock Lock(&CriticalSection);
+	SortedProfiles.Reserve(Profiles.Num());
+	for (const TUniquePtr<FSMNodeProfile>& Profile : Profiles)
+	{
+		SortedProfiles.Add(Profile.Get());
+	}
+
+	auto GetSortCycles = [SortCategory](const FSMNodeProfile& Profile)
+	{
+		if (SortCategory != ESMProfileCategory::Max)
+		{
+			return Profile.GetStat(SortCategory).TotalCycles;
+		}
+
+		// Nested categories are already part of their parent's total.
+		int64 SelfCycles = 0;
+		for (const FSMProfileStat& Stat : Profile.Stats)
+		{
+			SelfCycles += Stat.SelfCycles;
+		}
+		return SelfCycles;
+	};
+
+	SortedProfiles.Sort([&GetSortCycles](const FSMNodeProfile& A, const FSMNodeProfile& B)
+	{
+		return GetSortCycles(A) > GetSortCycles(B);
+	});
+
+	return SortedProfiles;
+}
+
+FString FSMProfiler::ToTable(int32 MaxRows, ESMProfileCategory SortCategory) const
+{
+	TArray<FString> Lines;
+	Lines.Add(FString::Printf(TEXT("%-40s %-32s %-16s %10s %10s %12s %12s %10s %10s"), TEXT("Class"), TEXT("Node"), TEXT("Category"),
+		TEXT("Count"), TEXT("Passes"), TEXT("Total(ms)"), TEXT("Self(ms)"), TEXT("Avg(ms)"), TEXT("Peak(ms)")));
+
+	const TArray<const FSMNodeProfile*> SortedProfiles = GetSortedProfiles(SortCategory);
+	const int32 NumRows = MaxRows > 0 ? FMath::Min(MaxRows, SortedProfiles.Num()) : SortedProfiles.Num();
+	for (int32 Idx = 0; Idx < NumRows; ++Idx)
+	{
+		const FSMNodeProfile& Profile = *SortedProfiles[Idx];
+		for (uint8 Category = 0; Category < static_cast<uint8>(ESMProfileCategory::Max); ++Category)
+		{
+			const FSMProfileStat& Stat = Profile.Stats[Category];
+			if (Stat.Count == 0)
+			{
+				continue;
+			}
+
+			Lines.Add(FString::Printf(TEXT("%-40s %-32s %-16s %10lld %10lld %12.3f %12.3f %10.4f %10.4f"), *Profile.ClassName, *Profile.NodeName,
+				GetCategoryName(static_cast<ESMProfileCategory>(Category)), Stat.Count, Stat.Passes, Stat.GetTotalMs(), Stat.GetSelfMs(),
+				Stat.GetAverageMs(), Stat.GetPeakMs()));
+		}
+	}
+
+	Lines.Add(FString::Printf(TEXT("%d of %d profiled nodes."), NumRows, SortedProfiles.Num()));
+	return FString::Join(Lines, LINE_TERMINATOR);
+}
+
+FString FSMProfiler::ToCsv(ESMProfileCategory SortCategory) const
+{
+	TArray<FString> Lines;
+	Lines.Add(TEXT("Class,Node,NodeGuid,Category,Count,Passes,TotalMs,SelfMs,AverageMs,PeakMs"));
+
+	for (const FSMNodeProfile* Profile : GetSortedProfiles(SortCategory))
+	{
+		for (uint8 Category = 0; Category < static_cast<uint8>(ESMProfileCategory::Max); ++Category)
+		{
+			const FSMProfileStat& Stat = Profile->Stats[Category];
+			if (Stat.Count == 0)
+			{
+				continue;
+			}
+
+			Lines.Add(FString::Printf(TEXT("%s,\"%s\",%s,%s,%lld,%lld,%.4f,%.4f,%.6f,%.6f"), *Profile->ClassName,
+				*Profile->NodeName.Replace(TEXT("\""), TEXT("\"\"")), *Profile->NodeGuid.ToString(), GetCategoryName(static_cast<ESMProfileCategory>(Category)),
+				Stat.Count, Stat.Passes, Stat.GetTotalMs(), Stat.GetSelfMs(), Stat.GetAverageMs(), Stat.GetPeakMs()));
+		}
+	}
+
+	return FString::Join(Lines, LINE_TERMINATOR);
+}
+
+const TCHAR* FSMProfiler::GetCategoryName(ESMProfileCategory Category)
+{
+	switch (Category)
+	{
+	case ESMProfileCategory::TransitionPass:
+		return TEXT("TransitionPass");
+	case ESMProfileCategory::StateUpdate:
+		return TEXT("StateUpdate");
+	case ESMProfileCategory::GraphProperties:
+		return TEXT("GraphProperties");
+	case ESMProfileCategory::GraphFunction:
+		return TEXT("GraphFunction");
+	default:
+		return TEXT("All");
+	}
+}
+
+FString FSMProfiler::GetDefaultCsvFilename()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("LogicDriver"), TEXT("Profiles"),
+		FString::Printf(TEXT("Profile-%s.csv"), *FDateTime::Now().ToString()));
+}
+
+#endif
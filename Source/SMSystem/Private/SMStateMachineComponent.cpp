@@ -3,12 +3,76 @@
 #include "SMStateMachineComponent.h"
 #include "SMUtils.h"
 #include "SMLogging.h"
+#include "SMInitializationQueue.h"
 
+#include "UObject/GCObject.h"
 #include "UObject/PropertyPortFlags.h"
 #include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/NetConnection.h"
 
 #define LOCTEXT_NAMESPACE "SMStateMachineComponent"
 
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("SMPredictedTransitions"), STAT_PredictedTransitions, STATGROUP_LogicDriver);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("SMMispredictedTransitions"), STAT_MispredictedTransitions, STATGROUP_LogicDriver);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("SMNetDormantComponents"), STAT_NetDormantComponents, STATGROUP_LogicDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("SMNetDormancyFlushes"), STAT_NetDormancyFlushes, STATGROUP_LogicDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("SMInstanceReplicatedBytes"), STAT_InstanceReplicatedBytes, STATGROUP_LogicDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("SMInstanceReplicationsSkipped"), STAT_InstanceReplicationsSkipped, STATGROUP_LogicDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("SMInstancePropertyComparesSkipped"), STAT_InstancePropertyComparesSkipped, STATGROUP_LogicDriver);
+
+/** Initialized prototypes by component archetype for bInitializeFromPrototype. Released when their world is cleaned up. */
+class FSMComponentPrototypes : public FGCObject
+{
+public:
+	static FSMComponentPrototypes& Get()
+	{
+		static FSMComponentPrototypes ComponentPrototypes;
+		return ComponentPrototypes;
+	}
+
+	USMInstance* Find(USMStateMachineComponent* Archetype) const
+	{
+		return Prototypes.FindRef(Archetype);
+	}
+
+	void Add(USMStateMachineComponent* Archetype, USMInstance* Prototype)
+	{
+		Prototypes.Add(Archetype, Prototype);
+	}
+
+	// FGCObject
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override
+	{
+		Collector.AddReferencedObjects(Prototypes);
+	}
+
+	virtual FString GetReferencerName() const override
+	{
+		return TEXT("FSMComponentPrototypes");
+	}
+	// ~FGCObject
+
+private:
+	FSMComponentPrototypes()
+	{
+		FWorldDelegates::OnWorldCleanup.AddRaw(this, &FSMComponentPrototypes::OnWorldCleanup);
+	}
+
+	void OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+	{
+		for (auto It = Prototypes.CreateIterator(); It; ++It)
+		{
+			if (!It.Key() || !It.Value() || It.Value()->GetWorld() == World)
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	TMap<USMStateMachineComponent*, USMInstance*> Prototypes;
+};
+
 USMStateMachineComponent::USMStateMachineComponent(class FObjectInitializer const & ObjectInitializer)
 {
 	R_Instance = nullptr;
@@ -17,6 +81,9 @@ USMStateMachineComponent::USMStateMachineComponent(class FObjectInitializer cons
 	bWantsInitializeComponent = true;
 	bInitializeOnBeginPlay = true;
 	bStartOnBeginPlay = false;
+	bDeferInitialization = false;
+	InitializationPriority = 0;
+	bInitializeFromPrototype = false;
 	bReuseInstanceAfterShutdown = false;
 	
 	NetworkTickConfiguration = SM_Client;
@@ -26,10 +93,14 @@ USMStateMachineComponent::USMStateMachineComponent(class FObjectInitializer cons
 	TransitionResetTimeSeconds = 2.f;
 	bReplicateStatesOnLoad = true;
 	bTakeTransitionsFromServerOnly = false;
+	bPredictTransitions = false;
 	bCalculateServerTimeForClients = true;
 	bDiscardTransitionsBeforeInitialize = false;
 	bIncludeSimulatedProxies = false;
 	MaxTimeToWaitForTransitionUpdate = 2.f;
+	bManageNetDormancy = false;
+	CoarseNetRelevancyDistance = 0.f;
+	CoarseNetUpdateInterval = 1.f;
 	
 	PrimaryComponentTick.bCanEverTick = true;
 	bCanInstanceNetworkTick = true;
@@ -40,6 +111,16 @@ USMStateMachineComponent::USMStateMachineComponent(class FObjectInitializer cons
 	TickInterval_DEPRECATED = 0.f;
 
 	InstanceTemplate = nullptr;
+	PreloadInitializeContext = nullptr;
+	bInitializeAfterPreload = false;
+	bStartAfterPreload = false;
+	bInitializationPending = false;
+	bStartAfterDeferredInitialization = false;
+	LastRollbackServerTime = FDateTime(0);
+	NumConfirmedPredictions = 0;
+	NumMispredictions = 0;
+	NumReplicatedInstanceProperties = 0;
+	bIsNetDormantFromComponent = false;
 	
 	SetIsReplicatedByDefault(true);
 }
@@ -67,7 +148,11 @@ void USMStateMachineComponent::BeginPlay()
 {
 	if (bInitializeOnBeginPlay)
 	{
-		if (HasAuthority())
+		if (bDeferInitialization)
+		{
+			InitializeDeferred(bStartOnBeginPlay);
+		}
+		else if (HasAuthority())
 		{
 			DoInitialize(GetContextForInitialization());
 
@@ -85,11 +170,16 @@ void USMStateMachineComponent::BeginPlay()
 void USMStateMachineComponent::TickComponent(float DeltaTime, ELevelTick TickType,
 	FActorComponentTickFunction* ThisTickFunction)
 {
-	if (R_Instance && CanTickForEnvironment())
+	if (R_Instance && !bInitializationPending && CanTickForEnvironment())
 	{
 		DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMStateMachineComponent::Tick"), STAT_SMStateMachineComponent_Tick, STATGROUP_LogicDriver);
 		R_Instance->Tick(DeltaTime);
 	}
+
+	if (bManageNetDormancy && IsConfiguredForNetworking() && HasAuthority())
+	{
+		UpdateNetDormancy();
+	}
 	
 	if (IsRegistered())
 	{
@@ -100,7 +190,23 @@ void USMStateMachineComponent::TickComponent(float DeltaTime, ELevelTick TickTyp
 
 void USMStateMachineComponent::OnComponentDestroyed(bool bDestroyingHierarchy)
 {
+	CancelPreload();
+	CancelDeferredInitialization();
 	Shutdown();
+
+	if (bIsNetDormantFromComponent)
+	{
+		// The owner may keep replicating other components, so wake it up if this component put it to sleep.
+		AActor* Owner = GetOwner();
+		if (Owner && !Owner->IsActorBeingDestroyed() && Owner->NetDormancy == DORM_DormantAll)
+		{
+			Owner->SetNetDormancy(DORM_Awake);
+		}
+
+		DEC_DWORD_STAT(STAT_NetDormantComponents);
+		bIsNetDormantFromComponent = false;
+	}
+	
 	Super::OnComponentDestroyed(bDestroyingHierarchy);
 }
 
@@ -273,12 +379,39 @@ bool USMStateMachineComponent::ReplicateSubobjects(class UActorChannel* Channel,
 
 	if (R_Instance)
 	{
+		if (!ShouldReplicateInstanceToConnection(Channel->Connection, RepFlags->bNetInitial))
+		{
+			INC_DWORD_STAT(STAT_InstanceReplicationsSkipped);
+			INC_DWORD_STAT_BY(STAT_InstancePropertyComparesSkipped, NumReplicatedInstanceProperties);
+			return WroteSomething;
+		}
+		
+		const int64 BitsBefore = Bunch->GetNumBits();
 		WroteSomething |= Channel->ReplicateSubobject(R_Instance, *Bunch, *RepFlags);
+		INC_DWORD_STAT_BY(STAT_InstanceReplicatedBytes, static_cast<uint32>((Bunch->GetNumBits() - BitsBefore + 7) / 8));
 	}
 
 	return WroteSomething;
 }
 
+ESMNetRelevancy USMStateMachineComponent::GetNetRelevancyForConnection(const UNetConnection* Connection) const
+{
+	const AActor* Owner = GetOwner();
+	if (CoarseNetRelevancyDistance <= 0.f || !Connection || !Owner || Owner->GetNetConnection() == Connection)
+	{
+		return ESMNetRelevancy::Full;
+	}
+
+	const AActor* ViewTarget = Connection->ViewTarget;
+	if (!ViewTarget)
+	{
+		return ESMNetRelevancy::Full;
+	}
+
+	const float DistanceSquared = FVector::DistSquared(ViewTarget->GetActorLocation(), Owner->GetActorLocation());
+	return DistanceSquared > FMath::Square(CoarseNetRelevancyDistance) ? ESMNetRelevancy::Coarse : ESMNetRelevancy::Full;
+}
+
 bool USMStateMachineComponent::IsNetworked() const
 {
 	return GetNetMode() != NM_Standalone;
@@ -315,6 +448,11 @@ bool USMStateMachineComponent::CanServerProcessTransitions() const
 	return NetworkTransitionConfiguration != SM_Client || bTakeTransitionsFromServerOnly;
 }
 
+bool USMStateMachineComponent::IsPredictingTransitions() const
+{
+	return bPredictTransitions && !bTakeTransitionsFromServerOnly && IsConfiguredForNetworking();
+}
+
 AActor* USMStateMachineComponent::GetTopMostParentActor() const
 {
 	AActor* TopMostParentActor = GetOwner();
@@ -332,8 +470,107 @@ UObject* USMStateMachineComponent::GetContextForInitialization_Implementation()
 	return GetOwner();
 }
 
+void USMStateMachineComponent::PreloadStateMachineClass(TSoftClassPtr<USMInstance> InStateMachineClass)
+{
+	// Deferred calls carry over to the new class.
+	if (PreloadRequest.IsValid())
+	{
+		PreloadRequest->Cancel();
+	}
+
+	// Assign the request before starting it. An unset class or one that can't be requested completes immediately.
+	PreloadRequest = MakeShared<FSMPreloadRequest>(InStateMachineClass,
+		FSimpleDelegate::CreateUObject(this, &USMStateMachineComponent::OnStateMachineClassPreloaded));
+	PreloadRequest->Start();
+}
+
+bool USMStateMachineComponent::IsPreloadingStateMachineClass() const
+{
+	return PreloadRequest.IsValid() && !PreloadRequest->IsComplete();
+}
+
+void USMStateMachineComponent::OnStateMachineClassPreloaded()
+{
+	if (PreloadRequest.IsValid() && PreloadRequest->GetStateMachineClass())
+	{
+		StateMachineClass = PreloadRequest->GetStateMachineClass();
+
+		// An instance created from a previous class during InitializeComponent is replaced.
+		if (R_Instance && !R_Instance->IsInitialized() && R_Instance->GetClass() != StateMachineClass)
+		{
+			R_Instance = nullptr;
+		}
+	}
+	
+	OnStateMachineClassPreloadedEvent.Broadcast(StateMachineClass);
+
+	UObject* Context = PreloadInitializeContext;
+	const bool bInitialize = bInitializeAfterPreload;
+	const bool bStart = bStartAfterPreload;
+	PreloadInitializeContext = nullptr;
+	bInitializeAfterPreload = bStartAfterPreload = false;
+
+	if (bInitialize)
+	{
+		DoInitialize(Context ? Context : GetContextForInitialization());
+	}
+
+	if (bStart)
+	{
+		DoStart();
+	}
+}
+
+void USMStateMachineComponent::CancelPreload()
+{
+	if (PreloadRequest.IsValid())
+	{
+		PreloadRequest->Cancel();
+		PreloadRequest.Reset();
+	}
+
+	PreloadInitializeContext = nullptr;
+	bInitializeAfterPreload = bStartAfterPreload = false;
+}
+
+void USMStateMachineComponent::InitializeDeferred(bool bStartWhenInitialized)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	bInitializationPending = true;
+	bStartAfterDeferredInitialization = bStartWhenInitialized;
+	FSMInitializationQueue::Get().Enqueue(this, InitializationPriority);
+}
+
+void USMStateMachineComponent::ProcessDeferredInitialization()
+{
+	const bool bStart = bStartAfterDeferredInitialization;
+	CancelDeferredInitialization();
+
+	DoInitialize(GetContextForInitialization());
+
+	if (bStart)
+	{
+		DoStart();
+	}
+}
+
+void USMStateMachineComponent::CancelDeferredInitialization()
+{
+	if (bInitializationPending)
+	{
+		FSMInitializationQueue::Get().Remove(this);
+		bInitializationPending = false;
+	}
+	bStartAfterDeferredInitialization = false;
+}
+
 void USMStateMachineComponent::Internal_OnStateMachineStarted(USMInstance* Instance)
 {
+	FlushNetDormancyIfManaged();
 	OnStateMachineStartedEvent.Broadcast(Instance);
 }
 
@@ -344,6 +581,7 @@ void USMStateMachineComponent::Internal_OnStateMachineUpdated(USMInstance* Insta
 
 void USMStateMachineComponent::Internal_OnStateMachineStopped(USMInstance* Instance)
 {
+	FlushNetDormancyIfManaged();
 	OnStateMachineStoppedEvent.Broadcast(Instance);
 }
 
@@ -355,6 +593,7 @@ void USMStateMachineComponent::Internal_OnStateMachineTransitionTaken(USMInstanc
 void USMStateMachineComponent::Internal_OnStateMachineStateChanged(USMInstance* Instance, FSMStateInfo ToState,
 	FSMStateInfo FromState)
 {
+	FlushNetDormancyIfManaged();
 	OnStateMachineStateChangedEvent.Broadcast(Instance, ToState, FromState);
 }
 
@@ -374,6 +613,17 @@ void USMStateMachineComponent::PostInitialize()
 	// Configure network settings after initialization.
 	ConfigureInstanceNetworkSettings();
 
+	NumReplicatedInstanceProperties = 0;
+	for (TFieldIterator<FProperty> It(R_Instance->GetClass()); It; ++It)
+	{
+		if (It->HasAnyPropertyFlags(CPF_Net))
+		{
+			++NumReplicatedInstanceProperties;
+		}
+	}
+	
+	FlushNetDormancyIfManaged();
+
 	// Allow child blueprint components to run specific initalize logic.
 	OnPostInitialize();
 	
@@ -572,6 +822,19 @@ void USMStateMachineComponent::ProcessTransaction(const TArray<FSMNetworkedTrans
 		return;
 	}
 
+	if (IsPredictingTransitions())
+	{
+		// These transitions have already been taken locally.
+		for (const FSMNetworkedTransaction& Transaction : Transactions)
+		{
+			if (Transaction.IsTransition())
+			{
+				PendingPredictions.Add(Transaction.TransactionGuid);
+				INC_DWORD_STAT(STAT_PredictedTransitions);
+			}
+		}
+	}
+
 	SERVER_ProcessTransaction(Transactions);
 }
 
@@ -739,8 +1002,63 @@ USMInstance* USMStateMachineComponent::CreateInstance(UObject* Context)
 	return R_Instance;
 }
 
+USMInstance* USMStateMachineComponent::GetOrCreatePrototype(UObject* Context)
+{
+	UWorld* World = Context ? Context->GetWorld() : nullptr;
+	if (!StateMachineClass || !World)
+	{
+		return nullptr;
+	}
+
+	USMStateMachineComponent* Archetype = IsTemplate() ? this : CastChecked<USMStateMachineComponent>(GetArchetype());
+
+	FSMComponentPrototypes& ComponentPrototypes = FSMComponentPrototypes::Get();
+	USMInstance* Prototype = ComponentPrototypes.Find(Archetype);
+	if (Prototype && Prototype->GetClass() == StateMachineClass && Prototype->IsInitialized() && !Prototype->IsActive())
+	{
+		return Prototype;
+	}
+
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMStateMachineComponent::CreatePrototype"), STAT_SMStateMachineComponent_CreatePrototype, STATGROUP_LogicDriver);
+
+	// Owned by the transient package so it outlives the component it was created for. The world is used as the context
+	// so the prototype doesn't keep a gameplay actor alive.
+	USMInstance* Template = Archetype->InstanceTemplate && Archetype->InstanceTemplate->GetClass() == StateMachineClass ? Archetype->InstanceTemplate : nullptr;
+	Prototype = NewObject<USMInstance>(GetTransientPackage(), StateMachineClass, NAME_None, RF_Transient, Template);
+	Prototype->InitializeAsPrototype(World);
+
+	if (!Prototype->IsInitialized())
+	{
+		return nullptr;
+	}
+
+	ComponentPrototypes.Add(Archetype, Prototype);
+	return Prototype;
+}
+
 void USMStateMachineComponent::DoInitialize(UObject* Context)
 {
+	if (IsInitializationPending())
+	{
+		// An explicit Initialize takes over from the queue, keeping any deferred Start.
+		const bool bStart = bStartAfterDeferredInitialization;
+		CancelDeferredInitialization();
+		DoInitialize(Context);
+
+		if (bStart)
+		{
+			DoStart();
+		}
+		return;
+	}
+	
+	if (IsPreloadingStateMachineClass())
+	{
+		PreloadInitializeContext = Context;
+		bInitializeAfterPreload = true;
+		return;
+	}
+	
 	if (!R_Instance)
 	{
 		bool bCanContinue = false;
@@ -763,7 +1081,15 @@ void USMStateMachineComponent::DoInitialize(UObject* Context)
 		R_Instance->Rename(*R_Instance->GetName(), Context, REN_DoNotDirty | REN_DontCreateRedirectors);
 	}
 
-	R_Instance->Initialize(Context);
+	USMInstance* Prototype = bInitializeFromPrototype ? GetOrCreatePrototype(Context) : nullptr;
+	if (Prototype)
+	{
+		R_Instance->InitializeFromPrototype(Prototype, Context);
+	}
+	else
+	{
+		R_Instance->Initialize(Context);
+	}
 
 	bCanInstanceNetworkTick = R_Instance->CanEverTick();
 	R_Instance->SetRegisterTick(bLetInstanceManageTick);
@@ -773,6 +1099,18 @@ void USMStateMachineComponent::DoInitialize(UObject* Context)
 
 void USMStateMachineComponent::DoStart()
 {
+	if (IsPreloadingStateMachineClass())
+	{
+		bStartAfterPreload = true;
+		return;
+	}
+
+	if (IsInitializationPending())
+	{
+		bStartAfterDeferredInitialization = true;
+		return;
+	}
+	
 	if (!R_Instance)
 	{
 		return;
@@ -783,7 +1121,7 @@ void USMStateMachineComponent::DoStart()
 
 void USMStateMachineComponent::DoUpdate(float DeltaTime)
 {
-	if (!R_Instance)
+	if (!R_Instance || bInitializationPending)
 	{
 		return;
 	}
@@ -793,6 +1131,8 @@ void USMStateMachineComponent::DoUpdate(float DeltaTime)
 
 void USMStateMachineComponent::DoStop()
 {
+	bStartAfterDeferredInitialization = false;
+	
 	if (!R_Instance)
 	{
 		return;
@@ -804,6 +1144,11 @@ void USMStateMachineComponent::DoStop()
 void USMStateMachineComponent::DoShutdown()
 {
 	PendingTransactions.Empty();
+	PendingPredictions.Empty();
+	CoarseConnectionUpdateTimes.Empty();
+	FlushNetDormancyIfManaged();
+	CancelPreload();
+	CancelDeferredInitialization();
 	
 	if (!R_Instance)
 	{
@@ -967,6 +1312,92 @@ void USMStateMachineComponent::SendTransactionsToClients(const TArray<FSMNetwork
 	}
 	
 	R_NetworkedTransactions.Append(Transactions);
+	FlushNetDormancyIfManaged();
+}
+
+bool USMStateMachineComponent::ShouldReplicateInstanceToConnection(UNetConnection* Connection, bool bNetInitial)
+{
+	if (GetNetRelevancyForConnection(Connection) == ESMNetRelevancy::Full)
+	{
+		CoarseConnectionUpdateTimes.Remove(Connection);
+		return true;
+	}
+
+	const UWorld* World = GetWorld();
+	const float CurrentTime = World ? World->GetTimeSeconds() : 0.f;
+
+	float* LastUpdateTime = CoarseConnectionUpdateTimes.Find(Connection);
+	if (bNetInitial || !LastUpdateTime || CurrentTime - *LastUpdateTime >= CoarseNetUpdateInterval)
+	{
+		// Connections are only purged when a new one is added so the map never outgrows the connected clients.
+		if (!LastUpdateTime)
+		{
+			for (auto It = CoarseConnectionUpdateTimes.CreateIterator(); It; ++It)
+			{
+				if (!It.Key().IsValid())
+				{
+					It.RemoveCurrent();
+				}
+			}
+		}
+
+		CoarseConnectionUpdateTimes.Add(Connection, CurrentTime);
+		return true;
+	}
+
+	return false;
+}
+
+void USMStateMachineComponent::FlushNetDormancyIfManaged()
+{
+	if (!bManageNetDormancy || !IsConfiguredForNetworking() || !HasAuthority())
+	{
+		return;
+	}
+
+	AActor* Owner = GetOwner();
+	if (Owner && Owner->NetDormancy > DORM_Awake)
+	{
+		Owner->FlushNetDormancy();
+		INC_DWORD_STAT(STAT_NetDormancyFlushes);
+	}
+}
+
+void USMStateMachineComponent::UpdateNetDormancy()
+{
+	AActor* Owner = GetOwner();
+	if (!Owner)
+	{
+		return;
+	}
+
+	if (Owner->NetDormancy == DORM_DormantAll)
+	{
+		return;
+	}
+
+	if (bIsNetDormantFromComponent)
+	{
+		// Woken up elsewhere.
+		DEC_DWORD_STAT(STAT_NetDormantComponents);
+		bIsNetDormantFromComponent = false;
+	}
+
+	if (Owner->NetDormancy != DORM_Awake)
+	{
+		// Dormancy is being managed by something else.
+		return;
+	}
+	
+	// Transactions stay replicated until they expire so late updates can still reach clients.
+	RemoveExpiredTransactions(FDateTime::UtcNow());
+	if (R_NetworkedTransactions.Num() == 0)
+	{
+		// The channel sends any unacknowledged changes before closing.
+		Owner->SetNetDormancy(DORM_DormantAll);
+		INC_DWORD_STAT(STAT_NetDormantComponents);
+		bIsNetDormantFromComponent = true;
+	}
 }
 
 void USMStateMachineComponent::RemoveExpiredTransactions(const FDateTime& CurrentTime)
@@ -992,6 +1423,59 @@ void USMStateMachineComponent::RemoveExpiredTransactions(const FDateTime& Curren
 	}
 }
 
+void USMStateMachineComponent::ProcessPredictedTransactions(const TArray<FSMNetworkedTransaction>& Transactions)
+{
+	TArray<FGuid> RejectedTransactions;
+	for (const FSMNetworkedTransaction& Transaction : Transactions)
+	{
+		// Anything predicted after a rejected transaction was predicted from the wrong state.
+		if (RejectedTransactions.Num() > 0 || !IsPredictedTransactionValid(Transaction))
+		{
+			RejectedTransactions.Add(Transaction.TransactionGuid);
+			continue;
+		}
+
+		// Taken one at a time so each transaction is validated against the result of the last.
+		TArray<FSMNetworkedTransaction> AcceptedTransactions;
+		AcceptedTransactions.Add(Transaction);
+		SendTransactionsToClients(AcceptedTransactions);
+		DoProcessTransactions(AcceptedTransactions, true);
+	}
+
+	if (RejectedTransactions.Num() == 0 || !R_Instance)
+	{
+		return;
+	}
+
+	TArray<uint8> ServerSnapshot;
+	R_Instance->SaveSnapshotToBytes(ServerSnapshot);
+	CLIENT_RejectPredictedTransactions(RejectedTransactions, FDateTime::UtcNow(), ServerSnapshot);
+}
+
+bool USMStateMachineComponent::IsPredictedTransactionValid(const FSMNetworkedTransaction& Transaction) const
+{
+	if (!Transaction.IsTransition())
+	{
+		return true;
+	}
+
+	if (!R_Instance)
+	{
+		return false;
+	}
+
+	FSMTransition* Transition = R_Instance->GetTransitionByGuid(Transaction.BaseGuid);
+	if (!Transition || Transition->bAlwaysFalse)
+	{
+		return false;
+	}
+
+	const FSMState_Base* SourceState = Transaction.AreAdditionalGuidsSetupForTransitions() ?
+		R_Instance->GetStateByGuid(Transaction.GetTransitionSourceGuid()) : Transition->GetFromState();
+
+	return SourceState && SourceState->IsActive();
+}
+
 bool USMStateMachineComponent::SERVER_Initialize_Validate(UObject* Context)
 {
 	return true;
@@ -1050,10 +1534,45 @@ bool USMStateMachineComponent::SERVER_ProcessTransaction_Validate(const TArray<F
 
 void USMStateMachineComponent::SERVER_ProcessTransaction_Implementation(const TArray<FSMNetworkedTransaction>& Transactions)
 {
+	if (IsPredictingTransitions())
+	{
+		ProcessPredictedTransactions(Transactions);
+		return;
+	}
+	
 	SendTransactionsToClients(Transactions);
 	DoProcessTransactions(Transactions, true);
 }
 
+void USMStateMachineComponent::CLIENT_RejectPredictedTransactions_Implementation(const TArray<FGuid>& TransactionGuids, FDateTime ServerTime,
+	const TArray<uint8>& ServerSnapshot)
+{
+	for (const FGuid& TransactionGuid : TransactionGuids)
+	{
+		if (PendingPredictions.Remove(TransactionGuid) > 0)
+		{
+			NumMispredictions++;
+			INC_DWORD_STAT(STAT_MispredictedTransitions);
+		}
+	}
+
+	LastRollbackServerTime = ServerTime;
+
+	if (!R_Instance || !R_Instance->IsInitialized())
+	{
+		return;
+	}
+
+	FSMInstanceSnapshot Snapshot;
+	if (!Snapshot.LoadFromBytes(ServerSnapshot))
+	{
+		LD_LOG_ERROR(TEXT("Could not read the server snapshot to roll back mispredicted transitions for component %s."), *GetName());
+		return;
+	}
+
+	R_Instance->RollbackToSnapshot(Snapshot);
+}
+
 void USMStateMachineComponent::REP_OnInstanceLoaded()
 {
 	if (R_Instance)
@@ -1116,6 +1635,31 @@ void USMStateMachineComponent::REP_NetworkedTransactions()
 		return;
 	}
 
+	if (IsPredictingTransitions())
+	{
+		TArray<FSMNetworkedTransaction> Transactions;
+		Transactions.Reserve(R_NetworkedTransactions.Num());
+		for (const FSMNetworkedTransaction& Transaction : R_NetworkedTransactions)
+		{
+			if (PendingPredictions.Remove(Transaction.TransactionGuid) > 0)
+			{
+				// Confirmed and already taken locally.
+				NumConfirmedPredictions++;
+				continue;
+			}
+
+			if (Transaction.Timestamp <= LastRollbackServerTime)
+			{
+				continue;
+			}
+			
+			Transactions.Add(Transaction);
+		}
+
+		DoProcessTransactions(Transactions);
+		return;
+	}
+
 	DoProcessTransactions(R_NetworkedTransactions);
 }
 
@@ -0,0 +1,113 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#include "SMStateMachineDefinition.h"
+#include "SMInstance.h"
+#include "SMUtils.h"
+#include "SMLogging.h"
+
+TSharedPtr<const FSMStateMachineDefinition> FSMStateMachineDefinition::Build(UClass* Class)
+{
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMStateMachineDefinition::Build"), STAT_SMStateMachineDefinition_Build, STATGROUP_LogicDriver);
+
+	if (Class == nullptr || !Class->IsChildOf(USMInstance::StaticClass()))
+	{
+		return nullptr;
+	}
+
+	USMInstance* ClassDefaults = CastChecked<USMInstance>(Class->GetDefaultObject());
+
+	TSharedPtr<FSMStateMachineDefinition> Definition = MakeShared<FSMStateMachineDefinition>();
+	Definition->RootGuid = ClassDefaults->RootStateMachineGuid;
+	if (!USMUtils::TryGetStateMachinePropertiesForClass(Class, Definition->Properties, Definition->RootGuid) || !Definition->RootGuid.IsValid())
+	{
+		return nullptr;
+	}
+
+	// Owner guid -> state guid -> index into the owner's layout.
+	TMap<FGuid, TMap<FGuid, int32>> MappedStates;
+
+	// Property order must match GenerateStateMachine so instances add nodes in the same order.
+	for (FStructProperty* Property : Definition->Properties)
+	{
+		if (!Property->Struct->IsChildOf(FSMState_Base::StaticStruct()))
+		{
+			continue;
+		}
+
+		const FSMState_Base* State = Property->ContainerPtrToValuePtr<FSMState_Base>(ClassDefaults);
+		FSMStateMachineLayout& Layout = Definition->Layouts.FindOrAdd(State->GetOwnerNodeGuid());
+
+		FSMNodeLayout& StateLayout = Layout.States.AddDefaulted_GetRef();
+		StateLayout.Property = Property;
+		StateLayout.Name = *State->GetNodeName();
+		StateLayout.bIsInitialState = State->IsRootNode();
+		StateLayout.bIsStateMachine = Property->Struct->IsChildOf(FSMStateMachine::StaticStruct());
+
+		MappedStates.FindOrAdd(State->GetOwnerNodeGuid()).Add(State->GetNodeGuid(), Layout.States.Num() - 1);
+		Definition->NumNodes++;
+	}
+
+	for (FStructProperty* Property : Definition->Properties)
+	{
+		if (!Property->Struct->IsChildOf(FSMTransition::StaticStruct()))
+		{
+			continue;
+		}
+
+		const FSMTransition* Transition = Property->ContainerPtrToValuePtr<FSMTransition>(ClassDefaults);
+		const TMap<FGuid, int32>* OwnerStates = MappedStates.Find(Transition->GetOwnerNodeGuid());
+		const int32* FromIndex = OwnerStates ? OwnerStates->Find(Transition->FromGuid) : nullptr;
+		const int32* ToIndex = OwnerStates ? OwnerStates->Find(Transition->ToGuid) : nullptr;
+		if (FromIndex == nullptr || ToIndex == nullptr)
+		{
+			// Let normal generation report the error.
+			LD_LOG_WARNING(TEXT("Could not build a shared definition for %s. Transition %s has unresolved states."), *Class->GetName(), *Transition->GetNodeName());
+			return nullptr;
+		}
+
+		FSMNodeLayout& TransitionLayout = Definition->Layouts.FindChecked(Transition->GetOwnerNodeGuid()).Transitions.AddDefaulted_GetRef();
+		TransitionLayout.Property = Property;
+		TransitionLayout.FromStateIndex = *FromIndex;
+		TransitionLayout.ToStateIndex = *ToIndex;
+
+		Definition->NumNodes++;
+	}
+
+	// Layouts are final, element pointers are stable from here on.
+	for (TPair<FGuid, FSMStateMachineLayout>& KeyVal : Definition->Layouts)
+	{
+		FSMStateMachineLayout& Layout = KeyVal.Value;
+		Layout.StateNameIndices.Reserve(Layout.States.Num());
+		for (int32 Idx = 0; Idx < Layout.States.Num(); ++Idx)
+		{
+			// Matches the previous per instance name map where the last duplicate wins.
+			Layout.StateNameIndices.Add(Layout.States[Idx].Name, Idx);
+		}
+	}
+
+	Definition->BuildStatePaths(Definition->RootGuid, FString(), ClassDefaults);
+
+	return Definition;
+}
+
+void FSMStateMachineDefinition::BuildStatePaths(const FGuid& StateMachineGuid, const FString& Prefix, const UObject* ClassDefaults)
+{
+	const FSMStateMachineLayout* Layout = FindLayout(StateMachineGuid);
+	if (Layout == nullptr)
+	{
+		return;
+	}
+
+	for (const FSMNodeLayout& StateLayout : Layout->States)
+	{
+		const FString Path = Prefix.IsEmpty() ? StateLayout.Name.ToString() : Prefix + TEXT(".") + StateLayout.Name.ToString();
+		StatePaths.Add(*Path, &StateLayout);
+
+		if (StateLayout.bIsStateMachine)
+		{
+			// References have no layout in this class and are resolved against the referenced instance.
+			const FSMState_Base* State = StateLayout.Property->ContainerPtrToValuePtr<FSMState_Base>(ClassDefaults);
+			BuildStatePaths(State->GetNodeGuid(), Path, ClassDefaults);
+		}
+	}
+}
@@ -2,6 +2,9 @@
 
 #include "ISMSystemModule.h"
 #include "SMLogging.h"
+#include "SMUtils.h"
+
+#include "Misc/CoreDelegates.h"
 
 DEFINE_LOG_CATEGORY(LogLogicDriver);
 
@@ -10,6 +13,9 @@ class FSMSystemModule : public ISMSystemModule
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
+
+private:
+	FDelegateHandle SyncLoadPackageHandle;
 };
 
 IMPLEMENT_MODULE(FSMSystemModule, SMSystem)
@@ -18,6 +24,7 @@ IMPLEMENT_MODULE(FSMSystemModule, SMSystem)
 void FSMSystemModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory (but after global variables are initialized, of course.)
+	SyncLoadPackageHandle = FCoreDelegates::OnSyncLoadPackage.AddStatic(&FSMScopedSyncLoadCheck::OnSyncLoadPackage);
 }
 
 
@@ -25,4 +32,5 @@ void FSMSystemModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	FCoreDelegates::OnSyncLoadPackage.Remove(SyncLoadPackageHandle);
 }
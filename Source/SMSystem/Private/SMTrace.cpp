@@ -0,0 +1,115 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#include "SMTrace.h"
+
+#if LOGICDRIVER_TRACE_ENABLED
+
+#include "SMInstance.h"
+#include "SMTransition.h"
+
+#include "Misc/ScopeLock.h"
+
+UE_TRACE_CHANNEL_DEFINE(LogicDriverChannel)
+
+UE_TRACE_EVENT_BEGIN(LogicDriver, TransitionTaken)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint64, InstanceId)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(LogicDriver, InstanceEvent)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint64, InstanceId)
+	UE_TRACE_EVENT_FIELD(uint8, Event)
+UE_TRACE_EVENT_END()
+
+static const TCHAR* GetNodeScopeName(ESMTraceNodeScope Scope)
+{
+	switch (Scope)
+	{
+	case ESMTraceNodeScope::StateStart:
+		return TEXT("Start");
+	case ESMTraceNodeScope::StateUpdate:
+		return TEXT("Update");
+	case ESMTraceNodeScope::StateEnd:
+		return TEXT("End");
+	case ESMTraceNodeScope::TransitionEvaluate:
+		return TEXT("Evaluate");
+	default:
+		return TEXT("");
+	}
+}
+
+static FString GetInstanceClassName(const USMInstance* Instance)
+{
+	return Instance ? Instance->GetClass()->GetName() : FString(TEXT("None"));
+}
+
+/** Attachments carry the display name as a null terminated wide string. */
+static uint16 GetAttachmentSize(const FString& Name)
+{
+	return static_cast<uint16>(FMath::Min<int32>((Name.Len() + 1) * sizeof(TCHAR), MAX_uint16 - (MAX_uint16 % sizeof(TCHAR))));
+}
+
+uint32 FSMTrace::GetNodeEventType(const FSMNode_Base& Node, ESMTraceNodeScope Scope)
+{
+	// Shared by every instance of a class so each node scope is registered once.
+	static FCriticalSection CriticalSection;
+	static TMap<TTuple<const UClass*, FGuid, uint8>, uint32> EventTypes;
+
+	const USMInstance* Instance = Node.GetOwningInstance();
+	const TTuple<const UClass*, FGuid, uint8> Key(Instance ? Instance->GetClass() : nullptr, Node.GetNodeGuid(), static_cast<uint8>(Scope));
+
+	FScopeLock Lock(&CriticalSection);
+	if (const uint32* EventType = EventTypes.Find(Key))
+	{
+		return *EventType;
+	}
+
+	const FString EventName = FString::Printf(TEXT("%s %s [%s]"), *Node.GetNodeName(), GetNodeScopeName(Scope), *GetInstanceClassName(Instance));
+	return EventTypes.Add(Key, FCpuProfilerTrace::OutputEventType(*EventName));
+}
+
+uint32 FSMTrace::GetInstanceUpdateEventType(const USMInstance& Instance)
+{
+	static FCriticalSection CriticalSection;
+	static TMap<const UClass*, uint32> EventTypes;
+
+	const UClass* InstanceClass = Instance.GetClass();
+
+	FScopeLock Lock(&CriticalSection);
+	if (const uint32* EventType = EventTypes.Find(InstanceClass))
+	{
+		return *EventType;
+	}
+
+	const FString EventName = FString::Printf(TEXT("Update [%s]"), *InstanceClass->GetName());
+	return EventTypes.Add(InstanceClass, FCpuProfilerTrace::OutputEventType(*EventName));
+}
+
+void FSMTrace::OutputTransitionTaken(const FSMTransition& Transition)
+{
+	const FSMState_Base* FromState = Transition.GetFromState();
+	const FSMState_Base* ToState = Transition.GetToState();
+	const FString Name = FString::Printf(TEXT("%s -> %s [%s]"), FromState ? *FromState->GetNodeName() : TEXT("None"),
+		ToState ? *ToState->GetNodeName() : TEXT("None"), *GetInstanceClassName(Transition.GetOwningInstance()));
+	const uint16 AttachmentSize = GetAttachmentSize(Name);
+
+	UE_TRACE_LOG(LogicDriver, TransitionTaken, LogicDriverChannel, AttachmentSize)
+		<< TransitionTaken.Cycle(FPlatformTime::Cycles64())
+		<< TransitionTaken.InstanceId(reinterpret_cast<UPTRINT>(Transition.GetOwningInstance()))
+		<< TransitionTaken.Attachment(*Name, AttachmentSize);
+}
+
+void FSMTrace::OutputInstanceEvent(const USMInstance& Instance, ESMTraceInstanceEvent Event)
+{
+	const FString Name = Instance.GetPathName();
+	const uint16 AttachmentSize = GetAttachmentSize(Name);
+
+	UE_TRACE_LOG(LogicDriver, InstanceEvent, LogicDriverChannel, AttachmentSize)
+		<< InstanceEvent.Cycle(FPlatformTime::Cycles64())
+		<< InstanceEvent.InstanceId(reinterpret_cast<UPTRINT>(&Instance))
+		<< InstanceEvent.Event(static_cast<uint8>(Event))
+		<< InstanceEvent.Attachment(*Name, AttachmentSize);
+}
+
+#endif
@@ -2,10 +2,12 @@
 
 #include "SMUtils.h"
 #include "Blueprints/SMBlueprintGeneratedClass.h"
+#include "SMStateMachineDefinition.h"
 #include "SMLogging.h"
 
 #include "Engine.h"
 #include "Engine/World.h"
+#include "Engine/AssetManager.h"
 #include "Engine/InputActionDelegateBinding.h"
 #include "Engine/InputAxisDelegateBinding.h"
 #include "Engine/InputAxisKeyDelegateBinding.h"
@@ -14,7 +16,96 @@
 #include "Engine/InputVectorAxisDelegateBinding.h"
 
 #include "Framework/Commands/InputChord.h"
+#include "UObject/UObjectArray.h"
 
+DEFINE_STAT(STAT_SyncLoadsDuringUpdate);
+
+FSMPreloadRequest::FSMPreloadRequest(const TSoftClassPtr<USMInstance>& InStateMachineClass, const FSimpleDelegate& InOnComplete) :
+	StateMachineClass(InStateMachineClass), OnComplete(InOnComplete)
+{
+}
+
+void FSMPreloadRequest::Start()
+{
+	check(IsInGameThread());
+
+	if (StateMachineClass.IsNull())
+	{
+		OnDependenciesLoaded();
+		return;
+	}
+
+	ClassHandle = USMUtils::GetStreamableManager().RequestAsyncLoad(StateMachineClass.ToSoftObjectPath(),
+		FStreamableDelegate::CreateSP(this, &FSMPreloadRequest::OnClassLoaded));
+	if (!ClassHandle.IsValid())
+	{
+		OnClassLoaded();
+	}
+}
+
+void FSMPreloadRequest::Cancel()
+{
+	OnComplete.Unbind();
+	bComplete = true;
+
+	for (TSharedPtr<FStreamableHandle>* Handle : { &ClassHandle, &DependencyHandle })
+	{
+		if (Handle->IsValid())
+		{
+			if ((*Handle)->IsLoadingInProgress())
+			{
+				(*Handle)->CancelHandle();
+			}
+			else
+			{
+				(*Handle)->ReleaseHandle();
+			}
+			Handle->Reset();
+		}
+	}
+}
+
+void FSMPreloadRequest::OnClassLoaded()
+{
+	// The streamable manager may call back immediately if everything is resident.
+	if (bComplete || bLoadingDependencies)
+	{
+		return;
+	}
+	
+	bLoadingDependencies = true;
+
+	UClass* LoadedClass = StateMachineClass.Get();
+	if (LoadedClass == nullptr)
+	{
+		LD_LOG_ERROR(TEXT("Could not preload state machine class %s."), *StateMachineClass.ToString());
+		OnDependenciesLoaded();
+		return;
+	}
+
+	TArray<FSoftObjectPath> Dependencies;
+	USMUtils::GetStateMachineClassDependencies(LoadedClass, Dependencies);
+
+	// Most dependencies are hard references which arrive with the class package. Requesting them
+	// anyway keeps them referenced by this request and picks up anything not yet resident.
+	DependencyHandle = USMUtils::GetStreamableManager().RequestAsyncLoad(Dependencies,
+		FStreamableDelegate::CreateSP(this, &FSMPreloadRequest::OnDependenciesLoaded));
+	if (!DependencyHandle.IsValid())
+	{
+		OnDependenciesLoaded();
+	}
+}
+
+void FSMPreloadRequest::OnDependenciesLoaded()
+{
+	if (bComplete)
+	{
+		return;
+	}
+
+	bComplete = true;
+	OnComplete.ExecuteIfBound();
+}
 
 USMInstance* USMBlueprintUtils::CreateStateMachineInstance(TSubclassOf<class USMInstance> StateMachineClass, UObject* Context, bool bInitializeNow)
 {
@@ -27,6 +118,51 @@ USMInstance* USMBlueprintUtils::CreateStateMachineInstanceFromTemplate(TSubclass
 	return CreateStateMachineInstanceInternal(StateMachineClass, Context, Template, bInitializeNow);
 }
 
+void USMBlueprintUtils::PreloadStateMachineClass(TSoftClassPtr<USMInstance> StateMachineClass, FOnStateMachineClassPreloadedSignature OnPreloaded)
+{
+	// Blueprint requests have no owner so keep them alive here. Completed requests are released on the next call
+	// as they can't be destroyed from within their own callback.
+	static TArray<TSharedRef<FSMPreloadRequest>> BlueprintRequests;
+	BlueprintRequests.RemoveAll([](const TSharedRef<FSMPreloadRequest>& Request)
+	{
+		return Request->IsComplete();
+	});
+
+	const TSharedRef<FSMPreloadRequest> Request = MakeShared<FSMPreloadRequest>(StateMachineClass, FSimpleDelegate::CreateLambda([StateMachineClass, OnPreloaded]()
+	{
+		OnPreloaded.ExecuteIfBound(StateMachineClass.Get());
+	}));
+	BlueprintRequests.Add(Request);
+	Request->Start();
+}
+
+USMInstance* USMBlueprintUtils::CloneInitializedInstance(USMInstance* Prototype, UObject* NewContext)
+{
+	if (Prototype == nullptr)
+	{
+		LD_LOG_ERROR(TEXT("No prototype provided to CloneInitializedInstance for context: %s"), NewContext ? *NewContext->GetName() : TEXT("No Context"));
+		return nullptr;
+	}
+
+	if (NewContext == nullptr)
+	{
+		LD_LOG_ERROR(TEXT("No context provided to CloneInitializedInstance."));
+		return nullptr;
+	}
+
+	USMInstance* Instance = NewObject<USMInstance>(NewContext, Prototype->GetClass());
+	Instance->InitializeFromPrototype(Prototype, NewContext);
+
+	return Instance;
+}
+
+TSharedRef<FSMPreloadRequest> USMBlueprintUtils::RequestPreloadStateMachineClass(const TSoftClassPtr<USMInstance>& StateMachineClass, const FSimpleDelegate& OnPreloaded)
+{
+	const TSharedRef<FSMPreloadRequest> Request = MakeShared<FSMPreloadRequest>(StateMachineClass, OnPreloaded);
+	Request->Start();
+	return Request;
+}
+
 USMInstance* USMBlueprintUtils::CreateStateMachineInstanceInternal(TSubclassOf<USMInstance> StateMachineClass,
                                                                    UObject* Context, USMInstance* Template, bool bInitializeNow)
 {
@@ -59,7 +195,7 @@ USMInstance* USMBlueprintUtils::CreateStateMachineInstanceInternal(TSubclassOf<U
 }
 
 bool USMUtils::GenerateStateMachine(UObject* Instance, FSMStateMachine& StateMachineOut,
-	const TSet<FStructProperty*>& RunTimeProperties, bool bDryRun)
+	const TSet<FStructProperty*>& RunTimeProperties, bool bDryRun, const FSMStateMachineDefinition* Definition)
 {
 	// State machines that contain references to each other can risk stack overflow. Let's track the ones being generated for a specific thread.
 	static TMap<uint32, GeneratingStateMachines> StateMachinesGeneratingForThread;
@@ -156,8 +292,26 @@ bool USMUtils::GenerateStateMachine(UObject* Instance, FSMStateMachine& StateMac
 				int32& CurrentInstances = CurrentGeneration.InstancesGenerating.FindOrAdd(StateMachineClassReference);
 				CurrentInstances++;
 
-				// Instantiate template.
-				USMInstance* ReferencedInstance = USMBlueprintUtils::CreateStateMachineInstanceFromTemplate(StateMachineClassReference, SMInstance->GetContext(), TemplateInstance, true);
+				// Copy the prototype's reference when initializing from a prototype, otherwise instantiate the template.
+				USMInstance* ReferencedInstance = nullptr;
+				const FSMStateMachine* PrototypeStateMachine = static_cast<const FSMStateMachine*>(SMInstance->FindPrototypeNode(StateMachineOut));
+				USMInstance* PrototypeReference = PrototypeStateMachine ? PrototypeStateMachine->GetInstanceReference() : nullptr;
+				if (PrototypeReference && PrototypeReference->GetClass() == StateMachineClassReference)
+				{
+					ReferencedInstance = USMBlueprintUtils::CloneInitializedInstance(PrototypeReference, SMInstance->GetContext());
+				}
+				else if (SMInstance->IsPrototype())
+				{
+					ReferencedInstance = USMBlueprintUtils::CreateStateMachineInstanceFromTemplate(StateMachineClassReference, SMInstance->GetContext(), TemplateInstance, false);
+					if (ReferencedInstance)
+					{
+						ReferencedInstance->InitializeAsPrototype(SMInstance->GetContext());
+					}
+				}
+				else
+				{
+					ReferencedInstance = USMBlueprintUtils::CreateStateMachineInstanceFromTemplate(StateMachineClassReference, SMInstance->GetContext(), TemplateInstance, true);
+				}
 				if (ReferencedInstance == nullptr)
 				{
 					LD_LOG_ERROR(TEXT("Could not create reference %s for use within state machine %s from package %s."), *StateMachineClassReference->GetName(), *StateMachineOut.GetNodeName(), *Instance->GetName());
@@ -204,6 +358,46 @@ bool USMUtils::GenerateStateMachine(UObject* Instance, FSMStateMachine& StateMac
 	// Only match properties belonging to this state machine.
 	const FGuid& StateMachineNodeGuid = StateMachineOut.GetNodeGuid();
 
+	// The topology is already resolved, only link this instance's nodes.
+	if (Definition)
+	{
+		if (const FSMStateMachineLayout* Layout = Definition->FindLayout(StateMachineNodeGuid))
+		{
+			TArray<FSMState_Base*, TInlineAllocator<16>> LayoutStates;
+			LayoutStates.Reserve(Layout->States.Num());
+			
+			for (const FSMNodeLayout& StateLayout : Layout->States)
+			{
+				FSMState_Base* State = StateLayout.Property->ContainerPtrToValuePtr<FSMState_Base>(Instance);
+				StateMachineOut.AddState(State);
+				LayoutStates.Add(State);
+
+				if (StateLayout.bIsStateMachine)
+				{
+					FSMStateMachine& NestedStateMachine = *(FSMStateMachine*)State;
+					GenerateStateMachine(Instance, NestedStateMachine, RunTimeProperties, bDryRun, Definition);
+				}
+
+				if (StateLayout.bIsInitialState)
+				{
+					StateMachineOut.AddInitialState(State);
+				}
+			}
+
+			for (const FSMNodeLayout& TransitionLayout : Layout->Transitions)
+			{
+				FSMTransition* Transition = TransitionLayout.Property->ContainerPtrToValuePtr<FSMTransition>(Instance);
+				Transition->SetFromState(LayoutStates[TransitionLayout.FromStateIndex]);
+				Transition->SetToState(LayoutStates[TransitionLayout.ToStateIndex]);
+
+				StateMachineOut.AddTransition(Transition);
+			}
+		}
+
+		FinishStateMachineGeneration(bIsTopLevel, StateMachinesGeneratingForThread, ThreadId);
+		return true;
+	}
+
 	// Used for quick lookup when linking to states.
 	TMap<FGuid, FSMState_Base*> MappedStates;
 	TMap<FGuid, FSMTransition*> MappedTransitions;
@@ -298,8 +492,40 @@ bool USMUtils::GenerateStateMachine(UObject* Instance, FSMStateMachine& StateMac
 	return true;
 }
 
+/** The native class generated from a blueprint class when the blueprint has been reparented to it. */
+static UClass* GetGeneratedNativeParent(UClass* Class)
+{
+	const USMBlueprintGeneratedClass* BlueprintClass = Cast<USMBlueprintGeneratedClass>(Class);
+	if (BlueprintClass == nullptr || !BlueprintClass->GetRootGuid().IsValid())
+	{
+		return nullptr;
+	}
+
+	UClass* NativeClass = Class->GetSuperClass();
+	while (NativeClass && !NativeClass->HasAnyClassFlags(CLASS_Native))
+	{
+		NativeClass = NativeClass->GetSuperClass();
+	}
+
+	if (NativeClass == nullptr || NativeClass == USMInstance::StaticClass() || !NativeClass->IsChildOf(USMInstance::StaticClass()))
+	{
+		return nullptr;
+	}
+
+	// Generated classes keep the root guid of their blueprint.
+	return CastChecked<USMInstance>(NativeClass->GetDefaultObject())->RootStateMachineGuid == BlueprintClass->GetRootGuid() ? NativeClass : nullptr;
+}
+
 bool USMUtils::TryGetStateMachinePropertiesForClass(UClass* Class, TSet<FStructProperty*>& PropertiesOut, FGuid& RootGuid, EFieldIteratorFlags::SuperClassFlags SuperFlags)
 {
+	// A blueprint reparented to the class generated from it runs the generated nodes. Its own nodes share their guids
+	// and only supply graph functions through USMInstance::ExecuteBlueprintNodeFunction.
+	if (UClass* NativeClass = GetGeneratedNativeParent(Class))
+	{
+		RootGuid = CastChecked<USMInstance>(NativeClass->GetDefaultObject())->RootStateMachineGuid;
+		return TryGetStateMachinePropertiesForClass(NativeClass, PropertiesOut, RootGuid, SuperFlags);
+	}
+
 	// Look for properties in this class.
 	for (TFieldIterator<FStructProperty> It(Class, SuperFlags); It; ++It)
 	{
@@ -326,6 +552,13 @@ bool USMUtils::TryGetStateMachinePropertiesForClass(UClass* Class, TSet<FStructP
 			RootGuid = CastChecked<USMInstance>(NextClass->GetDefaultObject())->RootStateMachineGuid;
 			return TryGetStateMachinePropertiesForClass(NextClass, PropertiesOut, RootGuid, SuperFlags);
 		}
+		// Native parent such as a class generated from a state machine blueprint.
+		UClass* NextClass = Class->GetSuperClass();
+		if (NextClass && NextClass->HasAnyClassFlags(CLASS_Native) && NextClass != USMInstance::StaticClass() && NextClass->IsChildOf(USMInstance::StaticClass()))
+		{
+			RootGuid = CastChecked<USMInstance>(NextClass->GetDefaultObject())->RootStateMachineGuid;
+			return TryGetStateMachinePropertiesForClass(NextClass, PropertiesOut, RootGuid, SuperFlags);
+		}
 	}
 
 	return PropertiesOut.Num() > 0;
@@ -452,6 +685,75 @@ bool USMUtils::TryGetAllReferenceTemplatesFromInstance(USMInstance* Instance, TS
 	return TemplatesOut.Num() > 0;
 }
 
+void USMUtils::GetStateMachineClassDependencies(UClass* StateMachineClass, TArray<FSoftObjectPath>& OutDependencies)
+{
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMUtils::GetStateMachineClassDependencies"), STAT_SMUtils_GetStateMachineClassDependencies, STATGROUP_LogicDriver);
+
+	TSet<UClass*> SearchedClasses;
+	TArray<UClass*> ClassesToSearch;
+	ClassesToSearch.Add(StateMachineClass);
+
+	while (ClassesToSearch.Num() > 0)
+	{
+		UClass* Class = ClassesToSearch.Pop(false);
+		if (Class == nullptr || !Class->IsChildOf(USMInstance::StaticClass()) || SearchedClasses.Contains(Class))
+		{
+			continue;
+		}
+
+		SearchedClasses.Add(Class);
+		OutDependencies.AddUnique(FSoftObjectPath(Class));
+
+		USMInstance* ClassDefaults = CastChecked<USMInstance>(Class->GetDefaultObject());
+
+		TSet<FStructProperty*> Properties;
+		FGuid RootGuid = ClassDefaults->RootStateMachineGuid;
+		TryGetStateMachinePropertiesForClass(Class, Properties, RootGuid);
+
+		for (FStructProperty* Property : Properties)
+		{
+			const FSMNode_Base* Node = Property->ContainerPtrToValuePtr<FSMNode_Base>(ClassDefaults);
+			if (UClass* NodeInstanceClass = Node->GetNodeInstanceClass())
+			{
+				OutDependencies.AddUnique(FSoftObjectPath(NodeInstanceClass));
+			}
+
+			if (Property->Struct->IsChildOf(FSMStateMachine::StaticStruct()))
+			{
+				ClassesToSearch.Add(static_cast<const FSMStateMachine*>(Node)->GetClassReference());
+			}
+		}
+
+		// Node and reference templates are default sub objects of the class.
+		TArray<UObject*> Templates;
+		ClassDefaults->GetDefaultSubobjects(Templates);
+		Templates.Append(ClassDefaults->ReferenceTemplates);
+		
+		for (UObject* Template : Templates)
+		{
+			if (Template == nullptr)
+			{
+				continue;
+			}
+
+			OutDependencies.AddUnique(FSoftObjectPath(Template));
+			OutDependencies.AddUnique(FSoftObjectPath(Template->GetClass()));
+			ClassesToSearch.Add(Template->GetClass());
+		}
+	}
+}
+
+FStreamableManager& USMUtils::GetStreamableManager()
+{
+	if (UAssetManager::IsValid())
+	{
+		return UAssetManager::GetStreamableManager();
+	}
+
+	static FStreamableManager StreamableManager;
+	return StreamableManager;
+}
+
 void USMUtils::EnableInputForObject(APlayerController* InPlayerController, UObject* InObject,
                                     UInputComponent*& InOutComponent, int32 InputPriority, bool bBlockInput, bool bPushPopInput)
 {
@@ -466,10 +768,24 @@ void USMUtils::EnableInputForObject(APlayerController* InPlayerController, UObje
 		InOutComponent->Priority = InputPriority;
 
 		BindInputDelegatesToObject(InObject->GetClass(), InOutComponent, InObject);
+
+		// Input is usually enabled after initialization so the owner may already be clustered.
+		AddToOwnerGCCluster(InOutComponent, InObject);
 	}
-	else if (bPushPopInput)
+	else
 	{
-		InPlayerController->PopInputComponent(InOutComponent);
+		// Reusing a component kept by DisableInput. Bindings are still valid.
+		if (!InOutComponent->IsRegistered())
+		{
+			InOutComponent->RegisterComponent();
+		}
+		InOutComponent->bBlockInput = bBlockInput;
+		InOutComponent->Priority = InputPriority;
+		
+		if (bPushPopInput)
+		{
+			InPlayerController->PopInputComponent(InOutComponent);
+		}
 	}
 
 	if (bPushPopInput)
@@ -478,7 +794,7 @@ void USMUtils::EnableInputForObject(APlayerController* InPlayerController, UObje
 	}
 }
 
-void USMUtils::DisableInput(UWorld* InWorld, UInputComponent*& InOutComponent)
+void USMUtils::DisableInput(UWorld* InWorld, UInputComponent*& InOutComponent, bool bReleaseComponent)
 {
 	if (InWorld && InOutComponent)
 	{
@@ -493,13 +809,44 @@ void USMUtils::DisableInput(UWorld* InWorld, UInputComponent*& InOutComponent)
 
 	if (InOutComponent)
 	{
-		InOutComponent->DestroyComponent();
-		InOutComponent = nullptr;
+		if (bReleaseComponent)
+		{
+			InOutComponent->DestroyComponent();
+			InOutComponent = nullptr;
+		}
+		else if (InOutComponent->IsRegistered())
+		{
+			InOutComponent->UnregisterComponent();
+		}
 	}
 }
 
+/** Input bindings of a class and its parents with parent overrides already resolved. Delegates are bound per object. */
+struct FSMInputBindingPlan
+{
+	struct FKeyBind
+	{
+		FInputKeyBinding Binding;
+		FName FunctionName;
+	};
+
+	struct FActionBind
+	{
+		FInputActionBinding Binding;
+		FName FunctionName;
+	};
+
+	TArray<FKeyBind> KeyBindings;
+	TArray<FActionBind> ActionBindings;
+
+#if WITH_EDITOR
+	/** Recompiling replaces the CDO and binding objects which invalidates the plan. */
+	TWeakObjectPtr<UObject> ClassDefaults;
+#endif
+};
+
 /* https://forums.unrealengine.com/t/input-events-on-uobject-graph/120579/4 */
-void USMUtils::BindInputDelegatesToObject(const UClass* InClass, UInputComponent* InInputComponent, UObject* InObject)
+static void BuildInputBindingPlan(const UClass* InClass, FSMInputBindingPlan& Plan)
 {
 	static UClass* InputBindingClasses[] =
 	{
@@ -511,92 +858,136 @@ void USMUtils::BindInputDelegatesToObject(const UClass* InClass, UInputComponent
 		UInputVectorAxisDelegateBinding::StaticClass(),
 	};
 
-	if (InClass)
+	if (!InClass)
 	{
-		// Bind parent class input delegates
-		BindInputDelegatesToObject(InClass->GetSuperClass(), InInputComponent, InObject);
+		return;
+	}
+	
+	// Bind parent class input delegates
+	BuildInputBindingPlan(InClass->GetSuperClass(), Plan);
 
-		// Bind own graph input delegates
-		for (UClass* InputBindingClass : InputBindingClasses)
+	// Bind own graph input delegates
+	for (UClass* InputBindingClass : InputBindingClasses)
+	{
+		if (UInputDelegateBinding* BindingObject = CastChecked<UInputDelegateBinding>(UBlueprintGeneratedClass::GetDynamicBindingObject(InClass, InputBindingClass), ECastCheckedType::NullAllowed))
 		{
-			if (UInputDelegateBinding* BindingObject = CastChecked<UInputDelegateBinding>(UBlueprintGeneratedClass::GetDynamicBindingObject(InClass, InputBindingClass), ECastCheckedType::NullAllowed))
+			if (UInputKeyDelegateBinding* KeyBinding = Cast<UInputKeyDelegateBinding>(BindingObject))
 			{
-				if (UInputKeyDelegateBinding* KeyBinding = Cast<UInputKeyDelegateBinding>(BindingObject))
+				TArray<FSMInputBindingPlan::FKeyBind> BindsToAdd;
+
+				for (const FBlueprintInputKeyDelegateBinding& Binding : KeyBinding->InputKeyDelegateBindings)
 				{
-					TArray<FInputKeyBinding> BindsToAdd;
+					FInputKeyBinding KB(Binding.InputChord, Binding.InputKeyEvent);
+					KB.bConsumeInput = Binding.bConsumeInput;
+					KB.bExecuteWhenPaused = Binding.bExecuteWhenPaused;
 
-					for (int32 BindIndex = 0; BindIndex < KeyBinding->InputKeyDelegateBindings.Num(); ++BindIndex)
+					if (Binding.bOverrideParentBinding)
 					{
-						const FBlueprintInputKeyDelegateBinding& Binding = KeyBinding->InputKeyDelegateBindings[BindIndex];
-						FInputKeyBinding KB(Binding.InputChord, Binding.InputKeyEvent);
-						KB.bConsumeInput = Binding.bConsumeInput;
-						KB.bExecuteWhenPaused = Binding.bExecuteWhenPaused;
-
-						// Originally instead of GraphObject, it said InputComponent->GetOwner() here
-						KB.KeyDelegate.BindDelegate(InObject, Binding.FunctionNameToBind);
-
-						if (Binding.bOverrideParentBinding)
+						Plan.KeyBindings.RemoveAll([&KB](const FSMInputBindingPlan::FKeyBind& ExistingBind)
 						{
-							for (int32 ExistingIndex = InInputComponent->KeyBindings.Num() - 1; ExistingIndex >= 0; --ExistingIndex)
-							{
-								const FInputKeyBinding& ExistingBind = InInputComponent->KeyBindings[ExistingIndex];
-								if (ExistingBind.Chord == KB.Chord && ExistingBind.KeyEvent == KB.KeyEvent)
-								{
-									InInputComponent->KeyBindings.RemoveAt(ExistingIndex);
-								}
-							}
-						}
-
-						// To avoid binds in the same layer being removed by the parent override temporarily put them in this array and add later
-						BindsToAdd.Add(KB);
+							return ExistingBind.Binding.Chord == KB.Chord && ExistingBind.Binding.KeyEvent == KB.KeyEvent;
+						});
 					}
 
-					for (const FInputKeyBinding& Binding : BindsToAdd)
-					{
-						InInputComponent->KeyBindings.Add(Binding);
-					}
+					// To avoid binds in the same layer being removed by the parent override temporarily put them in this array and add later
+					BindsToAdd.Add({ KB, Binding.FunctionNameToBind });
 				}
-				else if (UInputActionDelegateBinding* ActionBinding = Cast<UInputActionDelegateBinding>(BindingObject))
-				{
-					TArray<FInputActionBinding> BindsToAdd;
 
-					for (int32 BindIndex = 0; BindIndex < ActionBinding->InputActionDelegateBindings.Num(); ++BindIndex)
-					{
-						const FBlueprintInputActionDelegateBinding& Binding = ActionBinding->InputActionDelegateBindings[BindIndex];
-
-						FInputActionBinding AB(Binding.InputActionName, Binding.InputKeyEvent);
-						AB.bConsumeInput = Binding.bConsumeInput;
-						AB.bExecuteWhenPaused = Binding.bExecuteWhenPaused;
+				Plan.KeyBindings.Append(MoveTemp(BindsToAdd));
+			}
+			else if (UInputActionDelegateBinding* ActionBinding = Cast<UInputActionDelegateBinding>(BindingObject))
+			{
+				TArray<FSMInputBindingPlan::FActionBind> BindsToAdd;
 
-						// Originally instead of GraphObject, it said InputComponent->GetOwner() here
-						AB.ActionDelegate.BindDelegate(InObject, Binding.FunctionNameToBind);
+				for (const FBlueprintInputActionDelegateBinding& Binding : ActionBinding->InputActionDelegateBindings)
+				{
+					FInputActionBinding AB(Binding.InputActionName, Binding.InputKeyEvent);
+					AB.bConsumeInput = Binding.bConsumeInput;
+					AB.bExecuteWhenPaused = Binding.bExecuteWhenPaused;
 
-						if (Binding.bOverrideParentBinding)
+					if (Binding.bOverrideParentBinding)
+					{
+						Plan.ActionBindings.RemoveAll([&AB](const FSMInputBindingPlan::FActionBind& ExistingBind)
 						{
-							for (int32 ExistingIndex = InInputComponent->GetNumActionBindings() - 1; ExistingIndex >= 0; --ExistingIndex)
-							{
-								const FInputActionBinding& ExistingBind = InInputComponent->GetActionBinding(ExistingIndex);
-								if (ExistingBind.GetActionName() == AB.GetActionName() && ExistingBind.KeyEvent == AB.KeyEvent)
-								{
-									InInputComponent->RemoveActionBinding(ExistingIndex);
-								}
-							}
-						}
-
-						// To avoid binds in the same layer being removed by the parent override temporarily put them in this array and add later
-						BindsToAdd.Add(AB);
+							return ExistingBind.Binding.GetActionName() == AB.GetActionName() && ExistingBind.Binding.KeyEvent == AB.KeyEvent;
+						});
 					}
 
-					for (const FInputActionBinding& Binding : BindsToAdd)
-					{
-						InInputComponent->AddActionBinding(Binding);
-					}
+					// To avoid binds in the same layer being removed by the parent override temporarily put them in this array and add later
+					BindsToAdd.Add({ AB, Binding.FunctionNameToBind });
 				}
+
+				Plan.ActionBindings.Append(MoveTemp(BindsToAdd));
 			}
 		}
 	}
 }
 
+/** Find or build the cached input binding plan of a class. Game thread only. */
+static const FSMInputBindingPlan& GetInputBindingPlan(const UClass* InClass)
+{
+	check(IsInGameThread());
+	
+	static TMap<TWeakObjectPtr<const UClass>, TSharedRef<FSMInputBindingPlan>> CachedPlans;
+
+	if (const TSharedRef<FSMInputBindingPlan>* ExistingPlan = CachedPlans.Find(InClass))
+	{
+#if WITH_EDITOR
+		if ((*ExistingPlan)->ClassDefaults.Get() == InClass->GetDefaultObject(false))
+#endif
+		{
+			return ExistingPlan->Get();
+		}
+	}
+
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMUtils::BuildInputBindingPlan"), STAT_SMUtils_BuildInputBindingPlan, STATGROUP_LogicDriver);
+
+	// Drop plans of unloaded classes.
+	for (auto It = CachedPlans.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+	
+	TSharedRef<FSMInputBindingPlan> Plan = MakeShared<FSMInputBindingPlan>();
+	BuildInputBindingPlan(InClass, *Plan);
+#if WITH_EDITOR
+	Plan->ClassDefaults = InClass->GetDefaultObject(false);
+#endif
+
+	return CachedPlans.Add(InClass, Plan).Get();
+}
+
+void USMUtils::BindInputDelegatesToObject(const UClass* InClass, UInputComponent* InInputComponent, UObject* InObject)
+{
+	if (!InClass)
+	{
+		return;
+	}
+	
+	const FSMInputBindingPlan& Plan = GetInputBindingPlan(InClass);
+
+	InInputComponent->KeyBindings.Reserve(InInputComponent->KeyBindings.Num() + Plan.KeyBindings.Num());
+	for (const FSMInputBindingPlan::FKeyBind& KeyBind : Plan.KeyBindings)
+	{
+		FInputKeyBinding& KB = InInputComponent->KeyBindings.Add_GetRef(KeyBind.Binding);
+		
+		// Originally instead of GraphObject, it said InputComponent->GetOwner() here
+		KB.KeyDelegate.BindDelegate(InObject, KeyBind.FunctionName);
+	}
+
+	for (const FSMInputBindingPlan::FActionBind& ActionBind : Plan.ActionBindings)
+	{
+		FInputActionBinding AB = ActionBind.Binding;
+
+		// Originally instead of GraphObject, it said InputComponent->GetOwner() here
+		AB.ActionDelegate.BindDelegate(InObject, ActionBind.FunctionName);
+		InInputComponent->AddActionBinding(AB);
+	}
+}
+
 void USMUtils::HandlePawnControllerChange(APawn* InPawn, AController* InController, UObject* InObject, UInputComponent*& InOutComponent, int32 InputPriority, bool bBlockInput)
 {
 	check(InObject);
@@ -616,6 +1007,32 @@ void USMUtils::HandlePawnControllerChange(APawn* InPawn, AController* InControll
 	}
 }
 
+bool USMUtils::IsObjectInGCCluster(const UObject* InObject)
+{
+	if (InObject == nullptr)
+	{
+		return false;
+	}
+
+	const FUObjectItem* ObjectItem = GUObjectArray.ObjectToObjectItem(InObject);
+	return ObjectItem && (ObjectItem->GetOwnerIndex() != 0 || ObjectItem->HasAnyFlags(EInternalObjectFlags::ClusterRoot));
+}
+
+void USMUtils::AddToOwnerGCCluster(UObject* InObject, UObject* InOwner, bool bAsMutable)
+{
+	if (InObject == nullptr || InObject == InOwner || IsObjectInGCCluster(InObject) || !IsObjectInGCCluster(InOwner))
+	{
+		return;
+	}
+
+	if (!InObject->CanBeInCluster())
+	{
+		return;
+	}
+
+	InObject->AddToCluster(InOwner, bAsMutable);
+}
+
 #if WITH_EDITOR
 
 UObject* USMUtils::CreateTemplate(UClass* NewClass, UObject* OldInstance, UObject* CallingObject, FName InstanceName, EObjectFlags ObjectFlags, bool bModify)
@@ -747,3 +1164,31 @@ bool USMUtils::FinishStateMachineGeneration(bool bIsTopLevel, TMap<uint32, Gener
 
 	return bIsTopLevel;
 }
+
+const UObject* FSMScopedSyncLoadCheck::UpdatingObject = nullptr;
+
+FSMScopedSyncLoadCheck::FSMScopedSyncLoadCheck(const UObject* InUpdatingObject) : PreviousObject(UpdatingObject)
+{
+	if (IsInGameThread())
+	{
+		UpdatingObject = InUpdatingObject;
+	}
+}
+
+FSMScopedSyncLoadCheck::~FSMScopedSyncLoadCheck()
+{
+	if (IsInGameThread())
+	{
+		UpdatingObject = PreviousObject;
+	}
+}
+
+void FSMScopedSyncLoadCheck::OnSyncLoadPackage(const FString& PackageName)
+{
+	if (UpdatingObject && IsInGameThread())
+	{
+		INC_DWORD_STAT(STAT_SyncLoadsDuringUpdate);
+		LD_LOG_WARNING(TEXT("Package %s was loaded synchronously while updating state machine %s. Consider preloading the state machine class."),
+			*PackageName, *UpdatingObject->GetName());
+	}
+}
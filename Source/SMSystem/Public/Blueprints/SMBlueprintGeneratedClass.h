@@ -6,6 +6,7 @@
 #include "SMBlueprintGeneratedClass.generated.h"
 
 class USMInstance;
+struct FSMStateMachineDefinition;
 
 UCLASS()
 class SMSYSTEM_API USMBlueprintGeneratedClass : public UBlueprintGeneratedClass
@@ -17,12 +18,26 @@ public:
 	virtual void PurgeClass(bool bRecompilingOnLoad) override;
 	// ~UClass
 
+#if WITH_EDITOR
+	// UObject
+	virtual void PreSave(const ITargetPlatform* TargetPlatform) override;
+	// ~UObject
+
+	DECLARE_MULTICAST_DELEGATE_TwoParams(FOnPreCookSave, USMBlueprintGeneratedClass* /* Class */, const ITargetPlatform* /* TargetPlatform */);
+
+	/** Called before a class is saved for a cooked platform, after which the class defaults are serialized. */
+	static FOnPreCookSave OnPreCookSaveEvent;
+#endif
+
 	/** The root state machine Guid- set by the compiler. */
 	void SetRootGuid(const FGuid& Guid);
 
 	/** The root state machine Guid. */
 	const FGuid& GetRootGuid() const { return RootGuid; }
 
+	/** The topology shared by all instances of this class. Built on first use and cleared when the class is purged. */
+	TSharedPtr<const FSMStateMachineDefinition> GetStateMachineDefinition();
+
 #if WITH_EDITORONLY_DATA
 public:
 	TWeakObjectPtr<USMInstance> GetOldCDO() const { return OldCDO; }
@@ -35,6 +50,17 @@ private:
 protected:
 	UPROPERTY(meta=(BlueprintCompilerGeneratedDefaults))
 	FGuid RootGuid;
+
+private:
+	TSharedPtr<const FSMStateMachineDefinition> StateMachineDefinition;
+
+	/** If StateMachineDefinition was built, even if the build failed and it is null. */
+	bool bStateMachineDefinitionBuilt = false;
+
+#if WITH_EDITORONLY_DATA
+	/** The class defaults StateMachineDefinition was built from. Recompiling the class or a parent replaces the CDO which invalidates the definition. */
+	TWeakObjectPtr<UObject> StateMachineDefinitionDefaults;
+#endif
 };
 
 UCLASS()
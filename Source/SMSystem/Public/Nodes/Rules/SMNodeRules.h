@@ -3,8 +3,27 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "UObject/SoftObjectPath.h"
 #include "SMNodeRules.generated.h"
 
+/**
+ * A node class described by the paths of itself and its parents. Allows rules to be checked against classes which aren't loaded.
+ */
+struct SMSYSTEM_API FSMNodeClassPathHierarchy
+{
+	/** The class followed by each parent class. Empty when there is no class. */
+	TArray<FSoftObjectPath> ClassPaths;
+
+	/** Build the hierarchy of a loaded class. */
+	static FSMNodeClassPathHierarchy FromClass(const UClass* Class);
+
+	bool IsSet() const { return ClassPaths.Num() > 0; }
+	const FSoftObjectPath& GetClassPath() const { return ClassPaths[0]; }
+
+	/** If this class is or is derived from the class path. */
+	bool IsChildOf(const FSoftObjectPath& ClassPath) const { return ClassPaths.Contains(ClassPath); }
+};
+
 
 USTRUCT()
 struct SMSYSTEM_API FSMNodeClassRule
@@ -18,8 +37,15 @@ struct SMSYSTEM_API FSMNodeClassRule
 		return nullptr;
 	}
 
+	/** The path of the class this rule checks for without loading it. */
+	virtual FSoftObjectPath GetClassPath() const
+	{
+		return FSoftObjectPath();
+	}
+
 	/** Checks if a class is a base node class. Considers null a base class. */
 	static bool IsBaseClass(UClass* Class);
+	static bool IsBaseClass(const FSoftObjectPath& ClassPath);
 	
 	/** If all children of this class should be considered. */
 	UPROPERTY(EditDefaultsOnly, AdvancedDisplay, Category = "Rule", meta = (NoResetToDefault))
@@ -36,6 +62,7 @@ struct SMSYSTEM_API FSMStateClassRule : public FSMNodeClassRule
 	GENERATED_USTRUCT_BODY()
 
 	virtual UClass* GetClass() const override;
+	virtual FSoftObjectPath GetClassPath() const override { return StateClass.ToSoftObjectPath(); }
 	
 	/** The state class to look for. */
 	UPROPERTY(EditDefaultsOnly, Category = "Rule", meta = (NoResetToDefault, AllowAbstract))
@@ -48,6 +75,7 @@ struct SMSYSTEM_API FSMStateMachineClassRule : public FSMNodeClassRule
 	GENERATED_USTRUCT_BODY()
 
 	virtual UClass* GetClass() const override;
+	virtual FSoftObjectPath GetClassPath() const override { return StateMachineClass.ToSoftObjectPath(); }
 	
 	/** The state machine class to look for. */
 	UPROPERTY(EditDefaultsOnly, Category = "Rule", meta = (NoResetToDefault, AllowAbstract))
@@ -74,9 +102,21 @@ struct SMSYSTEM_API FSMNodeConnectionRule
 	FSMStateMachineClassRule InStateMachine;
 
 	static bool DoesClassMatch(UClass* ExpectedClass, UClass* ActualClass, const FSMNodeClassRule& Rule);
+	static bool DoesClassMatch(const FSoftObjectPath& ExpectedClass, const FSMNodeClassPathHierarchy& ActualClass, const FSMNodeClassRule& Rule);
+
+	static bool DoesRuleMatch(const FSMNodeClassRule& Rule, UClass* Class)
+	{
+		return DoesClassMatch(Rule.GetClass(), Class, Rule);
+	}
+
+	static bool DoesRuleMatch(const FSMNodeClassRule& Rule, const FSMNodeClassPathHierarchy& Class)
+	{
+		return DoesClassMatch(Rule.GetClassPath(), Class, Rule);
+	}
 
-	template<typename T>
-	static bool DoRulesPass(UClass* Class, const TArray<T>& Rules)
+	/** Check rules against a loaded class or a class path hierarchy. */
+	template<typename T, typename ClassType>
+	static bool DoRulesPass(const ClassType& Class, const TArray<T>& Rules)
 	{
 		if(Rules.Num() == 0)
 		{
@@ -91,7 +131,7 @@ struct SMSYSTEM_API FSMNodeConnectionRule
 			{
 				bCheckingInverse = true;
 			}
-			if (DoesClassMatch(Rule.GetClass(), Class, Rule))
+			if (DoesRuleMatch(Rule, Class))
 			{
 				// Only one regular rules needs to pass.
 				if (!Rule.bNOT)
@@ -133,6 +173,8 @@ struct SMSYSTEM_API FSMTransitionConnectionValidator : public FSMConnectionValid
 	
 	/** Checks if this class has rules and if any of them apply. */
 	bool IsConnectionValid(UClass* FromClass, UClass* ToClass, UClass* StateMachineClass, bool bPassOnNoRules = true) const;
+	bool IsConnectionValid(const FSMNodeClassPathHierarchy& FromClass, const FSMNodeClassPathHierarchy& ToClass,
+		const FSMNodeClassPathHierarchy& StateMachineClass, bool bPassOnNoRules = true) const;
 };
 
 /**
@@ -163,6 +205,7 @@ struct SMSYSTEM_API FSMStateConnectionValidator : public FSMConnectionValidator
 
 	/** Checks if this class has rules and if any of them apply. */
 	bool IsInboundConnectionValid(UClass* FromClass, UClass* StateMachineClass) const;
+	bool IsInboundConnectionValid(const FSMNodeClassPathHierarchy& FromClass, const FSMNodeClassPathHierarchy& StateMachineClass) const;
 	
 	/** Checks if this class has rules and if any of them apply. */
 	bool IsOutboundConnectionValid(UClass* ToClass, UClass* StateMachineClass) const;
@@ -211,5 +254,6 @@ struct SMSYSTEM_API FSMStateMachineNodePlacementValidator : public FSMConnection
 
 	/** Checks if this state can be placed in this state machine. */
 	bool IsStateAllowed(UClass* StateClass) const;
+	bool IsStateAllowed(const FSMNodeClassPathHierarchy& StateClass) const;
 };
 
@@ -501,4 +501,10 @@ private:
 
 	/** True from NativeInitialize. */
 	bool bIsInitialized;
+
+	/** The template ResetVariables copies from. Found on first reset. */
+	TWeakObjectPtr<UObject> ResetArchetype;
+
+	/** If ResetArchetype has been searched for. */
+	bool bHasSearchedResetArchetype;
 };
\ No newline at end of file
@@ -4,10 +4,13 @@
 
 #include "CoreMinimal.h"
 #include "SMGraphProperty_Base.h"
+#include "SMDebugRecorder.h"
+#include "SMProfiler.h"
 #include "SMNode_Base.generated.h"
 
 class USMInstance;
 class USMNodeInstance;
+struct FSMNodeSnapshot;
 
 UENUM()
 enum class ESMTransactionType : uint8
@@ -99,6 +102,26 @@ struct SMSYSTEM_API FSMActiveStateTransaction
 	float TimeInState;
 };
 
+#if WITH_EDITORONLY_DATA
+/**
+ * Debug state of a runtime node as displayed by the editor. Nodes write to this when their state changes
+ * and the editor reads it by index, so the editor never has to search for runtime nodes while debugging.
+ */
+struct FSMDebugNodeState
+{
+	FSMDebugNodeState() : bIsActive(false), bIsEvaluating(false), bWasActive(false), bWasEvaluating(false)
+	{
+	}
+
+	uint8 bIsActive: 1;
+	uint8 bIsEvaluating: 1;
+
+	/** Set by the runtime when the node deactivates or finishes evaluating and cleared by the editor once displayed. */
+	uint8 bWasActive: 1;
+	uint8 bWasEvaluating: 1;
+};
+#endif
+
 /**
  * Base struct for all state machine nodes. The Guid MUST be manually initialized right after construction.
  */
@@ -108,6 +131,10 @@ struct SMSYSTEM_API FSMNode_Base
 	GENERATED_USTRUCT_BODY()
 
 	friend class FSMEditorConstructionManager;
+	friend class FSMCookOptimizer;
+#if LOGICDRIVER_PROFILER_ENABLED
+	friend class FSMProfiler;
+#endif
 	
 public:
 	/** The primary graph evaluator. */
@@ -165,6 +192,9 @@ public:
 	const FGuid& GetGuid() const;
 	/** Calculate the value returned from GetGuid(). Gets all owner nodes and builds a path to this node. Hashes the path and sets PathGuid. */
 	virtual void CalculatePathGuid(TMap<FString, int32>& MappedPaths);
+
+	/** Use the path guid already calculated for the same node of another instance of the same class. */
+	void CopyPathGuid(const FSMNode_Base& FromNode) { PathGuid = FromNode.PathGuid; }
 	/** Unhashed string format of the guid path. MappedPaths are used to adjust for collisions. */
 	FString GetGuidPath(TMap<FString, int32>& MappedPaths) const;
 	
@@ -188,18 +218,30 @@ public:
 
 	/** Create the node instance if a node instance class is set. */
 	void CreateNodeInstance();
+	/** If the node instance can wait until it is first requested. Only default node classes without templates qualify. */
+	bool CanCreateNodeInstanceOnDemand() const;
+	/** Initialize the node instance. An on demand instance that hasn't been created is initialized once it is requested. */
+	void InitializeNodeInstance();
+	/** Shut down the node instance if it has been created. */
+	void ShutdownNodeInstance();
 	void CreateStackInstances();
 	virtual void RunConstructionScripts();
 	
 	/** Calls CheckNodeInstanceCompatible. */
 	void SetNodeInstanceClass(UClass* NewNodeInstanceClass);
+
+	/** The node instance class assigned to this node. May be null if using the default class. */
+	UClass* GetNodeInstanceClass() const { return NodeInstanceClass; }
 	
 	/** Derived nodes should overload and check for the correct type. */
 	virtual bool IsNodeInstanceClassCompatible(UClass* NewNodeInstanceClass) const;
 	
-	/** Return the current node instance. Only valid after initialization and may be nullptr. */
-	virtual USMNodeInstance* GetNodeInstance() const { return NodeInstance; }
-	
+	/** Return the current node instance. Only valid after initialization and may be nullptr. Creates on demand instances. */
+	virtual USMNodeInstance* GetNodeInstance() const;
+
+	/** Return the node instance only if it has been created. Never creates on demand instances. */
+	USMNodeInstance* GetNodeInstanceIfCreated() const { return NodeInstance; }
+
 	/** Returns the current stack instances. */
 	const TArray<USMNodeInstance*>& GetStackInstances() const { return StackNodeInstances; }
 	
@@ -229,6 +271,15 @@ public:
 
 	/** The time in state as recorded by the server. Kept in the base node as transitions can utilize it. */
 	float GetServerTimeInState() const { return ServerTimeInState; }
+
+	/**
+	 * Record the runtime state of this node.
+	 * @return False if the node is in its default state and doesn't need to be saved.
+	 */
+	virtual bool CaptureSnapshot(FSMNodeSnapshot& OutSnapshot) const;
+
+	/** Apply a recorded runtime state directly without running node logic. */
+	virtual void RestoreSnapshot(const FSMNodeSnapshot& InSnapshot);
 	
 	/**
 	* Checks if the instance is allowed to execute properties automatically.
@@ -248,6 +299,15 @@ public:
 
 	/** Retrieve the embedded graph properties. */
 	const TArray<FSMGraphProperty_Base_Runtime*>& GetGraphProperties() const { return GraphProperties; }
+
+	/** The size of the most derived node struct. */
+	virtual SIZE_T GetNodeStructSize() const { return sizeof(FSMNode_Base); }
+
+	/** The memory allocated by this node's containers. Graph properties and node instances aren't included. */
+	virtual SIZE_T GetAllocatedSize() const;
+
+	/** The memory used by graph properties this node evaluates. */
+	SIZE_T GetGraphPropertiesAllocatedSize() const;
 	
 #if WITH_EDITORONLY_DATA
 	virtual bool IsDebugActive() const { return bIsActive; }
@@ -255,6 +315,18 @@ public:
 	
 	/** Debug helper in case a state switches to inactive in one frame. */
 	bool bWasActive = false;
+
+	/** Index of this node in the owning instance's debug state machine. */
+	int32 DebugNodeIndex = INDEX_NONE;
+
+	/** Write the current debug state to the owning instance's debug state machine. Only done while a debugger is watching it. */
+	void PublishDebugState();
+
+	/** Copy this node's debug state. Sticky bits are only ever set. */
+	virtual void UpdateDebugNodeState(FSMDebugNodeState& InOutState) const;
+
+	/** Record an event if the owning instance is recording. */
+	void RecordDebugEvent(ESMDebugEventType Type, bool bResult = false);
 #endif
 
 #if WITH_EDITOR
@@ -270,6 +342,12 @@ protected:
 	void ResetGraphProperties();
 	void CreateGraphProperties();
 	void CreateGraphPropertiesForTemplate(USMNodeInstance* Template, const TSet<FProperty*>& GraphStructPropertiesForStateMachine);
+
+#if WITH_EDITOR
+	/** Record the node instance was accessed while the editor tracks which nodes a construction script reads. */
+	void RecordNodeInstanceRead() const;
+#endif
+	
 protected:
 	/*
 	 * NodeGuid used in constructing nodes from a graph. Set initially from the editor graph.
@@ -330,9 +408,26 @@ protected:
 	UClass* NodeInstanceClass;
 
 private:
+#if WITH_EDITOR
+	/** Set where node instance reads are recorded. Returns the previous tracker so nested construction can restore it. */
+	static TSet<const FSMNode_Base*>* SetNodeInstanceReadTracker(TSet<const FSMNode_Base*>* NewTracker);
+#endif
+	
 	/** Last recorded active time in state from the server. */
 	float ServerTimeInState;
 	
 	bool bInitialized;
 	bool bIsActive;
+
+	/** The node instance will be created the first time it is requested. */
+	bool bCreateNodeInstanceOnDemand;
+
+	/** An on demand node instance should be initialized when it is created. */
+	bool bInitializeNodeInstanceOnDemand;
+
+#if LOGICDRIVER_PROFILER_ENABLED
+	/** The profiler entry of this node, valid for CachedProfileSession. */
+	mutable FSMNodeProfile* CachedProfile = nullptr;
+	mutable uint32 CachedProfileSession = 0;
+#endif
 };
\ No newline at end of file
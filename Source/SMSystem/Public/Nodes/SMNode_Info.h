@@ -132,3 +132,23 @@ struct SMSYSTEM_API FSMStateHistory
 			this->ServerTimeInState == Other.ServerTimeInState;
 	}
 };
+
+/**
+ * [Logic Driver] An event posted to a state machine instance.
+ */
+USTRUCT(BlueprintType, meta = (DisplayName = "State Machine Event"))
+struct SMSYSTEM_API FSMEvent
+{
+	GENERATED_USTRUCT_BODY()
+
+	FSMEvent() : Payload(nullptr) {}
+	FSMEvent(FName InName, UObject* InPayload) : Name(InName), Payload(InPayload) {}
+
+	/** The name transitions subscribe to. */
+	UPROPERTY(BlueprintReadOnly, Category = "State Machines")
+	FName Name;
+
+	/** Optional object posted with the event. */
+	UPROPERTY(BlueprintReadOnly, Category = "State Machines")
+	UObject* Payload;
+};
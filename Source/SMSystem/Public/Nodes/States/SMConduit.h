@@ -50,6 +50,8 @@ public:
 	virtual bool CanExecuteGraphProperties(uint32 OnEvent, const USMStateInstance_Base* ForTemplate) const override;
 	virtual bool IsNodeInstanceClassCompatible(UClass* NewNodeInstanceClass) const override;
 	virtual UClass* GetDefaultNodeInstanceClass() const override;
+	virtual SIZE_T GetNodeStructSize() const override { return sizeof(FSMConduit); }
+	virtual SIZE_T GetAllocatedSize() const override;
 	// ~FSMNode_Base
 
 	// FSMState_Base
@@ -75,6 +77,7 @@ public:
 #if WITH_EDITORONLY_DATA
 	virtual bool IsDebugActive() const override { return bIsEvaluating ? bIsEvaluating : Super::IsDebugActive(); }
 	virtual bool WasDebugActive() const override { return bWasEvaluating ? bWasEvaluating : Super::WasDebugActive(); }
+	virtual void UpdateDebugNodeState(FSMDebugNodeState& InOutState) const override;
 	
 	/** Helper to display evaluation color in the editor. */
 	bool bWasEvaluating = false;
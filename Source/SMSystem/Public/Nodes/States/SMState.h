@@ -70,6 +70,10 @@ public:
 	virtual bool IsNodeInstanceClassCompatible(UClass* NewNodeInstanceClass) const override;
 	virtual UClass* GetDefaultNodeInstanceClass() const override;
 	virtual void ExecuteInitializeNodes() override;
+	virtual SIZE_T GetNodeStructSize() const override { return sizeof(FSMState_Base); }
+	virtual SIZE_T GetAllocatedSize() const override;
+	virtual bool CaptureSnapshot(FSMNodeSnapshot& OutSnapshot) const override;
+	virtual void RestoreSnapshot(const FSMNodeSnapshot& InSnapshot) override;
 	// ~ FSMNode_Base
 
 	/** The transitions leading out from this state, sorted lowest to highest priority. */
@@ -237,6 +241,8 @@ public:
 	virtual void Reset() override;
 	virtual void ExecuteInitializeNodes() override;
 	virtual void ExecuteShutdownNodes() override;
+	virtual SIZE_T GetNodeStructSize() const override { return sizeof(FSMState); }
+	virtual SIZE_T GetAllocatedSize() const override;
 	// ~ FSMNode_Base
 
 	// FSMState_Base
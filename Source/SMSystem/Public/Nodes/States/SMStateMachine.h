@@ -76,6 +76,9 @@ public:
 	virtual FSMNode_Base* GetOwnerNode() const override;
 	virtual void SetStartTime(const FDateTime& InStartTime) override;
 	virtual void SetServerTimeInState(float InTime) override;
+	virtual SIZE_T GetNodeStructSize() const override { return sizeof(FSMStateMachine); }
+	virtual SIZE_T GetAllocatedSize() const override;
+	virtual bool CaptureSnapshot(FSMNodeSnapshot& OutSnapshot) const override;
 	// ~FSMState_Base
 
 	/** Add a state to this State Machine. */
@@ -196,8 +199,19 @@ public:
 	/** Accessor for retrieving any previous transactions. */
 	TMap<FGuid, FSMNetworkedTransaction>& GetPreviousTransactions() { return PreviousTransactions; }
 
-	/** All contained states mapped out by their name, limited to this FSM scope. */
-	const TMap<FString, FSMState_Base*>& GetStateNameMap() const { return StateNameMap; }
+	/**
+	 * Find a contained state by name, limited to this FSM scope. Names are looked up from the class definition shared by all
+	 * instances, falling back to a linear search for native classes.
+	 */
+	FSMState_Base* FindStateByName(const FName& StateName) const;
+
+	/**
+	 * All contained states mapped out by their name, limited to this FSM scope.
+	 *
+	 * @deprecated The map is built on each call. Use FindStateByName() instead.
+	 */
+	UE_DEPRECATED(4.26, "Use `FindStateByName` instead.")
+	TMap<FString, FSMState_Base*> GetStateNameMap() const;
 	
 	/**
 	 * Forcibly add an active state.
@@ -214,6 +228,9 @@ public:
 	 * @param bReplicate If this should be replicated.
 	 */
 	void RemoveActiveState(FSMState_Base* State, bool bReplicate = false);
+
+	/** Replace the active states after restoring a snapshot. The states should already be restored and are not started. */
+	void RestoreActiveStates(const TArray<FSMState_Base*>& InStates);
 protected:
 	/**
 	 * Switches the current state and notifies the owning instance.
@@ -244,9 +261,6 @@ private:
 	 *  of active states and only on state changes. */
 	TArray<FSMState_Base*> ActiveStates;
 	
-	/** All contained states, mapped by their name. */
-	TMap<FString, FSMState_Base*> StateNameMap;
-
 	/** Keeps track of states currently processing for the given FSM scope.
 		Helps with possible infinite recursion when using multiple states that can re-enter each other. */
 	TMap<FGuid, TSet<FSMState_Base*>> ProcessingStates;
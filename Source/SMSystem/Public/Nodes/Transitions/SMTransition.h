@@ -101,6 +101,9 @@ public:
 
 	/** Destination state transitioning to. */
 	FSMState_Base* DestinationState;
+
+	/** Events this transition waits for, read from the node instance on initialize. */
+	TArray<FName> TriggerEvents;
 public:
 	virtual void UpdateReadStates() override;
 
@@ -114,6 +117,8 @@ public:
 	virtual UClass* GetDefaultNodeInstanceClass() const override;
 	virtual void ExecuteInitializeNodes() override;
 	virtual void ExecuteShutdownNodes() override;
+	virtual SIZE_T GetNodeStructSize() const override { return sizeof(FSMTransition); }
+	virtual SIZE_T GetAllocatedSize() const override;
 	// ~FSMNode_Base
 	
 	/** Will execute any transition tunnel logic. */
@@ -144,6 +149,9 @@ public:
 	/* If the transition is allowed to evaluate from an event. **/
 	bool CanEvaluateFromEvent() const;
 
+	/** The first event posted to the owning state machine this update matching #TriggerEvents, or nullptr. */
+	const FSMEvent* FindTriggeringEvent() const;
+
 	FORCEINLINE FSMState_Base* GetFromState() const { return FromState; }
 	FORCEINLINE FSMState_Base* GetToState() const { return ToState; }
 
@@ -154,6 +162,7 @@ public:
 #if WITH_EDITORONLY_DATA
 	virtual bool IsDebugActive() const override { return bIsEvaluating ? bIsEvaluating : Super::IsDebugActive(); }
 	virtual bool WasDebugActive() const override { return bWasEvaluating ? bWasEvaluating : Super::WasDebugActive(); }
+	virtual void UpdateDebugNodeState(FSMDebugNodeState& InOutState) const override;
 	/** Helper to display evaluation color in the editor. */
 	bool bWasEvaluating = false;
 #endif
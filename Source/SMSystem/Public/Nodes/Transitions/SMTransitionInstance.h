@@ -97,6 +97,22 @@ public:
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Logic Driver|Node Instance")
 	void EvaluateFromManuallyBoundEvent();
+
+	/** Public getter for #TriggerEvents. */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|Node Instance|Defaults")
+	const TArray<FName>& GetTriggerEvents() const { return TriggerEvents; }
+	/** Public setter for #TriggerEvents. */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|Node Instance|Defaults")
+	void SetTriggerEvents(const TArray<FName>& Value);
+
+	/**
+	 * Find the first event posted to the owning state machine this update that matches one of the #TriggerEvents.
+	 * Use from CanEnterTransition to read the event payload.
+	 *
+	 * @return True if a matching event was found.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|Node Instance")
+	bool GetTriggeringEvent(FSMEvent& OutEvent) const;
 	
 protected:
 	/* Override in native classes to implement. Never call these directly. */
@@ -209,6 +225,13 @@ private:
 	 */
 	UPROPERTY(EditDefaultsOnly, AdvancedDisplay, Category = Transition, meta = (NoResetToDefault))
 	bool bCanEvalWithStartState;
+
+	/**
+	 * Events posted with USMInstance::PostEvent this transition waits for. When set the transition is only
+	 * evaluated during updates where at least one matching event has been posted.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = Transition)
+	TArray<FName> TriggerEvents;
 	
 public:
 	/** Called when this transition has been entered from the previous state. */
@@ -10,6 +10,9 @@
  * Handles execution of functions exposed in blueprint graphs.
  * This is often wrapped in a TArray to reduce struct memory offsets
  * for garbage collection.
+ *
+ * The function and owner are not UPROPERTYs so handlers don't emit any GC reference tokens.
+ * The function is owned by the generated class and the owner is always the object containing this handler.
  */
 USTRUCT(BlueprintInternalUseOnly)
 struct SMSYSTEM_API FSMExposedFunctionHandler
@@ -35,10 +38,10 @@ struct SMSYSTEM_API FSMExposedFunctionHandler
 	void Execute(void* Parms = nullptr) const;
 
 private:
-	UPROPERTY()
+	/** Resolved from BoundFunction. Kept alive by the owning class. */
 	UFunction* Function;
 
-	UPROPERTY()
+	/** The instance executing the function. This owns the handler so it will always outlive it. */
 	UObject* OwnerObject;
 
 	bool bInitialized;
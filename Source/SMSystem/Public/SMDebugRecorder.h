@@ -0,0 +1,106 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CoreGlobals.h"
+
+#if WITH_EDITORONLY_DATA
+
+struct FSMDebugNodeState;
+
+enum class ESMDebugEventType : uint8
+{
+	/** A state or transition became active. */
+	Activated,
+	/** A state or transition became inactive. */
+	Deactivated,
+	/** A transition or conduit finished evaluating. */
+	Evaluated,
+	/** A transition was taken. */
+	TransitionTaken
+};
+
+/** A single recorded node event. Kept small so large buffers stay cheap. */
+struct FSMDebugEvent
+{
+	/** Seconds since recording started. */
+	float Time;
+
+	/** The engine frame the event occurred on. */
+	uint32 Frame;
+
+	/** The debug node index of the node in its instance's debug state machine. */
+	int32 NodeIndex;
+
+	ESMDebugEventType Type;
+
+	/** The result of an evaluation. */
+	bool bResult;
+};
+
+/**
+ * Records node events of a state machine instance into a fixed size ring buffer so the editor can display
+ * past frames, including changes which happened within a single frame. Recording never allocates,
+ * once the buffer is full the oldest events are overwritten.
+ */
+class SMSYSTEM_API FSMDebugRecorder
+{
+public:
+	/** Capacity is rounded up to a power of two. */
+	explicit FSMDebugRecorder(int32 InCapacity);
+
+	FORCEINLINE void Record(int32 NodeIndex, ESMDebugEventType Type, bool bResult = false)
+	{
+		FSMDebugEvent& Event = Events[WriteCount & CapacityMask];
+		Event.Time = static_cast<float>(static_cast<double>(FPlatformTime::Cycles64() - StartCycles) * FPlatformTime::GetSecondsPerCycle64());
+		Event.Frame = static_cast<uint32>(GFrameCounter);
+		Event.NodeIndex = NodeIndex;
+		Event.Type = Type;
+		Event.bResult = bResult;
+		WriteCount++;
+	}
+
+	/** Number of events currently in the buffer. */
+	int32 Num() const { return static_cast<int32>(FMath::Min<uint64>(WriteCount, Events.Num())); }
+
+	int32 GetCapacity() const { return Events.Num(); }
+
+	/** Total events recorded including events which have been overwritten. */
+	uint64 GetTotalRecorded() const { return WriteCount; }
+
+	/** An event by age where 0 is the oldest event still in the buffer. */
+	const FSMDebugEvent& GetEvent(int32 Index) const
+	{
+		check(Index >= 0 && Index < Num());
+		return Events[(WriteCount - Num() + Index) & CapacityMask];
+	}
+
+	/** The newest event recorded on or before a frame, or INDEX_NONE. */
+	int32 FindLastEventAtFrame(uint32 Frame) const;
+
+	/**
+	 * Rebuild node states as they were after an event by replaying the buffer up to it. Sticky bits are only set
+	 * for events on the same frame as the target event. Nodes which were active before the oldest event aren't known.
+	 *
+	 * @param OutTimesInState Optional recorded time each node was last active for, sized to match the node states.
+	 */
+	void ReplayTo(int32 EventIndex, TArray<FSMDebugNodeState>& InOutNodeStates, TArray<float>* OutTimesInState = nullptr) const;
+
+	/** Clear all events. */
+	void Reset();
+
+	/** If new instances should record automatically. Set with LogicDriver.DebugRecorder.AutoRecord. */
+	static bool ShouldAutoRecord();
+
+	/** The capacity to use when none is specified. Set with LogicDriver.DebugRecorder.Capacity. */
+	static int32 GetDefaultCapacity();
+
+private:
+	TArray<FSMDebugEvent> Events;
+	uint64 CapacityMask;
+	uint64 WriteCount;
+	uint64 StartCycles;
+};
+
+#endif
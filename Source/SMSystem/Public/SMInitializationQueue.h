@@ -0,0 +1,62 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+
+class USMStateMachineComponent;
+
+/**
+ * Spreads state machine component initialization across frames. Each frame queued components initialize in priority order
+ * until the frame budget set by LogicDriver.DeferredInit.BudgetMs is spent. At least one component initializes per frame.
+ */
+class SMSYSTEM_API FSMInitializationQueue : public FTickableGameObject
+{
+public:
+	static FSMInitializationQueue& Get();
+
+	/** Queue a component. Higher priorities initialize first, equal priorities in the order queued. Queuing again updates the priority. */
+	void Enqueue(USMStateMachineComponent* Component, int32 Priority);
+
+	/** Remove a component without initializing it. */
+	void Remove(const USMStateMachineComponent* Component);
+
+	bool Contains(const USMStateMachineComponent* Component) const;
+
+	int32 Num() const { return Entries.Num(); }
+
+	/**
+	 * Initialize queued components until the budget is spent.
+	 *
+	 * @param BudgetSeconds Time allowed. At least one component is always processed.
+	 * @return The number of components initialized.
+	 */
+	int32 ProcessQueue(double BudgetSeconds);
+
+	/** Initialize every queued component now, such as behind a loading screen. */
+	void Flush();
+
+	/** The per frame budget from LogicDriver.DeferredInit.BudgetMs. */
+	static double GetFrameBudgetSeconds();
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+	virtual bool IsTickable() const override { return Entries.Num() > 0; }
+	virtual bool IsTickableWhenPaused() const override { return true; }
+	// ~FTickableGameObject
+
+private:
+	struct FEntry
+	{
+		TWeakObjectPtr<USMStateMachineComponent> Component;
+		int32 Priority;
+		uint64 Order;
+	};
+
+	/** Sorted with the next component to initialize last so processing pops from the end. */
+	TArray<FEntry> Entries;
+	uint64 NextOrder = 0;
+};
@@ -7,7 +7,11 @@
 #include "SMTransitionInstance.h"
 #include "ISMStateMachineInterface.h"
 #include "SMNode_Info.h"
+#include "SMDebugRecorder.h"
+#include "SMStatePathHandle.h"
+#include "SMInstanceSnapshot.h"
 
+#include "Containers/Queue.h"
 #include "Tickable.h"
 #include "Net/UnrealNetwork.h"
 
@@ -66,11 +70,165 @@ struct FSMDebugStateMachine
 	void UpdateRuntimeNode(FSMNode_Base* RuntimeNode)
 	{
 		TArray<FSMNode_Base*>& Nodes = MappedNodes.FindOrAdd(RuntimeNode->GetNodeGuid());
-		Nodes.AddUnique(RuntimeNode);
+		if (!Nodes.Contains(RuntimeNode))
+		{
+			Nodes.Add(RuntimeNode);
+			RuntimeNode->DebugNodeIndex = IndexedNodes.Add(RuntimeNode);
+			NodeStates.AddDefaulted();
+		}
+	}
+
+	/** Find the debug indices of all runtime nodes with a NodeGuid. The editor only needs to do this once per debug session. */
+	void FindNodeIndices(const FGuid& Guid, TArray<int32>& OutIndices) const
+	{
+		if (const TArray<FSMNode_Base*>* Nodes = MappedNodes.Find(Guid))
+		{
+			for (const FSMNode_Base* Node : *Nodes)
+			{
+				OutIndices.Add(Node->DebugNodeIndex);
+			}
+		}
+	}
+
+	/** Select the index to display from indices of duplicate nodes, preferring active nodes the same as GetRuntimeNode. */
+	int32 SelectNodeIndex(const TArray<int32>& Indices) const
+	{
+		if (Indices.Num() <= 1)
+		{
+			return Indices.Num() == 1 ? Indices[0] : INDEX_NONE;
+		}
+
+		int32 LastActiveIndex = INDEX_NONE;
+		for (const int32 Index : Indices)
+		{
+			const FSMDebugNodeState& State = NodeStates[Index];
+			if (State.bIsActive || State.bIsEvaluating)
+			{
+				return Index;
+			}
+			if (State.bWasActive || State.bWasEvaluating)
+			{
+				LastActiveIndex = Index;
+			}
+		}
+
+		return LastActiveIndex != INDEX_NONE ? LastActiveIndex : Indices[0];
 	}
 
+	/** The debug state of a node. While scrubbing this is the recorded state instead of the live state. */
+	FSMDebugNodeState* GetNodeState(int32 Index)
+	{
+		TArray<FSMDebugNodeState>& States = bIsScrubbing ? ScrubbedNodeStates : NodeStates;
+		return States.IsValidIndex(Index) ? &States[Index] : nullptr;
+	}
+
+	/** The live debug state of a node regardless of scrubbing. Runtime nodes publish here. */
+	FSMDebugNodeState* GetLiveNodeState(int32 Index) { return NodeStates.IsValidIndex(Index) ? &NodeStates[Index] : nullptr; }
+	const FSMNode_Base* GetIndexedNode(int32 Index) const { return IndexedNodes.IsValidIndex(Index) ? IndexedNodes[Index] : nullptr; }
+
+	/**
+	 * Signal a debugger is reading node states this frame. Nodes only publish their state while being watched,
+	 * so when watching resumes node states are refreshed from the runtime nodes once.
+	 */
+	void Watch()
+	{
+		if (!IsBeingWatched())
+		{
+			for (int32 Idx = 0; Idx < IndexedNodes.Num(); ++Idx)
+			{
+				FSMDebugNodeState CurrentState;
+				IndexedNodes[Idx]->UpdateDebugNodeState(CurrentState);
+
+				// Only current state. Anything which happened while not being watched is stale.
+				CurrentState.bWasActive = CurrentState.bWasEvaluating = false;
+				NodeStates[Idx] = CurrentState;
+			}
+		}
+
+		LastWatchedFrame = GFrameCounter;
+		bHasBeenWatched = true;
+	}
+
+	/** Signal the debugger stopped reading node states. Nodes stop publishing immediately. */
+	void StopWatching() { bHasBeenWatched = false; }
+
+	/** Start recording node events. Any previous recording is discarded. */
+	void StartRecording(int32 Capacity = 0)
+	{
+		Recorder = MakeShared<FSMDebugRecorder>(Capacity > 0 ? Capacity : FSMDebugRecorder::GetDefaultCapacity());
+	}
+
+	void StopRecording()
+	{
+		StopScrubbing();
+		Recorder.Reset();
+	}
+
+	/** The active recorder or null if not recording. */
+	FSMDebugRecorder* GetRecorder() const { return Recorder.Get(); }
+
+	/** Display node states as they were after a recorded event. */
+	void ScrubTo(int32 EventIndex)
+	{
+		if (Recorder.IsValid())
+		{
+			ScrubbedNodeStates.SetNum(NodeStates.Num());
+			Recorder->ReplayTo(EventIndex, ScrubbedNodeStates, &ScrubbedTimesInState);
+			ScrubbedEventIndex = EventIndex;
+			bIsScrubbing = true;
+		}
+	}
+
+	/** Return to displaying live node states. */
+	void StopScrubbing()
+	{
+		bIsScrubbing = false;
+		ScrubbedEventIndex = INDEX_NONE;
+		ScrubbedNodeStates.Reset();
+		ScrubbedTimesInState.Reset();
+	}
+
+	bool IsScrubbing() const { return bIsScrubbing; }
+
+	/** The recorded event being scrubbed to or INDEX_NONE. */
+	int32 GetScrubbedEventIndex() const { return ScrubbedEventIndex; }
+
+	/** The recorded time a node was last active for at the event being scrubbed to. */
+	float GetScrubbedTimeInState(int32 Index) const { return ScrubbedTimesInState.IsValidIndex(Index) ? ScrubbedTimesInState[Index] : 0.f; }
+
+	/** If a debugger has read node states recently. */
+	bool IsBeingWatched() const { return IsBeingWatched(GFrameCounter); }
+
+	/** If a debugger has read node states recently as of a frame number. */
+	bool IsBeingWatched(uint64 Frame) const { return bHasBeenWatched && Frame - LastWatchedFrame <= MaxUnwatchedFrames; }
+
 	/** All states including nested state machine states. These are only NodeGuids and not PathGuids. */
 	TMap<FGuid, TArray<FSMNode_Base*>> MappedNodes;
+
+	/** Runtime nodes by debug index. */
+	TArray<FSMNode_Base*> IndexedNodes;
+
+	/** Debug state by debug index. Written by nodes as their state changes. */
+	TArray<FSMDebugNodeState> NodeStates;
+
+	/** Unique to each initialization of an instance so the editor knows when to look up debug indices again. */
+	uint32 Generation = 0;
+
+private:
+	/** Frames the editor can skip reading before nodes stop publishing. */
+	static constexpr uint64 MaxUnwatchedFrames = 2;
+
+	uint64 LastWatchedFrame = 0;
+	bool bHasBeenWatched = false;
+
+	/** Records node events when set. Only instances selected for recording allocate one. */
+	TSharedPtr<FSMDebugRecorder> Recorder;
+
+	/** Node states rebuilt from the recorder for the event being scrubbed to. */
+	TArray<FSMDebugNodeState> ScrubbedNodeStates;
+	TArray<float> ScrubbedTimesInState;
+	int32 ScrubbedEventIndex = INDEX_NONE;
+	bool bIsScrubbing = false;
 #endif
 };
 
@@ -126,6 +284,31 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
 	virtual void Initialize(UObject* Context = nullptr) override;
 
+	/**
+	 * Initialize by copying an initialized instance of the same class instead of building every node from its template.
+	 * Node instances are created from the prototype's node instances without running construction scripts again,
+	 * path guids are copied and references are cloned from the prototype's references. Context dependent setup such
+	 * as input and OnStateMachineInitialized still runs. Falls back to Initialize() if the prototype can't be used.
+	 *
+	 * @param Prototype An initialized instance of this class which isn't running.
+	 * @param Context The context for this instance.
+	 */
+	void InitializeFromPrototype(USMInstance* Prototype, UObject* Context);
+
+	/**
+	 * Initialize an instance which is only used as the prototype of other instances. Input isn't bound and
+	 * OnStateMachineInitialized isn't called.
+	 *
+	 * @param Context The context for the prototype. This should be a neutral object such as the world.
+	 */
+	void InitializeAsPrototype(UObject* Context);
+
+	/** If this instance was initialized with InitializeAsPrototype(). */
+	bool IsPrototype() const { return bIsPrototype; }
+
+	/** The node of the prototype at the same location as the given node. Only valid during InitializeFromPrototype(). */
+	const FSMNode_Base* FindPrototypeNode(const FSMNode_Base& Node) const;
+
 	/** Start the root state machine. */
 	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
 	virtual void Start() override;
@@ -161,6 +344,25 @@ public:
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
 	void EvaluateTransitions();
+
+	/**
+	 * Queue an event for the next update. All pending events are drained once at the start of an update and remain
+	 * available for that update only. Transitions with trigger events are only evaluated while a matching event is present.
+	 *
+	 * Safe to call from any thread. Events posted to a reference are forwarded to the instance owning it.
+	 *
+	 * @param EventName The name transitions subscribe to.
+	 * @param Payload Optional object to pass with the event. It is not kept alive by the queue.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	void PostEvent(FName EventName, UObject* Payload = nullptr);
+
+	/** Events drained for the current update. Empty outside of an update. */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	const TArray<FSMEvent>& GetCurrentEvents() const { return CurrentEvents; }
+
+	/** Find the first event of the current update with the given name. */
+	const FSMEvent* FindCurrentEvent(FName EventName) const;
 	
 	/**
 	 * Sets a temporary initial state of the guid's owning state machine.
@@ -189,6 +391,37 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
 	bool AreInitialStatesSetFromLoad() const { return R_bLoadFromStatesCalled; }
 
+	/**
+	 * Record the complete runtime state of this instance and all references. This includes active states, times,
+	 * state history and node instance properties marked SaveGame.
+	 * The snapshot has no object references and can be converted to bytes on any thread.
+	 */
+	void CaptureSnapshot(FSMInstanceSnapshot& OutSnapshot) const;
+
+	/**
+	 * Apply a snapshot captured from an instance of the same class. The instance must be initialized and not running.
+	 * States are restored directly as active without running begin logic.
+	 * @return False if the snapshot could not be applied.
+	 */
+	bool RestoreSnapshot(const FSMInstanceSnapshot& InSnapshot);
+
+	/** Capture a snapshot and write it to a compact versioned binary format. */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	void SaveSnapshotToBytes(TArray<uint8>& OutBytes) const;
+
+	/** Read and restore a snapshot written by SaveSnapshotToBytes(). */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	bool RestoreSnapshotFromBytes(const TArray<uint8>& InBytes);
+
+	/**
+	 * Move a running instance to the active states of a snapshot without executing any state or transition logic.
+	 * Only states whose active status differs are changed, all others keep their current data.
+	 * Used to correct mispredicted transitions.
+	 *
+	 * @return False if the snapshot could not be applied.
+	 */
+	bool RollbackToSnapshot(const FSMInstanceSnapshot& InSnapshot);
+
 protected:
 	/**
 	 * Called after an initial state has been set with LoadFromState() or LoadFromMultipleStates().
@@ -354,6 +587,26 @@ public:
 	/** Linear search all state machines for a contained node. */
 	FSMState_Base* FindStateByGuid(const FGuid& Guid) const;
 
+	/**
+	 * Resolve a qualified state name such as "Combat.Melee.Windup" relative to the root state machine. Nested state machines and
+	 * state machine references are separated by a period. Resolve once and reuse the handle with GetStateInstanceByHandle.
+	 *
+	 * @param QualifiedName State names from the root state machine separated by a period.
+	 * @return The handle which is invalid if the state couldn't be found.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	FSMStatePathHandle ResolveStatePath(const FString& QualifiedName) const;
+
+	/** Return the state instance of a resolved state path. The handle must be resolved from an instance of the same class. */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	USMStateInstance_Base* GetStateInstanceByHandle(const FSMStatePathHandle& Handle) const;
+
+	/** Constant time lookup of a state from a resolved state path. */
+	FSMState_Base* GetStateByHandle(const FSMStatePathHandle& Handle) const;
+
+	/** The topology shared by all instances of this class. Used for name lookups. May be null if the class isn't a blueprint. */
+	const FSMStateMachineDefinition* GetStateMachineDefinition() const { return StateMachineDefinition.Get(); }
+
 	/** The root state machine which may contain nested state machines. */
 	FSMStateMachine& GetRootStateMachine() { return RootStateMachine; }
 
@@ -570,6 +823,12 @@ public:
 	
 	bool IsLoggingEnabled() const { return bEnableLogging; }
 
+	/** If this instance is the root of a garbage collection cluster. */
+	bool IsGCClusterRoot() const;
+
+	/** If default node instances are only created when requested. */
+	bool ShouldCreateNodeInstancesOnDemand() const { return bCreateNodeInstancesOnDemand; }
+
 protected:
 	virtual void Tick_Implementation(float DeltaTime);
 	virtual void OnStateMachineInitialized_Implementation();
@@ -594,6 +853,12 @@ protected:
 	/** Logs a warning if not initialized. */
 	bool CheckIsInitialized() const;
 
+	/** Create a GC cluster for this instance and all of its owned objects if configured. */
+	void CreateGCCluster();
+
+	/** Dissolve the GC cluster rooted at this instance so objects can be recreated or collected individually. */
+	void ReleaseGCCluster();
+
 	/** Records time running so delta time can be established if not ticking or providing accurate delta seconds. */
 	void UpdateTime();
 
@@ -605,9 +870,43 @@ protected:
 
 	/** Makes sure state history current count doesn't exceed max count. */
 	void TrimStateHistory();
+
+	/** Resolve as much of a qualified state name as this class contains, continuing into state machine references. */
+	bool AppendStatePathHops(const FString& QualifiedName, FSMStatePathHandle& Handle) const;
+
+	/** Record this instance and the nodes it owns, excluding references. */
+	void CaptureInstanceRecord(FSMInstanceRecord& OutRecord) const;
+
+	/** Apply a record captured from the same position in an instance of the same class. */
+	void RestoreInstanceRecord(const FSMInstanceRecord& InRecord);
+
+	/** Apply only the differences in active states of a record. */
+	void RollbackInstanceRecord(const FSMInstanceRecord& InRecord);
+
+	/** Call a function for this instance and each reference with their record from the snapshot. */
+	bool ForEachInstanceRecord(const FSMInstanceSnapshot& InSnapshot, TFunctionRef<void(USMInstance&, const FSMInstanceRecord&)> Func);
 	
+	void DoInitialize(UObject* Context, USMInstance* Prototype, bool bAsPrototype = false);
 	void DoStart();
 
+	/**
+	 * Run a graph function which a blueprint child compiled for a node of this native class. Used by classes generated from a
+	 * state machine blueprint: once the blueprint is reparented to the generated class the generated nodes run, and the
+	 * blueprint node with the same guid only supplies graph functions. The blueprint node is updated from the native node
+	 * before the function runs and any value the function changes, such as the result of a transition, is copied back.
+	 *
+	 * @param Node The native node.
+	 * @param HandlerName The function handler array of the node, such as GraphEvaluator.
+	 * @param HandlerIndex The handler within the array.
+	 * @param Params Parameters of the graph function.
+	 *
+	 * @return True if the blueprint has the function.
+	 */
+	bool ExecuteBlueprintNodeFunction(FSMNode_Base& Node, FName HandlerName, int32 HandlerIndex = 0, void* Params = nullptr);
+
+	/** The blueprint node property matching a native node and the graph function of one of its handlers. */
+	TTuple<FStructProperty*, UFunction*> FindBlueprintNodeFunction(const FSMNode_Base& Node, FName HandlerName, int32 HandlerIndex) const;
+
 	UFUNCTION()
 	void REP_StartChanged();
 
@@ -631,11 +930,27 @@ protected:
 	
 	/** Map of all StateMachine Path Guids */
 	TSet<FGuid> StateMachineGuids;
+
+	/** The topology of this class, shared with all other instances. */
+	TSharedPtr<const FSMStateMachineDefinition> StateMachineDefinition;
 	
 	/** Networked transactions that are currently being executed. Only valid for one update cycle and only used if there is a server object. */
 	UPROPERTY(Transient)
 	TArray<FSMNetworkedTransaction> ActiveTransactions;
 
+	struct FSMPendingEvent
+	{
+		FName Name;
+		TWeakObjectPtr<UObject> Payload;
+	};
+
+	/** Events posted from any thread waiting for the next update. */
+	TQueue<FSMPendingEvent, EQueueMode::Mpsc> PendingEvents;
+
+	/** Events drained from PendingEvents for the current update. */
+	UPROPERTY(Transient)
+	TArray<FSMEvent> CurrentEvents;
+
 	/** Ordered history of states, oldest to newest, not including active state(s). */
 	UPROPERTY(VisibleInstanceOnly, Category = "State Machine Instance|History")
 	TArray<FSMStateHistory> StateHistory;
@@ -714,6 +1029,34 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category = "State Machine Instance|Logging", meta = (EditCondition = "bEnableLogging"))
 	bool bLogTransitionTaken = true;
 
+	/**
+	 * Form a garbage collection cluster rooted at this instance once it has initialized. Node instances, stack instances,
+	 * references and input components become members so the garbage collector marks the whole state machine at once
+	 * rather than walking every node.
+	 *
+	 * Clusters assume references don't change after creation. Objects assigned to node instance variables at run-time
+	 * must be referenced elsewhere or they may be collected. Only the primary instance creates a cluster and clusters
+	 * are never created in the editor.
+	 */
+	UPROPERTY(EditDefaultsOnly, AdvancedDisplay, Category = "State Machine Instance|Performance")
+	bool bCreateGCCluster = false;
+
+	/**
+	 * Share the state machine topology between every instance of this class. States and transitions are linked from a
+	 * definition resolved once per class rather than searching class properties on every Initialize.
+	 * Recommended when many instances of the same class are created.
+	 */
+	UPROPERTY(EditDefaultsOnly, AdvancedDisplay, Category = "State Machine Instance|Performance")
+	bool bUseSharedDefinition = false;
+
+	/**
+	 * Nodes using a default node class without templates or stack instances only create their node instance the
+	 * first time it is requested, such as from GetNodeInstance or state info lookups. This greatly reduces the number
+	 * of objects for large state machines that mostly use graph logic.
+	 */
+	UPROPERTY(EditDefaultsOnly, AdvancedDisplay, Category = "State Machine Instance|Performance")
+	bool bCreateNodeInstancesOnDemand = false;
+
 	///////////////////////
 	/// Input
 	///////////////////////
@@ -805,6 +1148,15 @@ protected:
 
 	/** Signal the state machine has been initialized. Normally set automatically when calling Initialize(). */
 	uint32 bInitialized: 1;
+
+	/** Set by InitializeAsPrototype(). References of a prototype are prototypes as well. */
+	uint32 bIsPrototype: 1;
+
+	/** The instance being copied during InitializeFromPrototype(). */
+	USMInstance* InitializingPrototype = nullptr;
+
+	/** Node guid, handler name and index -> blueprint node function. Misses are kept so they are only reported once. */
+	TMap<TTuple<FGuid, FName, int32>, TTuple<FStructProperty*, UFunction*>> BlueprintNodeFunctions;
 public:
 	/*
 	 * Archetype objects used for instantiating references. Only valid from the CDO.
@@ -0,0 +1,102 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SMNode_Info.h"
+
+enum class ESMInstanceSnapshotVersion : int32
+{
+	Initial = 1,
+
+	// -----<new versions can be added above this line>-----
+	VersionPlusOne,
+	LatestVersion = VersionPlusOne - 1
+};
+
+/** Runtime state of a single node. */
+struct SMSYSTEM_API FSMNodeSnapshot
+{
+	enum EFlags : uint8
+	{
+		Active = 1 << 0,
+		HasUpdated = 1 << 1,
+		InEndState = 1 << 2
+	};
+
+	/** The node path guid. */
+	FGuid Guid;
+
+	float TimeInState = 0.f;
+	float ServerTimeInState = 0.f;
+
+	/** States only: UTC time the state started. */
+	FDateTime StartTime;
+
+	/** EFlags. */
+	uint8 Flags = 0;
+
+	/** State machines only: The path guids of active states in activation order. */
+	TArray<FGuid> ActiveStates;
+
+	/** SaveGame properties of the node instance. */
+	TArray<uint8> NodeInstanceData;
+
+	bool HasFlag(EFlags Flag) const { return (Flags & Flag) != 0; }
+	void SetFlag(EFlags Flag, bool bValue) { Flags = bValue ? (Flags | Flag) : (Flags & ~Flag); }
+
+	friend FArchive& operator<<(FArchive& Ar, FSMNodeSnapshot& Snapshot);
+};
+
+/** Runtime state of a state machine instance and the nodes it owns, excluding nodes of references. */
+struct SMSYSTEM_API FSMInstanceRecord
+{
+	/** The path guid of the instance root state machine. */
+	FGuid RootGuid;
+
+	bool bHasStarted = false;
+
+	TArray<FSMStateHistory> StateHistory;
+
+	/** SaveGame properties of the instance. */
+	TArray<uint8> InstanceData;
+
+	TArray<FSMNodeSnapshot> Nodes;
+
+	friend FArchive& operator<<(FArchive& Ar, FSMInstanceRecord& Record);
+};
+
+/**
+ * Complete runtime state of a state machine instance and its references.
+ *
+ * Capturing and restoring must happen on the game thread as they read the instance, but the snapshot itself contains
+ * no object references so converting to and from bytes can be done on any thread.
+ */
+struct SMSYSTEM_API FSMInstanceSnapshot
+{
+	int32 Version = static_cast<int32>(ESMInstanceSnapshotVersion::LatestVersion);
+
+	/** The path name of the instance class the snapshot was captured from. */
+	FString ClassPath;
+
+	/** The primary instance first, followed by all references. */
+	TArray<FSMInstanceRecord> Instances;
+
+	bool IsEmpty() const { return Instances.Num() == 0; }
+
+	void Serialize(FArchive& Ar);
+
+	void SaveToBytes(TArray<uint8>& OutBytes);
+
+	/** @return False if the data could not be read or is from a newer version. */
+	bool LoadFromBytes(const TArray<uint8>& InBytes);
+
+	/** If the class has any properties flagged SaveGame. */
+	static bool HasSaveGameProperties(const UClass* Class);
+
+	/** Write SaveGame properties of an object. Game thread only. */
+	static void SaveSaveGameProperties(UObject* Object, TArray<uint8>& OutBytes);
+
+	/** Read SaveGame properties into an object. Game thread only. */
+	static void LoadSaveGameProperties(UObject* Object, const TArray<uint8>& InBytes);
+};
@@ -0,0 +1,68 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class USMInstance;
+
+/** Estimated memory of state machine instances. Sizes are in bytes. */
+struct SMSYSTEM_API FSMMemoryUsage
+{
+	/** The class measured, or the instance's class for a single instance. */
+	FString ClassName;
+
+	int32 NumInstances = 0;
+
+	/** Instances which are state machine references owned by another instance. */
+	int32 NumReferenceInstances = 0;
+
+	int32 NumNodes = 0;
+	int32 NumNodeInstances = 0;
+
+	/** The USMInstance objects. */
+	SIZE_T InstanceBytes = 0;
+
+	/** Runtime node structs and their containers. */
+	SIZE_T NodeStructBytes = 0;
+
+	/** Node instance and stack instance objects. */
+	SIZE_T NodeInstanceBytes = 0;
+
+	SIZE_T GraphPropertyBytes = 0;
+
+	/** GuidNodeMap, GuidStateMap and GuidTransitionMap. */
+	SIZE_T GuidMapBytes = 0;
+
+	SIZE_T StateHistoryBytes = 0;
+
+	SIZE_T GetTotalBytes() const
+	{
+		return InstanceBytes + NodeStructBytes + NodeInstanceBytes + GraphPropertyBytes + GuidMapBytes + StateHistoryBytes;
+	}
+
+	void Accumulate(const FSMMemoryUsage& Other);
+};
+
+/**
+ * Walks live state machine instances to estimate their memory per class. Available in all builds so budgets can be
+ * measured on target hardware. Use LogicDriver.MemReport [Rows=N] [-Csv[=File]] or call directly.
+ */
+class SMSYSTEM_API FSMMemoryReport
+{
+public:
+	/** Memory owned by a single instance. Nodes of referenced state machines are counted by the referenced instance. */
+	static FSMMemoryUsage GetInstanceMemoryUsage(const USMInstance* Instance);
+
+	/** Memory of every live instance aggregated per class, sorted by highest total. */
+	static TArray<FSMMemoryUsage> GetClassMemoryUsage();
+
+	/** Combine usage into a single total. */
+	static FSMMemoryUsage GetTotal(const TArray<FSMMemoryUsage>& Usages);
+
+	/** A table of the classes using the most memory followed by the totals. MaxRows <= 0 includes every class. */
+	static FString ToTable(const TArray<FSMMemoryUsage>& Usages, int32 MaxRows = 20);
+	static FString ToCsv(const TArray<FSMMemoryUsage>& Usages);
+
+	static FString GetDefaultCsvFilename();
+};
@@ -0,0 +1,162 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** The node profiler is available in all builds except shipping. */
+#define LOGICDRIVER_PROFILER_ENABLED (!UE_BUILD_SHIPPING)
+
+struct FSMNode_Base;
+class FSMProfileScope;
+
+/** Node work measured by the profiler. */
+enum class ESMProfileCategory : uint8
+{
+	/** Transition evaluations through DoesTransitionPass. Passes count the evaluations which succeeded. */
+	TransitionPass,
+	/** State updates. */
+	StateUpdate,
+	/** Graph property evaluation. */
+	GraphProperties,
+	/** Execution of a node's blueprint graph. */
+	GraphFunction,
+	Max
+};
+
+/** Counters for one category of a node. */
+struct FSMProfileStat
+{
+	int64 Count = 0;
+	int64 Passes = 0;
+	int64 TotalCycles = 0;
+	/** Total time excluding other profiled work nested inside, such as a graph function run by a transition pass. */
+	int64 SelfCycles = 0;
+	int64 PeakCycles = 0;
+
+	double GetTotalMs() const;
+	double GetSelfMs() const;
+	double GetPeakMs() const;
+	double GetAverageMs() const;
+};
+
+/** Counters of a node aggregated across all instances of a blueprint class. */
+struct FSMNodeProfile
+{
+	const UClass* InstanceClass = nullptr;
+	FString ClassName;
+	FString NodeName;
+	FGuid NodeGuid;
+	FSMProfileStat Stats[static_cast<uint8>(ESMProfileCategory::Max)];
+
+	const FSMProfileStat& GetStat(ESMProfileCategory Category) const { return Stats[static_cast<uint8>(Category)]; }
+};
+
+#if LOGICDRIVER_PROFILER_ENABLED
+
+/**
+ * Lightweight per node profiler. While a session is running node work is counted per blueprint class and node
+ * so the most expensive nodes across every instance can be found. Control with LogicDriver.Profile Start|Stop|Dump.
+ */
+class SMSYSTEM_API FSMProfiler
+{
+public:
+	static FSMProfiler& Get();
+
+	/** Begin a new session, discarding previous results. */
+	void Start();
+	void Stop();
+
+	static bool IsProfiling() { return bIsProfiling; }
+
+	/** Record work done by a node. SelfCycles excludes nested profiled work. Only call while profiling. */
+	void Record(const FSMNode_Base& Node, ESMProfileCategory Category, int64 Cycles, int64 SelfCycles, bool bPassed);
+
+	/** The innermost profile scope running on this thread. */
+	static FSMProfileScope*& GetCurrentScope();
+
+	/**
+	 * Profiles sorted by most total time of a category, or of all categories combined if Max.
+	 * Combined time sums self time so work nested in another category is only counted once.
+	 */
+	TArray<const FSMNodeProfile*> GetSortedProfiles(ESMProfileCategory SortCategory = ESMProfileCategory::Max) const;
+
+	/** A table of the most expensive nodes. MaxRows <= 0 includes every node. */
+	FString ToTable(int32 MaxRows = 20, ESMProfileCategory SortCategory = ESMProfileCategory::Max) const;
+	FString ToCsv(ESMProfileCategory SortCategory = ESMProfileCategory::Max) const;
+
+	static const TCHAR* GetCategoryName(ESMProfileCategory Category);
+	static FString GetDefaultCsvFilename();
+
+private:
+	FSMNodeProfile* FindOrAddProfile(const FSMNode_Base& Node);
+
+private:
+	static bool bIsProfiling;
+
+	/** Incremented each session so cached node entries from older sessions are ignored. */
+	uint32 Session = 0;
+
+	/** Owns every profile of the session. Entries are never removed while a session runs so nodes can cache them. */
+	TArray<TUniquePtr<FSMNodeProfile>> Profiles;
+	TMap<TPair<const UClass*, FGuid>, FSMNodeProfile*> ProfileMap;
+	mutable FCriticalSection CriticalSection;
+};
+
+/** Measure node work for the profiler. Only reads the clock while a session is running. */
+class FSMProfileScope
+{
+public:
+	FORCEINLINE FSMProfileScope(const FSMNode_Base& InNode, ESMProfileCategory InCategory) : Node(InNode), Category(InCategory),
+		StartCycles(FSMProfiler::IsProfiling() ? FPlatformTime::Cycles64() : 0)
+	{
+		if (StartCycles != 0)
+		{
+			FSMProfileScope*& CurrentScope = FSMProfiler::GetCurrentScope();
+			ParentScope = CurrentScope;
+			CurrentScope = this;
+		}
+	}
+
+	FORCEINLINE ~FSMProfileScope()
+	{
+		if (StartCycles != 0)
+		{
+			const int64 Cycles = static_cast<int64>(FPlatformTime::Cycles64() - StartCycles);
+			FSMProfiler::GetCurrentScope() = ParentScope;
+			if (ParentScope)
+			{
+				ParentScope->ChildCycles += Cycles;
+			}
+
+			if (FSMProfiler::IsProfiling())
+			{
+				FSMProfiler::Get().Record(Node, Category, Cycles, Cycles - ChildCycles, bPassed);
+			}
+		}
+	}
+
+	/** Mark the work as passed, such as a transition which can be taken. */
+	void SetPassed(bool bValue) { bPassed = bValue; }
+
+private:
+	const FSMNode_Base& Node;
+	ESMProfileCategory Category;
+	uint64 StartCycles;
+
+	/** The scope this is nested in, which excludes this scope's time from its self time. */
+	FSMProfileScope* ParentScope = nullptr;
+	int64 ChildCycles = 0;
+
+	bool bPassed = false;
+};
+
+#define SM_PROFILE_NODE_SCOPE(Node, Category) FSMProfileScope SMProfileScope(Node, Category)
+#define SM_PROFILE_NODE_SCOPE_PASSED(bValue) SMProfileScope.SetPassed(bValue)
+
+#else
+
+#define SM_PROFILE_NODE_SCOPE(Node, Category)
+#define SM_PROFILE_NODE_SCOPE_PASSED(bValue)
+
+#endif
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "SMInstance.h"
+#include "SMUtils.h"
 #include "ISMStateMachineInterface.h"
 
 #include "GameFramework/Actor.h"
@@ -11,6 +12,16 @@
 
 #include "SMStateMachineComponent.generated.h"
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnStateMachineClassPreloadedEventSignature, TSubclassOf<class USMInstance>, StateMachineClass);
+
+/** How much of the state machine a network connection receives. */
+UENUM()
+enum class ESMNetRelevancy : uint8
+{
+	Full,		// Every change, every net update.
+	Coarse		// Instance state at a reduced rate.
+};
+
 /**
  * Actor Component wrapper for a State Machine Instance. Supports Replication. Will default state machine context to the owning actor of this component.
  * Call Start() when ready.
@@ -111,6 +122,23 @@ public:
 
 	/** If the SERVER can process transitions. */
 	bool CanServerProcessTransitions() const;
+
+	/**
+	 * The level of detail a connection receives. The owning connection is always full. The default makes connections
+	 * whose view target is farther than CoarseNetRelevancyDistance coarse. Override for game specific relevancy.
+	 */
+	virtual ESMNetRelevancy GetNetRelevancyForConnection(const UNetConnection* Connection) const;
+
+	/** If transitions taken by clients are predicted. Requires bPredictTransitions and bTakeTransitionsFromServerOnly to be false. */
+	bool IsPredictingTransitions() const;
+
+	/** Predicted transitions the server has confirmed on this client. */
+	UFUNCTION(BlueprintPure, Category = "Logic Driver|State Machine Components")
+	int32 GetNumConfirmedPredictions() const { return NumConfirmedPredictions; }
+
+	/** Predicted transitions the server has rejected on this client, each causing a rollback. */
+	UFUNCTION(BlueprintPure, Category = "Logic Driver|State Machine Components")
+	int32 GetNumMispredictions() const { return NumMispredictions; }
 	
 	/** Find the highest level owning actor of this component. Useful if this component is used within a child actor component. */
 	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Components")
@@ -130,6 +158,37 @@ public:
 	 */
 	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "State Machine Components")
 	UObject* GetContextForInitialization() const;
+
+	/**
+	 * Asynchronously load a state machine class and its dependencies then assign it as the StateMachineClass.
+	 * Calls to Initialize and Start made while loading are deferred until loading has finished.
+	 * This avoids synchronous loads when the class is only soft referenced.
+	 *
+	 * @param InStateMachineClass The state machine class to load and use.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Components")
+	void PreloadStateMachineClass(TSoftClassPtr<USMInstance> InStateMachineClass);
+
+	/** If a state machine class is currently being preloaded. */
+	UFUNCTION(BlueprintPure, Category = "Logic Driver|State Machine Components")
+	bool IsPreloadingStateMachineClass() const;
+
+	/**
+	 * Queue initialization to run during a later frame within the per frame budget set by LogicDriver.DeferredInit.BudgetMs.
+	 * Start and Stop called while pending are applied once initialized, Update is ignored and Initialize runs immediately.
+	 * Bind to OnStateMachineInitializedEvent to know when the instance is ready.
+	 *
+	 * @param bStartWhenInitialized Start the state machine once it has initialized.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Components")
+	void InitializeDeferred(bool bStartWhenInitialized = false);
+
+	/** If initialization is waiting in the deferred initialization queue. */
+	UFUNCTION(BlueprintPure, Category = "Logic Driver|State Machine Components")
+	bool IsInitializationPending() const { return bInitializationPending; }
+
+	/** Initialize now and run a deferred Start. Called by the initialization queue. */
+	void ProcessDeferredInitialization();
 	
 	/** Called when the state machine is first initialized. */
 	UPROPERTY(BlueprintAssignable, Category = "Logic Driver|State Machine Components")
@@ -154,6 +213,10 @@ public:
 	/** Called when a state machine has switched states. */
 	UPROPERTY(BlueprintAssignable, Category = "Logic Driver|State Machine Components")
 	FOnStateMachineStateChangedSignature OnStateMachineStateChangedEvent;
+
+	/** Called when a preloaded state machine class has been assigned, before any deferred initialization. */
+	UPROPERTY(BlueprintAssignable, Category = "Logic Driver|State Machine Components")
+	FOnStateMachineClassPreloadedEventSignature OnStateMachineClassPreloadedEvent;
 protected:
 	UFUNCTION()
 	void Internal_OnStateMachineStarted(USMInstance* Instance);
@@ -182,6 +245,15 @@ protected:
 
 	/** If networked pending transitions should be discarded. */
 	bool ShouldDiscardTransitionsBeforeInitialize() const;
+
+	/** Assign the preloaded class and run any deferred Initialize or Start. */
+	void OnStateMachineClassPreloaded();
+
+	/** Stop any preload in progress and discard deferred calls. */
+	void CancelPreload();
+
+	/** Remove this component from the initialization queue and discard a deferred Start. */
+	void CancelDeferredInitialization();
 	
 #if WITH_EDITOR
 	/** Initialize the USMInstance template based on the current StateMachineClass. */
@@ -193,6 +265,9 @@ protected:
 #endif
 
 	USMInstance* CreateInstance(UObject* Context);
+
+	/** The initialized prototype shared by components with the same archetype, created in the world of the context if needed. */
+	USMInstance* GetOrCreatePrototype(UObject* Context);
 	virtual void DoInitialize(UObject* Context);
 	virtual void DoStart();
 	virtual void DoUpdate(float DeltaTime);
@@ -204,6 +279,24 @@ protected:
 
 	/* Removes all replicated transitions that have expired. */
 	void RemoveExpiredTransactions(const FDateTime& CurrentTime);
+
+	/** If the instance should replicate to a connection this net update. */
+	bool ShouldReplicateInstanceToConnection(UNetConnection* Connection, bool bNetInitial);
+
+	/** Let dormant clients receive the latest changes when dormancy is managed. */
+	void FlushNetDormancyIfManaged();
+
+	/** Put the owner to sleep once all replicated transactions have expired. */
+	void UpdateNetDormancy();
+
+	/** Take predicted transactions in order, rejecting the first invalid transaction and everything after it. */
+	void ProcessPredictedTransactions(const TArray<FSMNetworkedTransaction>& Transactions);
+
+	/**
+	 * Check a transaction predicted by a client can be taken from the current server state.
+	 * The default only requires the source state to be active. Override for gameplay validation.
+	 */
+	virtual bool IsPredictedTransactionValid(const FSMNetworkedTransaction& Transaction) const;
 	
 	///////////////////////
 	/// Server
@@ -232,6 +325,10 @@ protected:
 	UFUNCTION(Server, Reliable, WithValidation)
 	void SERVER_ProcessTransaction(const TArray<FSMNetworkedTransaction>& Transactions);
 
+	/** Signal the owning client its predicted transactions were rejected and it should roll back to the server snapshot. */
+	UFUNCTION(Client, Reliable)
+	void CLIENT_RejectPredictedTransactions(const TArray<FGuid>& TransactionGuids, FDateTime ServerTime, const TArray<uint8>& ServerSnapshot);
+
 	/** When the StateMachineInstance is loaded from the server. */
 	UFUNCTION()
 	virtual void REP_OnInstanceLoaded();
@@ -296,6 +393,15 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Network", meta = (EditCondition = "bReplicates"))
 	bool bTakeTransitionsFromServerOnly;
 
+	/**
+	 * Clients take transitions immediately and the server confirms or rejects them. When a predicted transition is rejected
+	 * the client rolls back to the active states of the server without running state or transition logic.
+	 *
+	 * Requires client driven transitions and a player controller. Ignored when bTakeTransitionsFromServerOnly is true.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Network", meta = (EditCondition = "bReplicates && !bTakeTransitionsFromServerOnly"))
+	bool bPredictTransitions;
+
 	/**
 	 * The domain to execute OnTransitionEntered logic.
 	 * This fires for transitions when one is being taken to the next state.
@@ -349,6 +455,26 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, AdvancedDisplay, Category = "Network", meta = (EditCondition = "bTakeTransitionsFromServerOnly") )
 	float MaxTimeToWaitForTransitionUpdate;
 
+	/**
+	 * Drive the net dormancy of the owning actor from the server. The actor goes dormant once no replicated transactions
+	 * are pending and is flushed whenever states change or transactions are sent.
+	 *
+	 * Dormancy applies to the whole actor so only enable when nothing else on the actor relies on regular replication.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, AdvancedDisplay, Category = "Network", meta = (EditCondition = "bReplicates"))
+	bool bManageNetDormancy;
+
+	/**
+	 * Connections viewing from farther than this distance only receive instance state every CoarseNetUpdateInterval seconds.
+	 * Transitions are still sent as they happen. Set to 0 to disable.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, AdvancedDisplay, Category = "Network", meta = (EditCondition = "bReplicates", ClampMin = "0.0"))
+	float CoarseNetRelevancyDistance;
+
+	/** Seconds between instance updates to coarse connections. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, AdvancedDisplay, Category = "Network", meta = (EditCondition = "bReplicates", ClampMin = "0.0"))
+	float CoarseNetUpdateInterval;
+
 	/**
 	 * Automatically initialize the state machine when the component begins play. This will set the Context to the owning actor of this component.
 	 * This happens in two stages: On InitializeComponent the state machine is instantiated, on BeginPlay the state machine is initialized.
@@ -360,6 +486,26 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "State Machine Components", meta = (EditCondition = "bInitializeOnBeginPlay", ExposeOnSpawn = true))
 	bool bStartOnBeginPlay;
 
+	/**
+	 * Initialize on BeginPlay through the deferred initialization queue rather than immediately. Spreads the cost of many
+	 * components beginning play on the same frame, such as during level streaming.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "State Machine Components", meta = (EditCondition = "bInitializeOnBeginPlay", ExposeOnSpawn = true))
+	bool bDeferInitialization;
+
+	/** Components with a higher priority are initialized first by the deferred initialization queue. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "State Machine Components", meta = (EditCondition = "bDeferInitialization"))
+	int32 InitializationPriority;
+
+	/**
+	 * Initialize by copying a prototype instance shared by every component with the same archetype instead of building
+	 * the state machine from scratch. Greatly reduces the cost of spawning many actors with the same state machine.
+	 * The prototype is initialized with the world as its context, so node construction scripts shouldn't depend on
+	 * the context.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, AdvancedDisplay, Category = "State Machine Components")
+	bool bInitializeFromPrototype;
+
 	/** The default behavior is to let the actor component tick the state machine when it ticks. This legacy option allows the instance to register as a tickable object instead. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, AdvancedDisplay, Category = "State Machine Components")
 	bool bLetInstanceManageTick;
@@ -430,4 +576,46 @@ protected:
 	/** Set from the template and adjusted for the network configuration. */
 	UPROPERTY(Transient)
 	bool bCanInstanceNetworkTick;
+
+	/** The context of an Initialize call deferred while preloading. */
+	UPROPERTY(Transient)
+	UObject* PreloadInitializeContext;
+
+	/** Initialize was called while preloading. */
+	UPROPERTY(Transient)
+	bool bInitializeAfterPreload;
+
+	/** Start was called while preloading. */
+	UPROPERTY(Transient)
+	bool bStartAfterPreload;
+
+	/** Waiting in the deferred initialization queue. */
+	UPROPERTY(Transient)
+	bool bInitializationPending;
+
+	/** Start was requested while initialization is deferred. */
+	UPROPERTY(Transient)
+	bool bStartAfterDeferredInitialization;
+
+	/** Client: Guids of predicted transactions waiting on the server. */
+	TSet<FGuid> PendingPredictions;
+
+	/** Client: Server time of the last rollback. Replicated transactions from before this are part of the rolled back state. */
+	FDateTime LastRollbackServerTime;
+
+	int32 NumConfirmedPredictions;
+	int32 NumMispredictions;
+
+	/** Server: Time each coarse connection last received the instance. */
+	TMap<TWeakObjectPtr<UNetConnection>, float> CoarseConnectionUpdateTimes;
+
+	/** Server: Replicated properties of the instance class, compared for every connection the instance replicates to. */
+	int32 NumReplicatedInstanceProperties;
+
+	/** Server: The owner was made dormant by this component. */
+	bool bIsNetDormantFromComponent;
+
+private:
+	/** The active preload. Keeps the loaded classes referenced until instantiated. */
+	TSharedPtr<FSMPreloadRequest> PreloadRequest;
 };
\ No newline at end of file
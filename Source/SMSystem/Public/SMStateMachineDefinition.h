@@ -0,0 +1,90 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/UnrealType.h"
+
+/** A single runtime node property and how it links into its owning state machine. */
+struct FSMNodeLayout
+{
+	/** The class property containing the node struct. */
+	FStructProperty* Property = nullptr;
+
+	/** States only: The node name used for name lookups. */
+	FName Name;
+
+	/** States only: The state is an entry point of its state machine. */
+	bool bIsInitialState = false;
+
+	/** States only: The state is a nested state machine with its own layout. */
+	bool bIsStateMachine = false;
+
+	/** Transitions only: Index into the owning layout's states. */
+	int32 FromStateIndex = INDEX_NONE;
+
+	/** Transitions only: Index into the owning layout's states. */
+	int32 ToStateIndex = INDEX_NONE;
+};
+
+/** The states and transitions directly owned by a state machine, in generation order. */
+struct FSMStateMachineLayout
+{
+	TArray<FSMNodeLayout> States;
+	TArray<FSMNodeLayout> Transitions;
+
+	/** State name -> index into States. */
+	TMap<FName, int32> StateNameIndices;
+
+	/** Find a directly owned state by name. May be null. */
+	const FSMNodeLayout* FindState(const FName& StateName) const
+	{
+		const int32* Index = StateNameIndices.Find(StateName);
+		return Index ? &States[*Index] : nullptr;
+	}
+};
+
+/**
+ * Immutable topology of a state machine class shared by every instance of that class.
+ * Built once from the class defaults so instances can wire their node structs without
+ * walking class properties or matching guids on every Initialize.
+ */
+struct SMSYSTEM_API FSMStateMachineDefinition
+{
+	/** The root state machine guid resolved for the class. */
+	FGuid RootGuid;
+
+	/** All node properties of the class. */
+	TSet<FStructProperty*> Properties;
+
+	/** State machine NodeGuid -> the nodes it owns. */
+	TMap<FGuid, FSMStateMachineLayout> Layouts;
+
+	/** Qualified state names such as "Combat.Melee.Windup" relative to the root state machine -> the state's layout. */
+	TMap<FName, const FSMNodeLayout*> StatePaths;
+
+	/** Total states and transitions described. */
+	int32 NumNodes = 0;
+
+	/** Find the layout for a state machine node. May be null if the state machine contains no nodes. */
+	const FSMStateMachineLayout* FindLayout(const FGuid& StateMachineGuid) const { return Layouts.Find(StateMachineGuid); }
+
+	/** Find a state by its qualified name. State machine references aren't entered. May be null. */
+	const FSMNodeLayout* FindStatePath(const FName& QualifiedName) const
+	{
+		const FSMNodeLayout* const* Layout = StatePaths.Find(QualifiedName);
+		return Layout ? *Layout : nullptr;
+	}
+
+	/**
+	 * Build a definition from a state machine class.
+	 *
+	 * @param Class A USMInstance class.
+	 * @return The definition or null if the class topology couldn't be resolved.
+	 */
+	static TSharedPtr<const FSMStateMachineDefinition> Build(UClass* Class);
+
+private:
+	/** Record qualified names for the states of a layout and its nested state machines. */
+	void BuildStatePaths(const FGuid& StateMachineGuid, const FString& Prefix, const UObject* ClassDefaults);
+};
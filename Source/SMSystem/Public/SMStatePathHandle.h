@@ -0,0 +1,40 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SMStatePathHandle.generated.h"
+
+struct FSMStateMachineDefinition;
+
+/**
+ * A state resolved from a qualified name such as "Combat.Melee.Windup". Resolve once with USMInstance::ResolveStatePath
+ * and reuse the handle to find the state on any instance of the same class without hashing names.
+ */
+USTRUCT(BlueprintType)
+struct SMSYSTEM_API FSMStatePathHandle
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** If the path was resolved. The handle may still fail to find a state on an instance of a different class. */
+	bool IsValid() const { return Hops.Num() > 0; }
+
+	/** The qualified name this handle was resolved from. */
+	const FName& GetPath() const { return Path; }
+
+private:
+	friend class USMInstance;
+
+	/** A node property to follow on an instance. */
+	struct FHop
+	{
+		/** The definition of the instance class the property belongs to. Instances of other classes are rejected. */
+		TWeakPtr<const FSMStateMachineDefinition> Definition;
+
+		/** The node struct property. All but the last hop are state machine references. */
+		FStructProperty* Property = nullptr;
+	};
+
+	FName Path;
+	TArray<FHop, TInlineAllocator<2>> Hops;
+};
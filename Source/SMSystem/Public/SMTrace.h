@@ -0,0 +1,101 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+/** Logic Driver trace events are compiled out with the cpu profiler trace and in shipping builds. */
+#define LOGICDRIVER_TRACE_ENABLED (CPUPROFILERTRACE_ENABLED && !UE_BUILD_SHIPPING)
+
+class USMInstance;
+struct FSMNode_Base;
+struct FSMTransition;
+
+/** Node scopes which are traced separately. */
+enum class ESMTraceNodeScope : uint8
+{
+	StateStart,
+	StateUpdate,
+	StateEnd,
+	TransitionEvaluate,
+	Max
+};
+
+enum class ESMTraceInstanceEvent : uint8
+{
+	Initialized,
+	Started,
+	Stopped,
+	Shutdown
+};
+
+#if LOGICDRIVER_TRACE_ENABLED
+
+UE_TRACE_CHANNEL_EXTERN(LogicDriverChannel, SMSYSTEM_API)
+
+/**
+ * Trace output for the LogicDriver channel. Enable with -trace=cpu,logicdriver to see which states and transitions of
+ * which state machine blueprint consume frame time in Unreal Insights.
+ */
+class SMSYSTEM_API FSMTrace
+{
+public:
+	static bool IsEnabled() { return UE_TRACE_CHANNELEXPR_IS_ENABLED(LogicDriverChannel); }
+
+	/** Register the cpu event type of a node scope, named after the node and its blueprint class. */
+	static uint32 GetNodeEventType(const FSMNode_Base& Node, ESMTraceNodeScope Scope);
+
+	/** Register the cpu event type of an instance update, named after the instance's class. */
+	static uint32 GetInstanceUpdateEventType(const USMInstance& Instance);
+
+	static void OutputTransitionTaken(const FSMTransition& Transition);
+	static void OutputInstanceEvent(const USMInstance& Instance, ESMTraceInstanceEvent Event);
+};
+
+/** A cpu scope on the LogicDriver channel. Nothing is output unless the channel was enabled when the scope began. */
+class FSMTraceCpuScope
+{
+public:
+	FORCEINLINE FSMTraceCpuScope(const FSMNode_Base& Node, ESMTraceNodeScope Scope) : bEnabled(FSMTrace::IsEnabled())
+	{
+		if (bEnabled)
+		{
+			FCpuProfilerTrace::OutputBeginEvent(FSMTrace::GetNodeEventType(Node, Scope));
+		}
+	}
+
+	FORCEINLINE explicit FSMTraceCpuScope(const USMInstance& Instance) : bEnabled(FSMTrace::IsEnabled())
+	{
+		if (bEnabled)
+		{
+			FCpuProfilerTrace::OutputBeginEvent(FSMTrace::GetInstanceUpdateEventType(Instance));
+		}
+	}
+
+	FORCEINLINE ~FSMTraceCpuScope()
+	{
+		if (bEnabled)
+		{
+			FCpuProfilerTrace::OutputEndEvent();
+		}
+	}
+
+private:
+	bool bEnabled;
+};
+
+#define SM_TRACE_NODE_SCOPE(Node, Scope) FSMTraceCpuScope PREPROCESSOR_JOIN(SMTraceNodeScope_, __LINE__)(Node, Scope)
+#define SM_TRACE_INSTANCE_SCOPE(Instance) FSMTraceCpuScope PREPROCESSOR_JOIN(SMTraceInstanceScope_, __LINE__)(Instance)
+#define SM_TRACE_TRANSITION_TAKEN(Transition) do { if (FSMTrace::IsEnabled()) { FSMTrace::OutputTransitionTaken(Transition); } } while (0)
+#define SM_TRACE_INSTANCE_EVENT(Instance, Event) do { if (FSMTrace::IsEnabled()) { FSMTrace::OutputInstanceEvent(Instance, Event); } } while (0)
+
+#else
+
+#define SM_TRACE_NODE_SCOPE(Node, Scope)
+#define SM_TRACE_INSTANCE_SCOPE(Instance)
+#define SM_TRACE_TRANSITION_TAKEN(Transition)
+#define SM_TRACE_INSTANCE_EVENT(Instance, Event)
+
+#endif
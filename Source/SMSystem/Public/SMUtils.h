@@ -6,9 +6,48 @@
 
 #include "GameFramework/Pawn.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
+#include "Engine/StreamableManager.h"
 
 #include "SMUtils.generated.h"
 
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("SMSyncLoadsDuringUpdate"), STAT_SyncLoadsDuringUpdate, STATGROUP_LogicDriver, SMSYSTEM_API);
+
+/** Called once a state machine class and its dependencies have loaded. The class is null if it could not be loaded. */
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnStateMachineClassPreloadedSignature, TSubclassOf<class USMInstance>, StateMachineClass);
+
+/**
+ * An asynchronous load of a state machine class and every class required to instantiate it.
+ * Loaded classes stay referenced for as long as the request is alive.
+ */
+class SMSYSTEM_API FSMPreloadRequest : public TSharedFromThis<FSMPreloadRequest>
+{
+public:
+	FSMPreloadRequest(const TSoftClassPtr<USMInstance>& InStateMachineClass, const FSimpleDelegate& InOnComplete);
+
+	/** Begin loading. OnComplete is called immediately if everything is already loaded. */
+	void Start();
+
+	/** Stop loading and release all loaded classes. OnComplete will not be called. */
+	void Cancel();
+
+	/** If loading has finished, successfully or not. */
+	bool IsComplete() const { return bComplete; }
+
+	/** The loaded state machine class. Null until complete or if the class could not be loaded. */
+	TSubclassOf<USMInstance> GetStateMachineClass() const { return StateMachineClass.Get(); }
+
+private:
+	void OnClassLoaded();
+	void OnDependenciesLoaded();
+
+	TSoftClassPtr<USMInstance> StateMachineClass;
+	FSimpleDelegate OnComplete;
+	TSharedPtr<FStreamableHandle> ClassHandle;
+	TSharedPtr<FStreamableHandle> DependencyHandle;
+	bool bLoadingDependencies = false;
+	bool bComplete = false;
+};
+
 /**
  * General Blueprint helpers for creating state machines.
  */
@@ -40,6 +79,38 @@ public:
 	 */
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Logic Driver|State Machine Utilities")
 	static USMInstance* CreateStateMachineInstanceFromTemplate(TSubclassOf<class USMInstance> StateMachineClass, UObject* Context, USMInstance* Template, bool bInitializeNow = true);
+
+	/**
+	 * Create a new initialized state machine instance by copying an initialized prototype of the same class.
+	 * Much faster than creating and initializing a new instance when spawning many instances of one class.
+	 * The prototype's construction script results are copied, so context dependent setup should happen on initialize or start.
+	 * The state machine is instantiated with the NewContext as the outer object.
+	 *
+	 * @param Prototype An initialized state machine instance which isn't running.
+	 * @param NewContext The context object the new state machine will run for. Often an actor.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Utilities")
+	static USMInstance* CloneInitializedInstance(USMInstance* Prototype, UObject* NewContext);
+
+	/**
+	 * Asynchronously load a state machine class along with its node classes, referenced state machine classes, and templates.
+	 * Creating an instance afterward will not cause a synchronous load. Hold a reference to the class to keep it loaded.
+	 *
+	 * @param StateMachineClass The state machine class to load.
+	 * @param OnPreloaded Called once loading has finished.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Utilities")
+	static void PreloadStateMachineClass(TSoftClassPtr<USMInstance> StateMachineClass, FOnStateMachineClassPreloadedSignature OnPreloaded);
+
+	/**
+	 * Native version of PreloadStateMachineClass. The caller owns the request and the loaded classes stay referenced until it is released.
+	 *
+	 * @param StateMachineClass The state machine class to load.
+	 * @param OnPreloaded Called once loading has finished. This can run before the request is returned, so to read the
+	 *                    request from the callback construct an FSMPreloadRequest and call Start once it is stored.
+	 * @return The started request.
+	 */
+	static TSharedRef<FSMPreloadRequest> RequestPreloadStateMachineClass(const TSoftClassPtr<USMInstance>& StateMachineClass, const FSimpleDelegate& OnPreloaded = FSimpleDelegate());
 	
 private:
 	static USMInstance* CreateStateMachineInstanceInternal(TSubclassOf<class USMInstance> StateMachineClass, UObject* Context, USMInstance* Template, bool bInitializeNow);
@@ -58,8 +129,10 @@ public:
 	 * @param StateMachineOut The state machine struct which will be assembled.
 	 * @param RunTimeProperties Class properties which will be used to create the state machine.
 	 * @param bDryRun Debugging flag to prevent templates and references from being assigned.
+	 * @param Definition A shared definition of the instance class. When provided nodes are linked from its layouts instead of searching RunTimeProperties.
 	 */
-	static bool GenerateStateMachine(UObject* Instance, FSMStateMachine& StateMachineOut, const TSet<FStructProperty*>& RunTimeProperties, bool bDryRun = false);
+	static bool GenerateStateMachine(UObject* Instance, FSMStateMachine& StateMachineOut, const TSet<FStructProperty*>& RunTimeProperties, bool bDryRun = false,
+		const struct FSMStateMachineDefinition* Definition = nullptr);
 
 	/** Locate the properties required for a state machine looking backwards up the parent classes. */
 	static bool TryGetStateMachinePropertiesForClass(UClass* Class, TSet<FStructProperty*>& PropertiesOut, FGuid& RootGuid, EFieldIteratorFlags::SuperClassFlags SuperFlags = EFieldIteratorFlags::ExcludeSuper);
@@ -105,6 +178,15 @@ public:
 	/** Search up parents for a default sub objects for a template. */
 	static UObject* FindTemplateFromInstance(USMInstance* Instance, const FName& TemplateName);
 
+	/**
+	 * Collect every object an instance of a state machine class depends on: node instance classes, referenced state machine classes,
+	 * and template archetypes. Referenced state machines are searched recursively. StateMachineClass must be loaded.
+	 */
+	static void GetStateMachineClassDependencies(UClass* StateMachineClass, TArray<FSoftObjectPath>& OutDependencies);
+
+	/** The streamable manager state machines load with. Uses the asset manager when available. */
+	static FStreamableManager& GetStreamableManager();
+
 	/** Find all reference templates from an instance. Nested children shouldn't be found after a compile or during run-time! */
 	static bool TryGetAllReferenceTemplatesFromInstance(USMInstance* Instance, TSet<USMInstance*>& TemplatesOut, bool bIncludeNested = false);
 
@@ -138,15 +220,27 @@ public:
 	/** Create an input component for an object if necessary and register with a player controller. */
 	static void EnableInputForObject(APlayerController* InPlayerController, UObject* InObject, UInputComponent*& InOutComponent, int32 InputPriority, bool bBlockInput, bool bPushPopInput);
 
-	/** Disable input for all player controllers using this input component. */
-	static void DisableInput(UWorld* InWorld, UInputComponent*& InOutComponent);
+	/**
+	 * Disable input for all player controllers using this input component.
+	 * When bReleaseComponent is false the component is unregistered but kept with its bindings so EnableInputForObject can reuse it.
+	 */
+	static void DisableInput(UWorld* InWorld, UInputComponent*& InOutComponent, bool bReleaseComponent = true);
 	
-	/** Allow input binding on a normal object. */
+	/** Allow input binding on a normal object. Bindings are resolved once per class and cached. */
 	static void BindInputDelegatesToObject(const UClass* InClass, UInputComponent* InInputComponent, UObject* InObject);
 
 	/** Call when a controller has changed for a tracked pawn. */
 	static void HandlePawnControllerChange(APawn* InPawn, AController* InController, UObject* InObject, UInputComponent*& InOutComponent, int32 InputPriority, bool bBlockInput);
 
+	/** Checks if an object is a GC cluster root or belongs to a cluster. */
+	static bool IsObjectInGCCluster(const UObject* InObject);
+
+	/**
+	 * Add an object created after cluster creation to the cluster of its owner. Does nothing if the owner isn't clustered.
+	 * Mutable objects still have their references processed by the garbage collector.
+	 */
+	static void AddToOwnerGCCluster(UObject* InObject, UObject* InOwner, bool bAsMutable = true);
+
 #if WITH_EDITOR
 	
 	/** Instantiates a object to use as a template and copy properties from and old instance. */
@@ -290,3 +384,20 @@ private:
 	/** Returns true if the state machine has completely finished generation. Can only be true when called from the top of the stack. */
 	static bool FinishStateMachineGeneration(bool bIsTopLevel, TMap<uint32, GeneratingStateMachines>& ThreadMap, uint32 ThreadId);
 };
+
+/**
+ * Marks a state machine update on the game thread so synchronous package loads during it can be reported.
+ * Preload state machine classes to avoid these hitches.
+ */
+struct SMSYSTEM_API FSMScopedSyncLoadCheck
+{
+	explicit FSMScopedSyncLoadCheck(const UObject* InUpdatingObject);
+	~FSMScopedSyncLoadCheck();
+
+	/** Bound to FCoreDelegates::OnSyncLoadPackage by the module. */
+	static void OnSyncLoadPackage(const FString& PackageName);
+
+private:
+	const UObject* PreviousObject;
+	static const UObject* UpdatingObject;
+};
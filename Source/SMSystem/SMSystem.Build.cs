@@ -59,6 +59,14 @@ public class SMSystem : ModuleRules
 				"SMPreviewEditor"
 			}
 			);
+
+			// Cooked platform checks when saving generated classes.
+			PrivateIncludePathModuleNames.AddRange(
+			new string[]
+			{
+				"TargetPlatform"
+			}
+			);
         }
 	}
 }
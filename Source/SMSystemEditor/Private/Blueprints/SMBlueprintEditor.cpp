@@ -471,6 +471,15 @@ void FSMBlueprintEditor::OnActiveTabChanged(TSharedPtr<SDockTab> PreviouslyActiv
 
 void FSMBlueprintEditor::OnSelectedNodesChangedImpl(const TSet<class UObject*>& NewSelection)
 {
+	// Property graphs deferred by the project settings are created once the user views the node.
+	if (NewSelection.Num() == 1)
+	{
+		if (USMGraphNode_Base* SelectedGraphNode = Cast<USMGraphNode_Base>(*NewSelection.CreateConstIterator()))
+		{
+			SelectedGraphNode->CreateDeferredPropertyGraphs();
+		}
+	}
+	
 	FBlueprintEditor::OnSelectedNodesChangedImpl(NewSelection);
 
 	if (SelectedStateMachineNode.IsValid())
@@ -110,6 +110,7 @@ FSMBlueprintEditorGraphMode::FSMBlueprintEditorGraphMode(TSharedPtr<class FSMBlu
 	}
 
 	Editor.Pin()->GetStateMachineToolbar()->AddModesToolbar(ToolbarExtender);
+	Editor.Pin()->GetStateMachineToolbar()->AddDebugToolbar(ToolbarExtender);
 }
 
 void FSMBlueprintEditorGraphMode::RegisterTabFactories(TSharedPtr<FTabManager> InTabManager)
@@ -5,6 +5,7 @@
 #include "Blueprints/SMBlueprintEditorModes.h"
 #include "Commands/SMEditorCommands.h"
 #include "Configuration/SMEditorStyle.h"
+#include "Widgets/SSMDebugTimeline.h"
 
 #include "ISMPreviewEditorModule.h"
 
@@ -55,6 +56,15 @@ void FSMBlueprintEditorToolbar::AddPreviewToolbar(TSharedPtr<FExtender> Extender
 		FToolBarExtensionDelegate::CreateSP(this, &FSMBlueprintEditorToolbar::FillPreviewToolbar));
 }
 
+void FSMBlueprintEditorToolbar::AddDebugToolbar(TSharedPtr<FExtender> Extender)
+{
+	Extender->AddToolBarExtension(
+		"Debugging",
+		EExtensionHook::After,
+		Editor.Pin()->GetToolkitCommands(),
+		FToolBarExtensionDelegate::CreateSP(this, &FSMBlueprintEditorToolbar::FillDebugToolbar));
+}
+
 void FSMBlueprintEditorToolbar::FillModesToolbar(FToolBarBuilder& ToolbarBuilder)
 {
 	TSharedPtr<FSMBlueprintEditor> EditorPtr = Editor.Pin();
@@ -128,4 +138,14 @@ void FSMBlueprintEditorToolbar::FillPreviewToolbar(FToolBarBuilder& ToolbarBuild
 	}
 }
 
+void FSMBlueprintEditorToolbar::FillDebugToolbar(FToolBarBuilder& ToolbarBuilder)
+{
+	const TSharedPtr<FSMBlueprintEditor> EditorPtr = Editor.Pin();
+	check(EditorPtr.IsValid());
+
+	ToolbarBuilder.BeginSection("DebugTimeline");
+	ToolbarBuilder.AddWidget(SNew(SSMDebugTimeline, EditorPtr));
+	ToolbarBuilder.EndSection();
+}
+
 #undef LOCTEXT_NAMESPACE
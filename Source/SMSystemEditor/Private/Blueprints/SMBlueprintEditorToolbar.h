@@ -15,10 +15,12 @@ public:
 
 	void AddModesToolbar(TSharedPtr<FExtender> Extender);
 	void AddPreviewToolbar(TSharedPtr<FExtender> Extender);
+	void AddDebugToolbar(TSharedPtr<FExtender> Extender);
 
 protected:
 	void FillModesToolbar(FToolBarBuilder& ToolbarBuilder);
 	void FillPreviewToolbar(FToolBarBuilder& ToolbarBuilder);
+	void FillDebugToolbar(FToolBarBuilder& ToolbarBuilder);
 
 private:
 	TWeakPtr<FSMBlueprintEditor> Editor;
@@ -0,0 +1,224 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#include "SMCompileBlueprintsCommandlet.h"
+#include "Compilers/SMCompileCache.h"
+#include "Compilers/SMCompileReport.h"
+#include "SMSystemEditorLog.h"
+
+#include "Blueprints/SMBlueprint.h"
+
+#include "AssetRegistryModule.h"
+#include "BlueprintCompilationManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+
+USMCompileBlueprintsCommandlet::USMCompileBlueprintsCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+
+	bForce = false;
+	bSave = false;
+	bUseCache = true;
+}
+
+/** Number of blueprint parents. Parents are compiled first so children don't compile against a stale parent. */
+static int32 GetBlueprintDepth(const UBlueprint* Blueprint)
+{
+	int32 Depth = 0;
+	for (UClass* ParentClass = Blueprint->ParentClass; ParentClass; ParentClass = ParentClass->GetSuperClass())
+	{
+		if (UBlueprint::GetBlueprintFromClass(ParentClass))
+		{
+			Depth++;
+		}
+	}
+
+	return Depth;
+}
+
+int32 USMCompileBlueprintsCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamVals;
+	ParseCommandLine(*Params, Tokens, Switches, ParamVals);
+
+	const FString ContentPath = ParamVals.Contains(TEXT("Path")) ? ParamVals[TEXT("Path")] : TEXT("/Game");
+	const FString CacheFilename = ParamVals.Contains(TEXT("CacheFile")) ? ParamVals[TEXT("CacheFile")] : FSMCompileCache::GetDefaultCacheFilename();
+	const int32 BatchSize = ParamVals.Contains(TEXT("BatchSize")) ? FMath::Max(1, FCString::Atoi(*ParamVals[TEXT("BatchSize")])) : 1;
+	ReportFilename = ParamVals.FindRef(TEXT("Report"));
+	const FString PhaseReportDirectory = ParamVals.Contains(TEXT("PhaseReport")) ? ParamVals[TEXT("PhaseReport")] :
+		Switches.Contains(TEXT("PhaseReport")) ? FSMCompileReports::GetDefaultReportDirectory() : FString();
+	bForce = Switches.Contains(TEXT("Force"));
+	bSave = Switches.Contains(TEXT("Save"));
+	bUseCache = !Switches.Contains(TEXT("NoCache"));
+
+	if (bUseCache)
+	{
+		FSMCompileCache::Get().Load(CacheFilename);
+	}
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	FARFilter Filter;
+	Filter.ClassNames.Add(USMBlueprint::StaticClass()->GetFName());
+	Filter.bRecursiveClasses = true;
+	Filter.PackagePaths.Add(*ContentPath);
+	Filter.bRecursivePaths = true;
+
+	TArray<FAssetData> Assets;
+	AssetRegistry.GetAssets(Filter, Assets);
+
+	LDEDITOR_LOG_INFO(TEXT("Found %d state machine blueprints under %s."), Assets.Num(), *ContentPath);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<UBlueprint*> Blueprints;
+	for (const FAssetData& Asset : Assets)
+	{
+		if (UBlueprint* Blueprint = Cast<UBlueprint>(Asset.GetAsset()))
+		{
+			Blueprints.Add(Blueprint);
+		}
+		else
+		{
+			LDEDITOR_LOG_ERROR(TEXT("Could not load %s."), *Asset.ObjectPath.ToString());
+		}
+	}
+
+	Blueprints.StableSort([](const UBlueprint& A, const UBlueprint& B)
+	{
+		return GetBlueprintDepth(&A) < GetBlueprintDepth(&B);
+	});
+
+	TArray<FCompileResult> Results;
+	Results.Reserve(Blueprints.Num());
+
+	for (int32 Idx = 0; Idx < Blueprints.Num(); Idx += BatchSize)
+	{
+		const int32 Count = FMath::Min(BatchSize, Blueprints.Num() - Idx);
+		CompileBatch(TArray<UBlueprint*>(&Blueprints[Idx], Count), Results);
+
+		// Clean up objects left over from reinstancing.
+		CollectGarbage(RF_NoFlags);
+	}
+
+	if (bUseCache)
+	{
+		FSMCompileCache::Get().Save(CacheFilename);
+	}
+
+	Report(Results, FPlatformTime::Seconds() - StartTime);
+
+	if (!PhaseReportDirectory.IsEmpty())
+	{
+		const int32 NumSaved = FSMCompileReports::Get().SaveReports(PhaseReportDirectory);
+		LDEDITOR_LOG_INFO(TEXT("Saved %d compile phase reports to %s."), NumSaved, *PhaseReportDirectory);
+	}
+
+	const bool bHasErrors = Results.ContainsByPredicate([](const FCompileResult& Result)
+	{
+		return !Result.bSucceeded;
+	});
+
+	return bHasErrors ? 1 : 0;
+}
+
+void USMCompileBlueprintsCommandlet::CompileBatch(const TArray<UBlueprint*>& Batch, TArray<FCompileResult>& ResultsOut)
+{
+	FSMCompileCache& CompileCache = FSMCompileCache::Get();
+
+	TArray<UBlueprint*> BlueprintsToCompile;
+	for (UBlueprint* Blueprint : Batch)
+	{
+		if (!bForce && bUseCache && CompileCache.IsUpToDate(Blueprint, CompileCache.CalculateInputHash(Blueprint)))
+		{
+			FCompileResult& Result = ResultsOut.AddDefaulted_GetRef();
+			Result.Name = Blueprint->GetPathName();
+			Result.bCacheHit = true;
+			continue;
+		}
+
+		BlueprintsToCompile.Add(Blueprint);
+		FBlueprintCompilationManager::QueueForCompilation(Blueprint);
+	}
+
+	if (BlueprintsToCompile.Num() == 0)
+	{
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	FBlueprintCompilationManager::FlushCompilationQueueAndReinstance();
+	const double SecondsPerBlueprint = (FPlatformTime::Seconds() - StartTime) / BlueprintsToCompile.Num();
+
+	for (UBlueprint* Blueprint : BlueprintsToCompile)
+	{
+		FCompileResult& Result = ResultsOut.AddDefaulted_GetRef();
+		Result.Name = Blueprint->GetPathName();
+		Result.Seconds = SecondsPerBlueprint;
+		Result.bSucceeded = Blueprint->Status != BS_Error;
+
+		if (!Result.bSucceeded)
+		{
+			LDEDITOR_LOG_ERROR(TEXT("Failed to compile %s."), *Result.Name);
+			continue;
+		}
+
+		if (bUseCache)
+		{
+			CompileCache.RecordCompile(Blueprint, CompileCache.CalculateInputHash(Blueprint));
+		}
+
+		if (bSave)
+		{
+			UPackage* Package = Blueprint->GetOutermost();
+			const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+			if (!UPackage::SavePackage(Package, nullptr, RF_Standalone, *Filename, GError, nullptr, false, true, SAVE_NoError))
+			{
+				LDEDITOR_LOG_ERROR(TEXT("Failed to save %s."), *Filename);
+			}
+		}
+	}
+}
+
+void USMCompileBlueprintsCommandlet::Report(const TArray<FCompileResult>& Results, double TotalSeconds) const
+{
+	int32 CacheHits = 0;
+	int32 Failures = 0;
+	double CompileSeconds = 0.0;
+
+	TArray<FString> Lines;
+	Lines.Add(TEXT("Blueprint,Seconds,CacheHit,Succeeded"));
+
+	for (const FCompileResult& Result : Results)
+	{
+		CacheHits += Result.bCacheHit ? 1 : 0;
+		Failures += Result.bSucceeded ? 0 : 1;
+		CompileSeconds += Result.Seconds;
+
+		if (!Result.bCacheHit)
+		{
+			LDEDITOR_LOG_INFO(TEXT("Compiled %s in %.3fs."), *Result.Name, Result.Seconds);
+		}
+
+		Lines.Add(FString::Printf(TEXT("%s,%.4f,%d,%d"), *Result.Name, Result.Seconds, Result.bCacheHit ? 1 : 0, Result.bSucceeded ? 1 : 0));
+	}
+
+	const float HitRate = Results.Num() > 0 ? static_cast<float>(CacheHits) / Results.Num() : 0.f;
+	LDEDITOR_LOG_INFO(TEXT("Processed %d blueprints in %.2fs (%.2fs compiling). Cache hits: %d (%.1f%%). Failures: %d."),
+		Results.Num(), TotalSeconds, CompileSeconds, CacheHits, HitRate * 100.f, Failures);
+
+	if (!ReportFilename.IsEmpty())
+	{
+		if (!FFileHelper::SaveStringArrayToFile(Lines, *ReportFilename))
+		{
+			LDEDITOR_LOG_WARNING(TEXT("Could not write report to %s."), *ReportFilename);
+		}
+	}
+}
@@ -0,0 +1,61 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SMCompileBlueprintsCommandlet.generated.h"
+
+class UBlueprint;
+
+/**
+ * Compile state machine blueprints in batches, skipping blueprints which haven't changed since they were last compiled.
+ *
+ * Usage: UE4Editor-Cmd.exe Project.uproject -run=SMCompileBlueprints [-Path=/Game/Folder] [-BatchSize=16] [-Force] [-Save]
+ *                                                                   [-CacheFile=File.txt] [-NoCache] [-Report=Report.csv]
+ *                                                                   [-PhaseReport[=Directory]]
+ *
+ * -Path		Only compile blueprints under this content path. Defaults to /Game.
+ * -BatchSize	How many blueprints are queued before flushing the compilation manager. Batches share dependency sorting and reinstancing.
+ *				Per blueprint time is exact only with a batch size of 1, otherwise it is averaged over the batch.
+ * -Force		Ignore compile records and compile every blueprint.
+ * -Save		Save packages which were compiled successfully.
+ * -CacheFile	The compile record file. Defaults to Saved/LogicDriver/CompileCache.txt.
+ * -NoCache		Don't read or write compile records.
+ * -Report		Write per blueprint results to a CSV file.
+ * -PhaseReport	Write a compile report with phase times and generated counts per compiled blueprint.
+ *				Defaults to Saved/LogicDriver/CompileReports.
+ */
+UCLASS()
+class USMCompileBlueprintsCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USMCompileBlueprintsCommandlet();
+
+	// UCommandlet
+	virtual int32 Main(const FString& Params) override;
+	// ~UCommandlet
+
+private:
+	struct FCompileResult
+	{
+		FString Name;
+		double Seconds = 0.0;
+		bool bCacheHit = false;
+		bool bSucceeded = true;
+	};
+
+	/** Compile a batch of blueprints together. */
+	void CompileBatch(const TArray<UBlueprint*>& Batch, TArray<FCompileResult>& ResultsOut);
+
+	/** Log a summary and optionally write a CSV report. */
+	void Report(const TArray<FCompileResult>& Results, double TotalSeconds) const;
+
+private:
+	FString ReportFilename;
+	bool bForce;
+	bool bSave;
+	bool bUseCache;
+};
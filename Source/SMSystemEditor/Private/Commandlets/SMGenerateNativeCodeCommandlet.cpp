@@ -0,0 +1,98 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#include "SMGenerateNativeCodeCommandlet.h"
+#include "Compilers/SMNativeCodeGenerator.h"
+#include "SMSystemEditorLog.h"
+
+#include "Blueprints/SMBlueprint.h"
+
+#include "AssetRegistryModule.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+
+USMGenerateNativeCodeCommandlet::USMGenerateNativeCodeCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 USMGenerateNativeCodeCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamVals;
+	ParseCommandLine(*Params, Tokens, Switches, ParamVals);
+
+	const FString OutputDirectory = ParamVals.Contains(TEXT("Output")) ? ParamVals[TEXT("Output")] :
+		FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("LogicDriver"), TEXT("NativeCode"));
+	const FString ApiMacro = ParamVals.FindRef(TEXT("Api"));
+
+	TArray<FString> BlueprintPaths;
+	if (ParamVals.Contains(TEXT("Blueprint")))
+	{
+		ParamVals[TEXT("Blueprint")].ParseIntoArray(BlueprintPaths, TEXT(","));
+	}
+	else
+	{
+		const FString ContentPath = ParamVals.Contains(TEXT("Path")) ? ParamVals[TEXT("Path")] : TEXT("/Game");
+
+		IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+		AssetRegistry.SearchAllAssets(true);
+
+		FARFilter Filter;
+		Filter.ClassNames.Add(USMBlueprint::StaticClass()->GetFName());
+		Filter.bRecursiveClasses = true;
+		Filter.PackagePaths.Add(*ContentPath);
+		Filter.bRecursivePaths = true;
+
+		TArray<FAssetData> Assets;
+		AssetRegistry.GetAssets(Filter, Assets);
+
+		for (const FAssetData& Asset : Assets)
+		{
+			BlueprintPaths.Add(Asset.ObjectPath.ToString());
+		}
+	}
+
+	int32 NumGenerated = 0;
+	int32 NumFailed = 0;
+
+	for (FString BlueprintPath : BlueprintPaths)
+	{
+		BlueprintPath.TrimStartAndEndInline();
+		if (!BlueprintPath.Contains(TEXT(".")))
+		{
+			BlueprintPath += TEXT(".") + FPackageName::GetShortName(BlueprintPath);
+		}
+
+		USMBlueprint* Blueprint = LoadObject<USMBlueprint>(nullptr, *BlueprintPath);
+		if (!Blueprint)
+		{
+			LDEDITOR_LOG_ERROR(TEXT("Could not load state machine blueprint %s."), *BlueprintPath);
+			NumFailed++;
+			continue;
+		}
+
+		FSMNativeCodeGenerationResult Result;
+		if (!FSMNativeCodeGenerator::Generate(Blueprint, ApiMacro, Result) || !FSMNativeCodeGenerator::Save(Result, OutputDirectory))
+		{
+			LDEDITOR_LOG_ERROR(TEXT("Could not generate native code for %s. %s"), *BlueprintPath, *FString::Join(Result.Warnings, TEXT(" ")));
+			NumFailed++;
+			continue;
+		}
+
+		LDEDITOR_LOG_INFO(TEXT("Generated %s"), *Result.ToString());
+		for (const FString& Warning : Result.Warnings)
+		{
+			LDEDITOR_LOG_WARNING(TEXT("%s: %s"), *Result.ClassName, *Warning);
+		}
+
+		NumGenerated++;
+	}
+
+	LDEDITOR_LOG_INFO(TEXT("Generated %d state machine classes to %s. Failures: %d."), NumGenerated, *OutputDirectory, NumFailed);
+
+	return NumFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,32 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SMGenerateNativeCodeCommandlet.generated.h"
+
+/**
+ * Generate native C++ state machine classes from state machine blueprints. The generated files are added to a game module
+ * and the blueprint replaced by, or reparented to, the generated class.
+ *
+ * Usage: UE4Editor-Cmd.exe Project.uproject -run=SMGenerateNativeCode [-Blueprint=/Game/AI/SM_Patrol,/Game/AI/SM_Guard] [-Path=/Game/Folder]
+ *                                                                     [-Output=Directory] [-Api=MYGAME_API]
+ *
+ * -Blueprint	Comma separated blueprints to generate.
+ * -Path		Generate every state machine blueprint under this content path. Used when -Blueprint isn't set. Defaults to /Game.
+ * -Output		Directory the header and source files are written to. Defaults to Saved/LogicDriver/NativeCode.
+ * -Api			Export macro of the module the files are added to.
+ */
+UCLASS()
+class USMGenerateNativeCodeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USMGenerateNativeCodeCommandlet();
+
+	// UCommandlet
+	virtual int32 Main(const FString& Params) override;
+	// ~UCommandlet
+};
@@ -0,0 +1,152 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#include "SMUpgradeAssetsCommandlet.h"
+#include "Utilities/SMVersionUtils.h"
+#include "SMSystemEditorLog.h"
+
+#include "AssetRegistryModule.h"
+#include "BlueprintCompilationManager.h"
+#include "Engine/Blueprint.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+
+USMUpgradeAssetsCommandlet::USMUpgradeAssetsCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+
+	bSave = true;
+}
+
+int32 USMUpgradeAssetsCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamVals;
+	ParseCommandLine(*Params, Tokens, Switches, ParamVals);
+
+	const FName ContentPath = ParamVals.Contains(TEXT("Path")) ? FName(*ParamVals[TEXT("Path")]) : NAME_None;
+	const int32 BatchSize = ParamVals.Contains(TEXT("BatchSize")) ? FMath::Max(1, FCString::Atoi(*ParamVals[TEXT("BatchSize")])) : 50;
+	ReportFilename = ParamVals.FindRef(TEXT("Report"));
+	bSave = !Switches.Contains(TEXT("NoSave"));
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	TArray<FAssetData> Assets;
+	bool bHasNewerAssets = false;
+	FSMVersionUtils::FindAssetsToUpdate(Assets, bHasNewerAssets, ContentPath);
+
+	if (bHasNewerAssets)
+	{
+		LDEDITOR_LOG_WARNING(TEXT("Some Logic Driver assets are from a newer version of the plugin and won't be updated."));
+	}
+
+	LDEDITOR_LOG_INFO(TEXT("Found %d Logic Driver assets to update."), Assets.Num());
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<FUpgradeResult> Results;
+	Results.Reserve(Assets.Num());
+
+	// Node blueprints are listed first so they are updated and saved before the state machines using them.
+	for (int32 Idx = 0; Idx < Assets.Num(); Idx += BatchSize)
+	{
+		const int32 Count = FMath::Min(BatchSize, Assets.Num() - Idx);
+		UpgradeBatch(TArray<FAssetData>(&Assets[Idx], Count), Results);
+
+		LDEDITOR_LOG_INFO(TEXT("Updated %d/%d assets."), Results.Num(), Assets.Num());
+
+		// Release the batch before loading the next one.
+		CollectGarbage(RF_NoFlags);
+	}
+
+	Report(Results, FPlatformTime::Seconds() - StartTime);
+
+	const bool bHasErrors = Results.ContainsByPredicate([](const FUpgradeResult& Result)
+	{
+		return !Result.bSucceeded;
+	});
+
+	return bHasErrors ? 1 : 0;
+}
+
+void USMUpgradeAssetsCommandlet::UpgradeBatch(const TArray<FAssetData>& Batch, TArray<FUpgradeResult>& ResultsOut)
+{
+	TArray<UBlueprint*> Blueprints;
+	for (const FAssetData& Asset : Batch)
+	{
+		UBlueprint* Blueprint = Cast<UBlueprint>(Asset.GetAsset());
+		if (!Blueprint)
+		{
+			FUpgradeResult& Result = ResultsOut.AddDefaulted_GetRef();
+			Result.Name = Asset.ObjectPath.ToString();
+			Result.Error = TEXT("Could not load");
+			Result.bSucceeded = false;
+			LDEDITOR_LOG_ERROR(TEXT("Could not load %s."), *Result.Name);
+			continue;
+		}
+
+		// The asset may have already been updated when loaded. It still needs to be compiled and saved.
+		FSMVersionUtils::UpdateBlueprintToNewVersion(Blueprint);
+
+		Blueprints.Add(Blueprint);
+		FBlueprintCompilationManager::QueueForCompilation(Blueprint);
+	}
+
+	FBlueprintCompilationManager::FlushCompilationQueueAndReinstance();
+
+	for (UBlueprint* Blueprint : Blueprints)
+	{
+		FUpgradeResult& Result = ResultsOut.AddDefaulted_GetRef();
+		Result.Name = Blueprint->GetPathName();
+
+		if (Blueprint->Status == BS_Error)
+		{
+			// Still save, the version update is valid and the asset would fail to compile either way.
+			Result.Error = TEXT("Compile failed");
+			Result.bSucceeded = false;
+			LDEDITOR_LOG_WARNING(TEXT("%s was updated but failed to compile."), *Result.Name);
+		}
+
+		if (bSave)
+		{
+			UPackage* Package = Blueprint->GetOutermost();
+			const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+			if (!UPackage::SavePackage(Package, nullptr, RF_Standalone, *Filename, GError, nullptr, false, true, SAVE_NoError))
+			{
+				Result.Error = TEXT("Save failed");
+				Result.bSucceeded = false;
+				LDEDITOR_LOG_ERROR(TEXT("Failed to save %s. Check the file isn't read only or checked out by another user."), *Filename);
+			}
+		}
+	}
+}
+
+void USMUpgradeAssetsCommandlet::Report(const TArray<FUpgradeResult>& Results, double TotalSeconds) const
+{
+	int32 Failures = 0;
+
+	TArray<FString> Lines;
+	Lines.Add(TEXT("Asset,Succeeded,Error"));
+
+	for (const FUpgradeResult& Result : Results)
+	{
+		Failures += Result.bSucceeded ? 0 : 1;
+		Lines.Add(FString::Printf(TEXT("%s,%d,%s"), *Result.Name, Result.bSucceeded ? 1 : 0, *Result.Error));
+	}
+
+	LDEDITOR_LOG_INFO(TEXT("Updated %d assets in %.2fs. Failures: %d.%s"), Results.Num() - Failures, TotalSeconds, Failures,
+		bSave ? TEXT("") : TEXT(" Assets were not saved."));
+
+	if (!ReportFilename.IsEmpty())
+	{
+		if (!FFileHelper::SaveStringArrayToFile(Lines, *ReportFilename))
+		{
+			LDEDITOR_LOG_WARNING(TEXT("Could not write report to %s."), *ReportFilename);
+		}
+	}
+}
@@ -0,0 +1,51 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SMUpgradeAssetsCommandlet.generated.h"
+
+struct FAssetData;
+
+/**
+ * Update Logic Driver assets saved by an older plugin version and save them in batches. Use this instead of updating assets on editor startup
+ * for large projects. Only out of date assets are loaded so an interrupted run can be started again and continues where it left off.
+ *
+ * Usage: UE4Editor-Cmd.exe Project.uproject -run=SMUpgradeAssets [-Path=/Game/Folder] [-BatchSize=50] [-NoSave] [-Report=Report.csv]
+ *
+ * -Path		Only update assets under this content path. Defaults to all paths.
+ * -BatchSize	How many assets are loaded, compiled and saved before collecting garbage.
+ * -NoSave		Update and compile assets without saving them. Useful to check which assets would fail.
+ * -Report		Write per asset results to a CSV file.
+ */
+UCLASS()
+class USMUpgradeAssetsCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USMUpgradeAssetsCommandlet();
+
+	// UCommandlet
+	virtual int32 Main(const FString& Params) override;
+	// ~UCommandlet
+
+private:
+	struct FUpgradeResult
+	{
+		FString Name;
+		FString Error;
+		bool bSucceeded = true;
+	};
+
+	/** Load, update, compile and save a batch of assets. */
+	void UpgradeBatch(const TArray<FAssetData>& Batch, TArray<FUpgradeResult>& ResultsOut);
+
+	/** Log a summary and optionally write a CSV report. */
+	void Report(const TArray<FUpgradeResult>& Results, double TotalSeconds) const;
+
+private:
+	FString ReportFilename;
+	bool bSave;
+};
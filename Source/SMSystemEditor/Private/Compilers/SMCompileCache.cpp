@@ -0,0 +1,332 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#include "SMCompileCache.h"
+#include "SMSystemEditorLog.h"
+#include "Utilities/SMVersionUtils.h"
+
+#include "ISMSystemModule.h"
+
+#include "Engine/Blueprint.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/ArchiveUObject.h"
+#include "UObject/UObjectHash.h"
+
+/** Hashes serialized object data. References are written by path so hashes are stable between sessions. */
+class FSMCompileHashArchive : public FArchiveUObject
+{
+public:
+	FSMCompileHashArchive()
+	{
+		SetIsSaving(true);
+		SetIsPersistent(true);
+	}
+
+	uint32 GetHash() const { return Hash; }
+
+	// FArchive
+	virtual void Serialize(void* Data, int64 Num) override
+	{
+		Hash = FCrc::MemCrc32(Data, Num, Hash);
+	}
+
+	virtual FArchive& operator<<(UObject*& Object) override
+	{
+		FString Path = Object ? Object->GetPathName() : FString();
+		return *this << Path;
+	}
+
+	virtual FArchive& operator<<(FName& Name) override
+	{
+		FString NameString = Name.ToString();
+		return *this << NameString;
+	}
+
+	virtual FString GetArchiveName() const override { return TEXT("FSMCompileHashArchive"); }
+	// ~FArchive
+
+	using FArchiveUObject::operator<<;
+
+private:
+	uint32 Hash = 0;
+};
+
+/** If the object or any outer up to the blueprint is transient, such as intermediate compiler graphs. */
+static bool IsTransientWithinBlueprint(const UObject* Object, const UBlueprint* Blueprint)
+{
+	for (const UObject* Outer = Object; Outer && Outer != Blueprint; Outer = Outer->GetOuter())
+	{
+		if (Outer->HasAnyFlags(RF_Transient))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/** Increment when the compiler output changes without a plugin version change. */
+static constexpr uint32 CompilerVersion = 1;
+
+/** The closest native class of a class. */
+static const UClass* GetNativeClass(const UClass* Class)
+{
+	while (Class && !Class->HasAnyClassFlags(CLASS_Native))
+	{
+		Class = Class->GetSuperClass();
+	}
+
+	return Class;
+}
+
+FSMCompileCache& FSMCompileCache::Get()
+{
+	static FSMCompileCache CompileCache;
+	return CompileCache;
+}
+
+uint32 FSMCompileCache::GetEnvironmentHash()
+{
+	static uint32 EnvironmentHash = 0;
+	if (EnvironmentHash == 0)
+	{
+		FString PluginVersion;
+		if (const TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(PLUGIN_NAME))
+		{
+			PluginVersion = Plugin->GetDescriptor().VersionName;
+		}
+
+		const FString Environment = FString::Printf(TEXT("%s|%s|%d|%d|%u"), *FEngineVersion::Current().ToString(), *PluginVersion,
+			FSMVersionUtils::GetCurrentBlueprintVersion(), FSMVersionUtils::GetCurrentBlueprintNodeVersion(), CompilerVersion);
+		EnvironmentHash = FMath::Max(FCrc::StrCrc32(*Environment), 1u);
+	}
+
+	return EnvironmentHash;
+}
+
+uint32 FSMCompileCache::CalculateInputHash(UBlueprint* Blueprint) const
+{
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("FSMCompileCache::CalculateInputHash"), STAT_CalculateCompileInputHash, STATGROUP_LogicDriverEditor);
+
+	TMap<UBlueprint*, uint32> VisitedHashes;
+	return HashCombine(GetEnvironmentHash(), CalculateInputHash_Internal(Blueprint, VisitedHashes));
+}
+
+uint32 FSMCompileCache::GetNativeTypeHash(const UStruct* Type) const
+{
+	if (Type == nullptr)
+	{
+		return 0;
+	}
+
+	if (const uint32* ExistingHash = NativeTypeHashes.Find(Type))
+	{
+		return *ExistingHash;
+	}
+
+	// Recursive structs resolve to 0 while being calculated.
+	NativeTypeHashes.Add(Type, 0);
+
+	FSMCompileHashArchive Archive;
+	FString TypePath = Type->GetPathName();
+	int32 TypeSize = Type->GetPropertiesSize();
+	Archive << TypePath << TypeSize;
+
+	uint32 Hash = 0;
+	for (TFieldIterator<FProperty> It(Type); It; ++It)
+	{
+		FString PropertyName = It->GetName();
+		FString PropertyType = It->GetCPPType();
+		int32 Offset = It->GetOffset_ForInternal();
+		uint64 Flags = It->GetPropertyFlags();
+		Archive << PropertyName << PropertyType << Offset << Flags;
+
+		const FProperty* ValueProperty = It->IsA<FArrayProperty>() ? CastField<FArrayProperty>(*It)->Inner : *It;
+		if (const FStructProperty* StructProperty = CastField<FStructProperty>(ValueProperty))
+		{
+			Hash = HashCombine(Hash, GetNativeTypeHash(StructProperty->Struct));
+		}
+	}
+
+	// Defaults of native classes are copied into node templates and class defaults when compiling.
+	if (const UClass* Class = Cast<UClass>(Type))
+	{
+		Class->GetDefaultObject()->Serialize(Archive);
+	}
+
+	Hash = HashCombine(Hash, Archive.GetHash());
+	NativeTypeHashes.Add(Type, Hash);
+	return Hash;
+}
+
+uint32 FSMCompileCache::CalculateInputHash_Internal(UBlueprint* Blueprint, TMap<UBlueprint*, uint32>& VisitedHashes) const
+{
+	if (Blueprint == nullptr)
+	{
+		return 0;
+	}
+
+	if (const uint32* ExistingHash = VisitedHashes.Find(Blueprint))
+	{
+		return *ExistingHash;
+	}
+
+	// Circular dependencies resolve to 0 while being calculated.
+	VisitedHashes.Add(Blueprint, 0);
+
+	TArray<UObject*> OwnedObjects;
+	GetObjectsWithOuter(Blueprint, OwnedObjects, true, RF_Transient, EInternalObjectFlags::PendingKill);
+	OwnedObjects.RemoveAll([Blueprint](const UObject* Object)
+	{
+		return IsTransientWithinBlueprint(Object, Blueprint);
+	});
+
+	// Object hash order isn't deterministic.
+	TArray<TPair<FString, UObject*>> SortedObjects;
+	SortedObjects.Reserve(OwnedObjects.Num());
+	for (UObject* Object : OwnedObjects)
+	{
+		SortedObjects.Emplace(Object->GetPathName(Blueprint), Object);
+	}
+	SortedObjects.Sort([](const TPair<FString, UObject*>& A, const TPair<FString, UObject*>& B)
+	{
+		return A.Key < B.Key;
+	});
+
+	FSMCompileHashArchive Archive;
+	Blueprint->Serialize(Archive);
+
+	for (TPair<FString, UObject*>& Object : SortedObjects)
+	{
+		Archive << Object.Key;
+		Object.Value->Serialize(Archive);
+	}
+
+	uint32 Hash = Archive.GetHash();
+
+	// Native classes the blueprint and its objects are built from, such as a native parent or node classes.
+	TSet<const UClass*> NativeClasses;
+	NativeClasses.Add(GetNativeClass(Blueprint->ParentClass));
+	for (const TPair<FString, UObject*>& Object : SortedObjects)
+	{
+		NativeClasses.Add(GetNativeClass(Object.Value->GetClass()));
+	}
+	NativeClasses.Remove(nullptr);
+
+	TArray<const UClass*> SortedNativeClasses = NativeClasses.Array();
+	SortedNativeClasses.Sort([](const UClass& A, const UClass& B)
+	{
+		return A.GetPathName() < B.GetPathName();
+	});
+
+	for (const UClass* NativeClass : SortedNativeClasses)
+	{
+		Hash = HashCombine(Hash, GetNativeTypeHash(NativeClass));
+	}
+
+	if (Blueprint->ParentClass)
+	{
+		Hash = HashCombine(Hash, CalculateInputHash_Internal(UBlueprint::GetBlueprintFromClass(Blueprint->ParentClass), VisitedHashes));
+	}
+
+	TArray<UBlueprint*> Dependencies;
+	for (const TWeakObjectPtr<UBlueprint>& Dependency : Blueprint->CachedDependencies)
+	{
+		if (Dependency.IsValid())
+		{
+			Dependencies.Add(Dependency.Get());
+		}
+	}
+	Dependencies.Sort([](const UBlueprint& A, const UBlueprint& B)
+	{
+		return A.GetPathName() < B.GetPathName();
+	});
+
+	for (UBlueprint* Dependency : Dependencies)
+	{
+		Hash = HashCombine(Hash, CalculateInputHash_Internal(Dependency, VisitedHashes));
+	}
+
+	VisitedHashes.Add(Blueprint, Hash);
+	return Hash;
+}
+
+bool FSMCompileCache::IsUpToDate(UBlueprint* Blueprint, uint32 InputHash) const
+{
+	const uint32* CompiledHash = CompiledInputHashes.Find(Blueprint->GetOutermost()->GetFName());
+	return CompiledHash && *CompiledHash == InputHash && Blueprint->GeneratedClass != nullptr;
+}
+
+void FSMCompileCache::RecordCompile(UBlueprint* Blueprint, uint32 InputHash)
+{
+	CompiledInputHashes.Add(Blueprint->GetOutermost()->GetFName(), InputHash);
+}
+
+bool FSMCompileCache::ShouldNotifyChildren(UBlueprint* Blueprint)
+{
+	const uint32 InputHash = CalculateInputHash(Blueprint);
+	const FName PackageName = Blueprint->GetOutermost()->GetFName();
+
+	const uint32* NotifiedHash = NotifiedInputHashes.Find(PackageName);
+	if (NotifiedHash && *NotifiedHash == InputHash)
+	{
+		return false;
+	}
+
+	PendingNotifiedInputHashes.Add(PackageName, InputHash);
+	return true;
+}
+
+void FSMCompileCache::RecordChildrenNotified(UBlueprint* Blueprint, bool bCompileSucceeded)
+{
+	const FName PackageName = Blueprint->GetOutermost()->GetFName();
+
+	uint32 InputHash;
+	if (PendingNotifiedInputHashes.RemoveAndCopyValue(PackageName, InputHash) && bCompileSucceeded)
+	{
+		NotifiedInputHashes.Add(PackageName, InputHash);
+	}
+}
+
+void FSMCompileCache::Load(const FString& Filename)
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *Filename))
+	{
+		return;
+	}
+
+	for (const FString& Line : Lines)
+	{
+		FString PackageName, HashString;
+		if (Line.Split(TEXT("="), &PackageName, &HashString))
+		{
+			CompiledInputHashes.Add(*PackageName, FCString::Strtoui64(*HashString, nullptr, 10));
+		}
+	}
+
+	LDEDITOR_LOG_INFO(TEXT("Loaded %d compile records from %s."), CompiledInputHashes.Num(), *Filename);
+}
+
+void FSMCompileCache::Save(const FString& Filename) const
+{
+	TArray<FString> Lines;
+	Lines.Reserve(CompiledInputHashes.Num());
+	for (const TPair<FName, uint32>& Record : CompiledInputHashes)
+	{
+		Lines.Add(FString::Printf(TEXT("%s=%u"), *Record.Key.ToString(), Record.Value));
+	}
+	Lines.Sort();
+
+	if (!FFileHelper::SaveStringArrayToFile(Lines, *Filename))
+	{
+		LDEDITOR_LOG_WARNING(TEXT("Could not save compile records to %s."), *Filename);
+	}
+}
+
+FString FSMCompileCache::GetDefaultCacheFilename()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("LogicDriver"), TEXT("CompileCache.txt"));
+}
@@ -0,0 +1,67 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UBlueprint;
+
+/**
+ * Tracks hashes of the editor data blueprints were compiled from so unchanged blueprints can skip work.
+ * The input hash covers every non-transient object owned by a blueprint, the input hashes of the blueprints it depends on,
+ * the native classes it is built from, and the engine and plugin versions.
+ */
+class SMSYSTEMEDITOR_API FSMCompileCache
+{
+public:
+	static FSMCompileCache& Get();
+
+	/** Hash all editor data of a blueprint, its parent blueprints, its cached dependencies and the native types they use. */
+	uint32 CalculateInputHash(UBlueprint* Blueprint) const;
+
+	/** Changes whenever compiling the same blueprint could produce different output, such as after an engine or plugin upgrade. */
+	static uint32 GetEnvironmentHash();
+
+	/** If the blueprint was last compiled successfully from the same input. */
+	bool IsUpToDate(UBlueprint* Blueprint, uint32 InputHash) const;
+
+	/** Record a successful compile of a blueprint. */
+	void RecordCompile(UBlueprint* Blueprint, uint32 InputHash);
+
+	/**
+	 * Check if children of a blueprint need to be notified it changed. Returns true until RecordChildrenNotified() records
+	 * a successful compile of the same input. Recompiling a parent without changes won't dirty its children again.
+	 */
+	bool ShouldNotifyChildren(UBlueprint* Blueprint);
+
+	/** Finish a compile which may have notified children. The input is only remembered if the compile succeeded. */
+	void RecordChildrenNotified(UBlueprint* Blueprint, bool bCompileSucceeded);
+
+	/** Load compile records saved by a previous session. */
+	void Load(const FString& Filename);
+
+	/** Save compile records so a later session can skip unchanged blueprints. */
+	void Save(const FString& Filename) const;
+
+	/** The file used when no cache file is specified. */
+	static FString GetDefaultCacheFilename();
+
+private:
+	uint32 CalculateInputHash_Internal(UBlueprint* Blueprint, TMap<UBlueprint*, uint32>& VisitedHashes) const;
+
+	/** Hash the layout and defaults of a native class or struct. Native types don't change during a session so these are cached. */
+	uint32 GetNativeTypeHash(const UStruct* Type) const;
+
+private:
+	/** Package name -> input hash of the last successful compile. */
+	TMap<FName, uint32> CompiledInputHashes;
+
+	/** Package name -> input hash children were last notified for. Only valid this session. */
+	TMap<FName, uint32> NotifiedInputHashes;
+
+	/** Package name -> input hash children were notified for by a compile which hasn't finished. */
+	TMap<FName, uint32> PendingNotifiedInputHashes;
+
+	/** Native class or struct -> hash of its layout and defaults. */
+	mutable TMap<TWeakObjectPtr<const UStruct>, uint32> NativeTypeHashes;
+};
@@ -0,0 +1,202 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#include "SMCompileReport.h"
+#include "SMSystemEditorLog.h"
+
+#include "Engine/Blueprint.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+/** Dump compile reports to the log and optionally to files which can be compared between compiles or builds. */
+static FAutoConsoleCommand CompileReportCommand(
+	TEXT("LogicDriver.CompileReport"),
+	TEXT("Log the last compile report of state machine blueprints. Usage: LogicDriver.CompileReport [Filter] [-Save[=Directory]]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		FString Filter;
+		FString SaveDirectory;
+		for (const FString& Arg : Args)
+		{
+			if (Arg.StartsWith(TEXT("-Save")))
+			{
+				if (!Arg.Split(TEXT("="), nullptr, &SaveDirectory))
+				{
+					SaveDirectory = FSMCompileReports::GetDefaultReportDirectory();
+				}
+			}
+			else
+			{
+				Filter = Arg;
+			}
+		}
+
+		const FSMCompileReports& CompileReports = FSMCompileReports::Get();
+		CompileReports.LogReports(Filter);
+
+		if (!SaveDirectory.IsEmpty())
+		{
+			const int32 NumSaved = CompileReports.SaveReports(SaveDirectory);
+			LDEDITOR_LOG_INFO(TEXT("Saved %d compile reports to %s."), NumSaved, *SaveDirectory);
+		}
+	}));
+
+void FSMCompileReport::AddPhaseTime(FName Phase, double Seconds)
+{
+	for (TPair<FName, double>& PhaseTime : PhaseSeconds)
+	{
+		if (PhaseTime.Key == Phase)
+		{
+			PhaseTime.Value += Seconds;
+			return;
+		}
+	}
+
+	PhaseSeconds.Emplace(Phase, Seconds);
+}
+
+double FSMCompileReport::GetPhaseTime(FName Phase) const
+{
+	for (const TPair<FName, double>& PhaseTime : PhaseSeconds)
+	{
+		if (PhaseTime.Key == Phase)
+		{
+			return PhaseTime.Value;
+		}
+	}
+
+	return 0.0;
+}
+
+FString FSMCompileReport::ToString(bool bIncludeTimes) const
+{
+	TArray<FString> Lines;
+	Lines.Add(FString::Printf(TEXT("Blueprint=%s"), *BlueprintPath));
+	Lines.Add(FString::Printf(TEXT("States=%d"), NumStates));
+	Lines.Add(FString::Printf(TEXT("Transitions=%d"), NumTransitions));
+	Lines.Add(FString::Printf(TEXT("GeneratedFunctions=%d"), NumGeneratedFunctions));
+	Lines.Add(FString::Printf(TEXT("GeneratedProperties=%d"), NumGeneratedProperties));
+	Lines.Add(FString::Printf(TEXT("Templates=%d"), NumTemplates));
+	Lines.Add(FString::Printf(TEXT("ClonedGraphs=%d"), NumClonedGraphs));
+
+	if (bIncludeTimes)
+	{
+		for (const TPair<FName, double>& PhaseTime : PhaseSeconds)
+		{
+			Lines.Add(FString::Printf(TEXT("Phase.%s=%.3fms"), *PhaseTime.Key.ToString(), PhaseTime.Value * 1000.0));
+		}
+	}
+
+	return FString::Join(Lines, LINE_TERMINATOR);
+}
+
+FSMCompileReports& FSMCompileReports::Get()
+{
+	static FSMCompileReports CompileReports;
+	return CompileReports;
+}
+
+TSharedRef<FSMCompileReport> FSMCompileReports::BeginReport(const UBlueprint* Blueprint)
+{
+	check(Blueprint);
+
+	TSharedRef<FSMCompileReport> Report = MakeShared<FSMCompileReport>();
+	Report->BlueprintPath = Blueprint->GetPathName();
+	Reports.Add(Report->BlueprintPath, Report);
+
+	return Report;
+}
+
+TSharedPtr<FSMCompileReport> FSMCompileReports::FindReport(const UBlueprint* Blueprint) const
+{
+	if (Blueprint == nullptr)
+	{
+		return nullptr;
+	}
+
+	if (const TSharedRef<FSMCompileReport>* Report = Reports.Find(Blueprint->GetPathName()))
+	{
+		return *Report;
+	}
+
+	return nullptr;
+}
+
+TArray<TSharedRef<FSMCompileReport>> FSMCompileReports::GetReports() const
+{
+	TArray<TSharedRef<FSMCompileReport>> SortedReports;
+	Reports.GenerateValueArray(SortedReports);
+	SortedReports.Sort([](const TSharedRef<FSMCompileReport>& A, const TSharedRef<FSMCompileReport>& B)
+	{
+		return A->BlueprintPath < B->BlueprintPath;
+	});
+
+	return SortedReports;
+}
+
+void FSMCompileReports::LogReports(const FString& Filter) const
+{
+	int32 NumLogged = 0;
+	for (const TSharedRef<FSMCompileReport>& Report : GetReports())
+	{
+		if (!Filter.IsEmpty() && !Report->BlueprintPath.Contains(Filter))
+		{
+			continue;
+		}
+
+		LDEDITOR_LOG_INFO(TEXT("%s%s"), LINE_TERMINATOR, *Report->ToString());
+		NumLogged++;
+	}
+
+	LDEDITOR_LOG_INFO(TEXT("%d compile reports."), NumLogged);
+}
+
+int32 FSMCompileReports::SaveReports(const FString& Directory) const
+{
+	int32 NumSaved = 0;
+	for (const TSharedRef<FSMCompileReport>& Report : GetReports())
+	{
+		// Package paths are unique, keep the folder structure so reports of identically named assets don't collide.
+		FString PackagePath;
+		Report->BlueprintPath.Split(TEXT("."), &PackagePath, nullptr);
+		const FString Filename = FPaths::Combine(Directory, PackagePath.IsEmpty() ? Report->BlueprintPath : PackagePath) + TEXT(".txt");
+
+		if (FFileHelper::SaveStringToFile(Report->ToString(), *Filename))
+		{
+			NumSaved++;
+		}
+		else
+		{
+			LDEDITOR_LOG_WARNING(TEXT("Could not save compile report to %s."), *Filename);
+		}
+	}
+
+	return NumSaved;
+}
+
+FString FSMCompileReports::GetDefaultReportDirectory()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("LogicDriver"), TEXT("CompileReports"));
+}
+
+FSMCompilePhaseTimer::FSMCompilePhaseTimer(FSMCompileReport* InReport, FName InPhase) : Report(InReport), Phase(InPhase),
+	StartTime(FPlatformTime::Seconds())
+{
+	if (Report)
+	{
+		Report->ActivePhases.FindOrAdd(Phase)++;
+	}
+}
+
+FSMCompilePhaseTimer::~FSMCompilePhaseTimer()
+{
+	if (Report)
+	{
+		int32& Depth = Report->ActivePhases.FindChecked(Phase);
+		if (--Depth == 0)
+		{
+			Report->ActivePhases.Remove(Phase);
+			Report->AddPhaseTime(Phase, FPlatformTime::Seconds() - StartTime);
+		}
+	}
+}
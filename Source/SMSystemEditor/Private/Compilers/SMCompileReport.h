@@ -0,0 +1,96 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UBlueprint;
+
+/**
+ * Cost of a single state machine blueprint compile. Phase times are recorded in the order phases first ran
+ * and counts describe what the compiler generated, so reports of the same blueprint can be diffed.
+ */
+struct SMSYSTEMEDITOR_API FSMCompileReport
+{
+	/** Path of the compiled blueprint. */
+	FString BlueprintPath;
+
+	/** Phase name -> accumulated seconds. Some phases run within others, such as AnyStateCloning within ProcessStateMachineGraph. */
+	TArray<TPair<FName, double>> PhaseSeconds;
+
+	int32 NumStates = 0;
+	int32 NumTransitions = 0;
+
+	/** Entry point functions created for runtime nodes and property graphs. */
+	int32 NumGeneratedFunctions = 0;
+
+	/** Runtime node and graph properties added to the generated class. */
+	int32 NumGeneratedProperties = 0;
+
+	/** Node, stack and reference templates stored on the CDO. */
+	int32 NumTemplates = 0;
+
+	/** Graphs cloned into the consolidated event graph, including parent and Any State graphs. */
+	int32 NumClonedGraphs = 0;
+
+	/** Add time to a phase. */
+	void AddPhaseTime(FName Phase, double Seconds);
+
+	/** Total seconds of a phase or 0 if it never ran. */
+	double GetPhaseTime(FName Phase) const;
+
+	/** Key=value lines. When bIncludeTimes is false only counts are written, which is stable between runs. */
+	FString ToString(bool bIncludeTimes = true) const;
+
+private:
+	friend class FSMCompilePhaseTimer;
+
+	/** Phases currently being timed. Recursive phases only record their outermost scope. */
+	TMap<FName, int32> ActivePhases;
+};
+
+/** Stores the last compile report of each state machine blueprint compiled this session. */
+class SMSYSTEMEDITOR_API FSMCompileReports
+{
+public:
+	static FSMCompileReports& Get();
+
+	/** Start a new report for a blueprint, replacing the previous one. */
+	TSharedRef<FSMCompileReport> BeginReport(const UBlueprint* Blueprint);
+
+	/** The last report of a blueprint or null. */
+	TSharedPtr<FSMCompileReport> FindReport(const UBlueprint* Blueprint) const;
+
+	/** All reports sorted by blueprint path. */
+	TArray<TSharedRef<FSMCompileReport>> GetReports() const;
+
+	/** Log reports with a blueprint path containing the filter. */
+	void LogReports(const FString& Filter = FString()) const;
+
+	/** Write one report file per blueprint to a directory. Returns the number of files written. */
+	int32 SaveReports(const FString& Directory) const;
+
+	/** The directory used when no directory is specified. */
+	static FString GetDefaultReportDirectory();
+
+private:
+	TMap<FString, TSharedRef<FSMCompileReport>> Reports;
+};
+
+/** Times a compiler phase for both the stat system and the compile report. The report may be null. */
+class SMSYSTEMEDITOR_API FSMCompilePhaseTimer
+{
+public:
+	FSMCompilePhaseTimer(FSMCompileReport* InReport, FName InPhase);
+	~FSMCompilePhaseTimer();
+
+private:
+	FSMCompileReport* Report;
+	FName Phase;
+	double StartTime;
+};
+
+/** Declare a scope cycle counter for a compiler phase and record it to the current compile report. */
+#define SM_COMPILER_PHASE_SCOPE(PhaseName) \
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("FSMKismetCompilerContext::" #PhaseName), STAT_SMCompilerPhase_##PhaseName, STATGROUP_LogicDriverEditor); \
+	const FSMCompilePhaseTimer PhaseTimer_##PhaseName(CompileReport.Get(), TEXT(#PhaseName))
@@ -1,6 +1,9 @@
 // Copyright Recursoft LLC 2019-2021. All Rights Reserved.
 
 #include "SMKismetCompiler.h"
+#include "SMCompileCache.h"
+#include "SMCompileReport.h"
+#include "SMSystemEditorLog.h"
 #include "EdGraphUtilities.h"
 #include "Kismet/KismetArrayLibrary.h"
 #include "Kismet2/KismetReinstanceUtilities.h"
@@ -9,6 +12,7 @@
 
 #include "Utilities/SMBlueprintEditorUtils.h"
 #include "Utilities/SMNodeInstanceUtils.h"
+#include "Utilities/SMNodeClassRegistry.h"
 
 #include "K2Node_VariableSet.h"
 #include "K2Node_VariableGet.h"
@@ -153,6 +157,12 @@ void FSMKismetCompilerContext::MergeUbergraphPagesIn(UEdGraph* Ubergraph)
 	ProcessInputNodes();
 	ProcessRuntimeContainers();
 	ProcessRuntimeReferences();
+
+	if (CompileReport.IsValid())
+	{
+		CompileReport->NumStates = NumberStates;
+		CompileReport->NumTransitions = NumberTransitions;
+	}
 }
 
 void FSMKismetCompilerContext::SpawnNewClass(const FString& NewClassName)
@@ -192,6 +202,8 @@ void FSMKismetCompilerContext::CleanAndSanitizeClass(UBlueprintGeneratedClass* C
 
 void FSMKismetCompilerContext::CopyTermDefaultsToDefaultObject(UObject* DefaultObject)
 {
+	SM_COMPILER_PHASE_SCOPE(CopyTermDefaultsToDefaultObject);
+	
 	Super::CopyTermDefaultsToDefaultObject(DefaultObject);
 	USMInstance* DefaultInstance = CastChecked<USMInstance>(DefaultObject);
 
@@ -473,13 +485,23 @@ void FSMKismetCompilerContext::CopyTermDefaultsToDefaultObject(UObject* DefaultO
 
 void FSMKismetCompilerContext::PreCompile()
 {
+	if (CompileOptions.CompileType != EKismetCompileType::SkeletonOnly)
+	{
+		CompileReport = FSMCompileReports::Get().BeginReport(Blueprint);
+	}
+
+	SM_COMPILER_PHASE_SCOPE(PreCompile);
+	
 	Super::PreCompile();
 	
 	FSMBlueprintEditorUtils::FixUpDuplicateRuntimeGuids(Blueprint, &MessageLog);
 	FSMBlueprintEditorUtils::FixUpMismatchedRuntimeGuids(Blueprint, &MessageLog);
 	FSMBlueprintEditorUtils::InvalidateCaches(Blueprint);
-	
-	FSMEditorConstructionManager::GetInstance()->RunAllConstructionScriptsForBlueprintImmediately(GetSMBlueprint());
+
+	{
+		SM_COMPILER_PHASE_SCOPE(ConstructionScripts);
+		FSMEditorConstructionManager::GetInstance()->RunAllConstructionScriptsForBlueprintImmediately(GetSMBlueprint());
+	}
 
 	if (USMGraph* Graph = FSMBlueprintEditorUtils::GetRootStateMachineGraph(Blueprint))
 	{
@@ -494,6 +516,8 @@ void FSMKismetCompilerContext::PreCompile()
 
 void FSMKismetCompilerContext::PostCompile()
 {
+	SM_COMPILER_PHASE_SCOPE(PostCompile);
+	
 	Super::PostCompile();
 
 	if (USMGraph* Graph = FSMBlueprintEditorUtils::GetRootStateMachineGraph(Blueprint))
@@ -505,6 +529,9 @@ void FSMKismetCompilerContext::PostCompile()
 			Node->PostCompileValidate(MessageLog);
 		}
 	}
+
+	// Children notified before compiling are notified again if this compile failed.
+	FSMCompileCache::Get().RecordChildrenNotified(Blueprint, MessageLog.NumErrors == 0);
 }
 
 USMGraphK2Node_StateMachineNode* FSMKismetCompilerContext::GetRootStateMachineNode() const
@@ -543,6 +570,8 @@ USMGraphK2Node_StateMachineNode* FSMKismetCompilerContext::GetRootStateMachineNo
 
 void FSMKismetCompilerContext::ValidateAllNodes(USMGraph* StateMachineGraph)
 {
+	SM_COMPILER_PHASE_SCOPE(ValidateAllNodes);
+
 	TArray<USMGraphNode_Base*> Nodes;
 	FSMBlueprintEditorUtils::GetAllNodesOfClassNested<USMGraphNode_Base>(StateMachineGraph, Nodes);
 	for (USMGraphNode_Base* Node : Nodes)
@@ -561,6 +590,8 @@ void FSMKismetCompilerContext::ValidateAllNodes(USMGraph* StateMachineGraph)
 
 void FSMKismetCompilerContext::ValidateDefaultObject(USMInstance* DefaultInstance)
 {
+	SM_COMPILER_PHASE_SCOPE(ValidateDefaultObject);
+
 	if (DefaultInstance->GetClass()->HasAnyClassFlags(CLASS_Abstract))
 	{
 		// Can't instantiate abstract class.
@@ -601,6 +632,8 @@ void FSMKismetCompilerContext::ValidateDefaultObject(USMInstance* DefaultInstanc
 
 void FSMKismetCompilerContext::PreProcessStateMachineNodes(UEdGraph* Graph)
 {
+	SM_COMPILER_PHASE_SCOPE(PreProcessStateMachineNodes);
+
 	TArray<USMGraphNode_StateMachineStateNode*> StateMachines;
 
 	FSMBlueprintEditorUtils::GetAllNodesOfClassNested<USMGraphNode_StateMachineStateNode>(Graph, StateMachines);
@@ -612,6 +645,8 @@ void FSMKismetCompilerContext::PreProcessStateMachineNodes(UEdGraph* Graph)
 
 void FSMKismetCompilerContext::PreProcessRuntimeReferences(UEdGraph* Graph)
 {
+	SM_COMPILER_PHASE_SCOPE(PreProcessRuntimeReferences);
+
 	TArray<USMGraphK2Node_RuntimeNodeContainer*> Containers;
 	TArray<USMGraphK2Node_RuntimeNodeReference*> References;
 
@@ -643,6 +678,8 @@ void FSMKismetCompilerContext::PreProcessRuntimeReferences(UEdGraph* Graph)
 
 void FSMKismetCompilerContext::ExpandParentNodes(UEdGraph* Graph)
 {
+	SM_COMPILER_PHASE_SCOPE(ExpandParentNodes);
+
 	TArray<USMGraphNode_StateMachineParentNode*> Parents;
 	FSMBlueprintEditorUtils::GetAllNodesOfClassNested<USMGraphNode_StateMachineParentNode>(Graph, Parents);
 
@@ -693,6 +730,8 @@ void FSMKismetCompilerContext::ExpandParentNodes(UEdGraph* Graph)
 
 void FSMKismetCompilerContext::ProcessStateMachineGraph(USMGraph* StateMachineGraph)
 {
+	SM_COMPILER_PHASE_SCOPE(ProcessStateMachineGraph);
+
 	// This state machine's Guid. Default to root Guid.
 	FGuid ThisStateMachinesGuid = NewSMBlueprintClass->GetRootGuid();
 	// Back out early if the state machine has no entry point.
@@ -746,7 +785,7 @@ void FSMKismetCompilerContext::ProcessStateMachineGraph(USMGraph* StateMachineGr
 			// Grab any property graphs.
 			for(const auto& KeyVal : BaseNode->GetAllPropertyGraphs())
 			{
-				FEdGraphUtilities::CloneAndMergeGraphIn(ConsolidatedEventGraph, KeyVal.Value, MessageLog, true, true);
+				CloneAndMergeGraphIn(KeyVal.Value);
 			}
 		}
 		
@@ -811,14 +850,14 @@ void FSMKismetCompilerContext::ProcessStateMachineGraph(USMGraph* StateMachineGr
 			StateSourceGraph->EntryNode->StateNode.SetOwnerNodeGuid(ThisStateMachinesGuid);
 
 			// Clone the state graph and any sub graphs to the consolidated graph.
-			FEdGraphUtilities::CloneAndMergeGraphIn(ConsolidatedEventGraph, StateSourceGraph, MessageLog, true, true);
+			CloneAndMergeGraphIn(StateSourceGraph);
 		}
 		else if (USMGraphNode_StateMachineStateNode* StateMachineNode = Cast<USMGraphNode_StateMachineStateNode>(GraphNode))
 		{
 			// Only reference graph's need to be processed.
 			if (USMIntermediateGraph* IntermediateGraph = Cast< USMIntermediateGraph>(StateMachineNode->GetBoundGraph()))
 			{
-				FEdGraphUtilities::CloneAndMergeGraphIn(ConsolidatedEventGraph, IntermediateGraph, MessageLog, true, true);
+				CloneAndMergeGraphIn(IntermediateGraph);
 			}
 		}
 		else if (USMGraphNode_ConduitNode* ConduitNode = Cast<USMGraphNode_ConduitNode>(GraphNode))
@@ -837,10 +876,12 @@ void FSMKismetCompilerContext::ProcessStateMachineGraph(USMGraph* StateMachineGr
 			ConduitSourceGraph->ResultNode->ConduitNode.SetOwnerNodeGuid(ThisStateMachinesGuid);
 
 			// Clone the conduit graph and any sub graphs to the consolidated graph.
-			FEdGraphUtilities::CloneAndMergeGraphIn(ConsolidatedEventGraph, ConduitSourceGraph, MessageLog, true, true);
+			CloneAndMergeGraphIn(ConduitSourceGraph);
 		}
 		else if (USMGraphNode_AnyStateNode* AnyState = Cast<USMGraphNode_AnyStateNode>(GraphNode))
 		{
+			SM_COMPILER_PHASE_SCOPE(AnyStateCloning);
+			
 			// Any State nodes will duplicate their transitions to all valid state nodes.
 			for (int32 Idx = 0; Idx < AnyState->GetOutputPin()->LinkedTo.Num(); ++Idx)
 			{
@@ -879,6 +920,10 @@ void FSMKismetCompilerContext::ProcessStateMachineGraph(USMGraph* StateMachineGr
 							// Clone original transition graph logic to new graph.
 							USMTransitionGraph* ClonedTransitionGraph = CastChecked<USMTransitionGraph>(FEdGraphUtilities::CloneGraph(Transition->GetBoundGraph(), ClonedTransition, &MessageLog, true));
 							ClonedTransition->SetBoundGraph(ClonedTransitionGraph);
+							if (CompileReport.IsValid())
+							{
+								CompileReport->NumClonedGraphs++;
+							}
 							
 							TArray<USMGraphK2Node_RuntimeNodeContainer*> Containers;
 							FSMBlueprintEditorUtils::GetAllNodesOfClassNested<USMGraphK2Node_RuntimeNodeContainer>(ClonedTransitionGraph, Containers);
@@ -1027,7 +1072,7 @@ void FSMKismetCompilerContext::ProcessStateMachineGraph(USMGraph* StateMachineGr
 			}
 
 			// Clone the transition graph and any sub graphs to the consolidated graph
-			FEdGraphUtilities::CloneAndMergeGraphIn(ConsolidatedEventGraph, TransitionSourceGraph, MessageLog, true, true);
+			CloneAndMergeGraphIn(TransitionSourceGraph);
 			NumberTransitions++;
 		}
 	}
@@ -1035,6 +1080,8 @@ void FSMKismetCompilerContext::ProcessStateMachineGraph(USMGraph* StateMachineGr
 
 void FSMKismetCompilerContext::ProcessRuntimeContainers()
 {
+	SM_COMPILER_PHASE_SCOPE(ProcessRuntimeContainers);
+
 	TArray<USMGraphK2Node_RuntimeNodeContainer*> RuntimeContainerNodeList;
 	ConsolidatedEventGraph->GetNodesOfClass<USMGraphK2Node_RuntimeNodeContainer>(/*out*/ RuntimeContainerNodeList);
 
@@ -1074,6 +1121,8 @@ void FSMKismetCompilerContext::ProcessRuntimeContainers()
 
 void FSMKismetCompilerContext::ProcessRuntimeReferences()
 {
+	SM_COMPILER_PHASE_SCOPE(ProcessRuntimeReferences);
+
 	// Process transition events first since they will expand additional runtime node references.
 	TArray<USMGraphK2Node_FunctionNode_TransitionEvent*> TransitionEvents;
 	ConsolidatedEventGraph->GetNodesOfClass<USMGraphK2Node_FunctionNode_TransitionEvent>(/*out*/ TransitionEvents);
@@ -1245,6 +1294,8 @@ void FSMKismetCompilerContext::ProcessRuntimeReferences()
 
 void FSMKismetCompilerContext::ProcessPropertyNodes()
 {
+	SM_COMPILER_PHASE_SCOPE(ProcessPropertyNodes);
+
 	TArray<USMGraphK2Node_PropertyNode_Base*> PropertyNodes;
 	ConsolidatedEventGraph->GetNodesOfClass<USMGraphK2Node_PropertyNode_Base>(/*out*/ PropertyNodes);
 
@@ -1298,6 +1349,8 @@ void FSMKismetCompilerContext::ProcessPropertyNodes()
 
 void FSMKismetCompilerContext::ProcessInputNodes()
 {
+	SM_COMPILER_PHASE_SCOPE(ProcessInputNodes);
+
 	auto ExpandPinBranch = [&](UEdGraphPin* FromPin, UEdGraph* SourceGraph, UK2Node* InputNode, const TSubclassOf<UObject> TargetType)
 	{
 		USMGraphK2Node_StateReadNode_GetNodeInstance* GetNodeInstance = nullptr;
@@ -1826,6 +1879,10 @@ USMGraph* FSMKismetCompilerContext::ProcessParentNode(USMGraphNode_StateMachineP
 
 	// Clone the entire parent graph and process as if it belongs directly to the child.
 	USMGraph* ClonedParentGraph = CastChecked<USMGraph>(FEdGraphUtilities::CloneGraph(ParentStateMachineGraph, ParentStateMachineNode, &MessageLog, true));
+	if (CompileReport.IsValid())
+	{
+		CompileReport->NumClonedGraphs++;
+	}
 	ValidateAllNodes(ClonedParentGraph);
 	
 	USMGraphNode_StateMachineEntryNode* EntryNode = ClonedParentGraph->GetEntryNode();
@@ -1924,6 +1981,11 @@ UK2Node_CustomEvent* FSMKismetCompilerContext::CreateEntryNode(USMGraphK2Node_Ro
 	EntryEventNode->CustomFunctionName = FunctionName;
 	EntryEventNode->AllocateDefaultPins();
 
+	if (CompileReport.IsValid())
+	{
+		CompileReport->NumGeneratedFunctions++;
+	}
+
 	if (bCreateAndLinkParamPins)
 	{
 		// Find all of the connections of the original pin properties.
@@ -1966,6 +2028,11 @@ FStructProperty* FSMKismetCompilerContext::CreateRuntimeProperty(USMGraphK2Node_
 		return NewProperty;
 	}
 
+	if (CompileReport.IsValid())
+	{
+		CompileReport->NumGeneratedProperties++;
+	}
+
 	// Record the property so it can be referenced during DefaultObject setup.
 	AllocatedNodePropertiesToNodes.Add(NewProperty, RuntimeContainerNode);
 
@@ -1995,16 +2062,39 @@ FStructProperty* FSMKismetCompilerContext::CreateRuntimeProperty(USMGraphK2Node_
 		return NewProperty;
 	}
 
+	if (CompileReport.IsValid())
+	{
+		CompileReport->NumGeneratedProperties++;
+	}
+
 	// Record the property so it can be referenced during DefaultObject setup.
 	AllocatedNodePropertiesToNodes.Add(NewProperty, PropertyNode);
 
 	return NewProperty;
 }
 
+void FSMKismetCompilerContext::CloneAndMergeGraphIn(UEdGraph* SourceGraph)
+{
+	FEdGraphUtilities::CloneAndMergeGraphIn(ConsolidatedEventGraph, SourceGraph, MessageLog, true, true);
+
+	if (CompileReport.IsValid())
+	{
+		CompileReport->NumClonedGraphs++;
+	}
+}
+
 void FSMKismetCompilerContext::AddDefaultObjectTemplate(const FGuid& RuntimeGuid, UObject* Template, FTemplateContainer::ETemplateType TemplateType, FGuid TemplateGuid)
 {
+	SM_COMPILER_PHASE_SCOPE(AddDefaultObjectTemplate);
+	
 	TArray<FTemplateContainer>& Templates = DefaultObjectTemplates.FindOrAdd(RuntimeGuid);
+	const int32 NumTemplates = Templates.Num();
 	Templates.AddUnique(FTemplateContainer(Template, TemplateType, TemplateGuid));
+
+	if (CompileReport.IsValid() && Templates.Num() > NumTemplates)
+	{
+		CompileReport->NumTemplates++;
+	}
 }
 
 FName FSMKismetCompilerContext::CreateFunctionName(USMGraphK2Node_RootNode* GraphNode, FSMNode_Base* RuntimeNode)
@@ -2043,6 +2133,9 @@ void FSMKismetCompilerContext::RecompileChildren()
 	FSMBlueprintEditorUtils::MarkBlueprintAsModified(Blueprint);
 	if (Blueprint->SkeletonGeneratedClass && !Blueprint->HasAnyFlags(RF_NeedLoad | RF_NeedPostLoad))
 	{
+		// Only calculated when a child needs it. Recompiling without changes shouldn't cascade to children again.
+		TOptional<bool> bShouldNotifyChildren;
+		
 		TArray<UClass*> ChildClasses;
 		GetDerivedClasses(Blueprint->SkeletonGeneratedClass, ChildClasses);
 
@@ -2071,6 +2164,16 @@ void FSMKismetCompilerContext::RecompileChildren()
 					// If there are no parent calls we can just use the normal skeleton recompile, otherwise the nodes need to be expanded in a full compile.
 					if (ParentCalls.Num() > 0)
 					{
+						if (!bShouldNotifyChildren.IsSet())
+						{
+							bShouldNotifyChildren = FSMCompileCache::Get().ShouldNotifyChildren(Blueprint);
+						}
+
+						if (!bShouldNotifyChildren.GetValue())
+						{
+							break;
+						}
+						
 						FSMBlueprintEditorUtils::MarkBlueprintAsModified(ChildBlueprint);
 						FSMBlueprintEditorUtils::EnsureCachedDependenciesUpToDate(ChildBlueprint);
 
@@ -2160,6 +2263,9 @@ void FSMNodeKismetCompilerContext::CopyTermDefaultsToDefaultObject(UObject* Defa
 			uint8* CDOContainer = HasGameConstructionScriptsProperty->ContainerPtrToValuePtr<uint8>(DefaultObject);
 			HasGameConstructionScriptsProperty->SetPropertyValue(CDOContainer, bHasGameConstructionScripts);
 		}
+
+		// Defaults are final so rules and descriptions can be registered.
+		FSMNodeClassRegistry::Get().UpdateClass(NodeInstance->GetClass());
 	}
 }
 
@@ -21,6 +21,7 @@ class USMGraphK2Node_RuntimeNodeContainer;
 class USMGraphK2Node_RootNode;
 class USMGraphK2Node_StateMachineNode;
 class USMGraphK2Node_StateMachineEntryNode;
+struct FSMCompileReport;
 
 
 struct FTemplateContainer
@@ -149,6 +150,9 @@ public:
 	/** Creates a runtime property for a property node. */
 	FStructProperty* CreateRuntimeProperty(class USMGraphK2Node_PropertyNode_Base* PropertyNode);
 
+	/** Clone a graph and its sub graphs into the consolidated event graph. */
+	void CloneAndMergeGraphIn(UEdGraph* SourceGraph);
+
 	/** Add a template to the list for the specified runtime guid. TemplateGuid only needed for state stack templates. */
 	void AddDefaultObjectTemplate(const FGuid& RuntimeGuid, UObject* Template, FTemplateContainer::ETemplateType TemplateType, FGuid TemplateGuid = FGuid());
 
@@ -200,6 +204,9 @@ protected:
 
 	/** Set if at least one input event is detected. */
 	UK2Node* InputConsumingEvent;
+
+	/** Phase times and generated counts of this compile. Only valid for full compiles. */
+	TSharedPtr<FSMCompileReport> CompileReport;
 };
 
 
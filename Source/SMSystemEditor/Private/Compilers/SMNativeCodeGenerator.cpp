@@ -0,0 +1,868 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#include "SMNativeCodeGenerator.h"
+#include "SMSystemEditorLog.h"
+#include "Utilities/SMBlueprintEditorUtils.h"
+#include "Utilities/SMCookOptimizer.h"
+#include "Graph/SMTransitionGraph.h"
+#include "Graph/Nodes/Helpers/SMGraphK2Node_StateReadNodes.h"
+#include "Graph/Nodes/RootNodes/SMGraphK2Node_TransitionResultNode.h"
+
+#include "Blueprints/SMBlueprint.h"
+#include "SMInstance.h"
+#include "SMBlueprintFunctions.h"
+#include "SMTransition.h"
+#include "SMConduit.h"
+
+#include "EdGraphSchema_K2.h"
+#include "K2Node_CallFunction.h"
+#include "K2Node_Knot.h"
+#include "K2Node_VariableGet.h"
+#include "Kismet/KismetMathLibrary.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/Script.h"
+#include "UObject/StructOnScope.h"
+#include "UObject/UnrealType.h"
+
+FString FSMNativeCodeGenerationResult::ToString() const
+{
+	return FString::Printf(TEXT("%s -> %s: Nodes=%d NativePredicates=%d VMFallbacks=%d EmptyFunctionsRemoved=%d Warnings=%d"),
+		*BlueprintPath, *ClassName, NumNodes, NumNativePredicates, NumVMFallbacks, NumEmptyFunctionsRemoved, Warnings.Num());
+}
+
+/** A valid C++ identifier from any name. */
+static FString MakeIdentifier(const FString& Name)
+{
+	FString Identifier;
+	Identifier.Reserve(Name.Len() + 1);
+
+	for (const TCHAR Char : Name)
+	{
+		const bool bIsValid = Char < 128 && (FChar::IsAlnum(Char) || Char == TEXT('_'));
+		Identifier.AppendChar(bIsValid ? Char : TEXT('_'));
+	}
+
+	if (Identifier.IsEmpty() || FChar::IsDigit(Identifier[0]))
+	{
+		Identifier.InsertAt(0, TEXT('_'));
+	}
+
+	return Identifier;
+}
+
+/** The include path of a native type relative to the public folder of its module. */
+static FString GetIncludePath(const UField* Type)
+{
+	FString IncludePath = Type->GetMetaData(TEXT("IncludePath"));
+	if (IncludePath.IsEmpty())
+	{
+		IncludePath = Type->GetMetaData(TEXT("ModuleRelativePath"));
+		IncludePath.RemoveFromStart(TEXT("Public/"));
+		IncludePath.RemoveFromStart(TEXT("Classes/"));
+	}
+
+	return IncludePath;
+}
+
+static FString GetEnumCppType(const UEnum* Enum)
+{
+	return Enum->CppType.IsEmpty() ? Enum->GetName() : Enum->CppType;
+}
+
+/** If a compiled graph function only contains debug sites and a return. */
+static bool IsFunctionEmpty(const UFunction* Function)
+{
+	for (const uint8 Token : Function->Script)
+	{
+		if (Token != EX_Tracepoint && Token != EX_WireTracepoint && Token != EX_Return && Token != EX_Nothing && Token != EX_EndOfScript)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/** Pure math library functions which translate to a single C++ operator. */
+static const TMap<FName, const TCHAR*>& GetMathOperators()
+{
+	static TMap<FName, const TCHAR*> Operators;
+	if (Operators.Num() == 0)
+	{
+		Operators.Add(TEXT("Not_PreBool"), TEXT("!"));
+		Operators.Add(TEXT("BooleanAND"), TEXT("&&"));
+		Operators.Add(TEXT("BooleanOR"), TEXT("||"));
+		Operators.Add(TEXT("BooleanXOR"), TEXT("!="));
+		Operators.Add(TEXT("EqualEqual_BoolBool"), TEXT("=="));
+		Operators.Add(TEXT("NotEqual_BoolBool"), TEXT("!="));
+		Operators.Add(TEXT("EqualEqual_NameName"), TEXT("=="));
+		Operators.Add(TEXT("NotEqual_NameName"), TEXT("!="));
+
+		const TCHAR* NumericTypes[] = { TEXT("IntInt"), TEXT("FloatFloat"), TEXT("ByteByte") };
+		const TPair<const TCHAR*, const TCHAR*> Comparisons[] =
+		{
+			{ TEXT("Greater"), TEXT(">") }, { TEXT("GreaterEqual"), TEXT(">=") }, { TEXT("Less"), TEXT("<") },
+			{ TEXT("LessEqual"), TEXT("<=") }, { TEXT("EqualEqual"), TEXT("==") }, { TEXT("NotEqual"), TEXT("!=") }
+		};
+
+		for (const TCHAR* NumericType : NumericTypes)
+		{
+			for (const TPair<const TCHAR*, const TCHAR*>& Comparison : Comparisons)
+			{
+				Operators.Add(*FString::Printf(TEXT("%s_%s"), Comparison.Key, NumericType), Comparison.Value);
+			}
+		}
+	}
+
+	return Operators;
+}
+
+/** Protected node properties and the public setter which assigns them. */
+static const TCHAR* FindNodeSetter(const FName PropertyName)
+{
+	static const TMap<FName, const TCHAR*> Setters =
+	{
+		{ TEXT("Guid"), TEXT("SetNodeGuid") },
+		{ TEXT("OwnerGuid"), TEXT("SetOwnerNodeGuid") },
+		{ TEXT("NodeName"), TEXT("SetNodeName") },
+		{ TEXT("NodeInstanceClass"), TEXT("SetNodeInstanceClass") },
+		{ TEXT("ReferencedStateMachineClass"), TEXT("SetClassReference") }
+	};
+
+	const TCHAR* const* Setter = Setters.Find(PropertyName);
+	return Setter ? *Setter : nullptr;
+}
+
+/** Node properties which name templates on the blueprint class defaults. Templates are not generated. */
+static bool IsTemplateProperty(const FName PropertyName)
+{
+	return PropertyName == TEXT("TemplateName") || PropertyName == TEXT("StackTemplateNames") ||
+		PropertyName == TEXT("ReferencedTemplateName") || PropertyName == TEXT("TemplateVariableGraphProperties");
+}
+
+static bool IsFunctionHandlerArray(const FProperty* Property)
+{
+	const FArrayProperty* ArrayProperty = CastField<FArrayProperty>(Property);
+	const FStructProperty* InnerProperty = ArrayProperty ? CastField<FStructProperty>(ArrayProperty->Inner) : nullptr;
+	return InnerProperty && InnerProperty->Struct == FSMExposedFunctionHandler::StaticStruct();
+}
+
+/** Builds the generated class of a single blueprint. */
+class FSMNativeClassWriter
+{
+public:
+	FSMNativeClassWriter(USMBlueprint* InBlueprint, FSMNativeCodeGenerationResult& InResult)
+		: Blueprint(InBlueprint), Result(InResult)
+	{
+		GeneratedClass = Blueprint->GeneratedClass;
+		DefaultObject = CastChecked<USMInstance>(GeneratedClass->GetDefaultObject());
+		ParentClass = Blueprint->ParentClass;
+	}
+
+	bool Write(const FString& ApiMacro);
+
+private:
+	void WriteVariables();
+	void WriteClassDefaults();
+	void WriteNode(FStructProperty* NodeProperty);
+	void WriteFunctionHandlers(const UScriptStruct* Struct, const FSMNode_Base* Node, const FString& NodeMember, const FArrayProperty* HandlerProperty, FString& OutLines);
+	void CheckEventGraph();
+
+	/**
+	 * A statement running the graph function of a node handler in the source blueprint once it is reparented to the generated class.
+	 * False if the function parameters can't be forwarded.
+	 */
+	bool CallBlueprintNodeFunction(const FString& NodeMember, const FArrayProperty* HandlerProperty, int32 HandlerIndex, const UFunction* Function,
+		FString& OutParameters, FString& OutStatement);
+
+	/** Translate the result of a transition or conduit to a C++ expression. */
+	bool TranslateResult(const FSMNode_Base* Node, const FString& NodeMember, FString& OutExpression) const;
+	bool TranslatePin(const UEdGraphPin* Pin, const USMGraphK2Node_TransitionResultNode* ResultNode, const FString& NodeMember, FString& OutExpression) const;
+	static bool TranslateLiteral(const UEdGraphPin* Pin, FString& OutExpression);
+
+	/** A C++ expression of a property value. False for types which can't be written as a literal. */
+	bool TranslateValue(const FProperty* Property, const void* Value, FString& OutExpression);
+
+	/** The static class finder holding a class, added to the constructor if needed. */
+	FString GetClassFinder(const UClass* Class);
+	FString MakeUniqueIdentifier(const FString& Name);
+
+	void AddWarning(const FString& Warning);
+
+private:
+	USMBlueprint* Blueprint;
+	UClass* GeneratedClass;
+	UClass* ParentClass;
+	USMInstance* DefaultObject;
+	FSMNativeCodeGenerationResult& Result;
+
+	/** Blueprint variable -> generated member. */
+	TMap<FName, FString> VariableMembers;
+
+	/** Runtime node guid -> the result node of its transition or conduit graph. */
+	TMap<FGuid, USMGraphK2Node_TransitionResultNode*> ResultNodes;
+
+	TSet<FString> UsedIdentifiers;
+	TSet<FString> Includes;
+
+	/** Class path -> class finder variable. */
+	TMap<FString, FString> ClassFinders;
+
+	TArray<FString> PublicDeclarations;
+	TArray<FString> PrivateDeclarations;
+	FString ClassDefaultLines;
+	TArray<FString> ConstructorLines;
+	TArray<FString> FunctionDefinitions;
+};
+
+bool FSMNativeClassWriter::Write(const FString& ApiMacro)
+{
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("FSMNativeCodeGenerator::Generate"), STAT_SMNativeCodeGenerator_Generate, STATGROUP_LogicDriverEditor);
+
+	const FString BaseName = MakeIdentifier(Blueprint->GetName()) + TEXT("Native");
+	Result.ClassName = TEXT("U") + BaseName;
+	Result.HeaderFilename = BaseName + TEXT(".h");
+	Result.SourceFilename = BaseName + TEXT(".cpp");
+	UsedIdentifiers.Add(Result.ClassName);
+	UsedIdentifiers.Add(TEXT("ExecuteBlueprintNodeFunction"));
+
+	TArray<USMGraphK2Node_TransitionResultNode*> AllResultNodes;
+	FSMBlueprintEditorUtils::GetAllNodesOfClassNested<USMGraphK2Node_TransitionResultNode>(Blueprint, AllResultNodes);
+	for (USMGraphK2Node_TransitionResultNode* ResultNode : AllResultNodes)
+	{
+		ResultNodes.Add(ResultNode->GetRunTimeNodeChecked()->GetNodeGuid(), ResultNode);
+	}
+
+	WriteVariables();
+	WriteClassDefaults();
+	if (!ClassDefaultLines.IsEmpty())
+	{
+		ConstructorLines.Add(ClassDefaultLines);
+	}
+
+	// Only nodes of this class. Nodes of a blueprint parent would have to be generated with the parent.
+	for (TFieldIterator<FStructProperty> It(GeneratedClass, EFieldIteratorFlags::ExcludeSuper); It; ++It)
+	{
+		if (It->Struct->IsChildOf(FSMNode_Base::StaticStruct()))
+		{
+			WriteNode(*It);
+		}
+	}
+
+	if (Result.NumNodes == 0)
+	{
+		AddWarning(TEXT("The blueprint has no state machine nodes."));
+		return false;
+	}
+
+	CheckEventGraph();
+
+	const FString GeneratedComment = FString::Printf(TEXT("// Generated from %s by the Logic Driver native code generator. Changes are lost when it is generated again.\n\n"),
+		*Result.BlueprintPath);
+
+	// Header.
+	FString& Header = Result.HeaderText;
+	Header = GeneratedComment;
+	Header += TEXT("#pragma once\n\n#include \"CoreMinimal.h\"\n");
+	Header += FString::Printf(TEXT("#include \"%s\"\n"), *GetIncludePath(ParentClass));
+
+	TArray<FString> SortedIncludes = Includes.Array();
+	SortedIncludes.Sort();
+	for (const FString& Include : SortedIncludes)
+	{
+		Header += FString::Printf(TEXT("#include \"%s\"\n"), *Include);
+	}
+
+	Header += FString::Printf(TEXT("#include \"%s.generated.h\"\n\n"), *BaseName);
+	Header += TEXT("UCLASS(Blueprintable)\n");
+	Header += FString::Printf(TEXT("class %s%s : public %s%s\n{\n\tGENERATED_BODY()\n\npublic:\n"),
+		*ApiMacro, ApiMacro.IsEmpty() ? TEXT("") : TEXT(" "), ParentClass->GetPrefixCPP(), *ParentClass->GetName());
+	Header += FString::Printf(TEXT("\t%s(const FObjectInitializer& ObjectInitializer);\n"), *Result.ClassName);
+
+	for (const FString& Declaration : PublicDeclarations)
+	{
+		Header += TEXT("\n") + Declaration;
+	}
+
+	Header += TEXT("\nprivate:");
+	for (const FString& Declaration : PrivateDeclarations)
+	{
+		Header += TEXT("\n") + Declaration;
+	}
+
+	Header += TEXT("};\n");
+
+	// Source.
+	FString& Source = Result.SourceText;
+	Source = GeneratedComment;
+	Source += FString::Printf(TEXT("#include \"%s\"\n"), *Result.HeaderFilename);
+	if (ClassFinders.Num() > 0)
+	{
+		Source += TEXT("#include \"UObject/ConstructorHelpers.h\"\n");
+	}
+
+	Source += FString::Printf(TEXT("\n%s::%s(const FObjectInitializer& ObjectInitializer)\n\t: Super(ObjectInitializer)\n{\n"), *Result.ClassName, *Result.ClassName);
+
+	for (const TPair<FString, FString>& ClassFinder : ClassFinders)
+	{
+		Source += FString::Printf(TEXT("\tstatic ConstructorHelpers::FClassFinder<UObject> %s(TEXT(\"%s\"));\n"), *ClassFinder.Value, *ClassFinder.Key);
+	}
+
+	if (ClassFinders.Num() > 0)
+	{
+		Source += TEXT("\n");
+	}
+
+	Source += FString::Join(ConstructorLines, TEXT("\n"));
+	Source += TEXT("}\n");
+
+	for (const FString& Definition : FunctionDefinitions)
+	{
+		Source += FString::Printf(TEXT("\n%s"), *Definition);
+	}
+
+	return true;
+}
+
+void FSMNativeClassWriter::WriteVariables()
+{
+	for (const FBPVariableDescription& Variable : Blueprint->NewVariables)
+	{
+		const FEdGraphPinType& VarType = Variable.VarType;
+		const FName Category = VarType.PinCategory;
+
+		const TCHAR* CppType = nullptr;
+		if (!VarType.IsContainer())
+		{
+			if (Category == UEdGraphSchema_K2::PC_Boolean)
+			{
+				CppType = TEXT("bool");
+			}
+			else if (Category == UEdGraphSchema_K2::PC_Int)
+			{
+				CppType = TEXT("int32");
+			}
+			else if (Category == UEdGraphSchema_K2::PC_Float)
+			{
+				CppType = TEXT("float");
+			}
+			else if (Category == UEdGraphSchema_K2::PC_Name)
+			{
+				CppType = TEXT("FName");
+			}
+			else if (Category == UEdGraphSchema_K2::PC_String)
+			{
+				CppType = TEXT("FString");
+			}
+			else if (Category == UEdGraphSchema_K2::PC_Byte && VarType.PinSubCategoryObject == nullptr)
+			{
+				CppType = TEXT("uint8");
+			}
+		}
+
+		FProperty* Property = FindFProperty<FProperty>(GeneratedClass, Variable.VarName);
+		if (!CppType || !Property)
+		{
+			AddWarning(FString::Printf(TEXT("Variable %s of type %s is not generated."), *Variable.VarName.ToString(), *Category.ToString()));
+			continue;
+		}
+
+		if (Variable.PropertyFlags & CPF_Net)
+		{
+			AddWarning(FString::Printf(TEXT("Variable %s is generated without replication."), *Variable.VarName.ToString()));
+		}
+
+		const FString Member = MakeUniqueIdentifier(Variable.VarName.ToString());
+		VariableMembers.Add(Variable.VarName, Member);
+
+		const FString VariableCategory = Variable.Category.IsEmpty() ? TEXT("Default") : Variable.Category.ToString();
+		PublicDeclarations.Add(FString::Printf(TEXT("\tUPROPERTY(EditAnywhere, BlueprintReadWrite%s, Category = \"%s\")\n\t%s %s;\n"),
+			(Variable.PropertyFlags & CPF_SaveGame) ? TEXT(", SaveGame") : TEXT(""), *VariableCategory.ReplaceCharWithEscapedChar(), CppType, *Member));
+
+		FString DefaultValue;
+		if (TranslateValue(Property, Property->ContainerPtrToValuePtr<void>(DefaultObject), DefaultValue))
+		{
+			ClassDefaultLines += FString::Printf(TEXT("\t%s = %s;\n"), *Member, *DefaultValue);
+		}
+	}
+}
+
+void FSMNativeClassWriter::WriteClassDefaults()
+{
+	const UObject* ParentDefaultObject = ParentClass->GetDefaultObject();
+	for (TFieldIterator<FProperty> It(ParentClass); It; ++It)
+	{
+		FProperty* Property = *It;
+		if (Property->HasAnyPropertyFlags(CPF_Transient | CPF_DuplicateTransient | CPF_EditorOnly) || Property->GetFName() == GET_MEMBER_NAME_CHECKED(USMInstance, ReferenceTemplates)
+			|| Property->Identical_InContainer(DefaultObject, ParentDefaultObject, 0, PPF_DeepComparison))
+		{
+			continue;
+		}
+
+		FString Value;
+		if (Property->HasAnyPropertyFlags(CPF_NativeAccessSpecifierPrivate) || !TranslateValue(Property, Property->ContainerPtrToValuePtr<void>(DefaultObject), Value))
+		{
+			AddWarning(FString::Printf(TEXT("Class default %s is not generated."), *Property->GetName()));
+			continue;
+		}
+
+		ClassDefaultLines += FString::Printf(TEXT("\t%s = %s;\n"), *Property->GetNameCPP(), *Value);
+	}
+}
+
+void FSMNativeClassWriter::WriteNode(FStructProperty* NodeProperty)
+{
+	UScriptStruct* Struct = NodeProperty->Struct;
+	const FSMNode_Base* Node = NodeProperty->ContainerPtrToValuePtr<FSMNode_Base>(DefaultObject);
+	const FString Member = MakeUniqueIdentifier(NodeProperty->GetName());
+
+	Includes.Add(GetIncludePath(Struct));
+	PrivateDeclarations.Add(FString::Printf(TEXT("\tUPROPERTY()\n\t%s %s;\n"), *Struct->GetStructCPPName(), *Member));
+	Result.NumNodes++;
+
+	FString Lines = FString::Printf(TEXT("\t// %s\n"), *Node->GetNodeName().ReplaceCharWithEscapedChar());
+
+	FStructOnScope Defaults(Struct);
+	for (TFieldIterator<FProperty> It(Struct); It; ++It)
+	{
+		FProperty* Property = *It;
+		const FName PropertyName = Property->GetFName();
+
+		if (Property->HasAnyPropertyFlags(CPF_Transient | CPF_DuplicateTransient | CPF_EditorOnly) || PropertyName == TEXT("PathGuid"))
+		{
+			continue;
+		}
+
+		if (IsFunctionHandlerArray(Property))
+		{
+			WriteFunctionHandlers(Struct, Node, Member, CastFieldChecked<FArrayProperty>(Property), Lines);
+			continue;
+		}
+
+		if (Property->Identical_InContainer(Node, Defaults.GetStructMemory(), 0, PPF_DeepComparison))
+		{
+			continue;
+		}
+
+		if (PropertyName == TEXT("TemplateName"))
+		{
+			const FName TemplateName = *Property->ContainerPtrToValuePtr<FName>(Node);
+			const UObject* Template = FindObject<UObject>(DefaultObject, *TemplateName.ToString());
+			if (Template && !FSMCookOptimizer::IsTemplateUnmodified(Template))
+			{
+				AddWarning(FString::Printf(TEXT("Node %s: Template values are not generated. The node instance uses the class defaults of %s."),
+					*Node->GetNodeName(), *Template->GetClass()->GetName()));
+			}
+			continue;
+		}
+
+		if (IsTemplateProperty(PropertyName))
+		{
+			AddWarning(FString::Printf(TEXT("Node %s: %s is not generated."), *Node->GetNodeName(), *Property->GetName()));
+			continue;
+		}
+
+		FString Value;
+		if (!TranslateValue(Property, Property->ContainerPtrToValuePtr<void>(Node), Value))
+		{
+			AddWarning(FString::Printf(TEXT("Node %s: %s of type %s is not generated."), *Node->GetNodeName(), *Property->GetName(), *Property->GetCPPType()));
+			continue;
+		}
+
+		if (Property->HasAnyPropertyFlags(CPF_NativeAccessSpecifierPublic))
+		{
+			Lines += FString::Printf(TEXT("\t%s.%s = %s;\n"), *Member, *Property->GetNameCPP(), *Value);
+		}
+		else if (const TCHAR* Setter = FindNodeSetter(PropertyName))
+		{
+			Lines += FString::Printf(TEXT("\t%s.%s(%s);\n"), *Member, Setter, *Value);
+		}
+		else
+		{
+			AddWarning(FString::Printf(TEXT("Node %s: %s is not accessible and is not generated."), *Node->GetNodeName(), *Property->GetName()));
+		}
+	}
+
+	ConstructorLines.Add(Lines);
+}
+
+void FSMNativeClassWriter::WriteFunctionHandlers(const UScriptStruct* Struct, const FSMNode_Base* Node, const FString& NodeMember, const FArrayProperty* HandlerProperty,
+	FString& OutLines)
+{
+	const TArray<FSMExposedFunctionHandler>& Handlers = *HandlerProperty->ContainerPtrToValuePtr<TArray<FSMExposedFunctionHandler>>(Node);
+
+	const bool bIsTransition = Struct->IsChildOf(FSMTransition::StaticStruct());
+	const bool bIsResultEvaluator = HandlerProperty->GetFName() == GET_MEMBER_NAME_CHECKED(FSMNode_Base, GraphEvaluator) &&
+		(bIsTransition || Struct->IsChildOf(FSMConduit::StaticStruct()));
+
+	if (bIsResultEvaluator && bIsTransition &&
+		static_cast<const FSMTransition*>(Node)->ConditionalEvaluationType != ESMConditionalEvaluationType::SM_Graph)
+	{
+		// Constant results never execute the graph.
+		return;
+	}
+
+	FString HandlerName = HandlerProperty->GetName();
+	HandlerName.RemoveFromEnd(TEXT("GraphEvaluators"));
+	HandlerName.RemoveFromEnd(TEXT("GraphEvaluator"));
+	if (HandlerName.IsEmpty())
+	{
+		HandlerName = TEXT("Execute");
+	}
+
+	for (int32 Idx = 0; Idx < Handlers.Num(); ++Idx)
+	{
+		const UFunction* Function = GeneratedClass->FindFunctionByName(Handlers[Idx].BoundFunction);
+		if (!Function)
+		{
+			continue;
+		}
+
+		if (IsFunctionEmpty(Function))
+		{
+			Result.NumEmptyFunctionsRemoved++;
+			continue;
+		}
+
+		FString Parameters;
+		FString Body;
+		FString Expression;
+		const bool bIsNative = bIsResultEvaluator && TranslateResult(Node, NodeMember, Expression);
+		if (bIsNative)
+		{
+			Body = FString::Printf(TEXT("\t%s.bCanEnterTransition = %s;\n"), *NodeMember, *Expression);
+			Result.NumNativePredicates++;
+		}
+		else if (CallBlueprintNodeFunction(NodeMember, HandlerProperty, Idx, Function, Parameters, Body))
+		{
+			Result.NumVMFallbacks++;
+			AddWarning(FString::Printf(TEXT("Node %s: %s runs on the blueprint VM."), *Node->GetNodeName(), *HandlerProperty->GetName()));
+		}
+		else
+		{
+			AddWarning(FString::Printf(TEXT("Node %s: %s has parameters which can't be forwarded and is not generated."), *Node->GetNodeName(), *HandlerProperty->GetName()));
+			continue;
+		}
+
+		const FString BoundFunction = bIsResultEvaluator ? MakeUniqueIdentifier(TEXT("Evaluate_") + NodeMember) :
+			MakeUniqueIdentifier(FString::Printf(TEXT("%s_%s"), *NodeMember, *HandlerName) + (Idx > 0 ? FString::Printf(TEXT("_%d"), Idx) : FString()));
+
+		PrivateDeclarations.Add(FString::Printf(TEXT("\tUFUNCTION()\n\tvoid %s(%s);\n"), *BoundFunction, *Parameters));
+		FunctionDefinitions.Add(FString::Printf(TEXT("void %s::%s(%s)\n{\n%s}\n"), *Result.ClassName, *BoundFunction, *Parameters, *Body));
+
+		OutLines += FString::Printf(TEXT("\t%s.%s.AddDefaulted_GetRef().BoundFunction = GET_FUNCTION_NAME_CHECKED(%s, %s);\n"),
+			*NodeMember, *HandlerProperty->GetNameCPP(), *Result.ClassName, *BoundFunction);
+	}
+}
+
+bool FSMNativeClassWriter::CallBlueprintNodeFunction(const FString& NodeMember, const FArrayProperty* HandlerProperty, int32 HandlerIndex,
+	const UFunction* Function, FString& OutParameters, FString& OutStatement)
+{
+	// Graph function names change each compile, so the function is found at runtime from the handler of the blueprint node.
+	FString ParamsArgument = TEXT("nullptr");
+	for (TFieldIterator<FProperty> It(Function); It && It->HasAnyPropertyFlags(CPF_Parm); ++It)
+	{
+		if (!OutParameters.IsEmpty() || It->HasAnyPropertyFlags(CPF_ReturnParm | CPF_OutParm))
+		{
+			// Only a single parameter is passed the same way the runtime node passes it, such as the delta seconds of an update.
+			return false;
+		}
+
+		const FString ParameterName = MakeIdentifier(It->GetName());
+		OutParameters = FString::Printf(TEXT("%s %s"), *It->GetCPPType(), *ParameterName);
+		ParamsArgument = TEXT("&") + ParameterName;
+	}
+
+	OutStatement = FString::Printf(TEXT("\tExecuteBlueprintNodeFunction(%s, TEXT(\"%s\"), %d, %s);\n"),
+		*NodeMember, *HandlerProperty->GetName(), HandlerIndex, *ParamsArgument);
+	return true;
+}
+
+void FSMNativeClassWriter::CheckEventGraph()
+{
+	for (const UEdGraph* Graph : Blueprint->UbergraphPages)
+	{
+		for (const UEdGraphNode* GraphNode : Graph->Nodes)
+		{
+			const bool bHasLinks = GraphNode->Pins.ContainsByPredicate([](const UEdGraphPin* Pin)
+			{
+				return Pin->LinkedTo.Num() > 0;
+			});
+
+			if (bHasLinks)
+			{
+				AddWarning(FString::Printf(TEXT("Event graph %s is not generated. Its logic must be added to the generated class or a child blueprint."), *Graph->GetName()));
+				break;
+			}
+		}
+	}
+}
+
+bool FSMNativeClassWriter::TranslateResult(const FSMNode_Base* Node, const FString& NodeMember, FString& OutExpression) const
+{
+	const USMGraphK2Node_TransitionResultNode* ResultNode = ResultNodes.FindRef(Node->GetNodeGuid());
+	if (!ResultNode)
+	{
+		return false;
+	}
+
+	const UEdGraphPin* ResultPin = ResultNode->GetTransitionEvaluationPin();
+	return ResultPin && TranslatePin(ResultPin, ResultNode, NodeMember, OutExpression);
+}
+
+bool FSMNativeClassWriter::TranslatePin(const UEdGraphPin* Pin, const USMGraphK2Node_TransitionResultNode* ResultNode, const FString& NodeMember,
+	FString& OutExpression) const
+{
+	if (Pin->PinType.IsContainer())
+	{
+		return false;
+	}
+
+	if (Pin->LinkedTo.Num() == 0)
+	{
+		return TranslateLiteral(Pin, OutExpression);
+	}
+
+	const UEdGraphPin* SourcePin = Pin->LinkedTo[0];
+	const UEdGraphNode* SourceNode = SourcePin->GetOwningNode();
+
+	if (const UK2Node_Knot* Knot = Cast<UK2Node_Knot>(SourceNode))
+	{
+		return TranslatePin(Knot->GetInputPin(), ResultNode, NodeMember, OutExpression);
+	}
+
+	if (const UK2Node_VariableGet* VariableGet = Cast<UK2Node_VariableGet>(SourceNode))
+	{
+		const FString* Member = VariableGet->VariableReference.IsSelfContext() ? VariableMembers.Find(VariableGet->GetVarName()) : nullptr;
+		if (Member)
+		{
+			OutExpression = *Member;
+			return true;
+		}
+
+		return false;
+	}
+
+	if (const USMGraphK2Node_StateReadNode* ReadNode = Cast<USMGraphK2Node_StateReadNode>(SourceNode))
+	{
+		// Read nodes are compiled to a member get of the runtime node, such as TimeInState.
+		const UScriptStruct* NodeStruct = ResultNode->GetRunTimeNodeType();
+		const FProperty* NodeProperty = NodeStruct ? FindFProperty<FProperty>(NodeStruct, SourcePin->GetFName()) : nullptr;
+		if (!ReadNode->HandlesOwnExpansion() && NodeProperty && NodeProperty->HasAnyPropertyFlags(CPF_NativeAccessSpecifierPublic))
+		{
+			OutExpression = FString::Printf(TEXT("%s.%s"), *NodeMember, *NodeProperty->GetNameCPP());
+			return true;
+		}
+
+		return false;
+	}
+
+	if (const UK2Node_CallFunction* CallFunction = Cast<UK2Node_CallFunction>(SourceNode))
+	{
+		const UFunction* Function = CallFunction->GetTargetFunction();
+		if (!Function || Function->GetOwnerClass() != UKismetMathLibrary::StaticClass())
+		{
+			return false;
+		}
+
+		const TCHAR* const* Operator = GetMathOperators().Find(Function->GetFName());
+		const UEdGraphPin* PinA = CallFunction->FindPin(TEXT("A"), EGPD_Input);
+		const UEdGraphPin* PinB = CallFunction->FindPin(TEXT("B"), EGPD_Input);
+
+		FString ExpressionA;
+		if (!Operator || !PinA || !TranslatePin(PinA, ResultNode, NodeMember, ExpressionA))
+		{
+			return false;
+		}
+
+		if (!PinB)
+		{
+			OutExpression = FString::Printf(TEXT("%s%s"), *Operator, *ExpressionA);
+			return true;
+		}
+
+		FString ExpressionB;
+		if (!TranslatePin(PinB, ResultNode, NodeMember, ExpressionB))
+		{
+			return false;
+		}
+
+		OutExpression = FString::Printf(TEXT("(%s %s %s)"), *ExpressionA, *Operator, *ExpressionB);
+		return true;
+	}
+
+	return false;
+}
+
+bool FSMNativeClassWriter::TranslateLiteral(const UEdGraphPin* Pin, FString& OutExpression)
+{
+	const FName Category = Pin->PinType.PinCategory;
+	if (Category == UEdGraphSchema_K2::PC_Boolean)
+	{
+		OutExpression = Pin->DefaultValue.ToBool() ? TEXT("true") : TEXT("false");
+	}
+	else if (Category == UEdGraphSchema_K2::PC_Int || (Category == UEdGraphSchema_K2::PC_Byte && Pin->PinType.PinSubCategoryObject == nullptr))
+	{
+		OutExpression = FString::FromInt(FCString::Atoi(*Pin->DefaultValue));
+	}
+	else if (Category == UEdGraphSchema_K2::PC_Float)
+	{
+		OutExpression = FString::SanitizeFloat(FCString::Atof(*Pin->DefaultValue)) + TEXT("f");
+	}
+	else if (Category == UEdGraphSchema_K2::PC_Name)
+	{
+		OutExpression = Pin->DefaultValue.IsEmpty() || Pin->DefaultValue == TEXT("None") ? TEXT("NAME_None") :
+			FString::Printf(TEXT("FName(TEXT(\"%s\"))"), *Pin->DefaultValue.ReplaceCharWithEscapedChar());
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool FSMNativeClassWriter::TranslateValue(const FProperty* Property, const void* Value, FString& OutExpression)
+{
+	if (Property->ArrayDim != 1)
+	{
+		return false;
+	}
+
+	if (const FBoolProperty* BoolProperty = CastField<FBoolProperty>(Property))
+	{
+		OutExpression = BoolProperty->GetPropertyValue(Value) ? TEXT("true") : TEXT("false");
+	}
+	else if (const FIntProperty* IntProperty = CastField<FIntProperty>(Property))
+	{
+		OutExpression = FString::FromInt(IntProperty->GetPropertyValue(Value));
+	}
+	else if (const FFloatProperty* FloatProperty = CastField<FFloatProperty>(Property))
+	{
+		OutExpression = FString::SanitizeFloat(FloatProperty->GetPropertyValue(Value)) + TEXT("f");
+	}
+	else if (const FByteProperty* ByteProperty = CastField<FByteProperty>(Property))
+	{
+		const uint8 ByteValue = ByteProperty->GetPropertyValue(Value);
+		OutExpression = ByteProperty->Enum ? FString::Printf(TEXT("static_cast<%s>(%d)"), *GetEnumCppType(ByteProperty->Enum), ByteValue) : FString::FromInt(ByteValue);
+	}
+	else if (const FEnumProperty* EnumProperty = CastField<FEnumProperty>(Property))
+	{
+		const int64 EnumValue = EnumProperty->GetUnderlyingProperty()->GetSignedIntPropertyValue(Value);
+		OutExpression = FString::Printf(TEXT("static_cast<%s>(%lld)"), *GetEnumCppType(EnumProperty->GetEnum()), EnumValue);
+	}
+	else if (const FNameProperty* NameProperty = CastField<FNameProperty>(Property))
+	{
+		const FName NameValue = NameProperty->GetPropertyValue(Value);
+		OutExpression = NameValue.IsNone() ? TEXT("NAME_None") : FString::Printf(TEXT("FName(TEXT(\"%s\"))"), *NameValue.ToString().ReplaceCharWithEscapedChar());
+	}
+	else if (const FStrProperty* StrProperty = CastField<FStrProperty>(Property))
+	{
+		OutExpression = FString::Printf(TEXT("TEXT(\"%s\")"), *StrProperty->GetPropertyValue(Value).ReplaceCharWithEscapedChar());
+	}
+	else if (const FClassProperty* ClassProperty = CastField<FClassProperty>(Property))
+	{
+		const UClass* Class = Cast<UClass>(ClassProperty->GetObjectPropertyValue(Value));
+		OutExpression = Class ? GetClassFinder(Class) + TEXT(".Class.Get()") : TEXT("nullptr");
+	}
+	else if (const FStructProperty* StructProperty = CastField<FStructProperty>(Property))
+	{
+		if (StructProperty->Struct == TBaseStructure<FGuid>::Get())
+		{
+			const FGuid& Guid = *static_cast<const FGuid*>(Value);
+			OutExpression = FString::Printf(TEXT("FGuid(0x%08XU, 0x%08XU, 0x%08XU, 0x%08XU)"), Guid.A, Guid.B, Guid.C, Guid.D);
+		}
+		else if (StructProperty->Struct == TBaseStructure<FVector2D>::Get())
+		{
+			const FVector2D& Vector = *static_cast<const FVector2D*>(Value);
+			OutExpression = FString::Printf(TEXT("FVector2D(%sf, %sf)"), *FString::SanitizeFloat(Vector.X), *FString::SanitizeFloat(Vector.Y));
+		}
+		else
+		{
+			return false;
+		}
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+FString FSMNativeClassWriter::GetClassFinder(const UClass* Class)
+{
+	const FString ClassPath = Class->GetPathName();
+	if (const FString* ClassFinder = ClassFinders.Find(ClassPath))
+	{
+		return *ClassFinder;
+	}
+
+	return ClassFinders.Add(ClassPath, FString::Printf(TEXT("ClassFinder_%d"), ClassFinders.Num()));
+}
+
+FString FSMNativeClassWriter::MakeUniqueIdentifier(const FString& Name)
+{
+	const FString BaseIdentifier = MakeIdentifier(Name);
+
+	FString Identifier = BaseIdentifier;
+	for (int32 Suffix = 1; UsedIdentifiers.Contains(Identifier); ++Suffix)
+	{
+		Identifier = FString::Printf(TEXT("%s_%d"), *BaseIdentifier, Suffix);
+	}
+
+	UsedIdentifiers.Add(Identifier);
+	return Identifier;
+}
+
+void FSMNativeClassWriter::AddWarning(const FString& Warning)
+{
+	Result.Warnings.Add(Warning);
+}
+
+bool FSMNativeCodeGenerator::Generate(USMBlueprint* Blueprint, const FString& ApiMacro, FSMNativeCodeGenerationResult& OutResult)
+{
+	check(Blueprint);
+
+	OutResult = FSMNativeCodeGenerationResult();
+	OutResult.BlueprintPath = Blueprint->GetPathName();
+
+	if (!Blueprint->GeneratedClass || Blueprint->Status == BS_Error)
+	{
+		OutResult.Warnings.Add(TEXT("The blueprint is not compiled."));
+		return false;
+	}
+
+	if (!Blueprint->ParentClass || !Blueprint->ParentClass->HasAnyClassFlags(CLASS_Native))
+	{
+		OutResult.Warnings.Add(TEXT("Only blueprints with a native parent class can be generated."));
+		return false;
+	}
+
+	FSMNativeClassWriter Writer(Blueprint, OutResult);
+	OutResult.bSucceeded = Writer.Write(ApiMacro);
+
+	return OutResult.bSucceeded;
+}
+
+bool FSMNativeCodeGenerator::Save(const FSMNativeCodeGenerationResult& Result, const FString& Directory)
+{
+	if (!Result.bSucceeded)
+	{
+		return false;
+	}
+
+	const FString HeaderPath = FPaths::Combine(Directory, Result.HeaderFilename);
+	const FString SourcePath = FPaths::Combine(Directory, Result.SourceFilename);
+
+	if (!FFileHelper::SaveStringToFile(Result.HeaderText, *HeaderPath) || !FFileHelper::SaveStringToFile(Result.SourceText, *SourcePath))
+	{
+		LDEDITOR_LOG_ERROR(TEXT("Could not write generated code of %s to %s."), *Result.BlueprintPath, *Directory);
+		return false;
+	}
+
+	return true;
+}
+
+#undef GENERATED_CATEGORY
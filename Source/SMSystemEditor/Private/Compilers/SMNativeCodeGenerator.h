@@ -0,0 +1,68 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class USMBlueprint;
+
+/** The C++ generated from a single state machine blueprint. */
+struct SMSYSTEMEDITOR_API FSMNativeCodeGenerationResult
+{
+	/** Path of the source blueprint. */
+	FString BlueprintPath;
+
+	/** Name of the generated class including its prefix. */
+	FString ClassName;
+
+	FString HeaderFilename;
+	FString SourceFilename;
+
+	FString HeaderText;
+	FString SourceText;
+
+	/** Runtime node properties constructed by the generated class. */
+	int32 NumNodes = 0;
+
+	/** Transition and conduit results evaluated natively. */
+	int32 NumNativePredicates = 0;
+
+	/** Graph functions which run the function of the source blueprint on the blueprint VM once it is reparented to the generated class. */
+	int32 NumVMFallbacks = 0;
+
+	/** Graph functions which have no logic and are not bound. */
+	int32 NumEmptyFunctionsRemoved = 0;
+
+	/** Data of the blueprint which the generated class does not reproduce. */
+	TArray<FString> Warnings;
+
+	bool bSucceeded = false;
+
+	FString ToString() const;
+};
+
+/**
+ * Generates a native USMInstance subclass from a compiled state machine blueprint.
+ *
+ * Runtime nodes are constructed statically in the class constructor instead of being loaded from the blueprint class
+ * defaults. Transition and conduit results made of variables, literals, comparisons, boolean operators and
+ * Time in State are translated to C++. Any other graph runs on the blueprint VM: reparent the source blueprint to the
+ * generated class and the generated nodes run in place of its nodes, which only supply the graph functions not translated.
+ */
+class SMSYSTEMEDITOR_API FSMNativeCodeGenerator
+{
+public:
+	/**
+	 * Generate the header and source of a blueprint.
+	 *
+	 * @param Blueprint A compiled state machine blueprint with a native parent class.
+	 * @param ApiMacro The export macro of the module the code is added to, such as MYGAME_API. May be empty.
+	 * @param OutResult The generated code. Check bSucceeded and Warnings.
+	 *
+	 * @return True if code was generated.
+	 */
+	static bool Generate(USMBlueprint* Blueprint, const FString& ApiMacro, FSMNativeCodeGenerationResult& OutResult);
+
+	/** Write the header and source of a successful result to a directory. */
+	static bool Save(const FSMNativeCodeGenerationResult& Result, const FString& Directory);
+};
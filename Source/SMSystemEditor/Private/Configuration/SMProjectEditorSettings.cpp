@@ -11,6 +11,7 @@ USMProjectEditorSettings::USMProjectEditorSettings()
 {
 	bUpdateAssetsOnStartup = true;
 	bDisplayAssetUpdateProgress = true;
+	bUpdateAssetsWhenLoaded = false;
 	bDisplayMemoryLimitsOnCompile = true;
 	bAlwaysDisplayStructMemoryUsage = false;
 	StructMemoryLimitWarningThreshold = 0.9f;
@@ -24,7 +25,10 @@ USMProjectEditorSettings::USMProjectEditorSettings()
 	bDisplayUpdateNotification = true;
 	InstalledVersion = "";
 	EditorNodeConstructionScriptSetting = ESMEditorConstructionScriptProjectSetting::SM_Standard;
+	bDeferDefaultPropertyGraphs = false;
 	bEnablePreviewMode = true;
+	bOptimizeCookedStateMachines = true;
+	bStripCookedNodePositions = false;
 
 	DefaultStateClass = USMStateInstance::StaticClass();
 	DefaultStateMachineClass = USMStateMachineInstance::StaticClass();
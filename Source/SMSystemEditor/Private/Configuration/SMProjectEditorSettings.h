@@ -34,6 +34,13 @@ public:
 	UPROPERTY(config, EditAnywhere, Category = "Version Updates", meta = (EditCondition = "bUpdateAssetsOnStartup"))
 	bool bDisplayAssetUpdateProgress;
 
+	/**
+	 * When assets aren't updated on startup, update each asset as it is loaded such as when opened or cooked.
+	 * Updated assets still need to be saved. Run the SMUpgradeAssets commandlet to update and save all assets in batches.
+	 */
+	UPROPERTY(config, EditAnywhere, Category = "Version Updates", meta = (EditCondition = "!bUpdateAssetsOnStartup"))
+	bool bUpdateAssetsWhenLoaded;
+
 	/**
 	 * Display a popup with a link to the patch notes when a new version is detected.
 	 */
@@ -112,6 +119,16 @@ public:
 	UPROPERTY(config, EditAnywhere, Category = "Node Instances")
 	ESMEditorConstructionScriptProjectSetting EditorNodeConstructionScriptSetting;
 
+	/**
+	 * Only create property graphs for exposed variables once they are needed, such as when the node is selected.
+	 * Until then the variable uses the value of the node template at runtime and can be edited from the details panel.
+	 * This reduces the number of graphs created when placing or pasting nodes in large state machines.
+	 *
+	 * Use 'stat LogicDriverEditor' and the 'LogicDriver.PropertyGraphStats' command to compare timing and graph counts.
+	 */
+	UPROPERTY(config, EditAnywhere, Category = "Node Instances", AdvancedDisplay)
+	bool bDeferDefaultPropertyGraphs;
+
 	/**
 	 * Default class to be assigned when placing a new state node.
 	 * A setting of None will use the system default classes.
@@ -140,6 +157,22 @@ public:
 	UPROPERTY(config, EditAnywhere, Category = "Node Instances")
 	TSoftClassPtr<USMTransitionInstance> DefaultTransitionClass;
 	
+	/**
+	 * When cooking, remove state machine data the runtime never reads. This includes node templates identical to their default
+	 * node class, graph evaluators of transitions with constant results, variable graph properties that were never linked and
+	 * exposed property overrides of templates. Bytes removed are logged per asset.
+	 *
+	 * Only runs from the cook commandlet.
+	 */
+	UPROPERTY(config, EditAnywhere, Category = "Cooking")
+	bool bOptimizeCookedStateMachines;
+
+	/**
+	 * Also clear node positions when cooking. GetNodePosition will return zero in cooked builds.
+	 */
+	UPROPERTY(config, EditAnywhere, Category = "Cooking", meta = (EditCondition = "bOptimizeCookedStateMachines"))
+	bool bStripCookedNodePositions;
+	
 	/**
 	 * Enable the preview mode as an available editor mode.
 	 */
@@ -15,8 +15,104 @@
 #include "SMConduit.h"
 #include "SMStateMachineInstance.h"
 
+#include "Serialization/ObjectWriter.h"
+
 #define LOCTEXT_NAMESPACE "SMEditorConstructionManager"
 
+/** The maximum times a node's construction scripts can run for a single change. Exceeding this implies nodes read each other in a cycle. */
+static constexpr int32 MaxConstructionScriptRunsPerNode = 4;
+
+/** Hash everything that requires the editor state machine to be rebuilt when changed. */
+static uint32 CalculateStructureHash(const TArray<USMGraphNode_Base*>& GraphNodes, const UClass* RootNodeInstanceClass)
+{
+	uint32 Hash = GetTypeHash(RootNodeInstanceClass);
+	for (USMGraphNode_Base* GraphNode : GraphNodes)
+	{
+		Hash = HashCombine(Hash, GetTypeHash(GraphNode));
+		Hash = HashCombine(Hash, GetTypeHash(GraphNode->GetNodeTemplate()));
+		Hash = HashCombine(Hash, GetTypeHash(GraphNode->GetBoundGraph()));
+
+		if (USMGraphNode_StateNode* StateNode = Cast<USMGraphNode_StateNode>(GraphNode))
+		{
+			for (const FStateStackContainer& StackTemplate : StateNode->StateStack)
+			{
+				Hash = HashCombine(Hash, GetTypeHash(StackTemplate.NodeStackInstanceTemplate));
+			}
+		}
+
+		for (const UEdGraphPin* Pin : GraphNode->Pins)
+		{
+			for (const UEdGraphPin* LinkedPin : Pin->LinkedTo)
+			{
+				Hash = HashCombine(Hash, GetTypeHash(LinkedPin->GetOwningNodeUnchecked()));
+			}
+		}
+	}
+
+	return Hash;
+}
+
+/** Hash the templates of a node. Used to detect if a construction script changed anything other nodes could read. */
+static uint32 CalculateNodeDataHash(const FSMNode_Base& Node)
+{
+	uint32 Hash = 0;
+	auto HashTemplate = [&Hash](USMNodeInstance* Template)
+	{
+		if (Template)
+		{
+			TArray<uint8> Bytes;
+			FObjectWriter Writer(Template, Bytes);
+			Hash = FCrc::MemCrc32(Bytes.GetData(), Bytes.Num(), Hash);
+		}
+	};
+
+	HashTemplate(Node.GetNodeInstanceIfCreated());
+	for (USMNodeInstance* StackTemplate : Node.GetStackInstances())
+	{
+		HashTemplate(StackTemplate);
+	}
+
+	return Hash;
+}
+
+/** The node instance class of the root state machine or null if there isn't a usable generated class. */
+static UClass* GetRootNodeInstanceClass(USMBlueprint* InBlueprint)
+{
+	// Use skeleton class if BPGC is being regenerated.
+	USMBlueprintGeneratedClass* BPGC = Cast<USMBlueprintGeneratedClass>(!InBlueprint->GeneratedClass || InBlueprint->GeneratedClass->HasAnyClassFlags(CLASS_LayoutChanging) ?
+		InBlueprint->SkeletonGeneratedClass :
+		InBlueprint->GeneratedClass);
+	
+	if (BPGC == nullptr)
+	{
+		return nullptr;
+	}
+	
+	TSubclassOf<USMStateMachineInstance> StateMachineClass = nullptr;
+
+	// An old CDO is needed during a compile when the CDO is being rebuilt. This should only be viable from a skeleton class.
+	USMInstance* DefaultInstance = BPGC->GetOldCDO().Get();
+		
+	if (DefaultInstance == nullptr)
+	{
+		// Either we are the BPGC or we are being newly created. Otherwise we should be using the cached CDO.
+		ensure(InBlueprint->GeneratedClass == nullptr || BPGC == InBlueprint->GeneratedClass);
+		DefaultInstance = Cast<USMInstance>(BPGC->GetDefaultObject(false));
+	}
+	else
+	{
+		// Skeletons should use cached CDO.
+		ensure(BPGC == InBlueprint->SkeletonGeneratedClass);
+	}
+	
+	if (ensure(DefaultInstance))
+	{
+		StateMachineClass = DefaultInstance->GetStateMachineClass();
+	}
+
+	return StateMachineClass.Get() ? StateMachineClass.Get() : USMStateMachineInstance::StaticClass();
+}
+
 FSMEditorConstructionManager::~FSMEditorConstructionManager()
 {
 	CleanupAllEditorStateMachines();
@@ -38,6 +134,8 @@ void FSMEditorConstructionManager::Tick(float DeltaTime)
 	if (HasPendingConstructionScripts()) // Sanity check, should always be true if tick is called.
 	{
 		DECLARE_SCOPE_CYCLE_COUNTER(TEXT("FSMEditorConstructionManager::Tick"), STAT_ConstructionManagerTick, STATGROUP_LogicDriverEditor);
+
+		CleanupStaleEditorStateMachines();
 		
 		TSet<TWeakObjectPtr<USMBlueprint>> BlueprintsToConstruct = BlueprintsPendingConstruction;
 		for (const TWeakObjectPtr<USMBlueprint>& Blueprint : BlueprintsToConstruct)
@@ -48,8 +146,10 @@ void FSMEditorConstructionManager::Tick(float DeltaTime)
 			}
 		}
 
-		CleanupAllEditorStateMachines();
+		// Editor state machines are kept with their templates detached so the next change can reuse them.
 		BlueprintsPendingConstruction.Reset();
+		BlueprintsPendingFullConstruction.Reset();
+		NodesPendingConstruction.Reset();
 	}
 }
 
@@ -73,7 +173,8 @@ bool FSMEditorConstructionManager::IsRunningConstructionScripts(USMBlueprint* Fo
 	return ForBlueprint ? BlueprintsBeingConstructed.Contains(ForBlueprint) : BlueprintsBeingConstructed.Num() > 0;
 }
 
-void FSMEditorConstructionManager::ConstructEditorStateMachine(USMGraph* InGraph, FSMStateMachine& StateMachineOut, TArray<FSMNode_Base*>& Storage)
+void FSMEditorConstructionManager::ConstructEditorStateMachine(USMGraph* InGraph, FSMStateMachine& StateMachineOut, TArray<FSMNode_Base*>& Storage,
+	TMap<TWeakObjectPtr<USMGraphNode_Base>, FSMNode_Base*>* GraphNodesOut)
 {
 	if (!InGraph)
 	{
@@ -96,7 +197,7 @@ void FSMEditorConstructionManager::ConstructEditorStateMachine(USMGraph* InGraph
 					GraphStateNodeBaseSelected = StateMachineNode;
 					GraphStateNodeBaseSelected->SetRuntimeDefaults(EntryNode->StateMachineNode);
 					RuntimeStateSelected = new FSMStateMachine(EntryNode->StateMachineNode);
-					ConstructEditorStateMachine(NestedFSMGraph, *(FSMStateMachine*)RuntimeStateSelected, Storage);
+					ConstructEditorStateMachine(NestedFSMGraph, *(FSMStateMachine*)RuntimeStateSelected, Storage, GraphNodesOut);
 				}
 			}
 		}
@@ -144,6 +245,10 @@ void FSMEditorConstructionManager::ConstructEditorStateMachine(USMGraph* InGraph
 			}
 			StateMachineOut.AddTransition(NewTransition);
 			Storage.Add(NewTransition);
+			if (GraphNodesOut)
+			{
+				GraphNodesOut->Add(TransitionEdge, NewTransition);
+			}
 			return NewTransition;
 		};
 
@@ -171,6 +276,10 @@ void FSMEditorConstructionManager::ConstructEditorStateMachine(USMGraph* InGraph
 			
 			StateMachineOut.AddState(RuntimeStateSelected);
 			Storage.Add(RuntimeStateSelected);
+			if (GraphNodesOut)
+			{
+				GraphNodesOut->Add(GraphStateNodeBaseSelected, RuntimeStateSelected);
+			}
 
 			// Input Transitions
 			{
@@ -215,6 +324,8 @@ void FSMEditorConstructionManager::ConstructEditorStateMachine(USMGraph* InGraph
 
 void FSMEditorConstructionManager::CleanupAllEditorStateMachines()
 {
+	CleanupStaleEditorStateMachines();
+	
 	TArray<TWeakObjectPtr<USMBlueprint>> AllBlueprints;
 	EditorStateMachines.GetKeys(AllBlueprints);
 
@@ -228,33 +339,64 @@ void FSMEditorConstructionManager::CleanupEditorStateMachine(USMBlueprint* InBlu
 {
 	if (FSMEditorStateMachine* EditorFSM = EditorStateMachines.Find(InBlueprint))
 	{
-		if (EditorFSM->StateMachineEditorInstance)
+		FreeEditorStateMachine(*EditorFSM);
+		EditorStateMachines.Remove(InBlueprint);
+	}
+}
+
+void FSMEditorConstructionManager::CleanupStaleEditorStateMachines()
+{
+	for (auto It = EditorStateMachines.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
 		{
-			EditorFSM->StateMachineEditorInstance->Shutdown();
+			FreeEditorStateMachine(It.Value());
+			It.RemoveCurrent();
 		}
+	}
+}
 
-		for (FSMNode_Base* Node : EditorFSM->EditorInstanceNodeStorage)
+void FSMEditorConstructionManager::FreeEditorStateMachine(FSMEditorStateMachine& EditorFSM)
+{
+	if (!EditorFSM.bTemplatesAttached)
+	{
+		// Templates may have been destroyed since the state machine was last used.
+		for (FSMNode_Base* Node : EditorFSM.EditorInstanceNodeStorage)
 		{
-			if (USMNodeInstance* Template = Node->GetNodeInstance())
-			{
-				Template->SetOwningNode(nullptr);
-				Template->bIsEditorExecution = false;
-			}
-			for (USMNodeInstance* StackNode : Node->StackNodeInstances)
-			{
-				StackNode->SetOwningNode(nullptr);
-				StackNode->bIsEditorExecution = false;
-			}
-			delete Node;
+			Node->NodeInstance = nullptr;
+			Node->StackNodeInstances.Reset();
 		}
+	}
+	
+	if (EditorFSM.StateMachineEditorInstance)
+	{
+		EditorFSM.StateMachineEditorInstance->Shutdown();
+	}
 
-		EditorFSM->EditorInstanceNodeStorage.Reset();
-
-		if (EditorFSM->StateMachineEditorInstance)
+	for (FSMNode_Base* Node : EditorFSM.EditorInstanceNodeStorage)
+	{
+		if (USMNodeInstance* Template = Node->GetNodeInstance())
 		{
-			EditorFSM->StateMachineEditorInstance->RemoveFromRoot();
+			Template->SetOwningNode(nullptr);
+			Template->bIsEditorExecution = false;
 		}
-		EditorStateMachines.Remove(InBlueprint);
+		for (USMNodeInstance* StackNode : Node->StackNodeInstances)
+		{
+			StackNode->SetOwningNode(nullptr);
+			StackNode->bIsEditorExecution = false;
+		}
+		delete Node;
+	}
+
+	EditorFSM.EditorInstanceNodeStorage.Reset();
+	EditorFSM.GraphToRuntimeNodes.Reset();
+	EditorFSM.NodeDependencies.Reset();
+	EditorFSM.bTemplatesAttached = false;
+
+	if (EditorFSM.StateMachineEditorInstance)
+	{
+		EditorFSM.StateMachineEditorInstance->RemoveFromRoot();
+		EditorFSM.StateMachineEditorInstance = nullptr;
 	}
 }
 
@@ -267,6 +409,8 @@ void FSMEditorConstructionManager::RunAllConstructionScriptsForBlueprintImmediat
 		RunAllConstructionScriptsForBlueprint_Internal(InBlueprint);
 		CleanupEditorStateMachine(InBlueprint);
 		BlueprintsPendingConstruction.Remove(InBlueprint);
+		BlueprintsPendingFullConstruction.Remove(InBlueprint);
+		NodesPendingConstruction.Remove(InBlueprint);
 	}
 }
 
@@ -285,11 +429,26 @@ void FSMEditorConstructionManager::RunAllConstructionScriptsForBlueprint(UObject
 
 	if (USMBlueprint* Blueprint = FSMBlueprintEditorUtils::FindBlueprintFromObject(InObject))
 	{
-		if (!(bSkipOnCompile && Blueprint->bBeingCompiled) && !BlueprintsBeingConstructed.Contains(Blueprint) && !BlueprintsPendingConstruction.Contains(Blueprint))
+		if (!(bSkipOnCompile && Blueprint->bBeingCompiled) && !BlueprintsBeingConstructed.Contains(Blueprint))
 		{
 			// Don't add pending if currently being constructed.
 			// Running the construction script itself can trigger property changes triggering this.
 			BlueprintsPendingConstruction.Add(MakeWeakObjectPtr(Blueprint));
+
+			USMGraphNode_Base* GraphNode = Cast<USMGraphNode_Base>(InObject);
+			if (GraphNode == nullptr && InObject)
+			{
+				GraphNode = InObject->GetTypedOuter<USMGraphNode_Base>();
+			}
+
+			if (GraphNode)
+			{
+				NodesPendingConstruction.FindOrAdd(Blueprint).AddUnique(GraphNode);
+			}
+			else
+			{
+				BlueprintsPendingFullConstruction.Add(Blueprint);
+			}
 		}
 	}
 	else
@@ -302,57 +461,52 @@ void FSMEditorConstructionManager::RunAllConstructionScriptsForBlueprint(UObject
 }
 
 FSMEditorStateMachine& FSMEditorConstructionManager::RebuildEditorStateMachine(USMBlueprint* InBlueprint)
+{
+	TArray<USMGraphNode_Base*> GraphNodes;
+	FSMBlueprintEditorUtils::GetAllNodesOfClassNested(InBlueprint, GraphNodes);
+
+	bool bWasRebuilt = false;
+	FSMEditorStateMachine& EditorFSM = RebuildEditorStateMachine(InBlueprint, GraphNodes, bWasRebuilt);
+	AttachTemplates(EditorFSM, !bWasRebuilt);
+	
+	return EditorFSM;
+}
+
+FSMEditorStateMachine& FSMEditorConstructionManager::RebuildEditorStateMachine(USMBlueprint* InBlueprint, const TArray<USMGraphNode_Base*>& GraphNodes, bool& bWasRebuilt)
 {
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("FSMEditorConstructionManager::RebuildEditorStateMachine"), STAT_RebuildEditorStateMachine, STATGROUP_LogicDriverEditor);
+
+	UClass* RootNodeInstanceClass = GetRootNodeInstanceClass(InBlueprint);
+	const uint32 StructureHash = CalculateStructureHash(GraphNodes, RootNodeInstanceClass);
 	
 	bool bWasCreated = false;
-	FSMEditorStateMachine& EditorFSM = GetOrCreateEditorStateMachine(InBlueprint, bWasCreated);
+	FSMEditorStateMachine* EditorFSM = &GetOrCreateEditorStateMachine(InBlueprint, bWasCreated);
 
 	if (!bWasCreated)
 	{
-		if (!InBlueprint->IsPossiblyDirty())
+		if (EditorFSM->StructureHash == StructureHash)
 		{
-			// Don't bother rebuilding if we haven't changed.
-			return EditorFSM;
+			// Don't bother rebuilding if the structure hasn't changed. Runtime defaults are refreshed when attaching templates.
+			bWasRebuilt = false;
+			return *EditorFSM;
 		}
 		
 		CleanupEditorStateMachine(InBlueprint);
+		EditorFSM = &GetOrCreateEditorStateMachine(InBlueprint, bWasCreated);
 	}
 
-	FSMStateMachine* RootStateMachine = &EditorFSM.StateMachineEditorInstance->GetRootStateMachine();
+	bWasRebuilt = true;
+	EditorFSM->StructureHash = StructureHash;
+	
+	FSMStateMachine* RootStateMachine = &EditorFSM->StateMachineEditorInstance->GetRootStateMachine();
 
 	// Setup the root node instance.
 	{
 		RootStateMachine->NodeInstance = nullptr;
 
-		// Use skeleton class if BPGC is being regenerated.
-		if (USMBlueprintGeneratedClass* BPGC = Cast<USMBlueprintGeneratedClass>(!InBlueprint->GeneratedClass || InBlueprint->GeneratedClass->HasAnyClassFlags(CLASS_LayoutChanging) ?
-			InBlueprint->SkeletonGeneratedClass :
-			InBlueprint->GeneratedClass))
+		if (RootNodeInstanceClass)
 		{
-			TSubclassOf<USMStateMachineInstance> StateMachineClass = nullptr;
-
-			// An old CDO is needed during a compile when the CDO is being rebuilt. This should only be viable from a skeleton class.
-			USMInstance* DefaultInstance = BPGC->GetOldCDO().Get();
-				
-			if (DefaultInstance == nullptr)
-			{
-				// Either we are the BPGC or we are being newly created. Otherwise we should be using the cached CDO.
-				ensure(InBlueprint->GeneratedClass == nullptr || BPGC == InBlueprint->GeneratedClass);
-				DefaultInstance = Cast<USMInstance>(BPGC->GetDefaultObject(false));
-			}
-			else
-			{
-				// Skeletons should use cached CDO.
-				ensure(BPGC == InBlueprint->SkeletonGeneratedClass);
-			}
-			
-			if (ensure(DefaultInstance))
-			{
-				StateMachineClass = DefaultInstance->GetStateMachineClass();
-			}
-
-			RootStateMachine->NodeInstance = NewObject<USMStateMachineInstance>(GetTransientPackage(), StateMachineClass.Get() ? StateMachineClass.Get() : USMStateMachineInstance::StaticClass());
+			RootStateMachine->NodeInstance = NewObject<USMStateMachineInstance>(GetTransientPackage(), RootNodeInstanceClass);
 			RootStateMachine->NodeInstance->SetOwningNode(RootStateMachine);
 		}
 	}
@@ -360,11 +514,12 @@ FSMEditorStateMachine& FSMEditorConstructionManager::RebuildEditorStateMachine(U
 	ConstructEditorStateMachine
 	(
 		FSMBlueprintEditorUtils::GetRootStateMachineGraph(InBlueprint),
-		*RootStateMachine, EditorFSM.EditorInstanceNodeStorage
+		*RootStateMachine, EditorFSM->EditorInstanceNodeStorage, &EditorFSM->GraphToRuntimeNodes
 	);
+	EditorFSM->bTemplatesAttached = true;
 
-	EditorFSM.StateMachineEditorInstance->Initialize(NewObject<USMEditorContext>());
-	return EditorFSM;
+	EditorFSM->StateMachineEditorInstance->Initialize(NewObject<USMEditorContext>());
+	return *EditorFSM;
 }
 
 FSMEditorStateMachine& FSMEditorConstructionManager::GetOrCreateEditorStateMachine(USMBlueprint* InBlueprint, bool& bWasCreated)
@@ -408,9 +563,19 @@ void FSMEditorConstructionManager::RunAllConstructionScriptsForBlueprint_Interna
 	}
 
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("FSMEditorConstructionManager::RunAllConstructionScriptsForBlueprint"), STAT_RunAllBlueprintConstructionScripts, STATGROUP_LogicDriverEditor);
+#if STATS
+	// Time spent per blueprint.
+	FScopeCycleCounter BlueprintCycleCounter(FDynamicStats::CreateStatId<FStatGroup_STATGROUP_LogicDriverEditor>(FString::Printf(TEXT("Construction Scripts - %s"), *InBlueprint->GetName())));
+#endif
+	
 	BlueprintsBeingConstructed.Add(InBlueprint);
+
+	TArray<USMGraphNode_Base*> GraphNodes;
+	FSMBlueprintEditorUtils::GetAllNodesOfClassNested(InBlueprint, GraphNodes);
 	
-	FSMEditorStateMachine& EditorStateMachine = RebuildEditorStateMachine(InBlueprint);
+	bool bWasRebuilt = false;
+	FSMEditorStateMachine& EditorStateMachine = RebuildEditorStateMachine(InBlueprint, GraphNodes, bWasRebuilt);
+	AttachTemplates(EditorStateMachine, !bWasRebuilt);
 
 	// Run the construction script for our root node.
 	if (USMNodeInstance* NodeInstance = EditorStateMachine.StateMachineEditorInstance->GetRootStateMachine().GetNodeInstance())
@@ -420,25 +585,198 @@ void FSMEditorConstructionManager::RunAllConstructionScriptsForBlueprint_Interna
 			NodeInstance->RunConstructionScript();
 		}
 	}
-	
-	TArray<USMGraphNode_Base*> GraphNodes;
-	FSMBlueprintEditorUtils::GetAllNodesOfClassNested(InBlueprint, GraphNodes);
 
-	for (USMGraphNode_Base* GraphNode : GraphNodes)
+	const TArray<TWeakObjectPtr<USMGraphNode_Base>>* EditedNodes = NodesPendingConstruction.Find(InBlueprint);
+	if (bWasRebuilt || EditedNodes == nullptr || BlueprintsPendingFullConstruction.Contains(InBlueprint))
 	{
-		GraphNode->RunAllConstructionScripts();
+		// Dependencies are unknown or the change wasn't isolated to a node.
+		RunConstructionScriptsUntilStable(EditorStateMachine, GraphNodes, false);
 	}
+	else
+	{
+		TArray<USMGraphNode_Base*> NodesToRun;
+		for (const TWeakObjectPtr<USMGraphNode_Base>& EditedNode : *EditedNodes)
+		{
+			if (EditedNode.IsValid())
+			{
+				NodesToRun.Add(EditedNode.Get());
+			}
+		}
 
-	// Perform a second pass -- There was a bug that caused construction scripts to be fired a second time.
-	// This is fixed, but the extra pass allows additional behavior on standard cs, such as the changing a nested FSM node property and having the owning
-	// FSM construction script read it. Without a second pass it wouldn't update until a manual compile was initiated.
+		// The edit itself changed these nodes so readers always need to run.
+		RunConstructionScriptsUntilStable(EditorStateMachine, NodesToRun, true);
+	}
+
+	DetachTemplates(EditorStateMachine);
+	BlueprintsBeingConstructed.Remove(InBlueprint);
+}
+
+void FSMEditorConstructionManager::RunConstructionScriptsUntilStable(FSMEditorStateMachine& EditorStateMachine, const TArray<USMGraphNode_Base*>& NodesToRun,
+	bool bInitialNodesChanged)
+{
+	TMap<const FSMNode_Base*, USMGraphNode_Base*> RuntimeToGraphNodes;
+	RuntimeToGraphNodes.Reserve(EditorStateMachine.GraphToRuntimeNodes.Num());
+	for (const TPair<TWeakObjectPtr<USMGraphNode_Base>, FSMNode_Base*>& GraphToRuntime : EditorStateMachine.GraphToRuntimeNodes)
+	{
+		RuntimeToGraphNodes.Add(GraphToRuntime.Value, GraphToRuntime.Key.Get());
+	}
+
+	// Last known template data of each node. Scripts can write to any node they read, so read nodes are compared against this.
+	TMap<const FSMNode_Base*, uint32> NodeDataHashes;
+	NodeDataHashes.Reserve(RuntimeToGraphNodes.Num());
+	for (const TPair<const FSMNode_Base*, USMGraphNode_Base*>& RuntimeToGraph : RuntimeToGraphNodes)
+	{
+		NodeDataHashes.Add(RuntimeToGraph.Key, CalculateNodeDataHash(*RuntimeToGraph.Key));
+	}
+
+	TArray<USMGraphNode_Base*> Queue = NodesToRun;
+	TSet<USMGraphNode_Base*> QueuedNodes(NodesToRun);
+	TMap<USMGraphNode_Base*, int32> RunCounts;
 	
-	for (USMGraphNode_Base* GraphNode : GraphNodes)
+	for (int32 QueueIndex = 0; QueueIndex < Queue.Num(); ++QueueIndex)
 	{
+		USMGraphNode_Base* GraphNode = Queue[QueueIndex];
+		QueuedNodes.Remove(GraphNode);
+
+		int32& RunCount = RunCounts.FindOrAdd(GraphNode);
+		if (++RunCount > MaxConstructionScriptRunsPerNode)
+		{
+			LDEDITOR_LOG_WARNING(TEXT("Construction scripts for node %s did not settle after %d runs. Nodes may be reading and writing each other in a cycle."),
+				*GraphNode->GetName(), MaxConstructionScriptRunsPerNode);
+			continue;
+		}
+
+		// Record which nodes are read so only those dependents need to run on later changes.
+		// Construction can nest, so the previous tracker is restored afterward.
+		TSet<const FSMNode_Base*> ReadNodes;
+		TSet<const FSMNode_Base*>* PreviousReadTracker = FSMNode_Base::SetNodeInstanceReadTracker(&ReadNodes);
 		GraphNode->RunAllConstructionScripts();
+		FSMNode_Base::SetNodeInstanceReadTracker(PreviousReadTracker);
+
+		TSet<TWeakObjectPtr<USMGraphNode_Base>>& Dependencies = EditorStateMachine.NodeDependencies.FindOrAdd(GraphNode);
+		Dependencies.Reset();
+		for (const FSMNode_Base* ReadNode : ReadNodes)
+		{
+			USMGraphNode_Base* ReadGraphNode = RuntimeToGraphNodes.FindRef(ReadNode);
+			if (ReadGraphNode && ReadGraphNode != GraphNode)
+			{
+				Dependencies.Add(ReadGraphNode);
+			}
+		}
+
+		// The script may have changed its own node or written to any node it read.
+		TArray<USMGraphNode_Base*> ChangedNodes;
+		if (FSMNode_Base* RuntimeNode = EditorStateMachine.GraphToRuntimeNodes.FindRef(GraphNode))
+		{
+			ReadNodes.Add(RuntimeNode);
+		}
+		
+		for (const FSMNode_Base* ReadNode : ReadNodes)
+		{
+			USMGraphNode_Base* ReadGraphNode = RuntimeToGraphNodes.FindRef(ReadNode);
+			uint32* KnownHash = NodeDataHashes.Find(ReadNode);
+			if (ReadGraphNode == nullptr || KnownHash == nullptr)
+			{
+				continue;
+			}
+
+			const uint32 NewHash = CalculateNodeDataHash(*ReadNode);
+			const bool bEditedNode = ReadGraphNode == GraphNode && bInitialNodesChanged && RunCount == 1 && NodesToRun.Contains(GraphNode);
+			if (NewHash != *KnownHash || bEditedNode)
+			{
+				*KnownHash = NewHash;
+				ChangedNodes.Add(ReadGraphNode);
+			}
+		}
+
+		for (USMGraphNode_Base* ChangedNode : ChangedNodes)
+		{
+			for (const TPair<TWeakObjectPtr<USMGraphNode_Base>, TSet<TWeakObjectPtr<USMGraphNode_Base>>>& NodeDependency : EditorStateMachine.NodeDependencies)
+			{
+				USMGraphNode_Base* Dependent = NodeDependency.Key.Get();
+				if (Dependent && Dependent != GraphNode && Dependent != ChangedNode && !QueuedNodes.Contains(Dependent) && NodeDependency.Value.Contains(ChangedNode))
+				{
+					Queue.Add(Dependent);
+					QueuedNodes.Add(Dependent);
+				}
+			}
+		}
 	}
+}
 
-	BlueprintsBeingConstructed.Remove(InBlueprint);
+void FSMEditorConstructionManager::AttachTemplates(FSMEditorStateMachine& EditorStateMachine, bool bRefreshRuntimeDefaults)
+{
+	if (bRefreshRuntimeDefaults)
+	{
+		for (const TPair<TWeakObjectPtr<USMGraphNode_Base>, FSMNode_Base*>& GraphToRuntime : EditorStateMachine.GraphToRuntimeNodes)
+		{
+			if (USMGraphNode_StateNodeBase* StateNode = Cast<USMGraphNode_StateNodeBase>(GraphToRuntime.Key.Get()))
+			{
+				StateNode->SetRuntimeDefaults(*static_cast<FSMState_Base*>(GraphToRuntime.Value));
+			}
+			else if (USMGraphNode_TransitionEdge* TransitionEdge = Cast<USMGraphNode_TransitionEdge>(GraphToRuntime.Key.Get()))
+			{
+				TransitionEdge->SetRuntimeDefaults(*static_cast<FSMTransition*>(GraphToRuntime.Value));
+			}
+		}
+
+		// Transition priorities may have changed.
+		for (const TPair<TWeakObjectPtr<USMGraphNode_Base>, FSMNode_Base*>& GraphToRuntime : EditorStateMachine.GraphToRuntimeNodes)
+		{
+			if (GraphToRuntime.Key.Get() && GraphToRuntime.Key->IsA<USMGraphNode_StateNodeBase>())
+			{
+				static_cast<FSMState_Base*>(GraphToRuntime.Value)->SortTransitions();
+			}
+		}
+	}
+
+	if (EditorStateMachine.bTemplatesAttached)
+	{
+		return;
+	}
+	
+	for (FSMNode_Base* Node : EditorStateMachine.EditorInstanceNodeStorage)
+	{
+		if (Node->NodeInstance)
+		{
+			Node->NodeInstance->bIsEditorExecution = true;
+			Node->NodeInstance->SetOwningNode(Node);
+		}
+		for (USMNodeInstance* StackNode : Node->StackNodeInstances)
+		{
+			StackNode->bIsEditorExecution = true;
+			StackNode->SetOwningNode(Node);
+		}
+	}
+
+	EditorStateMachine.bTemplatesAttached = true;
+}
+
+void FSMEditorConstructionManager::DetachTemplates(FSMEditorStateMachine& EditorStateMachine)
+{
+	if (!EditorStateMachine.bTemplatesAttached)
+	{
+		return;
+	}
+	
+	for (FSMNode_Base* Node : EditorStateMachine.EditorInstanceNodeStorage)
+	{
+		if (Node->NodeInstance && Node->NodeInstance->GetOwningNode() == Node)
+		{
+			Node->NodeInstance->SetOwningNode(nullptr);
+			Node->NodeInstance->bIsEditorExecution = false;
+		}
+		for (USMNodeInstance* StackNode : Node->StackNodeInstances)
+		{
+			if (StackNode->GetOwningNode() == Node)
+			{
+				StackNode->SetOwningNode(nullptr);
+				StackNode->bIsEditorExecution = false;
+			}
+		}
+	}
+
+	EditorStateMachine.bTemplatesAttached = false;
 }
 
 #undef LOCTEXT_NAMESPACE
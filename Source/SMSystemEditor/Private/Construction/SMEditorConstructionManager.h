@@ -9,16 +9,29 @@
 #include "TickableEditorObject.h"
 
 class USMGraph;
+class USMGraphNode_Base;
 class FSMBlueprintEditor;
 class USMEditorInstance;
 
 struct FSMEditorStateMachine
 {
 	/** The sm instance used during editor time. */
-	USMEditorInstance* StateMachineEditorInstance;
+	USMEditorInstance* StateMachineEditorInstance = nullptr;
 	
 	/** Storage for all editor runtime nodes. This memory is manually managed! */
 	TArray<FSMNode_Base*> EditorInstanceNodeStorage;
+
+	/** Each graph node and the editor runtime node built from it. */
+	TMap<TWeakObjectPtr<USMGraphNode_Base>, FSMNode_Base*> GraphToRuntimeNodes;
+
+	/** Each graph node and the graph nodes its construction scripts read during their last run. */
+	TMap<TWeakObjectPtr<USMGraphNode_Base>, TSet<TWeakObjectPtr<USMGraphNode_Base>>> NodeDependencies;
+
+	/** The graph structure the state machine was built from. A mismatch requires a rebuild. */
+	uint32 StructureHash = 0;
+
+	/** If node templates currently point to the editor runtime nodes. Templates are only attached while construction scripts run. */
+	bool bTemplatesAttached = false;
 };
 
 /**
@@ -65,8 +78,10 @@ public:
 	 * @param InGraph A state machine editor graph.
 	 * @param StateMachineOut The outgoing state machine being assembled. This should be the root.
 	 * @param Storage Heap memory will be initialized here. This memory MUST be freed manually to prevent a memory leak.
+	 * @param GraphNodesOut Optionally map each graph node to the runtime node created for it.
 	 */
-	void ConstructEditorStateMachine(USMGraph* InGraph, FSMStateMachine& StateMachineOut, TArray<FSMNode_Base*>& Storage);
+	void ConstructEditorStateMachine(USMGraph* InGraph, FSMStateMachine& StateMachineOut, TArray<FSMNode_Base*>& Storage,
+		TMap<TWeakObjectPtr<USMGraphNode_Base>, FSMNode_Base*>* GraphNodesOut = nullptr);
 
 	/**
 	 * Frees all associated memory and resets the editor state machine map.
@@ -89,7 +104,8 @@ public:
 	void RunAllConstructionScriptsForBlueprintImmediately(USMBlueprint* InBlueprint);
 	
 	/**
-	 * Runs all construction scripts for every node in a blueprint. This is executed on the next frame.
+	 * Runs construction scripts for a blueprint. This is executed on the next frame.
+	 * When InObject is a graph node only that node and the nodes which read it are run, otherwise every node is run.
 	 *
 	 * @param InObject The exact blueprint or the object belonging to the blueprint to run all construction scripts for.
 	 * @param bSkipOnCompile Construction scripts will not run if the blueprint is being compiled.
@@ -97,7 +113,7 @@ public:
 	void RunAllConstructionScriptsForBlueprint(UObject* InObject, bool bSkipOnCompile = true);
 
 	/**
-	 * Create or update a state machine for editor use.
+	 * Create or update a state machine for editor use. An existing state machine is reused when the graph structure hasn't changed.
 	 *
 	 * @param InBlueprint The blueprint owning the state machine.
 	 */
@@ -120,6 +136,36 @@ protected:
 	 * @param InBlueprint The blueprint to run all construction scripts for.
 	 */
 	void RunAllConstructionScriptsForBlueprint_Internal(USMBlueprint* InBlueprint);
+
+	/**
+	 * Run construction scripts for the given nodes and any nodes reading a node they changed, including other nodes a script wrote to, until no node changes.
+	 *
+	 * @param EditorStateMachine The editor state machine the nodes belong to.
+	 * @param NodesToRun The initial nodes to run, in order.
+	 * @param bInitialNodesChanged If the initial nodes were edited so nodes reading them must run regardless.
+	 */
+	void RunConstructionScriptsUntilStable(FSMEditorStateMachine& EditorStateMachine, const TArray<USMGraphNode_Base*>& NodesToRun, bool bInitialNodesChanged);
+
+	/** Point node templates to the editor runtime nodes, optionally refreshing runtime defaults from the graph nodes. */
+	void AttachTemplates(FSMEditorStateMachine& EditorStateMachine, bool bRefreshRuntimeDefaults);
+
+	/** Release node templates from the editor runtime nodes so the state machine can be kept between frames. */
+	void DetachTemplates(FSMEditorStateMachine& EditorStateMachine);
+
+	/** Free editor state machines of blueprints which no longer exist. */
+	void CleanupStaleEditorStateMachines();
+
+	/** Shutdown the editor instance and free node memory. */
+	static void FreeEditorStateMachine(FSMEditorStateMachine& EditorStateMachine);
+
+	/**
+	 * Create or update a state machine for editor use.
+	 *
+	 * @param InBlueprint The blueprint owning the state machine.
+	 * @param GraphNodes All graph nodes of the blueprint.
+	 * @param bWasRebuilt Set to true if the state machine was built instead of reused.
+	 */
+	FSMEditorStateMachine& RebuildEditorStateMachine(USMBlueprint* InBlueprint, const TArray<USMGraphNode_Base*>& GraphNodes, bool& bWasRebuilt);
 	
 private:
 	/** Loaded blueprints mapped to their editor state machine. */
@@ -128,6 +174,12 @@ private:
 	/** All blueprints waiting to have their construction scripts run. */
 	TSet<TWeakObjectPtr<USMBlueprint>> BlueprintsPendingConstruction;
 
+	/** Pending blueprints which need every node run. */
+	TSet<TWeakObjectPtr<USMBlueprint>> BlueprintsPendingFullConstruction;
+
+	/** Pending blueprints mapped to the edited nodes which need to run. */
+	TMap<TWeakObjectPtr<USMBlueprint>, TArray<TWeakObjectPtr<USMGraphNode_Base>>> NodesPendingConstruction;
+
 	/** All blueprints in process of being constructed for a frame. */
 	TSet<TWeakObjectPtr<USMBlueprint>> BlueprintsBeingConstructed;
 };
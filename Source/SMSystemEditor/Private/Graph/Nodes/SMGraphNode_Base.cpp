@@ -20,10 +20,60 @@
 #include "Engine/Engine.h"
 #include "UObject/UObjectThreadContext.h"
 #include "EdGraphUtilities.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
 
 
 #define LOCTEXT_NAMESPACE "SMGraphNodeBase"
 
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Property Graphs Created"), STAT_PropertyGraphsCreated, STATGROUP_LogicDriverEditor);
+
+/** Report property graph usage of loaded state machine blueprints. Used to measure the impact of bDeferDefaultPropertyGraphs. */
+static FAutoConsoleCommand PropertyGraphStatsCommand(
+	TEXT("LogicDriver.PropertyGraphStats"),
+	TEXT("Log the number of property graphs, their nodes, and deferred property graphs of all loaded state machine blueprints."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		int32 TotalBlueprints = 0;
+		int32 TotalGraphs = 0;
+		int32 TotalGraphNodes = 0;
+		int32 TotalDeferred = 0;
+		
+		for (TObjectIterator<USMBlueprint> It; It; ++It)
+		{
+			USMBlueprint* Blueprint = *It;
+			if (Blueprint->HasAnyFlags(RF_ClassDefaultObject | RF_Transient))
+			{
+				continue;
+			}
+			
+			TArray<USMGraphNode_Base*> GraphNodes;
+			FSMBlueprintEditorUtils::GetAllNodesOfClassNested(Blueprint, GraphNodes);
+
+			int32 Graphs = 0;
+			int32 Nodes = 0;
+			int32 Deferred = 0;
+			for (const USMGraphNode_Base* GraphNode : GraphNodes)
+			{
+				for (const TPair<FGuid, UEdGraph*>& KeyVal : GraphNode->GetAllPropertyGraphs())
+				{
+					Graphs++;
+					Nodes += KeyVal.Value ? KeyVal.Value->Nodes.Num() : 0;
+				}
+				Deferred += GraphNode->GetNumDeferredPropertyGraphs();
+			}
+
+			LDEDITOR_LOG_INFO(TEXT("%s: %d property graphs, %d property graph nodes, %d deferred."), *Blueprint->GetName(), Graphs, Nodes, Deferred);
+
+			TotalBlueprints++;
+			TotalGraphs += Graphs;
+			TotalGraphNodes += Nodes;
+			TotalDeferred += Deferred;
+		}
+
+		LDEDITOR_LOG_INFO(TEXT("Total for %d blueprints: %d property graphs, %d property graph nodes, %d deferred."), TotalBlueprints, TotalGraphs, TotalGraphNodes, TotalDeferred);
+	}));
+
 /** Log a message to the message log up to 4 arguments long. */
 #define LOG_MESSAGE(LOG_TYPE, MESSAGE, ARGS, ARGS_COUNT)						\
 	do {																		\
@@ -44,6 +94,7 @@ USMGraphNode_Base::USMGraphNode_Base(const FObjectInitializer& ObjectInitializer
 	: Super(ObjectInitializer)
 {
 	bCanRenameNode = true;
+	CachedDebugGeneration = 0;
 	DebugTotalTime = 0.f;
 	bIsDebugActive = false;
 	bWasDebugActive = false;
@@ -62,6 +113,7 @@ USMGraphNode_Base::USMGraphNode_Base(const FObjectInitializer& ObjectInitializer
 	bRequiresGuidRegeneration = false;
 	bNeedsStateStackConversion = false;
 	bTEST_ForceNoTemplateGuid = false;
+	bForceCreatePropertyGraphs = false;
 }
 
 void USMGraphNode_Base::DestroyNode()
@@ -241,7 +293,7 @@ void USMGraphNode_Base::ValidateNodeDuringCompilation(FCompilerResultsLog& Messa
 void USMGraphNode_Base::CreateGraphPropertyGraphs(bool bGenerateNewGuids)
 {
 	bGenerateNewGuids = bGenerateNewGuids || bRequiresGuidRegeneration;
-	
+
 	TSet<FGuid> LiveGuids;
 	bool bHasChanged = CreateGraphPropertyGraphsForTemplate(NodeInstanceTemplate, bGenerateNewGuids, LiveGuids);
 
@@ -500,6 +552,12 @@ bool USMGraphNode_Base::CreateGraphPropertyGraphsForTemplate(USMNodeInstance* Te
 				}
 				else
 				{
+					if (!bIsActualGraphProperty && !bForceCreatePropertyGraphs && FSMBlueprintEditorUtils::GetProjectEditorSettings()->bDeferDefaultPropertyGraphs)
+					{
+						// A new graph would only contain the default value, which the template already provides at runtime.
+						continue;
+					}
+					
 					// Load the package for this module. This is needed to find the correct class to load.
 					UPackage* Package = GraphProperty->GetEditorModule();
 					if (!Package)
@@ -546,6 +604,8 @@ bool USMGraphNode_Base::CreateGraphPropertyGraphsForTemplate(USMNodeInstance* Te
 					// Initialize the property graph
 					const UEdGraphSchema* Schema = PropertyGraph->GetSchema();
 					Schema->CreateDefaultNodesForGraph(*PropertyGraph);
+
+					INC_DWORD_STAT(STAT_PropertyGraphsCreated);
 				}
 
 				BoundGraph->SubGraphs.AddUnique(PropertyGraph);
@@ -617,6 +677,80 @@ TArray<USMGraphK2Node_PropertyNode_Base*> USMGraphNode_Base::GetAllPropertyGraph
 	return Nodes;
 }
 
+int32 USMGraphNode_Base::GetNumDeferredPropertyGraphs() const
+{
+	if (!SupportsPropertyGraphs())
+	{
+		return 0;
+	}
+
+	TArray<USMNodeInstance*> Templates { NodeInstanceTemplate };
+	if (const USMGraphNode_StateNode* StateNode = Cast<USMGraphNode_StateNode>(this))
+	{
+		for (const FStateStackContainer& StackTemplate : StateNode->GetAllNodeStackTemplates())
+		{
+			Templates.Add(StackTemplate.NodeStackInstanceTemplate);
+		}
+	}
+
+	// Compare exposed variables against existing graphs rather than tracking deferred graphs, so this holds after the asset is reloaded.
+	int32 NumDeferred = 0;
+	for (USMNodeInstance* Template : Templates)
+	{
+		if (Template == nullptr)
+		{
+			continue;
+		}
+		
+		for (TFieldIterator<FProperty> It(Template->GetClass()); It; ++It)
+		{
+			FProperty* Property = *It;
+			if (Property->GetFName() == GET_MEMBER_NAME_CHECKED(USMNodeInstance, ExposedPropertyOverrides) ||
+				FSMNodeInstanceUtils::IsPropertyGraphProperty(Property) || !FSMNodeInstanceUtils::IsPropertyExposedToGraphNode(Property))
+			{
+				continue;
+			}
+
+			FProperty* TargetProperty = Property;
+			int32 ArraySize = 1;
+			if (FArrayProperty* ArrayProperty = CastField<FArrayProperty>(Property))
+			{
+				TargetProperty = ArrayProperty->Inner;
+				FScriptArrayHelper Helper(ArrayProperty, ArrayProperty->ContainerPtrToValuePtr<uint8>(Template));
+				ArraySize = Helper.Num();
+			}
+
+			for (int32 Idx = 0; Idx < ArraySize; ++Idx)
+			{
+				FSMGraphProperty TempProperty;
+				const FGuid& Guid = FSMNodeInstanceUtils::SetGraphPropertyFromProperty(TempProperty, TargetProperty, Template, Idx);
+				if (!GraphPropertyGraphs.Contains(Guid))
+				{
+					NumDeferred++;
+				}
+			}
+		}
+	}
+
+	return NumDeferred;
+}
+
+void USMGraphNode_Base::CreateDeferredPropertyGraphs()
+{
+	if (!HasDeferredPropertyGraphs() || BoundGraph == nullptr)
+	{
+		return;
+	}
+
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("USMGraphNode_Base::CreateDeferredPropertyGraphs"), STAT_CreateDeferredPropertyGraphs, STATGROUP_LogicDriverEditor);
+	
+	bForceCreatePropertyGraphs = true;
+	bCreatePropertyGraphsSilently = true;
+	CreateGraphPropertyGraphs();
+	bCreatePropertyGraphsSilently = false;
+	bForceCreatePropertyGraphs = false;
+}
+
 void USMGraphNode_Base::InitPropertyGraphNodes(UEdGraph* PropertyGraph, FSMGraphProperty_Base* Property)
 {
 	Modify();
@@ -796,9 +930,10 @@ void USMGraphNode_Base::OnCompile(FSMKismetCompilerContext& CompilerContext)
 void USMGraphNode_Base::ResetDebugState()
 {
 	// Prevents a previous cycle from showing it as running.
-	if (const FSMNode_Base* DebugNode = GetDebugNode())
+	bWasDebugActive = false;
+	if (FSMDebugNodeState* DebugState = !IsDebugScrubbing() ? GetDebugNodeState() : nullptr)
 	{
-		const_cast<FSMNode_Base*>(DebugNode)->bWasActive = bWasDebugActive = false;
+		DebugState->bWasActive = false;
 	}
 }
 
@@ -809,17 +944,29 @@ void USMGraphNode_Base::OnWidgetConstruct()
 
 void USMGraphNode_Base::UpdateTime(float DeltaTime)
 {
-	if (const FSMNode_Base* DebugNode = GetDebugNode())
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("USMGraphNode_Base::UpdateTime"), STAT_SMGraphNode_UpdateTime, STATGROUP_LogicDriverEditor);
+	
+	if (FSMDebugNodeState* DebugState = GetDebugNodeState())
 	{
 		MaxTimeToShowDebug = GetMaxDebugTime();
+
+		if (IsDebugScrubbing())
+		{
+			// The recorded event is shown as it was without fading.
+			const bool bShowEvaluation = FSMBlueprintEditorUtils::GetEditorSettings()->bDisplayTransitionEvaluation;
+			bIsDebugActive = DebugState->bIsActive || (bShowEvaluation && DebugState->bIsEvaluating);
+			bWasDebugActive = !bIsDebugActive && (DebugState->bWasActive || (bShowEvaluation && DebugState->bWasEvaluating));
+			DebugTotalTime = 0.f;
+			return;
+		}
 		
 		// Toggle active status and reset time if switching active states.
-		if(DebugNode->IsActive() || (DebugNode->bWasActive && !WasDebugNodeActive()))
+		if(DebugState->bIsActive || (DebugState->bWasActive && !WasDebugNodeActive()))
 		{
 			bWasDebugActive = false;
 
-			// Was active is debug only data and exists to help us determine if we should draw an active state.
-			const_cast<FSMNode_Base*>(DebugNode)->bWasActive = false;
+			// Was active is set by the runtime and exists to help us determine if we should draw an active state.
+			DebugState->bWasActive = false;
 			if (!IsDebugNodeActive())
 			{
 				bIsDebugActive = true;
@@ -1121,21 +1268,88 @@ FSMNode_Base* USMGraphNode_Base::FindRuntimeNode() const
 }
 
 const FSMNode_Base* USMGraphNode_Base::GetDebugNode() const
+{
+	USMInstance* Instance = nullptr;
+	const int32 DebugIndex = FindDebugNodeIndex(Instance);
+
+	// Find the real runtime node being debugged.
+	return DebugIndex != INDEX_NONE && !Instance->GetDebugStateMachineConst().IsScrubbing() ?
+		Instance->GetDebugStateMachineConst().GetIndexedNode(DebugIndex) : nullptr;
+}
+
+bool USMGraphNode_Base::IsDebugScrubbing() const
 {
 	USMBlueprint* Blueprint = CastChecked<USMBlueprint>(FSMBlueprintEditorUtils::FindBlueprintForNode(this));
+	const USMInstance* Instance = Cast<USMInstance>(Blueprint->GetObjectBeingDebugged());
+	return Instance && Instance->GetDebugStateMachineConst().IsScrubbing();
+}
 
-	if (USMInstance* Instance = Cast<USMInstance>(Blueprint->GetObjectBeingDebugged()))
+bool USMGraphNode_Base::GetDebugTimeInState(float& OutTimeInState) const
+{
+	USMInstance* Instance = nullptr;
+	const int32 DebugIndex = FindDebugNodeIndex(Instance);
+	if (DebugIndex == INDEX_NONE)
 	{
+		return false;
+	}
+
+	const FSMDebugStateMachine& DebugStateMachine = Instance->GetDebugStateMachineConst();
+	if (DebugStateMachine.IsScrubbing())
+	{
+		OutTimeInState = DebugStateMachine.GetScrubbedTimeInState(DebugIndex);
+		return true;
+	}
+
+	if (const FSMNode_Base* DebugNode = DebugStateMachine.GetIndexedNode(DebugIndex))
+	{
+		OutTimeInState = DebugNode->TimeInState;
+		return true;
+	}
+
+	return false;
+}
+
+FSMDebugNodeState* USMGraphNode_Base::GetDebugNodeState() const
+{
+	USMInstance* Instance = nullptr;
+	const int32 DebugIndex = FindDebugNodeIndex(Instance);
+
+	return DebugIndex != INDEX_NONE ? Instance->GetDebugStateMachine().GetNodeState(DebugIndex) : nullptr;
+}
+
+int32 USMGraphNode_Base::FindDebugNodeIndex(USMInstance*& OutInstance) const
+{
+	USMBlueprint* Blueprint = CastChecked<USMBlueprint>(FSMBlueprintEditorUtils::FindBlueprintForNode(this));
+
+	OutInstance = Cast<USMInstance>(Blueprint->GetObjectBeingDebugged());
+	if (OutInstance == nullptr)
+	{
+		CachedDebugInstance.Reset();
+		return INDEX_NONE;
+	}
+
+	FSMDebugStateMachine& DebugMachine = OutInstance->GetDebugStateMachine();
+
+	// Searching for the runtime node is expensive, only do it when the debugged instance changes or reinitializes.
+	if (CachedDebugInstance.Get() != OutInstance || CachedDebugGeneration != DebugMachine.Generation)
+	{
+		CachedDebugInstance = OutInstance;
+		CachedDebugGeneration = DebugMachine.Generation;
+		CachedDebugNodeIndices.Reset();
+
 		if (FSMNode_Base* RuntimeNode = FindRuntimeNode())
 		{
-			const FSMDebugStateMachine& DebugMachine = Instance->GetDebugStateMachineConst();
-
-			// Find the real runtime node being debugged.
-			return DebugMachine.GetRuntimeNode(RuntimeNode->GetNodeGuid());
+			DebugMachine.FindNodeIndices(RuntimeNode->GetNodeGuid(), CachedDebugNodeIndices);
 		}
 	}
 
-	return nullptr;
+	if (CachedDebugNodeIndices.Num() == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	DebugMachine.Watch();
+	return DebugMachine.SelectNodeIndex(CachedDebugNodeIndices);
 }
 
 float USMGraphNode_Base::GetMaxDebugTime() const
@@ -1150,7 +1364,7 @@ FLinearColor USMGraphNode_Base::GetBackgroundColor() const
 	const FLinearColor BaseColor = Internal_GetBackgroundColor() * (CustomColor ? *CustomColor : FLinearColor(1.f, 1.f, 1.f, 1.f));
 	const FLinearColor ActiveColor = GetActiveBackgroundColor();
 
-	if (GetDebugNode() == nullptr)
+	if (GetDebugNodeState() == nullptr)
 	{
 		return BaseColor;
 	}
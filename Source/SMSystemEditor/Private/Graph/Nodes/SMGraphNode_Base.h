@@ -17,6 +17,8 @@ class USMEditorSettings;
 class USMGraph;
 class FSMKismetCompilerContext;
 struct FSMNode_Base;
+struct FSMDebugNodeState;
+class USMInstance;
 
 DECLARE_MULTICAST_DELEGATE_OneParam(FOnGraphNodeRefreshRequested, class USMGraphNode_Base* /* GraphNode */);
 
@@ -197,6 +199,12 @@ public:
 	const TMap<FGuid, USMGraphK2Node_PropertyNode_Base*>& GetAllPropertyGraphNodes() const { return GraphPropertyNodes; }
 	/** Look for all property nodes that should be exposed. */
 	TArray<USMGraphK2Node_PropertyNode_Base*> GetAllPropertyGraphNodesAsArray() const;
+	/** If exposed variables are waiting for their property graphs to be created. Only possible when bDeferDefaultPropertyGraphs is enabled. */
+	bool HasDeferredPropertyGraphs() const { return GetNumDeferredPropertyGraphs() > 0; }
+	/** The number of exposed variables of all templates which don't have a property graph yet. */
+	int32 GetNumDeferredPropertyGraphs() const;
+	/** Create property graphs which were deferred. This does not dirty the package as the graphs only contain default values. */
+	void CreateDeferredPropertyGraphs();
 	void InitPropertyGraphNodes(UEdGraph* PropertyGraph, FSMGraphProperty_Base* Property);
 	void RefreshAllProperties(bool bModify, bool bSetFromPinFirst = true);
 	
@@ -247,8 +255,14 @@ public:
 	
 	/** Helper to locate the runtime node this node represents. */
 	FSMNode_Base* FindRuntimeNode() const;
-	/** Locates the current debug node if one exists. */
+	/** Locates the current debug node if one exists. Null while scrubbing since the live node doesn't match the recorded event. */
 	const FSMNode_Base* GetDebugNode() const;
+	/** Locates the debug state of the current debug node. Reading it keeps the runtime publishing debug states. */
+	FSMDebugNodeState* GetDebugNodeState() const;
+	/** If the debugged instance is displaying a recorded event. Recorded debug states are displayed as is and never cleared. */
+	bool IsDebugScrubbing() const;
+	/** The time in state of the current debug node. While scrubbing this is the recorded time. */
+	bool GetDebugTimeInState(float& OutTimeInState) const;
 	
 	float GetDebugTime() const { return DebugTotalTime; }
 	virtual float GetMaxDebugTime() const;
@@ -284,6 +298,9 @@ public:
 private:
 	friend class SGraphNode_BaseNode;
 	FOnGraphNodeRefreshRequested OnGraphNodeRefreshRequestedEvent;
+
+	/** The debug state machine index of the runtime node to display from the instance being debugged. */
+	int32 FindDebugNodeIndex(USMInstance*& OutInstance) const;
 	
 protected:
 	virtual FLinearColor Internal_GetBackgroundColor() const;
@@ -336,6 +353,11 @@ protected:
 	UPROPERTY(Transient)
 	FLinearColor CachedNodeTintColor;
 
+	/** Debug state machine indices of the runtime nodes this node represents, looked up once per debugged instance. */
+	mutable TArray<int32> CachedDebugNodeIndices;
+	mutable TWeakObjectPtr<USMInstance> CachedDebugInstance;
+	mutable uint32 CachedDebugGeneration;
+
 	/** Resets on active change. */
 	float DebugTotalTime;
 	float MaxTimeToShowDebug;
@@ -369,6 +391,9 @@ public:
 
 	/** Testing flag for forcing old guid generation WITHOUT template support. */
 	uint32 bTEST_ForceNoTemplateGuid:	1;
+
+	/** Create every property graph even if bDeferDefaultPropertyGraphs is enabled. */
+	uint32 bForceCreatePropertyGraphs:	1;
 	
 private:
 	// Graph node properties deprecated in favor of being stored on the node template.
@@ -97,9 +97,10 @@ void USMGraphNode_ConduitNode::ResetDebugState()
 	Super::ResetDebugState();
 
 	// Prevents a previous cycle from showing it as running.
-	if (const FSMConduit* DebugNode = (FSMConduit*)GetDebugNode())
+	bWasEvaluating = false;
+	if (FSMDebugNodeState* DebugState = !IsDebugScrubbing() ? GetDebugNodeState() : nullptr)
 	{
-		const_cast<FSMConduit*>(DebugNode)->bWasEvaluating = bWasEvaluating = false;
+		DebugState->bWasEvaluating = false;
 	}
 }
 
@@ -108,21 +109,26 @@ void USMGraphNode_ConduitNode::UpdateTime(float DeltaTime)
 	const USMEditorSettings* Settings = FSMBlueprintEditorUtils::GetEditorSettings();
 	if (ShouldEvalWithTransitions() && Settings->bDisplayTransitionEvaluation)
 	{
-		if (const FSMConduit* DebugNode = (FSMConduit*)GetDebugNode())
+		if (FSMDebugNodeState* DebugState = GetDebugNodeState())
 		{
-			if (WasEvaluating() && (DebugNode->IsActive() || DebugNode->bWasActive))
+			if (WasEvaluating() && (DebugState->bIsActive || DebugState->bWasActive))
 			{
 				// Cancel evaluation display and let the super method reset.
 				bWasEvaluating = false;
 				bWasDebugActive = false;
 			}
-			else if (DebugNode->bIsEvaluating || DebugNode->bWasEvaluating)
+			else if (DebugState->bIsEvaluating || DebugState->bWasEvaluating)
 			{
 				// Not active but evaluating.
 				bIsDebugActive = true;
 				bWasEvaluating = true;
 			}
-			const_cast<FSMConduit*>(DebugNode)->bWasEvaluating = false;
+
+			// Recorded states are kept while scrubbing.
+			if (!IsDebugScrubbing())
+			{
+				DebugState->bWasEvaluating = false;
+			}
 		}
 	}
 
@@ -189,9 +195,9 @@ FLinearColor USMGraphNode_ConduitNode::GetActiveBackgroundColor() const
 		const USMEditorSettings* Settings = FSMBlueprintEditorUtils::GetEditorSettings();
 		if (Settings->bDisplayTransitionEvaluation)
 		{
-			if (const FSMConduit* DebugNode = (FSMConduit*)GetDebugNode())
+			if (const FSMDebugNodeState* DebugState = GetDebugNodeState())
 			{
-				if (DebugNode->bIsEvaluating || bWasEvaluating)
+				if (DebugState->bIsEvaluating || bWasEvaluating)
 				{
 					const float TimeToFade = 0.7f;
 					const float DebugTime = GetDebugTime();
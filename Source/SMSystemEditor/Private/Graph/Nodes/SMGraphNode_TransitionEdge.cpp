@@ -276,9 +276,10 @@ void USMGraphNode_TransitionEdge::ResetDebugState()
 	Super::ResetDebugState();
 
 	// Prevents a previous cycle from showing it as running.
-	if (const FSMTransition* DebugNode = (FSMTransition*)GetDebugNode())
+	bWasEvaluating = false;
+	if (FSMDebugNodeState* DebugState = !IsDebugScrubbing() ? GetDebugNodeState() : nullptr)
 	{
-		const_cast<FSMTransition*>(DebugNode)->bWasEvaluating = bWasEvaluating = false;
+		DebugState->bWasEvaluating = false;
 	}
 }
 
@@ -287,21 +288,26 @@ void USMGraphNode_TransitionEdge::UpdateTime(float DeltaTime)
 	const USMEditorSettings* Settings = FSMBlueprintEditorUtils::GetEditorSettings();
 	if (Settings->bDisplayTransitionEvaluation)
 	{
-		if (const FSMTransition* DebugNode = (FSMTransition*)GetDebugNode())
+		if (FSMDebugNodeState* DebugState = GetDebugNodeState())
 		{
-			if (WasEvaluating() && (DebugNode->IsActive() || DebugNode->bWasActive))
+			if (WasEvaluating() && (DebugState->bIsActive || DebugState->bWasActive))
 			{
 				// Cancel evaluation display and let the super method reset.
 				bWasEvaluating = false;
 				bWasDebugActive = false;
 			}
-			else if (DebugNode->bIsEvaluating || DebugNode->bWasEvaluating)
+			else if (DebugState->bIsEvaluating || DebugState->bWasEvaluating)
 			{
 				// Not active but evaluating.
 				bIsDebugActive = true;
 				bWasEvaluating = true;
 			}
-			const_cast<FSMTransition*>(DebugNode)->bWasEvaluating = false;
+
+			// Recorded states are kept while scrubbing.
+			if (!IsDebugScrubbing())
+			{
+				DebugState->bWasEvaluating = false;
+			}
 		}
 	}
 
@@ -590,9 +596,9 @@ FLinearColor USMGraphNode_TransitionEdge::GetBackgroundColor() const
 	const USMEditorSettings* Settings = FSMBlueprintEditorUtils::GetEditorSettings();
 	if (Settings->bDisplayTransitionEvaluation)
 	{
-		if (const FSMTransition* DebugNode = (FSMTransition*)GetDebugNode())
+		if (const FSMDebugNodeState* DebugState = GetDebugNodeState())
 		{
-			if (DebugNode->bIsEvaluating || bWasEvaluating)
+			if (DebugState->bIsEvaluating || bWasEvaluating)
 			{
 				const float TimeToFade = 0.7f;
 				const float DebugTime = GetDebugTime();
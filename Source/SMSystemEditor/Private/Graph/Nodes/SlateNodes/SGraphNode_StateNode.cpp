@@ -419,13 +419,14 @@ void SGraphNode_StateNode::GetNodeInfoPopups(FNodeInfoContext* Context,
 	TArray<FGraphInformationPopupInfo>& Popups) const
 {
 	USMGraphNode_StateNodeBase* Node = CastChecked<USMGraphNode_StateNodeBase>(GraphNode);
-	if (const FSMNode_Base* DebugNode = Node->GetDebugNode())
+	float TimeInState = 0.f;
+	if (Node->GetDebugTimeInState(TimeInState))
 	{
 		// Show active time or last active time over the node.
 
 		if (Node->IsDebugNodeActive())
 		{
-			const FString StateText = FString::Printf(TEXT("Active for %.2f secs"), DebugNode->TimeInState);
+			const FString StateText = FString::Printf(TEXT("Active for %.2f secs"), TimeInState);
 			new (Popups) FGraphInformationPopupInfo(nullptr, Node->GetBackgroundColor(), StateText);
 		}
 		else if (Node->WasDebugNodeActive())
@@ -438,7 +439,7 @@ void SGraphNode_StateNode::GetNodeInfoPopups(FNodeInfoContext* Context,
 
 			if (DebugTime < StartFade + TimeToFade)
 			{
-				const FString StateText = FString::Printf(TEXT("Was Active for %.2f secs"), DebugNode->TimeInState);
+				const FString StateText = FString::Printf(TEXT("Was Active for %.2f secs"), TimeInState);
 
 				if (DebugTime > StartFade)
 				{
@@ -882,7 +883,7 @@ void SGraphNode_ConduitNode::Construct(const FArguments& InArgs, USMGraphNode_Co
 void SGraphNode_ConduitNode::GetNodeInfoPopups(FNodeInfoContext* Context, TArray<FGraphInformationPopupInfo>& Popups) const
 {
 	USMGraphNode_ConduitNode* Node = CastChecked<USMGraphNode_ConduitNode>(GraphNode);
-	if (const FSMConduit* DebugNode = (FSMConduit*)Node->GetDebugNode())
+	if (Node->GetDebugNodeState())
 	{
 		if (Node->ShouldEvalWithTransitions() && Node->WasEvaluating())
 		{
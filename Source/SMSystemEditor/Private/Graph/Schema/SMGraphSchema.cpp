@@ -13,6 +13,7 @@
 #include "Graph/Nodes/SMGraphNode_StateMachineEntryNode.h"
 #include "Blueprints/SMBlueprintEditor.h"
 #include "Utilities/SMBlueprintEditorUtils.h"
+#include "Utilities/SMNodeClassRegistry.h"
 #include "Construction/SMEditorConstructionManager.h"
 #include "Graph/ConnectionDrawing/SMGraphConnectionDrawingPolicy.h"
 
@@ -69,6 +70,11 @@ UEdGraphNode* FSMGraphSchemaAction_NewNode::PerformAction(class UEdGraph* Parent
 
 	if (NodeTemplate != nullptr)
 	{
+		if (NodeClass == nullptr && !NodeClassPath.IsNull())
+		{
+			NodeClass = NodeClassPath.TryLoadClass<USMNodeInstance>();
+		}
+		
 		const FScopedTransaction Transaction(NSLOCTEXT("UnrealEd", "AddNode", "Add Node"));
 		ParentGraph->Modify();
 		if (FromPin != nullptr)
@@ -171,20 +177,11 @@ UEdGraphNode* FSMGraphSchemaAction_NewNode::PerformAction(class UEdGraph* Parent
 				{
 					UClass* StateMachineClass = FSMBlueprintEditorUtils::GetStateMachineClassFromGraph(ParentGraph);
 					
-					TArray<UClass*> TransitionClasses;
-					FSMBlueprintEditorUtils::GetAllNodeSubClasses(USMTransitionInstance::StaticClass(), TransitionClasses);
-					for (UClass* TransitionClass : TransitionClasses)
+					if (UClass* TransitionClass = FSMNodeClassRegistry::Get().FindTransitionClassForConnection(FromNode ? FromNode->GetNodeClass() : nullptr,
+						NodeClass, StateMachineClass))
 					{
-						if (USMTransitionInstance* DefaultObject = Cast<USMTransitionInstance>(TransitionClass->GetDefaultObject()))
-						{
-							const FSMTransitionConnectionValidator& Filter = DefaultObject->GetAllowedConnections();
-							if (Filter.IsConnectionValid(FromNode ? FromNode->GetNodeClass() : nullptr, NodeClass, StateMachineClass, false))
-							{
-								TransitionNode->SetNodeClass(TransitionClass);
-								TransitionNode->CreateGraphPropertyGraphs();
-								break;
-							}
-						}
+						TransitionNode->SetNodeClass(TransitionClass);
+						TransitionNode->CreateGraphPropertyGraphs();
 					}
 				}
 			}
@@ -396,60 +393,60 @@ void USMGraphSchema::GetGraphContextActions(FGraphContextMenuBuilder& ContextMen
 
 	// Custom node actions
 	{
-		TArray<UClass*> NodeClasses;
-		FSMBlueprintEditorUtils::GetAllNodeSubClasses(USMStateInstance_Base::StaticClass(), NodeClasses);
+		FSMNodeClassRegistry& NodeClassRegistry = FSMNodeClassRegistry::Get();
+		
+		TArray<TSharedRef<const FSMNodeClassInfo>> NodeClasses;
+		NodeClassRegistry.GetNodeClasses(USMStateInstance_Base::StaticClass(), NodeClasses);
 
-		UClass* FromClass = FSMBlueprintEditorUtils::GetNodeClassFromPin(ContextMenuBuilder.FromPin);
+		const FSMNodeClassPathHierarchy FromClass = FSMNodeClassPathHierarchy::FromClass(FSMBlueprintEditorUtils::GetNodeClassFromPin(ContextMenuBuilder.FromPin));
+		const FSMNodeClassPathHierarchy StateMachineClassHierarchy = FSMNodeClassPathHierarchy::FromClass(StateMachineClass);
+		const FSoftObjectPath StateMachineInstancePath(USMStateMachineInstance::StaticClass());
+		const FSoftObjectPath ConduitInstancePath(USMConduitInstance::StaticClass());
 
-		for (UClass* NodeClass : NodeClasses)
+		// Rules are read from the registry so classes are only loaded once placed.
+		for (const TSharedRef<const FSMNodeClassInfo>& NodeClassInfo : NodeClasses)
 		{
-			if (NodeClass->HasAnyClassFlags(CLASS_Abstract))
+			if (NodeClassInfo->bIsAbstract || !NodeClassInfo->bRegisteredWithContextMenu)
 			{
 				continue;
 			}
+
+			const FSMNodeClassPathHierarchy NodeClass = NodeClassRegistry.GetClassHierarchy(*NodeClassInfo);
 			
-			if (USMStateInstance_Base* NodeDefault = Cast<USMStateInstance_Base>(NodeClass->GetDefaultObject()))
+			// Validate allowed placement in state machine.
+			if (StateMachineDefault)
 			{
-				if (!NodeDefault->IsRegisteredWithContextMenu())
+				if (!StateMachineDefault->GetAllowedStates().IsStateAllowed(NodeClass))
 				{
 					continue;
 				}
+			}
 
-				// Validate allowed placement in state machine.
-				if (StateMachineDefault)
-				{
-					if (!StateMachineDefault->GetAllowedStates().IsStateAllowed(NodeClass))
-					{
-						continue;
-					}
-				}
-
-				// Validate connection.
+			// Validate connection.
+			{
+				if (!NodeClassInfo->StateConnectionRules.IsInboundConnectionValid(FromClass, StateMachineClassHierarchy) && NodeClassInfo->bHideFromContextMenuIfRulesFail)
 				{
-					if (!NodeDefault->GetAllowedConnections().IsInboundConnectionValid(FromClass, StateMachineClass) && NodeDefault->HideFromContextMenuIfRulesFail())
-					{
-						continue;
-					}
+					continue;
 				}
+			}
 
-				FText MenuDescription = FText::FromString(FString::Printf(TEXT("Add %s..."), *NodeDefault->GetNodeDisplayName()));
-				const FSMNodeDescription& NodeDescription = NodeDefault->GetNodeDescription();
+			FText MenuDescription = FText::FromString(FString::Printf(TEXT("Add %s..."), *NodeClassInfo->DisplayName));
+			const FSMNodeDescription& NodeDescription = NodeClassInfo->NodeDescription;
 
-				TSharedPtr<FSMGraphSchemaAction_NewNode> NewNodeAction = AddNewStateNodeAction<FSMGraphSchemaAction_NewNode>(ContextMenuBuilder, NodeDescription.Category, MenuDescription, NodeDescription.Description, UserGrouping);
-				if (NodeClass->IsChildOf(USMStateMachineInstance::StaticClass()))
-				{
-					NewNodeAction->NodeTemplate = NewObject<USMGraphNode_StateMachineStateNode>(ContextMenuBuilder.OwnerOfTemporaries);
-				}
-				else if (NodeClass->IsChildOf(USMConduitInstance::StaticClass()))
-				{
-					NewNodeAction->NodeTemplate = NewObject<USMGraphNode_ConduitNode>(ContextMenuBuilder.OwnerOfTemporaries);
-				}
-				else
-				{
-					NewNodeAction->NodeTemplate = NewObject<USMGraphNode_StateNode>(ContextMenuBuilder.OwnerOfTemporaries);
-				}
-				NewNodeAction->NodeClass = NodeClass;
+			TSharedPtr<FSMGraphSchemaAction_NewNode> NewNodeAction = AddNewStateNodeAction<FSMGraphSchemaAction_NewNode>(ContextMenuBuilder, NodeDescription.Category, MenuDescription, NodeDescription.Description, UserGrouping);
+			if (NodeClass.IsChildOf(StateMachineInstancePath))
+			{
+				NewNodeAction->NodeTemplate = NewObject<USMGraphNode_StateMachineStateNode>(ContextMenuBuilder.OwnerOfTemporaries);
+			}
+			else if (NodeClass.IsChildOf(ConduitInstancePath))
+			{
+				NewNodeAction->NodeTemplate = NewObject<USMGraphNode_ConduitNode>(ContextMenuBuilder.OwnerOfTemporaries);
 			}
+			else
+			{
+				NewNodeAction->NodeTemplate = NewObject<USMGraphNode_StateNode>(ContextMenuBuilder.OwnerOfTemporaries);
+			}
+			NewNodeAction->NodeClassPath = NodeClassInfo->ClassPath;
 		}
 	}
 }
@@ -731,21 +728,10 @@ bool USMGraphSchema::CreateAutomaticConversionNodeAndConnections(UEdGraphPin* A,
 
 	// If this is a transition being placed as part of a new state node then the state node will handle this.
 	// This only matters if this transition is being connected after a state has been placed.
-	TArray<UClass*> TransitionClasses;
-	FSMBlueprintEditorUtils::GetAllNodeSubClasses(USMTransitionInstance::StaticClass(), TransitionClasses);
-	
-	for (UClass* TransitionClass : TransitionClasses)
+	if (UClass* TransitionClass = FSMNodeClassRegistry::Get().FindTransitionClassForConnection(NodeA->GetNodeClass(), NodeB->GetNodeClass(), StateMachineClass))
 	{
-		if (USMTransitionInstance* DefaultObject = Cast<USMTransitionInstance>(TransitionClass->GetDefaultObject()))
-		{
-			const FSMTransitionConnectionValidator& Filter = DefaultObject->GetAllowedConnections();
-			if (Filter.IsConnectionValid(NodeA->GetNodeClass(), NodeB->GetNodeClass(), StateMachineClass, false))
-			{
-				EdgeNode->SetNodeClass(TransitionClass);
-				EdgeNode->CreateGraphPropertyGraphs();
-				break;
-			}
-		}
+		EdgeNode->SetNodeClass(TransitionClass);
+		EdgeNode->CreateGraphPropertyGraphs();
 	}
 
 	if (A->Direction == EGPD_Output)
@@ -30,6 +30,10 @@ public:
 	UEdGraphNode* NodeTemplate;
 
 	UClass* NodeClass;
+
+	/** A node class which is loaded when the action is performed. Used when NodeClass isn't set. */
+	FSoftClassPath NodeClassPath;
+	
 	bool bDontOverrideDefaultClass;
 };
 
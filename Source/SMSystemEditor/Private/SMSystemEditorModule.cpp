@@ -14,6 +14,8 @@
 #include "Configuration/SMProjectEditorSettings.h"
 #include "Customization/SMEditorCustomization.h"
 #include "Utilities/SMBlueprintEditorUtils.h"
+#include "Utilities/SMCookOptimizer.h"
+#include "Utilities/SMNodeClassRegistry.h"
 #include "Utilities/SMVersionUtils.h"
 #include "SMSystemEditorLog.h"
 
@@ -114,13 +116,21 @@ void FSMSystemEditorModule::StartupModule()
 
 	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
 	AssetAddedHandle = AssetRegistry.OnAssetAdded().AddRaw(this, &FSMSystemEditorModule::OnAssetAdded);
+
+	FSMNodeClassRegistry::Get().Initialize();
+	FSMCookOptimizer::Get().Initialize();
 	
 	const USMProjectEditorSettings* ProjectEditorSettings = FSMBlueprintEditorUtils::GetProjectEditorSettings();
-	if (ProjectEditorSettings->bUpdateAssetsOnStartup)
+	// Commandlets such as SMUpgradeAssets search all assets and would load every one of them at once.
+	if (ProjectEditorSettings->bUpdateAssetsOnStartup && !IsRunningCommandlet())
 	{
 		FAssetRegistryModule& AssetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry"));
 		FilesLoadedHandle = AssetRegistryModule.Get().OnFilesLoaded().AddStatic(&FSMVersionUtils::UpdateBlueprintsToNewVersion);
 	}
+	else if (ProjectEditorSettings->bUpdateAssetsWhenLoaded)
+	{
+		AssetLoadedHandle = FCoreUObjectDelegates::OnAssetLoaded.AddStatic(&FSMVersionUtils::UpdateLoadedAssetToNewVersion);
+	}
 
 	CheckForNewInstalledVersion();
 }
@@ -179,6 +189,9 @@ void FSMSystemEditorModule::ShutdownModule()
 	FEditorDelegates::BeginPIE.Remove(BeginPieHandle);
 	FEditorDelegates::EndPIE.Remove(EndPieHandle);
 
+	FSMNodeClassRegistry::Get().Shutdown();
+	FSMCookOptimizer::Get().Shutdown();
+
 	if (AssetAddedHandle.IsValid() && FModuleManager::Get().IsModuleLoaded("AssetRegistry"))
 	{
 		IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
@@ -190,6 +203,11 @@ void FSMSystemEditorModule::ShutdownModule()
 		FAssetRegistryModule& AssetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry"));
 		AssetRegistryModule.Get().OnFilesLoaded().Remove(FilesLoadedHandle);
 	}
+
+	if (AssetLoadedHandle.IsValid())
+	{
+		FCoreUObjectDelegates::OnAssetLoaded.Remove(AssetLoadedHandle);
+	}
 }
 
 void FSMSystemEditorModule::RegisterAssetTypeAction(IAssetTools& AssetTools, TSharedRef<IAssetTypeActions> Action)
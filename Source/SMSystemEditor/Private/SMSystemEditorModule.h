@@ -63,6 +63,7 @@ private:
 
 	FDelegateHandle AssetAddedHandle;
 	FDelegateHandle FilesLoadedHandle;
+	FDelegateHandle AssetLoadedHandle;
 
 	/** Notification popup that the plugin has updated. */
 	TWeakPtr<SNotificationItem> NewVersionNotification;
@@ -1934,7 +1934,13 @@ bool FSMBlueprintEditorUtils::DuplicateStackTemplatePropertyGraphs(USMGraphNode_
 	FStateStackContainer& NewStackContainer, const FGuid& OriginalTemplateGuid)
 {
 	TSet<FGuid> LiveGuids;
-	if (!DestinationStateNode->CreateGraphPropertyGraphsForTemplate(NewStackContainer.NodeStackInstanceTemplate, false, LiveGuids, true))
+
+	// Every graph is needed to copy the original graphs into.
+	DestinationStateNode->bForceCreatePropertyGraphs = true;
+	const bool bCreatedGraphs = DestinationStateNode->CreateGraphPropertyGraphsForTemplate(NewStackContainer.NodeStackInstanceTemplate, false, LiveGuids, true);
+	DestinationStateNode->bForceCreatePropertyGraphs = false;
+	
+	if (!bCreatedGraphs)
 	{
 		return false;
 	}
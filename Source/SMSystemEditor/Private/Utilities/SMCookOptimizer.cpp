@@ -0,0 +1,296 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#include "SMCookOptimizer.h"
+#include "SMSystemEditorLog.h"
+#include "Configuration/SMProjectEditorSettings.h"
+#include "Utilities/SMBlueprintEditorUtils.h"
+
+#include "Blueprints/SMBlueprintGeneratedClass.h"
+#include "SMInstance.h"
+#include "SMNodeInstance.h"
+#include "SMTransition.h"
+
+#include "AssetRegistryModule.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+#include "UObject/UnrealType.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("SMCookBytesRemoved"), STAT_SMCookBytesRemoved, STATGROUP_LogicDriverEditor);
+
+FString FSMCookOptimizationReport::ToString() const
+{
+	return FString::Printf(TEXT("%s: %lld bytes removed (%lld -> %lld). Templates=%d ConstantEvaluators=%d UnlinkedGraphProperties=%d ExposedPropertyOverrides=%d NodePositions=%d"),
+		*ClassPath, GetBytesRemoved(), BytesBefore, BytesAfter, NumTemplatesRemoved, NumConstantEvaluatorsRemoved,
+		NumUnlinkedGraphPropertiesRemoved, NumExposedPropertyOverridesRemoved, NumNodePositionsStripped);
+}
+
+/** The size of the tagged properties an object saves with. */
+static int64 GetSerializedSize(UObject* Object)
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes, true);
+	FObjectAndNameAsStringProxyArchive Ar(Writer, false);
+	Object->SerializeScriptProperties(Ar);
+	return Bytes.Num();
+}
+
+/** The size of the class defaults and all templates which will be saved with them. */
+static int64 GetSerializedClassSize(USMInstance* DefaultObject)
+{
+	int64 Size = GetSerializedSize(DefaultObject);
+	for (UObject* Template : DefaultObject->ReferenceTemplates)
+	{
+		if (Template && !Template->HasAnyFlags(RF_Transient))
+		{
+			Size += GetSerializedSize(Template);
+		}
+	}
+
+	return Size;
+}
+
+bool FSMCookOptimizer::IsTemplateUnmodified(const UObject* Template)
+{
+	const UObject* ClassDefaults = Template->GetClass()->GetDefaultObject();
+	for (TFieldIterator<FProperty> It(Template->GetClass()); It; ++It)
+	{
+		if (It->HasAnyPropertyFlags(CPF_Transient | CPF_DuplicateTransient))
+		{
+			continue;
+		}
+
+		if (!It->Identical_InContainer(Template, ClassDefaults, 0, PPF_DeepComparison))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/** Child classes look up templates of the parent class by name, so their templates must stay. */
+static bool HasDerivedClasses(const UClass* Class)
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+
+	TSet<FName> DerivedClassNames;
+	AssetRegistry.GetDerivedClassNames({ Class->GetFName() }, TSet<FName>(), DerivedClassNames);
+	DerivedClassNames.Remove(Class->GetFName());
+
+	return DerivedClassNames.Num() > 0;
+}
+
+FSMCookOptimizer& FSMCookOptimizer::Get()
+{
+	static FSMCookOptimizer CookOptimizer;
+	return CookOptimizer;
+}
+
+void FSMCookOptimizer::Initialize()
+{
+	PreCookSaveHandle = USMBlueprintGeneratedClass::OnPreCookSaveEvent.AddRaw(this, &FSMCookOptimizer::OnPreCookSave);
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	AssetRemovedHandle = AssetRegistry.OnAssetRemoved().AddRaw(this, &FSMCookOptimizer::OnAssetRemoved);
+}
+
+void FSMCookOptimizer::Shutdown()
+{
+	USMBlueprintGeneratedClass::OnPreCookSaveEvent.Remove(PreCookSaveHandle);
+	PreCookSaveHandle.Reset();
+
+	if (FModuleManager::Get().IsModuleLoaded("AssetRegistry"))
+	{
+		IAssetRegistry& AssetRegistry = FModuleManager::GetModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+		AssetRegistry.OnAssetRemoved().Remove(AssetRemovedHandle);
+	}
+	AssetRemovedHandle.Reset();
+
+	if (Reports.Num() > 0)
+	{
+		LDEDITOR_LOG_INFO(TEXT("Cook optimized %d state machine classes, %lld bytes removed."), Reports.Num(), GetTotalBytesRemoved());
+	}
+}
+
+const FSMCookOptimizationReport& FSMCookOptimizer::OptimizeClass(USMBlueprintGeneratedClass* Class, bool bStripNodePositions)
+{
+	check(Class);
+
+	const FString ClassPath = Class->GetPathName();
+	if (const int32* ExistingIndex = ReportIndices.Find(ClassPath))
+	{
+		if (OptimizedClasses.FindRef(ClassPath).Get() == Class)
+		{
+			// Already optimized for another platform.
+			return Reports[*ExistingIndex];
+		}
+
+		// The class was reloaded and has its original defaults again.
+		RemoveReport(ClassPath);
+	}
+
+	const int32 Index = Reports.AddDefaulted();
+	ReportIndices.Add(ClassPath, Index);
+	OptimizedClasses.Add(ClassPath, Class);
+
+	FSMCookOptimizationReport& Report = Reports[Index];
+	Report.ClassPath = ClassPath;
+	OptimizeClassInternal(Class, bStripNodePositions, Report);
+
+	INC_DWORD_STAT_BY(STAT_SMCookBytesRemoved, static_cast<uint32>(FMath::Max<int64>(Report.GetBytesRemoved(), 0)));
+	LDEDITOR_LOG_INFO(TEXT("Cook optimized %s"), *Report.ToString());
+
+	return Report;
+}
+
+int64 FSMCookOptimizer::GetTotalBytesRemoved() const
+{
+	int64 Total = 0;
+	for (const FSMCookOptimizationReport& Report : Reports)
+	{
+		Total += Report.GetBytesRemoved();
+	}
+
+	return Total;
+}
+
+void FSMCookOptimizer::OnPreCookSave(USMBlueprintGeneratedClass* Class, const ITargetPlatform* TargetPlatform)
+{
+	// The class defaults are changed in place which would break an editor session.
+	if (!IsRunningCommandlet())
+	{
+		return;
+	}
+
+	const USMProjectEditorSettings* Settings = FSMBlueprintEditorUtils::GetProjectEditorSettings();
+	if (Settings->bOptimizeCookedStateMachines)
+	{
+		OptimizeClass(Class, Settings->bStripCookedNodePositions);
+	}
+}
+
+void FSMCookOptimizer::OnAssetRemoved(const FAssetData& AssetData)
+{
+	if (ReportIndices.Num() > 0)
+	{
+		RemoveReport(AssetData.ObjectPath.ToString() + TEXT("_C"));
+	}
+}
+
+void FSMCookOptimizer::RemoveReport(const FString& ClassPath)
+{
+	OptimizedClasses.Remove(ClassPath);
+	
+	int32 Index;
+	if (!ReportIndices.RemoveAndCopyValue(ClassPath, Index))
+	{
+		return;
+	}
+
+	Reports.RemoveAt(Index);
+	for (TPair<FString, int32>& KeyVal : ReportIndices)
+	{
+		if (KeyVal.Value > Index)
+		{
+			KeyVal.Value--;
+		}
+	}
+}
+
+void FSMCookOptimizer::OptimizeClassInternal(USMBlueprintGeneratedClass* Class, bool bStripNodePositions, FSMCookOptimizationReport& Report)
+{
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("FSMCookOptimizer::OptimizeClass"), STAT_SMCookOptimizer_OptimizeClass, STATGROUP_LogicDriverEditor);
+
+	USMInstance* DefaultObject = Cast<USMInstance>(Class->GetDefaultObject(false));
+	if (!DefaultObject)
+	{
+		return;
+	}
+
+	Report.BytesBefore = GetSerializedClassSize(DefaultObject);
+
+	// Exposed property overrides only configure graph pins.
+	for (UObject* Template : DefaultObject->ReferenceTemplates)
+	{
+		if (USMNodeInstance* NodeTemplate = Cast<USMNodeInstance>(Template))
+		{
+			Report.NumExposedPropertyOverridesRemoved += NodeTemplate->ExposedPropertyOverrides.Num();
+			NodeTemplate->ExposedPropertyOverrides.Empty();
+		}
+	}
+
+	const bool bCanRemoveTemplates = !HasDerivedClasses(Class);
+	TSet<UObject*> RemovedTemplates;
+
+	// Only nodes owned by this class. Nodes of parent classes are saved with their own package.
+	for (TFieldIterator<FStructProperty> It(Class, EFieldIteratorFlags::ExcludeSuper); It; ++It)
+	{
+		if (!It->Struct->IsChildOf(FSMNode_Base::StaticStruct()))
+		{
+			continue;
+		}
+
+		FSMNode_Base* Node = It->ContainerPtrToValuePtr<FSMNode_Base>(DefaultObject);
+
+		if (It->Struct->IsChildOf(FSMTransition::StaticStruct()))
+		{
+			FSMTransition* Transition = static_cast<FSMTransition*>(Node);
+			if (Transition->ConditionalEvaluationType != ESMConditionalEvaluationType::SM_Graph && Transition->GraphEvaluator.Num() > 0)
+			{
+				Report.NumConstantEvaluatorsRemoved += Transition->GraphEvaluator.Num();
+				Transition->GraphEvaluator.Empty();
+			}
+		}
+
+		for (auto GraphPropertyIt = Node->TemplateVariableGraphProperties.CreateIterator(); GraphPropertyIt; ++GraphPropertyIt)
+		{
+			TArray<FSMGraphProperty_Base_Runtime>& VariableGraphProperties = GraphPropertyIt.Value().VariableGraphProperties;
+			Report.NumUnlinkedGraphPropertiesRemoved += VariableGraphProperties.RemoveAll([](const FSMGraphProperty_Base_Runtime& GraphProperty)
+			{
+				return GraphProperty.GraphEvaluator.Num() == 0;
+			});
+
+			if (VariableGraphProperties.Num() == 0)
+			{
+				GraphPropertyIt.RemoveCurrent();
+			}
+		}
+
+		if (bCanRemoveTemplates && Node->TemplateName != NAME_None && Node->StackTemplateNames.Num() == 0 && Node->TemplateVariableGraphProperties.Num() == 0)
+		{
+			UObject* Template = FindObject<UObject>(DefaultObject, *Node->TemplateName.ToString());
+			UClass* DefaultNodeClass = Node->GetDefaultNodeInstanceClass();
+			if (Template && Template->GetClass() == DefaultNodeClass && (Node->NodeInstanceClass == nullptr || Node->NodeInstanceClass == DefaultNodeClass)
+				&& IsTemplateUnmodified(Template))
+			{
+				// The node instance is created from the class defaults, or on demand when the instance allows it.
+				Node->TemplateName = NAME_None;
+				RemovedTemplates.Add(Template);
+			}
+		}
+
+		if (bStripNodePositions && !Node->NodePosition.IsZero())
+		{
+			Node->NodePosition = FVector2D::ZeroVector;
+			Report.NumNodePositionsStripped++;
+		}
+	}
+
+	if (RemovedTemplates.Num() > 0)
+	{
+		DefaultObject->ReferenceTemplates.RemoveAll([&](const UObject* Template)
+		{
+			return RemovedTemplates.Contains(Template);
+		});
+
+		for (UObject* Template : RemovedTemplates)
+		{
+			// Transient objects are not exported with the package.
+			Template->SetFlags(RF_Transient);
+		}
+
+		Report.NumTemplatesRemoved = RemovedTemplates.Num();
+	}
+
+	Report.BytesAfter = GetSerializedClassSize(DefaultObject);
+}
@@ -0,0 +1,93 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class USMBlueprintGeneratedClass;
+class ITargetPlatform;
+struct FAssetData;
+
+/** What was removed from a single state machine class when cooking. */
+struct SMSYSTEMEDITOR_API FSMCookOptimizationReport
+{
+	/** Path of the optimized class. */
+	FString ClassPath;
+
+	/** Node templates identical to their default node class. The node instance is created from the class defaults instead. */
+	int32 NumTemplatesRemoved = 0;
+
+	/** Transition graph evaluators never executed because the result is constant or read from the node instance. */
+	int32 NumConstantEvaluatorsRemoved = 0;
+
+	/** Variable graph properties without a graph to evaluate. */
+	int32 NumUnlinkedGraphPropertiesRemoved = 0;
+
+	/** Exposed property overrides on templates. Only the editor reads these. */
+	int32 NumExposedPropertyOverridesRemoved = 0;
+
+	int32 NumNodePositionsStripped = 0;
+
+	/** Serialized size of the class defaults and templates before and after optimizing. */
+	int64 BytesBefore = 0;
+	int64 BytesAfter = 0;
+
+	int64 GetBytesRemoved() const { return BytesBefore - BytesAfter; }
+
+	FString ToString() const;
+};
+
+/**
+ * Removes data from state machine classes being cooked which only the editor reads or which the runtime never
+ * executes. The class defaults are modified in place, so this only runs from the cook commandlet where the
+ * editor will not use the class afterward.
+ */
+class SMSYSTEMEDITOR_API FSMCookOptimizer
+{
+public:
+	static FSMCookOptimizer& Get();
+
+	/** Listen for state machine classes being cooked. */
+	void Initialize();
+	void Shutdown();
+
+	/**
+	 * Optimize a class now. A class is only optimized once while it is loaded.
+	 *
+	 * @param Class The class to optimize. Its default object is modified.
+	 * @param bStripNodePositions Clear node positions which are only read by GetNodePosition.
+	 *
+	 * @return The report of the class.
+	 */
+	const FSMCookOptimizationReport& OptimizeClass(USMBlueprintGeneratedClass* Class, bool bStripNodePositions);
+
+	/** Reports of all classes optimized this session which haven't been deleted. */
+	const TArray<FSMCookOptimizationReport>& GetReports() const { return Reports; }
+
+	/** Total bytes removed this session. */
+	int64 GetTotalBytesRemoved() const;
+
+	/** If a template has the same values as its class defaults. */
+	static bool IsTemplateUnmodified(const UObject* Template);
+
+private:
+	void OnPreCookSave(USMBlueprintGeneratedClass* Class, const ITargetPlatform* TargetPlatform);
+	void OnAssetRemoved(const FAssetData& AssetData);
+
+	/** Remove the report of a class which no longer exists. */
+	void RemoveReport(const FString& ClassPath);
+
+	void OptimizeClassInternal(USMBlueprintGeneratedClass* Class, bool bStripNodePositions, FSMCookOptimizationReport& Report);
+
+private:
+	TArray<FSMCookOptimizationReport> Reports;
+
+	/** Class path -> index into Reports. */
+	TMap<FString, int32> ReportIndices;
+
+	/** Class path -> the class which was optimized. A class reloaded under the same path is optimized again. */
+	TMap<FString, TWeakObjectPtr<USMBlueprintGeneratedClass>> OptimizedClasses;
+
+	FDelegateHandle PreCookSaveHandle;
+	FDelegateHandle AssetRemovedHandle;
+};
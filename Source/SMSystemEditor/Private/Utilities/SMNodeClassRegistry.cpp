@@ -0,0 +1,404 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#include "SMNodeClassRegistry.h"
+#include "SMSystemEditorLog.h"
+
+#include "Blueprints/SMBlueprint.h"
+#include "SMStateInstance.h"
+#include "SMStateMachineInstance.h"
+#include "SMTransitionInstance.h"
+
+#include "AssetRegistryModule.h"
+#include "Misc/OutputDeviceNull.h"
+#include "Misc/PackageName.h"
+#include "UObject/UObjectIterator.h"
+
+const FName FSMNodeClassRegistry::NodeClassInfoTag = TEXT("LogicDriverNodeClassInfo");
+
+FSMNodeClassInfo::FSMNodeClassInfo() : bIsNative(false), bIsAbstract(false), bRegisteredWithContextMenu(false),
+	bHideFromContextMenuIfRulesFail(false)
+{
+}
+
+FSMNodeClassInfo FSMNodeClassInfo::FromClass(const UClass* Class)
+{
+	check(Class);
+
+	FSMNodeClassInfo ClassInfo;
+	ClassInfo.ClassPath = FSoftClassPath(Class);
+	ClassInfo.ParentClassPath = FSoftClassPath(Class->GetSuperClass());
+	ClassInfo.bIsNative = Class->IsNative();
+	ClassInfo.bIsAbstract = Class->HasAnyClassFlags(CLASS_Abstract);
+
+	if (const USMNodeInstance* NodeDefault = Cast<USMNodeInstance>(Class->GetDefaultObject()))
+	{
+		ClassInfo.DisplayName = NodeDefault->GetNodeDisplayName();
+		ClassInfo.NodeDescription = NodeDefault->GetNodeDescription();
+	}
+
+	if (const USMStateInstance_Base* StateDefault = Cast<USMStateInstance_Base>(Class->GetDefaultObject()))
+	{
+		ClassInfo.bRegisteredWithContextMenu = StateDefault->IsRegisteredWithContextMenu();
+		ClassInfo.bHideFromContextMenuIfRulesFail = StateDefault->HideFromContextMenuIfRulesFail();
+		ClassInfo.StateConnectionRules = StateDefault->GetAllowedConnections();
+	}
+
+	if (const USMStateMachineInstance* StateMachineDefault = Cast<USMStateMachineInstance>(Class->GetDefaultObject()))
+	{
+		ClassInfo.StatePlacementRules = StateMachineDefault->GetAllowedStates();
+	}
+
+	if (const USMTransitionInstance* TransitionDefault = Cast<USMTransitionInstance>(Class->GetDefaultObject()))
+	{
+		ClassInfo.TransitionConnectionRules = TransitionDefault->GetAllowedConnections();
+	}
+
+	return ClassInfo;
+}
+
+UClass* FSMNodeClassInfo::LoadClass() const
+{
+	return ClassPath.TryLoadClass<USMNodeInstance>();
+}
+
+FSMNodeClassRegistry& FSMNodeClassRegistry::Get()
+{
+	static FSMNodeClassRegistry NodeClassRegistry;
+	return NodeClassRegistry;
+}
+
+void FSMNodeClassRegistry::Initialize()
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	AssetAddedHandle = AssetRegistry.OnAssetAdded().AddRaw(this, &FSMNodeClassRegistry::OnAssetAdded);
+	AssetRemovedHandle = AssetRegistry.OnAssetRemoved().AddRaw(this, &FSMNodeClassRegistry::OnAssetRemoved);
+	AssetRenamedHandle = AssetRegistry.OnAssetRenamed().AddRaw(this, &FSMNodeClassRegistry::OnAssetRenamed);
+
+	ExtraObjectTagsHandle = UObject::FAssetRegistryTag::OnGetExtraObjectTags.AddRaw(this, &FSMNodeClassRegistry::OnGetExtraObjectTags);
+	ReloadCompleteHandle = FCoreUObjectDelegates::ReloadCompleteDelegate.AddRaw(this, &FSMNodeClassRegistry::OnReloadComplete);
+	ObjectPropertyChangedHandle = FCoreUObjectDelegates::OnObjectPropertyChanged.AddRaw(this, &FSMNodeClassRegistry::OnObjectPropertyChanged);
+}
+
+void FSMNodeClassRegistry::Shutdown()
+{
+	if (FModuleManager::Get().IsModuleLoaded("AssetRegistry"))
+	{
+		IAssetRegistry& AssetRegistry = FModuleManager::GetModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+		AssetRegistry.OnAssetAdded().Remove(AssetAddedHandle);
+		AssetRegistry.OnAssetRemoved().Remove(AssetRemovedHandle);
+		AssetRegistry.OnAssetRenamed().Remove(AssetRenamedHandle);
+	}
+
+	UObject::FAssetRegistryTag::OnGetExtraObjectTags.Remove(ExtraObjectTagsHandle);
+	FCoreUObjectDelegates::ReloadCompleteDelegate.Remove(ReloadCompleteHandle);
+	FCoreUObjectDelegates::OnObjectPropertyChanged.Remove(ObjectPropertyChangedHandle);
+
+	Reset();
+}
+
+void FSMNodeClassRegistry::GetNodeClasses(const UClass* BaseClass, TArray<TSharedRef<const FSMNodeClassInfo>>& OutClasses)
+{
+	BuildIfNeeded();
+
+	const FSoftObjectPath BaseClassPath(BaseClass);
+	for (const TSharedRef<FSMNodeClassInfo>& ClassInfo : Classes)
+	{
+		if (GetClassHierarchy(*ClassInfo).IsChildOf(BaseClassPath))
+		{
+			OutClasses.Add(ClassInfo);
+		}
+	}
+}
+
+TSharedPtr<const FSMNodeClassInfo> FSMNodeClassRegistry::FindClass(const FSoftClassPath& ClassPath)
+{
+	BuildIfNeeded();
+
+	if (const TSharedRef<FSMNodeClassInfo>* ClassInfo = ClassMap.Find(ClassPath))
+	{
+		return *ClassInfo;
+	}
+
+	return nullptr;
+}
+
+FSMNodeClassPathHierarchy FSMNodeClassRegistry::GetClassHierarchy(const FSMNodeClassInfo& ClassInfo) const
+{
+	FSMNodeClassPathHierarchy Hierarchy;
+
+	// Parents which aren't registered or loaded only need their paths.
+	FSMNodeClassInfo UnregisteredInfo;
+	
+	const FSMNodeClassInfo* CurrentInfo = &ClassInfo;
+	while (CurrentInfo && !Hierarchy.IsChildOf(CurrentInfo->ClassPath))
+	{
+		Hierarchy.ClassPaths.Add(CurrentInfo->ClassPath);
+
+		const FSoftClassPath ParentClassPath = CurrentInfo->ParentClassPath;
+		if (ParentClassPath.IsNull())
+		{
+			break;
+		}
+
+		if (const TSharedRef<FSMNodeClassInfo>* ParentInfo = ClassMap.Find(ParentClassPath))
+		{
+			CurrentInfo = &ParentInfo->Get();
+			continue;
+		}
+
+		// Native classes are always loaded.
+		if (const UClass* ParentClass = ParentClassPath.ResolveClass())
+		{
+			Hierarchy.ClassPaths.Append(FSMNodeClassPathHierarchy::FromClass(ParentClass).ClassPaths);
+			break;
+		}
+
+		FSoftClassPath GrandParentClassPath;
+		if (!FindParentClassPathFromAsset(ParentClassPath, GrandParentClassPath))
+		{
+			break;
+		}
+
+		UnregisteredInfo.ClassPath = ParentClassPath;
+		UnregisteredInfo.ParentClassPath = GrandParentClassPath;
+		CurrentInfo = &UnregisteredInfo;
+	}
+
+	return Hierarchy;
+}
+
+UClass* FSMNodeClassRegistry::FindTransitionClassForConnection(UClass* FromClass, UClass* ToClass, UClass* StateMachineClass)
+{
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("FSMNodeClassRegistry::FindTransitionClassForConnection"), STAT_FindTransitionClassForConnection, STATGROUP_LogicDriverEditor);
+
+	BuildIfNeeded();
+
+	const FSMNodeClassPathHierarchy FromHierarchy = FSMNodeClassPathHierarchy::FromClass(FromClass);
+	const FSMNodeClassPathHierarchy ToHierarchy = FSMNodeClassPathHierarchy::FromClass(ToClass);
+	const FSMNodeClassPathHierarchy StateMachineHierarchy = FSMNodeClassPathHierarchy::FromClass(StateMachineClass);
+	const FSoftObjectPath TransitionClassPath(USMTransitionInstance::StaticClass());
+
+	for (const TSharedRef<FSMNodeClassInfo>& ClassInfo : Classes)
+	{
+		if (ClassInfo->TransitionConnectionRules.AllowedConnections.Num() == 0 || !GetClassHierarchy(*ClassInfo).IsChildOf(TransitionClassPath))
+		{
+			continue;
+		}
+
+		if (ClassInfo->TransitionConnectionRules.IsConnectionValid(FromHierarchy, ToHierarchy, StateMachineHierarchy, false))
+		{
+			return ClassInfo->LoadClass();
+		}
+	}
+
+	return nullptr;
+}
+
+void FSMNodeClassRegistry::UpdateClass(const UClass* Class)
+{
+	if (!bIsBuilt || !Class || !Class->IsChildOf(USMNodeInstance::StaticClass()) ||
+		Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_")))
+	{
+		return;
+	}
+
+	AddClassInfo(FSMNodeClassInfo::FromClass(Class));
+}
+
+void FSMNodeClassRegistry::Reset()
+{
+	Classes.Reset();
+	ClassMap.Reset();
+	bIsBuilt = false;
+}
+
+void FSMNodeClassRegistry::BuildIfNeeded()
+{
+	if (bIsBuilt)
+	{
+		return;
+	}
+
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("FSMNodeClassRegistry::Build"), STAT_BuildNodeClassRegistry, STATGROUP_LogicDriverEditor);
+
+	bIsBuilt = true;
+
+	for (TObjectIterator<UClass> ClassIt; ClassIt; ++ClassIt)
+	{
+		const UClass* Class = *ClassIt;
+		if (Class->IsNative() && Class->IsChildOf(USMNodeInstance::StaticClass()) &&
+			!Class->HasAnyClassFlags(CLASS_Deprecated | CLASS_NewerVersionExists))
+		{
+			AddClassInfo(FSMNodeClassInfo::FromClass(Class));
+		}
+	}
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+
+	TArray<FAssetData> Assets;
+	AssetRegistry.GetAssetsByClass(USMNodeBlueprint::StaticClass()->GetFName(), Assets, true);
+	for (const FAssetData& Asset : Assets)
+	{
+		AddBlueprintAsset(Asset);
+	}
+}
+
+void FSMNodeClassRegistry::AddClassInfo(const FSMNodeClassInfo& ClassInfo)
+{
+	if (TSharedRef<FSMNodeClassInfo>* ExistingInfo = ClassMap.Find(ClassInfo.ClassPath))
+	{
+		ExistingInfo->Get() = ClassInfo;
+		return;
+	}
+
+	TSharedRef<FSMNodeClassInfo> NewInfo = MakeShared<FSMNodeClassInfo>(ClassInfo);
+	Classes.Add(NewInfo);
+	ClassMap.Add(ClassInfo.ClassPath, NewInfo);
+}
+
+void FSMNodeClassRegistry::RemoveClass(const FSoftClassPath& ClassPath)
+{
+	if (const TSharedRef<FSMNodeClassInfo>* ClassInfo = ClassMap.Find(ClassPath))
+	{
+		Classes.Remove(*ClassInfo);
+		ClassMap.Remove(ClassPath);
+	}
+}
+
+void FSMNodeClassRegistry::AddBlueprintAsset(const FAssetData& AssetData)
+{
+	const FSoftClassPath ClassPath = GetGeneratedClassPath(AssetData);
+
+	// Loaded classes may have changed since they were saved.
+	if (const UClass* LoadedClass = ClassPath.ResolveClass())
+	{
+		AddClassInfo(FSMNodeClassInfo::FromClass(LoadedClass));
+		return;
+	}
+
+	const FAssetDataTagMapSharedView::FFindTagResult Result = AssetData.TagsAndValues.FindTag(NodeClassInfoTag);
+	if (Result.IsSet())
+	{
+		FSMNodeClassInfo ClassInfo;
+		FOutputDeviceNull ImportErrors;
+		if (FSMNodeClassInfo::StaticStruct()->ImportText(*Result.GetValue(), &ClassInfo, nullptr, PPF_None, &ImportErrors,
+			FSMNodeClassInfo::StaticStruct()->GetName()))
+		{
+			ClassInfo.ClassPath = ClassPath;
+			AddClassInfo(ClassInfo);
+			return;
+		}
+	}
+
+	// Saved before node class info was tagged. Loading is only needed until the asset is resaved.
+	if (const UClass* Class = ClassPath.TryLoadClass<USMNodeInstance>())
+	{
+		LDEDITOR_LOG_INFO(TEXT("Loaded node class %s to read its rules. Resave the asset to avoid loading it."), *ClassPath.ToString());
+		AddClassInfo(FSMNodeClassInfo::FromClass(Class));
+	}
+}
+
+bool FSMNodeClassRegistry::IsNodeBlueprintAsset(const FAssetData& AssetData)
+{
+	return AssetData.AssetClass == USMNodeBlueprint::StaticClass()->GetFName();
+}
+
+FSoftClassPath FSMNodeClassRegistry::GetGeneratedClassPath(const FAssetData& AssetData)
+{
+	const FAssetDataTagMapSharedView::FFindTagResult Result = AssetData.TagsAndValues.FindTag(TEXT("GeneratedClass"));
+	if (Result.IsSet())
+	{
+		return FSoftClassPath(FPackageName::ExportTextPathToObjectPath(Result.GetValue()));
+	}
+
+	return FSoftClassPath(AssetData.ObjectPath.ToString() + TEXT("_C"));
+}
+
+bool FSMNodeClassRegistry::FindParentClassPathFromAsset(const FSoftClassPath& ClassPath, FSoftClassPath& OutParentClassPath)
+{
+	FString BlueprintPath = ClassPath.ToString();
+	if (!BlueprintPath.RemoveFromEnd(TEXT("_C")))
+	{
+		return false;
+	}
+	
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	const FAssetData AssetData = AssetRegistry.GetAssetByObjectPath(*BlueprintPath);
+	if (!AssetData.IsValid())
+	{
+		return false;
+	}
+
+	const FAssetDataTagMapSharedView::FFindTagResult Result = AssetData.TagsAndValues.FindTag(TEXT("ParentClass"));
+	if (!Result.IsSet())
+	{
+		return false;
+	}
+
+	OutParentClassPath = FSoftClassPath(FPackageName::ExportTextPathToObjectPath(Result.GetValue()));
+	return !OutParentClassPath.IsNull();
+}
+
+void FSMNodeClassRegistry::OnAssetAdded(const FAssetData& AssetData)
+{
+	if (bIsBuilt && IsNodeBlueprintAsset(AssetData))
+	{
+		AddBlueprintAsset(AssetData);
+	}
+}
+
+void FSMNodeClassRegistry::OnAssetRemoved(const FAssetData& AssetData)
+{
+	if (bIsBuilt && IsNodeBlueprintAsset(AssetData))
+	{
+		RemoveClass(GetGeneratedClassPath(AssetData));
+	}
+}
+
+void FSMNodeClassRegistry::OnAssetRenamed(const FAssetData& AssetData, const FString& OldObjectPath)
+{
+	if (bIsBuilt && IsNodeBlueprintAsset(AssetData))
+	{
+		RemoveClass(FSoftClassPath(OldObjectPath + TEXT("_C")));
+		AddBlueprintAsset(AssetData);
+	}
+}
+
+void FSMNodeClassRegistry::OnGetExtraObjectTags(const UObject* Object, TArray<UObject::FAssetRegistryTag>& OutTags)
+{
+	const USMNodeBlueprint* NodeBlueprint = Cast<USMNodeBlueprint>(Object);
+	if (!NodeBlueprint || !NodeBlueprint->GeneratedClass || !NodeBlueprint->GeneratedClass->IsChildOf(USMNodeInstance::StaticClass()))
+	{
+		return;
+	}
+
+	const FSMNodeClassInfo ClassInfo = FSMNodeClassInfo::FromClass(NodeBlueprint->GeneratedClass);
+
+	FString ClassInfoText;
+	FSMNodeClassInfo::StaticStruct()->ExportText(ClassInfoText, &ClassInfo, nullptr, nullptr, PPF_None, nullptr);
+	OutTags.Add(UObject::FAssetRegistryTag(NodeClassInfoTag, ClassInfoText, UObject::FAssetRegistryTag::TT_Hidden));
+}
+
+void FSMNodeClassRegistry::OnReloadComplete(EReloadCompleteReason Reason)
+{
+	// Native classes may have been added or replaced.
+	Reset();
+}
+
+void FSMNodeClassRegistry::OnObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& PropertyChangedEvent)
+{
+	if (!bIsBuilt || Object == nullptr)
+	{
+		return;
+	}
+
+	// Rules are read from class defaults which can be edited without recompiling.
+	if (Object->HasAnyFlags(RF_ClassDefaultObject))
+	{
+		UpdateClass(Object->GetClass());
+	}
+	else if (const USMNodeBlueprint* NodeBlueprint = Cast<USMNodeBlueprint>(Object))
+	{
+		UpdateClass(NodeBlueprint->GeneratedClass);
+	}
+}
@@ -0,0 +1,138 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SMNodeInstance.h"
+#include "Nodes/Rules/SMNodeRules.h"
+#include "SMNodeClassRegistry.generated.h"
+
+struct FAssetData;
+
+/**
+ * Everything the graph editor needs to know about a node class to list and validate it without loading it.
+ * Saved to node blueprint asset registry tags.
+ */
+USTRUCT()
+struct SMSYSTEMEDITOR_API FSMNodeClassInfo
+{
+	GENERATED_USTRUCT_BODY()
+
+	FSMNodeClassInfo();
+
+	/** Read the class default object of a loaded node class. */
+	static FSMNodeClassInfo FromClass(const UClass* Class);
+
+	/** Load the class. Only call once the class is going to be used. */
+	UClass* LoadClass() const;
+
+	UPROPERTY()
+	FSoftClassPath ClassPath;
+
+	UPROPERTY()
+	FSoftClassPath ParentClassPath;
+
+	UPROPERTY()
+	bool bIsNative;
+
+	UPROPERTY()
+	bool bIsAbstract;
+
+	UPROPERTY()
+	bool bRegisteredWithContextMenu;
+
+	UPROPERTY()
+	bool bHideFromContextMenuIfRulesFail;
+
+	UPROPERTY()
+	FString DisplayName;
+
+	UPROPERTY()
+	FSMNodeDescription NodeDescription;
+
+	/** Rules of state classes. */
+	UPROPERTY()
+	FSMStateConnectionValidator StateConnectionRules;
+
+	/** Rules of transition classes. */
+	UPROPERTY()
+	FSMTransitionConnectionValidator TransitionConnectionRules;
+
+	/** Rules of state machine classes. */
+	UPROPERTY()
+	FSMStateMachineNodePlacementValidator StatePlacementRules;
+};
+
+/**
+ * Registry of native and blueprint node classes used by the graph schema for context menus and connection rules.
+ * Blueprint classes are read from asset registry tags so classes are only loaded once placed. The registry is built on first use
+ * and kept up to date from asset registry events, node blueprint compiles and class default edits.
+ */
+class SMSYSTEMEDITOR_API FSMNodeClassRegistry
+{
+public:
+	static FSMNodeClassRegistry& Get();
+
+	/** Listen for asset and compile changes. */
+	void Initialize();
+	void Shutdown();
+
+	/** Node classes derived from a base class with native classes first. */
+	void GetNodeClasses(const UClass* BaseClass, TArray<TSharedRef<const FSMNodeClassInfo>>& OutClasses);
+
+	/** Find a registered class. */
+	TSharedPtr<const FSMNodeClassInfo> FindClass(const FSoftClassPath& ClassPath);
+
+	/** The paths of a registered class and its parents. */
+	FSMNodeClassPathHierarchy GetClassHierarchy(const FSMNodeClassInfo& ClassInfo) const;
+
+	/**
+	 * The first transition class whose rules require this connection. Only the matching class is loaded.
+	 * @return The transition class or nullptr if no rules apply.
+	 */
+	UClass* FindTransitionClassForConnection(UClass* FromClass, UClass* ToClass, UClass* StateMachineClass);
+
+	/** Refresh a class which has been compiled. */
+	void UpdateClass(const UClass* Class);
+
+	/** Clear the registry so it is rebuilt on next use. */
+	void Reset();
+
+	/** Read the parent of a blueprint class from its asset registry tags without loading it. */
+	static bool FindParentClassPathFromAsset(const FSoftClassPath& ClassPath, FSoftClassPath& OutParentClassPath);
+
+	/** The asset registry tag node class info is saved to. */
+	static const FName NodeClassInfoTag;
+
+private:
+	void BuildIfNeeded();
+	void AddClassInfo(const FSMNodeClassInfo& ClassInfo);
+	void RemoveClass(const FSoftClassPath& ClassPath);
+	void AddBlueprintAsset(const FAssetData& AssetData);
+
+	static bool IsNodeBlueprintAsset(const FAssetData& AssetData);
+	static FSoftClassPath GetGeneratedClassPath(const FAssetData& AssetData);
+
+	void OnAssetAdded(const FAssetData& AssetData);
+	void OnAssetRemoved(const FAssetData& AssetData);
+	void OnAssetRenamed(const FAssetData& AssetData, const FString& OldObjectPath);
+	void OnGetExtraObjectTags(const UObject* Object, TArray<UObject::FAssetRegistryTag>& OutTags);
+	void OnReloadComplete(EReloadCompleteReason Reason);
+	void OnObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& PropertyChangedEvent);
+
+private:
+	/** Classes in the order registered. */
+	TArray<TSharedRef<FSMNodeClassInfo>> Classes;
+
+	/** Class path -> class info. */
+	TMap<FSoftClassPath, TSharedRef<FSMNodeClassInfo>> ClassMap;
+
+	bool bIsBuilt = false;
+
+	FDelegateHandle AssetAddedHandle;
+	FDelegateHandle AssetRemovedHandle;
+	FDelegateHandle AssetRenamedHandle;
+	FDelegateHandle ExtraObjectTagsHandle;
+	FDelegateHandle ReloadCompleteHandle;
+	FDelegateHandle ObjectPropertyChangedHandle;
+};
@@ -2,6 +2,7 @@
 
 #include "SMVersionUtils.h"
 #include "Utilities/SMBlueprintEditorUtils.h"
+#include "SMSystemEditorLog.h"
 #include "Blueprints/SMBlueprintFactory.h"
 
 #include "Blueprints/SMBlueprint.h"
@@ -32,15 +33,63 @@ int32 FSMVersionUtils::GetCurrentBlueprintNodeVersion()
 }
 
 void FSMVersionUtils::UpdateBlueprintsToNewVersion()
+{
+	TArray<FAssetData> AssetsToUpdate;
+	bool bIsAssetVersionNotSupported = false;
+	FindAssetsToUpdate(AssetsToUpdate, bIsAssetVersionNotSupported);
+
+	if (bIsAssetVersionNotSupported)
+	{
+		// There are assets from a newer version of the plugin.
+		FNotificationInfo Info(LOCTEXT("LogicDriverAssetsFromNewerVersion", "Logic Driver assets are from a newer version of the plugin!\nPlease update Logic Driver and verify your team is using the same version."));
+		Info.bFireAndForget = false;
+		Info.bUseLargeFont = false;
+		Info.bUseThrobber = false;
+		Info.FadeOutDuration = 0.25f;
+		Info.ButtonDetails.Add(FNotificationButtonInfo(LOCTEXT("LogicDriverWrongVersionDismiss", "Dismiss"), LOCTEXT("LogicDriverWrongVersionDismissTT", "Dismiss this notification"), FSimpleDelegate::CreateStatic(&FSMVersionUtils::DismissWrongVersionNotification)));
+		
+		WrongVersionNotification = FSlateNotificationManager::Get().AddNotification(Info);
+		WrongVersionNotification.Pin()->SetCompletionState(SNotificationItem::CS_Pending);
+	}
+
+	if (AssetsToUpdate.Num() > 0)
+	{
+		FScopedSlowTask Feedback(AssetsToUpdate.Num(), NSLOCTEXT("LogicDriver", "LogicDriverAssetUpdate", "Updating Logic Driver assets to the current version..."));
+
+		if (FSMBlueprintEditorUtils::GetProjectEditorSettings()->bDisplayAssetUpdateProgress)
+		{
+			Feedback.MakeDialog(true);
+		}
+		
+		for (FAssetData& Asset : AssetsToUpdate)
+		{
+			UpdateBlueprintToNewVersion(Cast<UBlueprint>(Asset.GetAsset()));
+			Feedback.CompletedWork += 1;
+		}
+	}
+}
+
+void FSMVersionUtils::FindAssetsToUpdate(TArray<FAssetData>& OutAssets, bool& bOutHasNewerAssets, FName PackagePath)
 {
 	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(FName("AssetRegistry")).Get();
 
-	TArray<FAssetData> OutNodeAssets, OutStateMachineAssets, AssetsToUpdate;
-	AssetRegistry.GetAssetsByClass(USMNodeBlueprint::StaticClass()->GetFName(), OutNodeAssets, true);
-	AssetRegistry.GetAssetsByClass(USMBlueprint::StaticClass()->GetFName(), OutStateMachineAssets, true);
+	auto GetAssets = [&](UClass* BlueprintClass, TArray<FAssetData>& Assets)
+	{
+		FARFilter Filter;
+		Filter.ClassNames.Add(BlueprintClass->GetFName());
+		Filter.bRecursiveClasses = true;
+		if (!PackagePath.IsNone())
+		{
+			Filter.PackagePaths.Add(PackagePath);
+			Filter.bRecursivePaths = true;
+		}
+		AssetRegistry.GetAssets(Filter, Assets);
+	};
+
+	TArray<FAssetData> OutNodeAssets, OutStateMachineAssets;
+	GetAssets(USMNodeBlueprint::StaticClass(), OutNodeAssets);
+	GetAssets(USMBlueprint::StaticClass(), OutStateMachineAssets);
 
-	bool bIsAssetVersionNotSupported = false;
-	
 	// Check nodes first, they should be updated prior to state machines.
 	for (const FAssetData& Asset : OutNodeAssets)
 	{
@@ -49,13 +98,13 @@ void FSMVersionUtils::UpdateBlueprintsToNewVersion()
 		const bool bVersionFound = Asset.GetTagValue(GET_MEMBER_NAME_CHECKED(USMNodeBlueprint, AssetVersion), Version);
 		if (!bVersionFound || !IsStateMachineNodeUpToDate(Version))
 		{
-			AssetsToUpdate.Add(Asset);
+			OutAssets.Add(Asset);
 			continue;
 		}
 
 		if (IsStateMachineNodeFromNewerPluginVersion(Version))
 		{
-			bIsAssetVersionNotSupported = true;
+			bOutHasNewerAssets = true;
 		}
 	}
 
@@ -67,66 +116,85 @@ void FSMVersionUtils::UpdateBlueprintsToNewVersion()
 		const bool bVersionFound = Asset.GetTagValue(GET_MEMBER_NAME_CHECKED(USMBlueprint, AssetVersion), Version);
 		if (!bVersionFound || !IsStateMachineUpToDate(Version))
 		{
-			AssetsToUpdate.Add(Asset);
+			OutAssets.Add(Asset);
 			continue;
 		}
 
 		if (IsStateMachineFromNewerPluginVersion(Version))
 		{
-			bIsAssetVersionNotSupported = true;
+			bOutHasNewerAssets = true;
 		}
 	}
+}
 
-	if (bIsAssetVersionNotSupported)
+bool FSMVersionUtils::UpdateBlueprintToNewVersion(UBlueprint* Blueprint)
+{
+	if (!Blueprint || IsAssetUpToDate(Blueprint))
 	{
-		// There are assets from a newer version of the plugin.
-		FNotificationInfo Info(LOCTEXT("LogicDriverAssetsFromNewerVersion", "Logic Driver assets are from a newer version of the plugin!\nPlease update Logic Driver and verify your team is using the same version."));
-		Info.bFireAndForget = false;
-		Info.bUseLargeFont = false;
-		Info.bUseThrobber = false;
-		Info.FadeOutDuration = 0.25f;
-		Info.ButtonDetails.Add(FNotificationButtonInfo(LOCTEXT("LogicDriverWrongVersionDismiss", "Dismiss"), LOCTEXT("LogicDriverWrongVersionDismissTT", "Dismiss this notification"), FSimpleDelegate::CreateStatic(&FSMVersionUtils::DismissWrongVersionNotification)));
-		
-		WrongVersionNotification = FSlateNotificationManager::Get().AddNotification(Info);
-		WrongVersionNotification.Pin()->SetCompletionState(SNotificationItem::CS_Pending);
+		return false;
 	}
-
-	if (AssetsToUpdate.Num() > 0)
+	
+	if (USMBlueprint* SMBlueprint = Cast<USMBlueprint>(Blueprint))
 	{
-		FScopedSlowTask Feedback(AssetsToUpdate.Num(), NSLOCTEXT("LogicDriver", "LogicDriverAssetUpdate", "Updating Logic Driver assets to the current version..."));
+		// Fixes existing broken graphs for t-141.
+		USMBlueprintFactory::CreateGraphsForBlueprintIfMissing(SMBlueprint);
+		
+		TArray<USMGraphNode_Base*> GraphNodes;
+		FSMBlueprintEditorUtils::GetAllNodesOfClassNested<USMGraphNode_Base>(SMBlueprint, GraphNodes);
 
-		if (FSMBlueprintEditorUtils::GetProjectEditorSettings()->bDisplayAssetUpdateProgress)
+		for (USMGraphNode_Base* Node : GraphNodes)
 		{
-			Feedback.MakeDialog(true);
+			Node->ConvertToCurrentVersion(false);
 		}
-		
-		for (FAssetData& Asset : AssetsToUpdate)
+
+		SetToLatestVersion(SMBlueprint);
+		SMBlueprint->MarkPackageDirty();
+		return true;
+	}
+	
+	if (USMNodeBlueprint* NodeBlueprint = Cast<USMNodeBlueprint>(Blueprint))
+	{
+		SetToLatestVersion(NodeBlueprint);
+		// For now we just need to recompile the node BP.
+		FBlueprintEditorUtils::MarkBlueprintAsModified(NodeBlueprint);
+		return true;
+	}
+
+	return false;
+}
+
+void FSMVersionUtils::UpdateLoadedAssetToNewVersion(UObject* Object)
+{
+	UBlueprint* Blueprint = Cast<UBlueprint>(Object);
+	if (!Blueprint || (!Blueprint->IsA<USMBlueprint>() && !Blueprint->IsA<USMNodeBlueprint>()))
+	{
+		return;
+	}
+
+	// Node blueprints aren't guaranteed to load before the state machines using them. Update them first so state machine nodes convert against current node classes.
+	if (USMBlueprint* SMBlueprint = Cast<USMBlueprint>(Blueprint))
+	{
+		TArray<USMGraphNode_Base*> GraphNodes;
+		FSMBlueprintEditorUtils::GetAllNodesOfClassNested<USMGraphNode_Base>(SMBlueprint, GraphNodes);
+
+		TSet<UBlueprint*> NodeBlueprints;
+		for (const USMGraphNode_Base* GraphNode : GraphNodes)
 		{
-			if(USMBlueprint* SMBlueprint = Cast<USMBlueprint>(Asset.GetAsset()))
-			{
-				// Fixes existing broken graphs for t-141.
-				USMBlueprintFactory::CreateGraphsForBlueprintIfMissing(SMBlueprint);
-				
-				TArray<USMGraphNode_Base*> GraphNodes;
-				FSMBlueprintEditorUtils::GetAllNodesOfClassNested<USMGraphNode_Base>(SMBlueprint, GraphNodes);
-
-				for (USMGraphNode_Base* Node : GraphNodes)
-				{
-					Node->ConvertToCurrentVersion(false);
-				}
-
-				SetToLatestVersion(SMBlueprint);
-				SMBlueprint->MarkPackageDirty();
-			}
-			else if (USMNodeBlueprint* NodeBlueprint = Cast<USMNodeBlueprint>(Asset.GetAsset()))
+			if (UBlueprint* NodeBlueprint = UBlueprint::GetBlueprintFromClass(GraphNode->GetNodeClass()))
 			{
-				SetToLatestVersion(NodeBlueprint);
-				// For now we just need to recompile the node BP.
-				FBlueprintEditorUtils::MarkBlueprintAsModified(NodeBlueprint);
+				NodeBlueprints.Add(NodeBlueprint);
 			}
-			
-			Feedback.CompletedWork += 1;
 		}
+
+		for (UBlueprint* NodeBlueprint : NodeBlueprints)
+		{
+			UpdateBlueprintToNewVersion(NodeBlueprint);
+		}
+	}
+
+	if (UpdateBlueprintToNewVersion(Blueprint))
+	{
+		LDEDITOR_LOG_INFO(TEXT("Updated %s to the current Logic Driver version on load. Save the asset to keep the update."), *Blueprint->GetPathName());
 	}
 }
 
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 
 class UBlueprint;
+struct FAssetData;
 struct FPluginDescriptor;
 
 #define LD_PLUGIN_VERSION_CONSTRUCTION_SCRIPTS "2.5.0"
@@ -85,6 +86,24 @@ public:
 	/** Check all SM blueprints and update to a new version if necessary. */
 	static void UpdateBlueprintsToNewVersion();
 
+	/**
+	 * Find Logic Driver blueprints saved by an older version. Node blueprints are listed first so they update before state machines.
+	 *
+	 * @param OutAssets Assets which need to be updated.
+	 * @param bOutHasNewerAssets Set if any assets are from a newer plugin version.
+	 * @param PackagePath Only search under this path. Searches everything when None.
+	 */
+	static void FindAssetsToUpdate(TArray<FAssetData>& OutAssets, bool& bOutHasNewerAssets, FName PackagePath = NAME_None);
+
+	/**
+	 * Update a loaded blueprint to the current version if it is out of date. The blueprint is marked modified but not saved.
+	 * @return True if the blueprint was updated.
+	 */
+	static bool UpdateBlueprintToNewVersion(UBlueprint* Blueprint);
+
+	/** Update assets as they load, such as when opened or cooked. Used when assets aren't updated on startup. */
+	static void UpdateLoadedAssetToNewVersion(UObject* Object);
+
 	/**
 	 * Handle project specific updates.
 	 * @param PreviousVersionName The previously installed plugin version.
@@ -0,0 +1,163 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#include "SSMDebugTimeline.h"
+#include "Blueprints/SMBlueprintEditor.h"
+
+#include "Blueprints/SMBlueprint.h"
+#include "SMInstance.h"
+
+#include "Widgets/Input/SCheckBox.h"
+#include "Widgets/Input/SSlider.h"
+#include "Widgets/Layout/SBox.h"
+#include "Widgets/Text/STextBlock.h"
+
+#define LOCTEXT_NAMESPACE "SSMDebugTimeline"
+
+void SSMDebugTimeline::Construct(const FArguments& InArgs, TSharedPtr<FSMBlueprintEditor> InEditor)
+{
+	Editor = InEditor;
+
+	ChildSlot
+	[
+		SNew(SHorizontalBox)
+		.IsEnabled(this, &SSMDebugTimeline::IsDebugging)
+		+ SHorizontalBox::Slot()
+		.AutoWidth()
+		.VAlign(VAlign_Center)
+		.Padding(4.f, 0.f)
+		[
+			SNew(SCheckBox)
+			.IsChecked(this, &SSMDebugTimeline::GetRecordingState)
+			.OnCheckStateChanged(this, &SSMDebugTimeline::OnRecordingStateChanged)
+			.ToolTipText(LOCTEXT("RecordTooltip", "Record state and transition events of the instance being debugged so past frames can be displayed."))
+			[
+				SNew(STextBlock)
+				.Text(LOCTEXT("Record", "Record"))
+			]
+		]
+		+ SHorizontalBox::Slot()
+		.AutoWidth()
+		.VAlign(VAlign_Center)
+		.Padding(4.f, 0.f)
+		[
+			SNew(SBox)
+			.WidthOverride(200.f)
+			.IsEnabled(this, &SSMDebugTimeline::IsRecording)
+			[
+				SNew(SSlider)
+				.Value(this, &SSMDebugTimeline::GetScrubPosition)
+				.OnValueChanged(this, &SSMDebugTimeline::OnScrubPositionChanged)
+				.ToolTipText(LOCTEXT("ScrubTooltip", "Display node states after a recorded event. Move to the end to resume live debugging."))
+			]
+		]
+		+ SHorizontalBox::Slot()
+		.AutoWidth()
+		.VAlign(VAlign_Center)
+		.Padding(4.f, 0.f)
+		[
+			SNew(STextBlock)
+			.Text(this, &SSMDebugTimeline::GetScrubText)
+		]
+	];
+}
+
+USMInstance* SSMDebugTimeline::GetDebugInstance() const
+{
+	if (const TSharedPtr<FSMBlueprintEditor> EditorPtr = Editor.Pin())
+	{
+		if (USMBlueprint* Blueprint = EditorPtr->GetStateMachineBlueprint())
+		{
+			return Cast<USMInstance>(Blueprint->GetObjectBeingDebugged());
+		}
+	}
+
+	return nullptr;
+}
+
+bool SSMDebugTimeline::IsDebugging() const
+{
+	return GetDebugInstance() != nullptr;
+}
+
+bool SSMDebugTimeline::IsRecording() const
+{
+	const USMInstance* Instance = GetDebugInstance();
+	return Instance && Instance->GetDebugStateMachineConst().GetRecorder() != nullptr;
+}
+
+ECheckBoxState SSMDebugTimeline::GetRecordingState() const
+{
+	return IsRecording() ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+}
+
+void SSMDebugTimeline::OnRecordingStateChanged(ECheckBoxState NewState)
+{
+	if (USMInstance* Instance = GetDebugInstance())
+	{
+		FSMDebugStateMachine& DebugStateMachine = Instance->GetDebugStateMachine();
+		if (NewState == ECheckBoxState::Checked)
+		{
+			DebugStateMachine.StartRecording();
+		}
+		else
+		{
+			DebugStateMachine.StopRecording();
+		}
+	}
+
+	ScrubPosition = 1.f;
+}
+
+float SSMDebugTimeline::GetScrubPosition() const
+{
+	const USMInstance* Instance = GetDebugInstance();
+	return Instance && Instance->GetDebugStateMachineConst().IsScrubbing() ? ScrubPosition : 1.f;
+}
+
+void SSMDebugTimeline::OnScrubPositionChanged(float NewPosition)
+{
+	ScrubPosition = NewPosition;
+
+	USMInstance* Instance = GetDebugInstance();
+	if (!Instance)
+	{
+		return;
+	}
+
+	FSMDebugStateMachine& DebugStateMachine = Instance->GetDebugStateMachine();
+	const FSMDebugRecorder* Recorder = DebugStateMachine.GetRecorder();
+	if (!Recorder || Recorder->Num() == 0 || ScrubPosition >= 1.f)
+	{
+		DebugStateMachine.StopScrubbing();
+		return;
+	}
+
+	DebugStateMachine.ScrubTo(FMath::RoundToInt(ScrubPosition * (Recorder->Num() - 1)));
+}
+
+FText SSMDebugTimeline::GetScrubText() const
+{
+	const USMInstance* Instance = GetDebugInstance();
+	const FSMDebugRecorder* Recorder = Instance ? Instance->GetDebugStateMachineConst().GetRecorder() : nullptr;
+	if (!Recorder)
+	{
+		return FText::GetEmpty();
+	}
+
+	// The event the node states were replayed to. Recording may have continued since scrubbing.
+	const int32 EventIndex = Instance->GetDebugStateMachineConst().GetScrubbedEventIndex();
+	if (!Instance->GetDebugStateMachineConst().IsScrubbing() || !FMath::IsWithin(EventIndex, 0, Recorder->Num()))
+	{
+		return FText::Format(LOCTEXT("Live", "Live ({0} events)"), FText::AsNumber(Recorder->Num()));
+	}
+
+	const FSMDebugEvent& Event = Recorder->GetEvent(EventIndex);
+
+	FNumberFormattingOptions TimeFormat;
+	TimeFormat.SetMinimumFractionalDigits(3).SetMaximumFractionalDigits(3);
+
+	return FText::Format(LOCTEXT("ScrubbedEvent", "Event {0}/{1}  Frame {2}  {3}s"), FText::AsNumber(EventIndex + 1),
+		FText::AsNumber(Recorder->Num()), FText::AsNumber(Event.Frame), FText::AsNumber(Event.Time, &TimeFormat));
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,43 @@
+// Copyright Recursoft LLC 2019-2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Widgets/SCompoundWidget.h"
+
+class FSMBlueprintEditor;
+class USMInstance;
+
+/**
+ * Toolbar timeline for the instance being debugged. Toggles event recording and scrubs recorded events,
+ * displaying node states as they were at that point. Moving the slider to the end returns to live debugging.
+ */
+class SSMDebugTimeline : public SCompoundWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SSMDebugTimeline) {}
+	SLATE_END_ARGS()
+
+	void Construct(const FArguments& InArgs, TSharedPtr<FSMBlueprintEditor> InEditor);
+
+private:
+	/** The instance currently being debugged in the editor. */
+	USMInstance* GetDebugInstance() const;
+
+	bool IsDebugging() const;
+	bool IsRecording() const;
+
+	ECheckBoxState GetRecordingState() const;
+	void OnRecordingStateChanged(ECheckBoxState NewState);
+
+	float GetScrubPosition() const;
+	void OnScrubPositionChanged(float NewPosition);
+
+	FText GetScrubText() const;
+
+private:
+	TWeakPtr<FSMBlueprintEditor> Editor;
+
+	/** Normalized position in the recorded events. 1 is live. */
+	float ScrubPosition = 1.f;
+};
@@ -197,6 +197,26 @@ void USMTransitionTestInstance::OnTransitionShutdown_Implementation()
 	//OnTransitionEnteredEvent.RemoveDynamic(this, &USMTransitionTestInstance::OnTransitionEnteredEventFunc); Can't remove because this will fire before TransitionEntered.
 }
 
+const FName USMTransitionEventTestInstance::TriggerEventName = "TestEvent";
+
+USMTransitionEventTestInstance::USMTransitionEventTestInstance()
+{
+	SetTriggerEvents({ TriggerEventName });
+}
+
+bool USMTransitionEventTestInstance::CanEnterTransition_Implementation() const
+{
+	TimesEvaluated++;
+
+	FSMEvent Event;
+	if (GetTriggeringEvent(Event))
+	{
+		TriggeringPayload = Event.Payload;
+	}
+
+	return true;
+}
+
 FText USMTextGraphState::DefaultText = FText::FromString("ctor default");
 
 USMTextGraphState::USMTextGraphState()
@@ -206,6 +226,7 @@ USMTextGraphState::USMTextGraphState()
 
 USMStateMachineTestComponent::USMStateMachineTestComponent(class FObjectInitializer const& ObjectInitializer) : Super(ObjectInitializer)
 {
+	TestContext = nullptr;
 }
 
 void USMTextGraphState::OnStateBegin_Implementation()
@@ -240,3 +261,57 @@ void USMStateMachineTestComponent::ImportDeprecatedProperties_Public()
 {
 	ImportDeprecatedProperties();
 }
+
+UObject* USMStateMachineTestComponent::GetContextForInitialization_Implementation() const
+{
+	return TestContext ? TestContext : Super::GetContextForInitialization_Implementation();
+}
+
+USMTestNativeStateMachine::USMTestNativeStateMachine()
+{
+	NumNativeEvaluations = 0;
+	Transition.GraphEvaluator.AddDefaulted_GetRef().BoundFunction = GET_FUNCTION_NAME_CHECKED(USMTestNativeStateMachine, Evaluate_Transition);
+}
+
+void USMTestNativeStateMachine::MatchBlueprintNodes(const USMInstance* BlueprintDefaults)
+{
+	auto IsFunctionHandlerArray = [](const FProperty* Property)
+	{
+		const FArrayProperty* ArrayProperty = CastField<FArrayProperty>(Property);
+		const FStructProperty* InnerProperty = ArrayProperty ? CastField<FStructProperty>(ArrayProperty->Inner) : nullptr;
+		return InnerProperty && InnerProperty->Struct == FSMExposedFunctionHandler::StaticStruct();
+	};
+
+	TSet<const FStructProperty*> MatchedProperties;
+	for (TFieldIterator<FStructProperty> BlueprintIt(BlueprintDefaults->GetClass(), EFieldIteratorFlags::ExcludeSuper); BlueprintIt; ++BlueprintIt)
+	{
+		for (TFieldIterator<FStructProperty> NativeIt(StaticClass(), EFieldIteratorFlags::ExcludeSuper); NativeIt; ++NativeIt)
+		{
+			if (NativeIt->Struct != BlueprintIt->Struct || MatchedProperties.Contains(*NativeIt))
+			{
+				continue;
+			}
+
+			MatchedProperties.Add(*NativeIt);
+
+			const void* BlueprintNode = BlueprintIt->ContainerPtrToValuePtr<void>(BlueprintDefaults);
+			void* NativeNode = NativeIt->ContainerPtrToValuePtr<void>(this);
+			for (TFieldIterator<FProperty> It(NativeIt->Struct); It; ++It)
+			{
+				if (!IsFunctionHandlerArray(*It))
+				{
+					It->CopyCompleteValue_InContainer(NativeNode, BlueprintNode);
+				}
+			}
+			break;
+		}
+	}
+
+	RootStateMachineGuid = BlueprintDefaults->RootStateMachineGuid;
+}
+
+void USMTestNativeStateMachine::Evaluate_Transition()
+{
+	NumNativeEvaluations++;
+	ExecuteBlueprintNodeFunction(Transition, GET_MEMBER_NAME_CHECKED(FSMNode_Base, GraphEvaluator));
+}
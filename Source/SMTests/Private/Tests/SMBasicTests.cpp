@@ -3,15 +3,24 @@
 #include "Blueprints/SMBlueprint.h"
 #include "SMTestHelpers.h"
 #include "Blueprints/SMBlueprintGeneratedClass.h"
+#include "SMStateMachineDefinition.h"
+#include "SMUtils.h"
 #include "Blueprints/SMBlueprintFactory.h"
 #include "Utilities/SMBlueprintEditorUtils.h"
 #include "SMTestContext.h"
 #include "Utilities/SMVersionUtils.h"
+#include "Compilers/SMCompileCache.h"
+#include "Compilers/SMCompileReport.h"
+#include "Utilities/SMCookOptimizer.h"
+#include "Compilers/SMNativeCodeGenerator.h"
 #include "EdGraph/EdGraph.h"
 #include "Kismet2/KismetEditorUtilities.h"
+#include "Kismet/KismetMathLibrary.h"
+#include "K2Node_CallFunction.h"
 #include "Graph/SMGraphK2.h"
 #include "Graph/SMGraph.h"
 #include "Graph/SMStateGraph.h"
+#include "Graph/SMTransitionGraph.h"
 #include "Graph/Schema/SMGraphK2Schema.h"
 #include "Graph/Nodes/RootNodes/SMGraphK2Node_StateMachineSelectNode.h"
 #include "Graph/Nodes/SMGraphK2Node_StateMachineNode.h"
@@ -515,6 +524,578 @@ IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStateHistoryTest, "SMTests.StateHistory", EAut
 	return true;
 }
 
+/**
+ * Verify instances using a shared definition and on demand node instances match normal instances.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSharedDefinitionTest, "SMTests.SharedDefinition", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FSharedDefinitionTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	const int32 TotalStates = 5;
+	UEdGraphPin* LastStatePin = nullptr;
+
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, TotalStates, &LastStatePin);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMInstance* DefaultInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, NewObject<USMTestContext>());
+
+	TArray<UObject*> DefaultObjects;
+	GetObjectsWithOuter(DefaultInstance, DefaultObjects, false);
+
+	USMInstance* ClassDefaults = CastChecked<USMInstance>(NewBP->GetGeneratedClass()->GetDefaultObject());
+	for (const TCHAR* PropertyName : { TEXT("bUseSharedDefinition"), TEXT("bCreateNodeInstancesOnDemand") })
+	{
+		FBoolProperty* Property = FindFProperty<FBoolProperty>(USMInstance::StaticClass(), PropertyName);
+		check(Property);
+		Property->SetPropertyValue_InContainer(ClassDefaults, true);
+	}
+
+	USMTestContext* Context = NewObject<USMTestContext>();
+	USMInstance* SharedInstance = USMBlueprintUtils::CreateStateMachineInstance(NewBP->GetGeneratedClass(), Context);
+	TestTrue("State machine initialized", SharedInstance->IsInitialized());
+	TestTrue("Shared definition built", NewBP->GetGeneratedClass()->GetStateMachineDefinition().IsValid());
+
+	const TArray<FSMState_Base*>& DefaultStates = DefaultInstance->GetRootStateMachine().GetStates();
+	const TArray<FSMState_Base*>& SharedStates = SharedInstance->GetRootStateMachine().GetStates();
+	if (!TestEqual("States match", SharedStates.Num(), DefaultStates.Num()))
+	{
+		return false;
+	}
+	
+	for (int32 Idx = 0; Idx < SharedStates.Num(); ++Idx)
+	{
+		TestEqual("State order matches", SharedStates[Idx]->GetGuid(), DefaultStates[Idx]->GetGuid());
+		TestEqual("Outgoing transitions match", SharedStates[Idx]->GetOutgoingTransitions().Num(), DefaultStates[Idx]->GetOutgoingTransitions().Num());
+	}
+	TestEqual("Transitions match", SharedInstance->GetRootStateMachine().GetTransitions().Num(), DefaultInstance->GetRootStateMachine().GetTransitions().Num());
+	TestEqual("Node maps match", SharedInstance->GetNodeMap().Num(), DefaultInstance->GetNodeMap().Num());
+
+	TArray<UObject*> SharedObjects;
+	GetObjectsWithOuter(SharedInstance, SharedObjects, false);
+	TestTrue("Fewer node instances created", SharedObjects.Num() < DefaultObjects.Num());
+
+	SharedInstance->Start();
+	for (int32 Idx = 1; Idx < TotalStates; ++Idx)
+	{
+		SharedInstance->Update(1.f);
+	}
+
+	TestEqual("All states entered", Context->GetEntryInt(), TotalStates);
+	TestTrue("End state reached", SharedInstance->GetRootStateMachine().IsInEndState());
+	FSMState_Base* EndState = SharedInstance->GetRootStateMachine().GetSingleActiveState();
+	TestNull("Running states doesn't create default node instances", EndState->GetNodeInstanceIfCreated());
+	for (const FSMTransition* Transition : SharedInstance->GetRootStateMachine().GetTransitions())
+	{
+		TestNull("Evaluating transitions doesn't create default node instances", Transition->GetNodeInstanceIfCreated());
+	}
+	
+	USMNodeInstance* EndStateInstance = EndState->GetNodeInstance();
+	if (TestNotNull("Node instance created on demand", EndStateInstance))
+	{
+		TestTrue("Node instance of an active state initialized on demand", EndStateInstance->IsInitialized());
+	}
+
+	SharedInstance->Shutdown();
+	DefaultInstance->Shutdown();
+
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * Verify compile records only match blueprints which haven't changed.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCompileCacheTest, "SMTests.CompileCache", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FCompileCacheTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 2, &LastStatePin);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	FSMCompileCache& CompileCache = FSMCompileCache::Get();
+	
+	const uint32 InputHash = CompileCache.CalculateInputHash(NewBP);
+	TestEqual("Hash is stable", CompileCache.CalculateInputHash(NewBP), InputHash);
+	TestFalse("Not recorded", CompileCache.IsUpToDate(NewBP, InputHash));
+
+	CompileCache.RecordCompile(NewBP, InputHash);
+	TestTrue("Recorded", CompileCache.IsUpToDate(NewBP, InputHash));
+
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &LastStatePin);
+	const uint32 ModifiedInputHash = CompileCache.CalculateInputHash(NewBP);
+	TestNotEqual("Hash changed", ModifiedInputHash, InputHash);
+	TestFalse("Modified blueprint not up to date", CompileCache.IsUpToDate(NewBP, ModifiedInputHash));
+
+	TestTrue("Children notified of first change", CompileCache.ShouldNotifyChildren(NewBP));
+	CompileCache.RecordChildrenNotified(NewBP, false);
+	TestTrue("Children notified again after a failed compile", CompileCache.ShouldNotifyChildren(NewBP));
+	CompileCache.RecordChildrenNotified(NewBP, true);
+	TestFalse("Children not notified without a change", CompileCache.ShouldNotifyChildren(NewBP));
+
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * Verify a compile report counts the generated nodes and times each compile phase.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCompileReportTest, "SMTests.CompileReport", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FCompileReportTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	const int32 TotalStates = 3;
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, TotalStates, &LastStatePin);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	TSharedPtr<FSMCompileReport> Report = FSMCompileReports::Get().FindReport(NewBP);
+	if (!TestTrue("Compile report recorded", Report.IsValid()))
+	{
+		return NewAsset.DeleteAsset(this);
+	}
+
+	TestEqual("States counted", Report->NumStates, TotalStates);
+	TestEqual("Transitions counted", Report->NumTransitions, TotalStates - 1);
+	TestTrue("Functions generated", Report->NumGeneratedFunctions > 0);
+	TestTrue("Properties generated", Report->NumGeneratedProperties > 0);
+	TestTrue("Graphs cloned", Report->NumClonedGraphs >= TotalStates);
+
+	for (const TCHAR* Phase : { TEXT("PreCompile"), TEXT("ProcessStateMachineGraph"), TEXT("ProcessRuntimeContainers"), TEXT("CopyTermDefaultsToDefaultObject") })
+	{
+		TestTrue(FString::Printf(TEXT("Phase %s timed"), Phase), Report->GetPhaseTime(Phase) > 0.0);
+	}
+
+	const FString Counts = Report->ToString(false);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	TSharedPtr<FSMCompileReport> NewReport = FSMCompileReports::Get().FindReport(NewBP);
+	if (TestTrue("New report created", NewReport.IsValid() && NewReport != Report))
+	{
+		TestEqual("Counts stable between compiles", NewReport->ToString(false), Counts);
+	}
+
+	return NewAsset.DeleteAsset(this);
+}
+
+
+/**
+ * Verify cook optimization strips constant transition evaluators and node positions and the state machine still runs.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCookOptimizationTest, "SMTests.CookOptimization", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FCookOptimizationTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	const int32 TotalStates = 4;
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, TotalStates, &LastStatePin, nullptr, nullptr, false);
+
+	// Constant results don't need the graph evaluated.
+	TArray<USMGraphNode_TransitionEdge*> TransitionEdges;
+	FSMBlueprintEditorUtils::GetAllNodesOfClassNested<USMGraphNode_TransitionEdge>(StateMachineGraph, TransitionEdges);
+	for (USMGraphNode_TransitionEdge* TransitionEdge : TransitionEdges)
+	{
+		USMGraphK2Node_TransitionResultNode* ResultNode = CastChecked<USMTransitionGraph>(TransitionEdge->GetBoundGraph())->ResultNode;
+		ResultNode->BreakAllNodeLinks();
+		ResultNode->GetInputPin()->DefaultValue = TEXT("True");
+	}
+	
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	// Optimizing modifies the class defaults in place. The saved asset is reloaded afterward to discard the changes.
+	if (!NewAsset.SaveAsset(this))
+	{
+		return false;
+	}
+
+	USMBlueprintGeneratedClass* GeneratedClass = CastChecked<USMBlueprintGeneratedClass>(NewBP->GeneratedClass);
+	const FSMCookOptimizationReport& Report = FSMCookOptimizer::Get().OptimizeClass(GeneratedClass, true);
+	TestEqual("Report is for the class", Report.ClassPath, GeneratedClass->GetPathName());
+	TestTrue("Bytes not added", Report.BytesAfter <= Report.BytesBefore);
+	TestTrue("Node positions stripped", Report.NumNodePositionsStripped > 0);
+
+	const FSMCookOptimizationReport& SecondReport = FSMCookOptimizer::Get().OptimizeClass(GeneratedClass, true);
+	TestTrue("Class only optimized once", &SecondReport == &Report);
+
+	TSet<FSMTransition*> Transitions;
+	USMUtils::TryGetAllRuntimeNodesFromInstance(CastChecked<USMInstance>(GeneratedClass->GetDefaultObject()), Transitions);
+	TestEqual("All transitions found", Transitions.Num(), TotalStates - 1);
+	for (const FSMTransition* Transition : Transitions)
+	{
+		TestTrue("Transition is constant", Transition->ConditionalEvaluationType == ESMConditionalEvaluationType::SM_AlwaysTrue);
+		TestEqual("Constant evaluator removed", Transition->GraphEvaluator.Num(), 0);
+		TestTrue("Position removed", Transition->NodePosition.IsZero());
+	}
+
+	int32 A, B, C;
+	USMInstance* Instance = TestHelpers::RunStateMachineToCompletion(this, NewBP, A, B, C, 1000, false, true, false);
+	TestTrue("Optimized state machine reached the end", Instance->IsInEndState());
+	Instance->Shutdown();
+
+	if (!NewAsset.UnloadAsset(this) || !NewAsset.LoadAsset(this))
+	{
+		return false;
+	}
+
+	NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	TSet<FSMNode_Base*> ReloadedNodes;
+	USMUtils::TryGetAllRuntimeNodesFromInstance(CastChecked<USMInstance>(NewBP->GeneratedClass->GetDefaultObject()), ReloadedNodes);
+	TestTrue("Reloaded class isn't optimized", ReloadedNodes.Array().ContainsByPredicate([](const FSMNode_Base* Node)
+	{
+		return !Node->NodePosition.IsZero();
+	}));
+
+	// Deleted classes shouldn't remain in the session's reports.
+	const int32 NumReports = FSMCookOptimizer::Get().GetReports().Num();
+	if (!NewAsset.DeleteAsset(this))
+	{
+		return false;
+	}
+	TestEqual("Report removed with the asset", FSMCookOptimizer::Get().GetReports().Num(), NumReports - 1);
+
+	return true;
+}
+
+
+/**
+ * Verify states are found by name and qualified path through nested state machines and references.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStatePathLookupTest, "SMTests.StatePathLookup", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FStatePathLookupTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &LastStatePin);
+	USMGraphNode_StateMachineStateNode* NestedFSMNode = TestHelpers::BuildNestedStateMachine(this, StateMachineGraph, 3, &LastStatePin, nullptr);
+
+	UEdGraphPin* FromPin = NestedFSMNode->GetOutputPin();
+	USMGraphNode_StateMachineStateNode* ReferenceFSMNode = TestHelpers::BuildNestedStateMachine(this, StateMachineGraph, 2, &FromPin, nullptr);
+
+	USMBlueprint* NewReferencedBlueprint = FSMBlueprintEditorUtils::ConvertStateMachineToReference(ReferenceFSMNode, false, nullptr, nullptr);
+	TestNotNull("New referenced blueprint created", NewReferencedBlueprint);
+	FKismetEditorUtilities::CompileBlueprint(NewReferencedBlueprint);
+
+	// Store handler information so we can delete the object.
+	FString ReferencedPath = NewReferencedBlueprint->GetPathName();
+	FAssetHandler ReferencedAsset(NewReferencedBlueprint->GetName(), USMBlueprint::StaticClass(), NewObject<USMBlueprintFactory>(), &ReferencedPath);
+	ReferencedAsset.Object = NewReferencedBlueprint;
+	ReferencedAsset.Package = FAssetData(NewReferencedBlueprint).GetPackage();
+
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, NewObject<USMTestContext>());
+	TestNotNull("Definition available for lookups", Instance->GetStateMachineDefinition());
+
+	FSMStateMachine& RootStateMachine = Instance->GetRootStateMachine();
+	FSMStateMachine* NestedStateMachine = (FSMStateMachine*)RootStateMachine.FindStateByName(*NestedFSMNode->GetStateName());
+	FSMStateMachine* ReferenceStateMachine = (FSMStateMachine*)RootStateMachine.FindStateByName(*ReferenceFSMNode->GetStateName());
+	if (!TestNotNull("Nested state machine found by name", NestedStateMachine) || !TestNotNull("Reference found by name", ReferenceStateMachine))
+	{
+		return false;
+	}
+	TestTrue("Nested state machine found", NestedStateMachine->IsStateMachine());
+	TestNull("Unknown state not found", RootStateMachine.FindStateByName(TEXT("NotAState")));
+
+	USMInstance* ReferencedInstance = ReferenceStateMachine->GetInstanceReference();
+	if (!TestNotNull("Referenced instance created", ReferencedInstance))
+	{
+		return false;
+	}
+
+	FSMState_Base* NestedState = NestedStateMachine->GetStates().Last();
+	FSMState_Base* ReferencedState = ReferencedInstance->GetRootStateMachine().GetStates().Last();
+	TestEqual("Contained state found by name", NestedStateMachine->FindStateByName(*NestedState->GetNodeName()), NestedState);
+	TestEqual("Contained state instance found by name", Cast<USMStateMachineInstance>(NestedStateMachine->GetNodeInstance())->GetContainedStateByName(NestedState->GetNodeName()),
+		Cast<USMStateInstance_Base>(NestedState->GetNodeInstance()));
+
+	const FSMStatePathHandle NestedHandle = Instance->ResolveStatePath(NestedStateMachine->GetNodeName() + TEXT(".") + NestedState->GetNodeName());
+	TestTrue("Nested path resolved", NestedHandle.IsValid());
+	TestEqual("Nested path found", Instance->GetStateByHandle(NestedHandle), NestedState);
+	TestEqual("Nested path state instance found", Instance->GetStateInstanceByHandle(NestedHandle), Cast<USMStateInstance_Base>(NestedState->GetNodeInstance()));
+
+	const FSMStatePathHandle ReferenceHandle = Instance->ResolveStatePath(ReferenceStateMachine->GetNodeName() + TEXT(".") + ReferencedState->GetNodeName());
+	TestTrue("Path through reference resolved", ReferenceHandle.IsValid());
+	TestEqual("Path through reference found", Instance->GetStateByHandle(ReferenceHandle), ReferencedState);
+
+	AddExpectedError(TEXT("Could not resolve state path"), EAutomationExpectedErrorFlags::Contains, 1);
+	TestFalse("Invalid path not resolved", Instance->ResolveStatePath(NestedStateMachine->GetNodeName() + TEXT(".NotAState")).IsValid());
+
+	// Handles are reused between instances of the same class.
+	USMInstance* SecondInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, NewObject<USMTestContext>());
+	FSMState_Base* SecondNestedState = SecondInstance->GetStateByHandle(NestedHandle);
+	TestNotNull("Handle reused on another instance", SecondNestedState);
+	TestNotEqual("Handle finds the other instance's state", SecondNestedState, NestedState);
+	TestEqual("Handle finds the same node", SecondNestedState ? SecondNestedState->GetGuid() : FGuid(), NestedState->GetGuid());
+	TestNull("Handle rejected by a different class", ReferencedInstance->GetStateByHandle(NestedHandle));
+
+	SecondInstance->Shutdown();
+	Instance->Shutdown();
+
+	ReferencedAsset.DeleteAsset(this);
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * Verify instances copied from an initialized prototype match normal instances.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCloneInitializedInstanceTest, "SMTests.CloneInitializedInstance", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FCloneInitializedInstanceTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 3, &LastStatePin);
+	USMGraphNode_StateMachineStateNode* ReferenceFSMNode = TestHelpers::BuildNestedStateMachine(this, StateMachineGraph, 2, &LastStatePin, nullptr);
+
+	USMBlueprint* NewReferencedBlueprint = FSMBlueprintEditorUtils::ConvertStateMachineToReference(ReferenceFSMNode, false, nullptr, nullptr);
+	TestNotNull("New referenced blueprint created", NewReferencedBlueprint);
+	FKismetEditorUtilities::CompileBlueprint(NewReferencedBlueprint);
+
+	// Store handler information so we can delete the object.
+	FString ReferencedPath = NewReferencedBlueprint->GetPathName();
+	FAssetHandler ReferencedAsset(NewReferencedBlueprint->GetName(), USMBlueprint::StaticClass(), NewObject<USMBlueprintFactory>(), &ReferencedPath);
+	ReferencedAsset.Object = NewReferencedBlueprint;
+	ReferencedAsset.Package = FAssetData(NewReferencedBlueprint).GetPackage();
+
+	int32 EntryVal, UpdateVal, EndVal;
+	TestHelpers::RunStateMachineToCompletion(this, NewBP, EntryVal, UpdateVal, EndVal);
+
+	USMInstance* Prototype = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, NewObject<USMTestContext>());
+
+	USMTestContext* Context = NewObject<USMTestContext>();
+	USMInstance* Clone = USMBlueprintUtils::CloneInitializedInstance(Prototype, Context);
+	if (!TestNotNull("Clone created", Clone))
+	{
+		return false;
+	}
+
+	TestTrue("Clone initialized", Clone->IsInitialized());
+	TestEqual("Clone uses new context", Clone->GetContext(), Cast<UObject>(Context));
+	TestEqual("Node maps match", Clone->GetNodeMap().Num(), Prototype->GetNodeMap().Num());
+
+	for (const TPair<FGuid, FSMNode_Base*>& KeyVal : Prototype->GetNodeMap())
+	{
+		FSMNode_Base* const* CloneNode = Clone->GetNodeMap().Find(KeyVal.Key);
+		if (!TestNotNull("Clone node found by prototype guid", CloneNode))
+		{
+			continue;
+		}
+
+		TestNotEqual("Clone node is not the prototype node", *CloneNode, KeyVal.Value);
+		if (USMNodeInstance* PrototypeNodeInstance = KeyVal.Value->GetNodeInstance())
+		{
+			USMNodeInstance* CloneNodeInstance = (*CloneNode)->GetNodeInstance();
+			TestNotEqual("Node instance copied", CloneNodeInstance, PrototypeNodeInstance);
+			TestEqual("Node instance class matches", CloneNodeInstance ? CloneNodeInstance->GetClass() : nullptr, PrototypeNodeInstance->GetClass());
+		}
+	}
+
+	const TArray<USMInstance*> PrototypeReferences = Prototype->GetAllReferencedInstances(true);
+	const TArray<USMInstance*> CloneReferences = Clone->GetAllReferencedInstances(true);
+	if (TestEqual("References cloned", CloneReferences.Num(), PrototypeReferences.Num()) && CloneReferences.Num() > 0)
+	{
+		TestNotEqual("Reference is a new instance", CloneReferences[0], PrototypeReferences[0]);
+		TestEqual("Reference uses new context", CloneReferences[0]->GetContext(), Cast<UObject>(Context));
+	}
+
+	Clone->Start();
+	for (int32 Iterations = 0; !Clone->GetRootStateMachine().IsInEndState() && Iterations < 1000; ++Iterations)
+	{
+		Clone->Update(1.f);
+	}
+	Clone->Shutdown();
+
+	TestTrue("Clone reached end state", Clone->GetRootStateMachine().IsInEndState());
+	TestEqual("Clone entry logic matches", Context->GetEntryInt(), EntryVal);
+	TestEqual("Clone update logic matches", Context->GetUpdateInt(), UpdateVal);
+	TestEqual("Clone end logic matches", Context->GetEndInt(), EndVal);
+	TestFalse("Prototype not started", Prototype->IsActive());
+
+	Prototype->Shutdown();
+
+	ReferencedAsset.DeleteAsset(this);
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * Generate native code from a state machine with a translatable and an untranslatable transition. The untranslatable
+ * transition must still produce the result of its blueprint graph.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNativeCodeGenerationTest, "SMTests.NativeCodeGeneration", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FNativeCodeGenerationTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	const int32 TotalStates = 3;
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, TotalStates, &LastStatePin, nullptr, nullptr, false);
+
+	TArray<USMGraphNode_TransitionEdge*> TransitionEdges;
+	FSMBlueprintEditorUtils::GetAllNodesOfClassNested<USMGraphNode_TransitionEdge>(StateMachineGraph, TransitionEdges);
+	TestEqual("All transitions found", TransitionEdges.Num(), TotalStates - 1);
+
+	// Replace the context call of the first transition with logic that can be translated.
+	UEdGraph* TransitionGraph = TransitionEdges[0]->GetBoundGraph();
+	TransitionGraph->Nodes.Empty();
+	TransitionGraph->GetSchema()->CreateDefaultNodesForGraph(*TransitionGraph);
+
+	UK2Node_CallFunction* NotNode = TestHelpers::CreateFunctionCall(TransitionGraph,
+		UKismetMathLibrary::StaticClass()->FindFunctionByName(GET_FUNCTION_NAME_CHECKED(UKismetMathLibrary, Not_PreBool)));
+	NotNode->FindPinChecked(TEXT("A"))->DefaultValue = TEXT("false");
+	TestTrue("Result connected", TransitionGraph->GetSchema()->TryCreateConnection(NotNode->GetReturnValuePin(),
+		CastChecked<USMTransitionGraph>(TransitionGraph)->ResultNode->GetInputPin()));
+
+	// Read the result of the second transition from the context, which can't be translated.
+	TestHelpers::AddTransitionResultLogic(this, TransitionEdges[1]);
+
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	FSMNativeCodeGenerationResult Result;
+	TestTrue("Code generated", FSMNativeCodeGenerator::Generate(NewBP, TEXT("SMTESTS_API"), Result));
+	TestTrue("All states and transitions generated", Result.NumNodes >= TotalStates * 2 - 1);
+	TestEqual("Translated transition is native", Result.NumNativePredicates, 1);
+	TestTrue("Context call runs on the VM", Result.NumVMFallbacks >= 1);
+
+	TestTrue("Class declared", Result.HeaderText.Contains(FString::Printf(TEXT("class SMTESTS_API %s : public USMInstance"), *Result.ClassName)));
+	TestTrue("Transition property declared", Result.HeaderText.Contains(TEXT("\tFSMTransition ")));
+	TestTrue("State property declared", Result.HeaderText.Contains(TEXT("\tFSMState ")));
+	TestTrue("Root guid set", Result.SourceText.Contains(TEXT("RootStateMachineGuid = FGuid(")));
+	TestTrue("Predicate translated", Result.SourceText.Contains(TEXT("bCanEnterTransition = !false;")));
+	TestTrue("Context call runs the blueprint node function", Result.SourceText.Contains(TEXT("ExecuteBlueprintNodeFunction(")));
+	TestFalse("Graph functions aren't called by their compiled name", Result.SourceText.Contains(TEXT("FindFunction(")));
+
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * Verify a blueprint reparented to a native state machine with the same nodes runs the native nodes, with results the
+ * native class doesn't implement running the graph functions of the blueprint.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNativeParentStateMachineTest, "SMTests.NativeParentStateMachine", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FNativeParentStateMachineTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	NewBP->ParentClass = USMTestNativeStateMachine::StaticClass();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 2, &LastStatePin, nullptr, nullptr, false);
+
+	TArray<USMGraphNode_TransitionEdge*> TransitionEdges;
+	FSMBlueprintEditorUtils::GetAllNodesOfClassNested<USMGraphNode_TransitionEdge>(StateMachineGraph, TransitionEdges);
+	if (!TestEqual("Transition found", TransitionEdges.Num(), 1))
+	{
+		return NewAsset.DeleteAsset(this);
+	}
+
+	TestHelpers::AddTransitionResultLogic(this, TransitionEdges[0]);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	// Make the native class match the blueprint as if it had been generated from it, then compile so the blueprint defaults inherit its nodes.
+	USMTestNativeStateMachine* NativeDefaults = GetMutableDefault<USMTestNativeStateMachine>();
+	NativeDefaults->MatchBlueprintNodes(CastChecked<USMInstance>(NewBP->GeneratedClass->GetDefaultObject()));
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMTestContext* Context = NewObject<USMTestContext>();
+	USMTestNativeStateMachine* Instance = Cast<USMTestNativeStateMachine>(TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context));
+	if (TestNotNull("Instance is the native class", Instance))
+	{
+		Instance->Start();
+		FSMState_Base* FirstState = Instance->GetRootStateMachine().GetSingleActiveState();
+		TestNotNull("Native initial state active", FirstState);
+
+		Context->bCanTransition = false;
+		Instance->Update(0.f);
+		TestTrue("Native transition evaluated", Instance->NumNativeEvaluations > 0);
+		TestEqual("Blueprint result false", Instance->GetRootStateMachine().GetSingleActiveState(), FirstState);
+
+		Context->bCanTransition = true;
+		Instance->Update(0.f);
+		TestNotEqual("Blueprint result true", Instance->GetRootStateMachine().GetSingleActiveState(), FirstState);
+
+		Instance->Shutdown();
+	}
+
+	// Other blueprints must not match the native class.
+	NativeDefaults->RootStateMachineGuid.Invalidate();
+
+	return NewAsset.DeleteAsset(this);
+}
+
 #endif
 
-#endif //WITH_DEV_AUTOMATION_TESTS
\ No newline at end of file
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -3,6 +3,7 @@
 #include "SMTestHelpers.h"
 #include "SMTestContext.h"
 #include "Utilities/SMBlueprintEditorUtils.h"
+#include "Utilities/SMNodeClassRegistry.h"
 #include "Blueprints/SMBlueprintFactory.h"
 #include "Graph/SMGraph.h"
 #include "Graph/SMStateGraph.h"
@@ -1448,6 +1449,174 @@ bool FNodeInstanceResetVariablesTest::RunTest(const FString& Parameters)
 	return true;
 }
 
+/**
+ * Verify exposed variables don't create property graphs until needed when deferred.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNodeInstanceDeferPropertyGraphsTest, "SMTests.NodeInstanceDeferPropertyGraphs", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FNodeInstanceDeferPropertyGraphsTest::RunTest(const FString& Parameters)
+{
+	USMProjectEditorSettings* Settings = GetMutableDefault<USMProjectEditorSettings>();
+	const bool bSavedDeferSetting = Settings->bDeferDefaultPropertyGraphs;
+	Settings->bDeferDefaultPropertyGraphs = true;
+	
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		Settings->bDeferDefaultPropertyGraphs = bSavedDeferSetting;
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	const int32 TotalStates = 1;
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, TotalStates, &LastStatePin, USMStateTestInstance::StaticClass(), USMTransitionTestInstance::StaticClass());
+
+	USMGraphNode_StateNode* StateNode = CastChecked<USMGraphNode_StateNode>(StateMachineGraph->GetEntryNode()->GetOutputNode());
+	TestEqual("No property graphs created", StateNode->GetAllPropertyGraphs().Num(), 0);
+	TestTrue("Property graphs deferred", StateNode->HasDeferredPropertyGraphs());
+
+	// Deferred properties still compile and run from the template.
+	TestHelpers::TestLinearStateMachine(this, NewBP, TotalStates);
+
+	// Graphs are kept deferred when properties are recreated.
+	StateNode->ForceRecreateProperties();
+	TestEqual("No property graphs created", StateNode->GetAllPropertyGraphs().Num(), 0);
+
+	// Deferred graphs are still found after the asset is reloaded.
+	if (!NewAsset.SaveAsset(this) || !NewAsset.UnloadAsset(this) || !NewAsset.LoadAsset(this))
+	{
+		Settings->bDeferDefaultPropertyGraphs = bSavedDeferSetting;
+		return false;
+	}
+
+	NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+	StateNode = CastChecked<USMGraphNode_StateNode>(StateMachineGraph->GetEntryNode()->GetOutputNode());
+	TestEqual("No property graphs created after reload", StateNode->GetAllPropertyGraphs().Num(), 0);
+	TestTrue("Property graphs deferred after reload", StateNode->HasDeferredPropertyGraphs());
+
+	StateNode->CreateDeferredPropertyGraphs();
+	TestTrue("Property graphs created", StateNode->GetAllPropertyGraphs().Num() > 0);
+	TestFalse("No property graphs deferred", StateNode->HasDeferredPropertyGraphs());
+	TestEqual("Property nodes created", StateNode->GetAllPropertyGraphNodesAsArray().Num(), StateNode->GetAllPropertyGraphs().Num());
+
+	// Created graphs aren't removed once deferring resumes.
+	const int32 TotalGraphs = StateNode->GetAllPropertyGraphs().Num();
+	StateNode->ForceRecreateProperties();
+	TestEqual("Property graphs kept", StateNode->GetAllPropertyGraphs().Num(), TotalGraphs);
+	
+	TestHelpers::TestLinearStateMachine(this, NewBP, TotalStates);
+
+	Settings->bDeferDefaultPropertyGraphs = bSavedDeferSetting;
+	
+	return NewAsset.DeleteAsset(this);
+}
+
+
+/**
+ * Verify the node class registry reads node classes and evaluates rules by class path.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNodeInstanceClassRegistryTest, "SMTests.NodeInstanceClassRegistry", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FNodeInstanceClassRegistryTest::RunTest(const FString& Parameters)
+{
+	FSMNodeClassRegistry& Registry = FSMNodeClassRegistry::Get();
+
+	TArray<TSharedRef<const FSMNodeClassInfo>> StateClasses;
+	Registry.GetNodeClasses(USMStateInstance_Base::StaticClass(), StateClasses);
+	TestTrue("Native state class registered", StateClasses.ContainsByPredicate([](const TSharedRef<const FSMNodeClassInfo>& ClassInfo)
+	{
+		return ClassInfo->bIsNative && ClassInfo->ClassPath == FSoftClassPath(USMStateInstance::StaticClass());
+	}));
+	
+	FAssetHandler StateAsset;
+	if (!TestHelpers::TryCreateNewNodeAsset(this, StateAsset, USMStateInstance::StaticClass(), false))
+	{
+		return false;
+	}
+
+	USMNodeBlueprint* StateBP = StateAsset.GetObjectAs<USMNodeBlueprint>();
+	UClass* StateClass = StateBP->GeneratedClass;
+
+	// Compiling updates the registry.
+	const TSharedPtr<const FSMNodeClassInfo> StateClassInfo = Registry.FindClass(FSoftClassPath(StateClass));
+	if (TestTrue("Blueprint state class registered", StateClassInfo.IsValid()))
+	{
+		TestFalse("Not native", StateClassInfo->bIsNative);
+		TestEqual("Display name read from defaults", StateClassInfo->DisplayName, CastChecked<USMNodeInstance>(StateClass->GetDefaultObject())->GetNodeDisplayName());
+
+		const FSMNodeClassPathHierarchy Hierarchy = Registry.GetClassHierarchy(*StateClassInfo);
+		TestTrue("Hierarchy starts with the class", Hierarchy.GetClassPath() == FSoftObjectPath(StateClass));
+		TestTrue("Hierarchy includes the native parent", Hierarchy.IsChildOf(FSoftObjectPath(USMStateInstance::StaticClass())));
+		TestFalse("Hierarchy excludes unrelated classes", Hierarchy.IsChildOf(FSoftObjectPath(USMTransitionInstance::StaticClass())));
+	}
+
+	// Editing class defaults updates the registry without a compile.
+	{
+		USMStateInstance_Base* StateDefaults = CastChecked<USMStateInstance_Base>(StateClass->GetDefaultObject());
+		FBoolProperty* RegisterProperty = FindFProperty<FBoolProperty>(USMStateInstance_Base::StaticClass(), TEXT("bRegisterWithContextMenu"));
+		check(RegisterProperty);
+		
+		const bool bWasRegistered = RegisterProperty->GetPropertyValue_InContainer(StateDefaults);
+		RegisterProperty->SetPropertyValue_InContainer(StateDefaults, !bWasRegistered);
+		FPropertyChangedEvent PropertyChangedEvent(RegisterProperty);
+		StateDefaults->PostEditChangeProperty(PropertyChangedEvent);
+
+		const TSharedPtr<const FSMNodeClassInfo> EditedClassInfo = Registry.FindClass(FSoftClassPath(StateClass));
+		if (TestTrue("Edited class registered", EditedClassInfo.IsValid()))
+		{
+			TestEqual("Registry updated from edited defaults", EditedClassInfo->bRegisteredWithContextMenu, StateDefaults->IsRegisteredWithContextMenu());
+		}
+
+		RegisterProperty->SetPropertyValue_InContainer(StateDefaults, bWasRegistered);
+		StateDefaults->PostEditChangeProperty(PropertyChangedEvent);
+	}
+
+	// Parents of blueprints which aren't registered or loaded are read from asset tags.
+	{
+		FSoftClassPath ParentClassPath;
+		TestTrue("Parent read from asset tags", FSMNodeClassRegistry::FindParentClassPathFromAsset(FSoftClassPath(StateClass), ParentClassPath));
+		TestTrue("Parent from asset tags matches", ParentClassPath == FSoftClassPath(USMStateInstance::StaticClass()));
+	}
+
+	// Class info is saved to asset tags and can be read back without loading.
+	TArray<UObject::FAssetRegistryTag> Tags;
+	StateBP->GetAssetRegistryTags(Tags);
+	const UObject::FAssetRegistryTag* ClassInfoTag = Tags.FindByPredicate([](const UObject::FAssetRegistryTag& Tag)
+	{
+		return Tag.Name == FSMNodeClassRegistry::NodeClassInfoTag;
+	});
+	if (TestNotNull("Class info tag saved", ClassInfoTag))
+	{
+		FSMNodeClassInfo ImportedClassInfo;
+		TestNotNull("Class info tag imported", FSMNodeClassInfo::StaticStruct()->ImportText(*ClassInfoTag->Value, &ImportedClassInfo, nullptr, PPF_None, GWarn,
+			FSMNodeClassInfo::StaticStruct()->GetName()));
+		TestTrue("Imported class path", ImportedClassInfo.ClassPath == FSoftClassPath(StateClass));
+		TestEqual("Imported display name", ImportedClassInfo.DisplayName, StateClassInfo.IsValid() ? StateClassInfo->DisplayName : FString());
+	}
+
+	// Rules evaluated by path match rules evaluated by class.
+	FSMStateMachineNodePlacementValidator PlacementRules;
+	FSMStateClassRule& StateRule = PlacementRules.AllowedStates.AddDefaulted_GetRef();
+	StateRule.StateClass = StateClass;
+
+	TestTrue("Class allowed by class", PlacementRules.IsStateAllowed(StateClass));
+	TestTrue("Class allowed by path", PlacementRules.IsStateAllowed(FSMNodeClassPathHierarchy::FromClass(StateClass)));
+	TestFalse("Other class rejected by class", PlacementRules.IsStateAllowed(USMConduitInstance::StaticClass()));
+	TestFalse("Other class rejected by path", PlacementRules.IsStateAllowed(FSMNodeClassPathHierarchy::FromClass(USMConduitInstance::StaticClass())));
+
+	StateRule.bNOT = true;
+	TestFalse("Inverted rule rejects class by path", PlacementRules.IsStateAllowed(FSMNodeClassPathHierarchy::FromClass(StateClass)));
+	TestTrue("Inverted rule allows other class by path", PlacementRules.IsStateAllowed(FSMNodeClassPathHierarchy::FromClass(USMConduitInstance::StaticClass())));
+
+	return StateAsset.DeleteAsset(this);
+}
+
 #endif
 
-#endif //WITH_DEV_AUTOMATION_TESTS
\ No newline at end of file
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -530,6 +530,151 @@ IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSaveStateMachineStateWithIntermediateReference
 		TestSaveStateMachineState(this, bUseReferences, true, true, true);
 }
 
+/**
+ * Capture a running instance to bytes and restore it to a new instance without entering states again.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInstanceSnapshotTest, "SMTests.InstanceSnapshot", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FInstanceSnapshotTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 3, &LastStatePin);
+	USMGraphNode_StateMachineStateNode* ReferenceFSMNode = TestHelpers::BuildNestedStateMachine(this, StateMachineGraph, 2, &LastStatePin, nullptr);
+
+	USMBlueprint* NewReferencedBlueprint = FSMBlueprintEditorUtils::ConvertStateMachineToReference(ReferenceFSMNode, false, nullptr, nullptr);
+	TestNotNull("New referenced blueprint created", NewReferencedBlueprint);
+	FKismetEditorUtilities::CompileBlueprint(NewReferencedBlueprint);
+
+	// Store handler information so we can delete the object.
+	FString ReferencedPath = NewReferencedBlueprint->GetPathName();
+	FAssetHandler ReferencedAsset(NewReferencedBlueprint->GetName(), USMBlueprint::StaticClass(), NewObject<USMBlueprintFactory>(), &ReferencedPath);
+	ReferencedAsset.Object = NewReferencedBlueprint;
+	ReferencedAsset.Package = FAssetData(NewReferencedBlueprint).GetPackage();
+
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, NewObject<USMTestContext>());
+	Instance->Start();
+	Instance->Update(0.5f);
+	Instance->Update(0.25f);
+
+	FSMInstanceSnapshot Snapshot;
+	Instance->CaptureSnapshot(Snapshot);
+	TestEqual("Instance and reference recorded", Snapshot.Instances.Num(), 2);
+
+	TArray<uint8> Bytes;
+	Instance->SaveSnapshotToBytes(Bytes);
+	TestTrue("Snapshot written", Bytes.Num() > 0);
+
+	FSMInstanceSnapshot EmptySnapshot;
+	TestFalse("Empty data rejected", EmptySnapshot.LoadFromBytes(TArray<uint8>()));
+
+	AddExpectedError(TEXT("while it was running"), EAutomationExpectedErrorFlags::Contains, 1);
+	TestFalse("Running instance not restored", Instance->RestoreSnapshotFromBytes(Bytes));
+
+	USMTestContext* RestoredContext = NewObject<USMTestContext>();
+	USMInstance* RestoredInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, RestoredContext);
+	if (!TestTrue("Snapshot restored", RestoredInstance->RestoreSnapshotFromBytes(Bytes)))
+	{
+		return false;
+	}
+
+	TestTrue("Restored instance active", RestoredInstance->IsActive());
+	TestTrue("Restored instance started", RestoredInstance->HasStarted());
+	TestEqual("States not entered when restoring", RestoredContext->GetEntryInt(), 0);
+
+	FSMState_Base* ActiveState = Instance->GetSingleActiveState();
+	FSMState_Base* RestoredActiveState = RestoredInstance->GetSingleActiveState();
+	if (!TestNotNull("Restored active state", RestoredActiveState))
+	{
+		return false;
+	}
+
+	TestEqual("Active state restored", RestoredActiveState->GetGuid(), ActiveState->GetGuid());
+	TestEqual("Time in state restored", RestoredActiveState->GetActiveTime(), ActiveState->GetActiveTime());
+	TestEqual("Start time restored", RestoredActiveState->GetStartTime(), ActiveState->GetStartTime());
+	TestTrue("History restored", RestoredInstance->GetStateHistory() == Instance->GetStateHistory());
+
+	// The restored instance continues from the restored state.
+	RestoredInstance->Update(0.5f);
+	TestTrue("Next state entered", RestoredContext->GetEntryInt() > 0);
+	TestNotEqual("Restored instance advanced", RestoredInstance->GetSingleActiveState()->GetGuid(), ActiveState->GetGuid());
+
+	RestoredInstance->Shutdown();
+	Instance->Shutdown();
+
+	ReferencedAsset.DeleteAsset(this);
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * Roll a running instance back to a snapshot without running state logic, as done when a predicted transition is rejected.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInstanceSnapshotRollbackTest, "SMTests.InstanceSnapshotRollback", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FInstanceSnapshotRollbackTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 4, &LastStatePin);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMTestContext* Context = NewObject<USMTestContext>();
+	USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+	Instance->Start();
+
+	FSMInstanceSnapshot Snapshot;
+	Instance->CaptureSnapshot(Snapshot);
+	const FGuid SnapshotStateGuid = Instance->GetSingleActiveState()->GetGuid();
+
+	Instance->Update(0.5f);
+	FSMState_Base* PredictedState = Instance->GetSingleActiveState();
+	TestNotEqual("Instance advanced", PredictedState->GetGuid(), SnapshotStateGuid);
+
+	const int32 EntryVal = Context->GetEntryInt();
+	const int32 EndVal = Context->GetEndInt();
+
+	if (!TestTrue("Instance rolled back", Instance->RollbackToSnapshot(Snapshot)))
+	{
+		return false;
+	}
+
+	TestTrue("Instance still running", Instance->IsActive());
+	TestEqual("Active state rolled back", Instance->GetSingleActiveState()->GetGuid(), SnapshotStateGuid);
+	TestFalse("Predicted state deactivated", PredictedState->IsActive());
+	TestEqual("Active states", Instance->GetAllActiveStateGuidsCopy().Num(), 1);
+	TestEqual("No states entered on rollback", Context->GetEntryInt(), EntryVal);
+	TestEqual("No states ended on rollback", Context->GetEndInt(), EndVal);
+
+	// The instance continues from the rolled back state.
+	Instance->Update(0.5f);
+	TestEqual("Predicted state entered again", Instance->GetSingleActiveState()->GetGuid(), PredictedState->GetGuid());
+	TestTrue("State logic runs after rollback", Context->GetEntryInt() > EntryVal);
+
+	Instance->Shutdown();
+
+	return NewAsset.DeleteAsset(this);
+}
+
 #endif
 
 #endif //WITH_DEV_AUTOMATION_TESTS
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "SMTestHelpers.h"
 #include "SMTestContext.h"
+#include "SMMemoryReport.h"
+#include "SMInitializationQueue.h"
 
 #include "Blueprints/SMBlueprint.h"
 
@@ -672,6 +674,451 @@ IMPLEMENT_SIMPLE_AUTOMATION_TEST(FParallelStatesTest, "SMTests.ParallelStates",
 	return NewAsset.DeleteAsset(this);
 }
 
+/**
+ * Verify debug states are published by node index only while a debugger is watching.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDebugNodeStateTest, "SMTests.DebugNodeState", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FDebugNodeStateTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 3, &LastStatePin);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMTestContext* Context = NewObject<USMTestContext>();
+	USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+	FSMDebugStateMachine& DebugStateMachine = Instance->GetDebugStateMachine();
+
+	TestEqual("Every node indexed", DebugStateMachine.IndexedNodes.Num(), DebugStateMachine.NodeStates.Num());
+	TestFalse("Not watched before a debugger reads", DebugStateMachine.IsBeingWatched());
+
+	Instance->Start();
+
+	FSMState_Base* FirstState = Instance->GetRootStateMachine().GetSingleActiveState();
+	TestFalse("Nothing published without a debugger", DebugStateMachine.GetNodeState(FirstState->DebugNodeIndex)->bIsActive);
+
+	// Reading refreshes from the runtime nodes.
+	DebugStateMachine.Watch();
+	TestTrue("Watched", DebugStateMachine.IsBeingWatched());
+	TestTrue("Active state refreshed", DebugStateMachine.GetNodeState(FirstState->DebugNodeIndex)->bIsActive);
+	TestEqual("Indexed node matches", DebugStateMachine.GetIndexedNode(FirstState->DebugNodeIndex), static_cast<const FSMNode_Base*>(FirstState));
+
+	Instance->Update(0.f);
+
+	FSMState_Base* SecondState = Instance->GetRootStateMachine().GetSingleActiveState();
+	TestNotEqual("State changed", SecondState, FirstState);
+	TestFalse("First state published inactive", DebugStateMachine.GetNodeState(FirstState->DebugNodeIndex)->bIsActive);
+	TestTrue("First state published was active", DebugStateMachine.GetNodeState(FirstState->DebugNodeIndex)->bWasActive);
+	TestTrue("Second state published active", DebugStateMachine.GetNodeState(SecondState->DebugNodeIndex)->bIsActive);
+
+	TArray<int32> Indices;
+	DebugStateMachine.FindNodeIndices(SecondState->GetNodeGuid(), Indices);
+	TestEqual("Node index found by guid", DebugStateMachine.SelectNodeIndex(Indices), SecondState->DebugNodeIndex);
+
+	// Watching expires once the debugger skips reading for a few frames.
+	TestTrue("Watched within the unwatched frame limit", DebugStateMachine.IsBeingWatched(GFrameCounter + 2));
+	TestFalse("Watching expires", DebugStateMachine.IsBeingWatched(GFrameCounter + 10));
+
+	// Stop reading. Changes are no longer published.
+	DebugStateMachine.StopWatching();
+	TestFalse("No longer watched", DebugStateMachine.IsBeingWatched());
+
+	Instance->Update(0.f);
+	TestTrue("Second state not published while unwatched", DebugStateMachine.GetNodeState(SecondState->DebugNodeIndex)->bIsActive);
+
+	Instance->Stop();
+
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * Verify node events are recorded into a bounded buffer and can be replayed.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDebugRecorderTest, "SMTests.DebugRecorder", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FDebugRecorderTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 3, &LastStatePin);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMTestContext* Context = NewObject<USMTestContext>();
+	USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+	FSMDebugStateMachine& DebugStateMachine = Instance->GetDebugStateMachine();
+
+	TestNull("Not recording by default", DebugStateMachine.GetRecorder());
+
+	DebugStateMachine.StartRecording(64);
+	FSMDebugRecorder* Recorder = DebugStateMachine.GetRecorder();
+	TestNotNull("Recording", Recorder);
+	TestEqual("Capacity", Recorder->GetCapacity(), 64);
+
+	// Watch so live states are published alongside the recording.
+	DebugStateMachine.Watch();
+
+	Instance->Start();
+	FSMState_Base* FirstState = Instance->GetRootStateMachine().GetSingleActiveState();
+
+	TestTrue("Start recorded", Recorder->Num() > 0);
+	const FSMDebugEvent& FirstEvent = Recorder->GetEvent(0);
+	TestTrue("First event activated", FirstEvent.Type == ESMDebugEventType::Activated);
+	const int32 StartEventIndex = Recorder->Num() - 1;
+
+	Instance->Update(0.f);
+	FSMState_Base* SecondState = Instance->GetRootStateMachine().GetSingleActiveState();
+	TestNotEqual("Second state active", SecondState, FirstState);
+
+	bool bFoundTransitionTaken = false;
+	bool bFoundEvaluated = false;
+	for (int32 Idx = 0; Idx < Recorder->Num(); ++Idx)
+	{
+		const FSMDebugEvent& Event = Recorder->GetEvent(Idx);
+		bFoundTransitionTaken |= Event.Type == ESMDebugEventType::TransitionTaken;
+		bFoundEvaluated |= Event.Type == ESMDebugEventType::Evaluated && Event.bResult;
+	}
+	TestTrue("Transition taken recorded", bFoundTransitionTaken);
+	TestTrue("Transition evaluation recorded", bFoundEvaluated);
+
+	// Replay to when only the first state was active.
+	DebugStateMachine.ScrubTo(StartEventIndex);
+	TestTrue("Scrubbing", DebugStateMachine.IsScrubbing());
+	TestTrue("First state active in the past", DebugStateMachine.GetNodeState(FirstState->DebugNodeIndex)->bIsActive);
+	TestFalse("Second state inactive in the past", DebugStateMachine.GetNodeState(SecondState->DebugNodeIndex)->bIsActive);
+	TestTrue("Recorded time in state", DebugStateMachine.GetScrubbedTimeInState(FirstState->DebugNodeIndex) >= 0.f);
+	TestEqual("Last event at frame found", Recorder->FindLastEventAtFrame(static_cast<uint32>(GFrameCounter)), Recorder->Num() - 1);
+
+	DebugStateMachine.StopScrubbing();
+	TestTrue("Still watched", DebugStateMachine.IsBeingWatched());
+	TestFalse("Live first state shown", DebugStateMachine.GetNodeState(FirstState->DebugNodeIndex)->bIsActive);
+	TestTrue("Live second state shown", DebugStateMachine.GetNodeState(SecondState->DebugNodeIndex)->bIsActive);
+
+	// Fill the buffer past its capacity.
+	for (int32 Idx = 0; Idx < 100; ++Idx)
+	{
+		Instance->Stop();
+		Instance->Start();
+	}
+	TestEqual("Buffer bounded", Recorder->Num(), Recorder->GetCapacity());
+	TestTrue("Older events overwritten", Recorder->GetTotalRecorded() > static_cast<uint64>(Recorder->GetCapacity()));
+
+	DebugStateMachine.ScrubTo(0);
+	DebugStateMachine.StopRecording();
+	TestNull("Recording stopped", DebugStateMachine.GetRecorder());
+	TestFalse("Scrubbing stopped", DebugStateMachine.IsScrubbing());
+
+	Instance->Stop();
+
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * Verify the node profiler aggregates node work per class while a session is running.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNodeProfilerTest, "SMTests.NodeProfiler", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FNodeProfilerTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 3, &LastStatePin);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMTestContext* Context = NewObject<USMTestContext>();
+	USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+	USMInstance* SecondInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+
+	FSMProfiler& Profiler = FSMProfiler::Get();
+	const bool bWasProfiling = FSMProfiler::IsProfiling();
+	Profiler.Start();
+
+	for (USMInstance* RunInstance : { Instance, SecondInstance })
+	{
+		RunInstance->Start();
+		for (int32 Idx = 0; Idx < 3; ++Idx)
+		{
+			RunInstance->Update(0.f);
+		}
+	}
+
+	Profiler.Stop();
+
+	const FSMNodeProfile* TransitionProfile = nullptr;
+	int32 NumClassProfiles = 0;
+	for (const FSMNodeProfile* Profile : Profiler.GetSortedProfiles())
+	{
+		if (Profile->InstanceClass != Instance->GetClass())
+		{
+			continue;
+		}
+
+		NumClassProfiles++;
+		if (Profile->GetStat(ESMProfileCategory::TransitionPass).Count > 0)
+		{
+			TransitionProfile = Profile;
+		}
+	}
+
+	TestTrue("Nodes profiled", NumClassProfiles > 0);
+	if (TestNotNull("Transition profiled", TransitionProfile))
+	{
+		const FSMProfileStat& Stat = TransitionProfile->GetStat(ESMProfileCategory::TransitionPass);
+		TestTrue("Aggregated across instances", Stat.Count >= 2);
+		TestTrue("Passes counted", Stat.Passes > 0 && Stat.Passes <= Stat.Count);
+		TestTrue("Peak within total", Stat.PeakCycles <= Stat.TotalCycles);
+		TestTrue("Self within total", Stat.SelfCycles >= 0 && Stat.SelfCycles <= Stat.TotalCycles);
+
+		// Nothing is recorded once stopped.
+		const int64 StoppedCount = Stat.Count;
+		SecondInstance->Stop();
+		SecondInstance->Start();
+		SecondInstance->Update(0.f);
+		TestEqual("No counts after stopping", Stat.Count, StoppedCount);
+	}
+
+	TestTrue("Csv includes the class", Profiler.ToCsv().Contains(Instance->GetClass()->GetName()));
+	TestTrue("Table includes the class", Profiler.ToTable().Contains(Instance->GetClass()->GetName()));
+
+	Instance->Stop();
+	SecondInstance->Stop();
+
+	if (bWasProfiling)
+	{
+		Profiler.Start();
+	}
+
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * Verify instance memory is measured and aggregated per class.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMemoryReportTest, "SMTests.MemoryReport", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FMemoryReportTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 3, &LastStatePin);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMTestContext* Context = NewObject<USMTestContext>();
+	USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+	USMInstance* SecondInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+
+	const FSMMemoryUsage InstanceUsage = FSMMemoryReport::GetInstanceMemoryUsage(Instance);
+	TestEqual("One instance", InstanceUsage.NumInstances, 1);
+	TestEqual("Not a reference", InstanceUsage.NumReferenceInstances, 0);
+	TestEqual("Root, states and transitions counted", InstanceUsage.NumNodes, Instance->GetNodeMap().Num());
+	TestTrue("Instance measured", InstanceUsage.InstanceBytes > 0);
+	TestTrue("Nodes measured", InstanceUsage.NodeStructBytes > 0);
+	TestTrue("Guid maps measured", InstanceUsage.GuidMapBytes > 0);
+	TestEqual("Total adds up", InstanceUsage.GetTotalBytes(), InstanceUsage.InstanceBytes + InstanceUsage.NodeStructBytes +
+		InstanceUsage.NodeInstanceBytes + InstanceUsage.GraphPropertyBytes + InstanceUsage.GuidMapBytes + InstanceUsage.StateHistoryBytes);
+
+	const TArray<FSMMemoryUsage> ClassUsages = FSMMemoryReport::GetClassMemoryUsage();
+	const FSMMemoryUsage* ClassUsage = ClassUsages.FindByPredicate([&](const FSMMemoryUsage& Usage)
+	{
+		return Usage.ClassName == Instance->GetClass()->GetName();
+	});
+
+	if (TestNotNull("Class found", ClassUsage))
+	{
+		TestTrue("Instances aggregated", ClassUsage->NumInstances >= 2);
+		TestTrue("Bytes aggregated", ClassUsage->GetTotalBytes() >= InstanceUsage.GetTotalBytes() * 2);
+	}
+
+	for (int32 Idx = 1; Idx < ClassUsages.Num(); ++Idx)
+	{
+		TestTrue("Sorted by total", ClassUsages[Idx - 1].GetTotalBytes() >= ClassUsages[Idx].GetTotalBytes());
+	}
+
+	TestTrue("Table includes the class", FSMMemoryReport::ToTable(ClassUsages, 0).Contains(Instance->GetClass()->GetName()));
+	TestTrue("Csv includes the class", FSMMemoryReport::ToCsv(ClassUsages).Contains(Instance->GetClass()->GetName()));
+
+	Instance->Shutdown();
+	SecondInstance->Shutdown();
+
+	return NewAsset.DeleteAsset(this);
+}
+
+
+/**
+ * Verify deferred component initialization runs by priority and applies calls made while pending.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDeferredInitializationTest, "SMTests.DeferredInitialization", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FDeferredInitializationTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 2, &LastStatePin);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMTestContext* Context = NewObject<USMTestContext>();
+	FSMInitializationQueue& Queue = FSMInitializationQueue::Get();
+	const int32 StartingQueueSize = Queue.Num();
+
+	auto CreateComponent = [&](int32 Priority)
+	{
+		USMStateMachineTestComponent* Component = NewObject<USMStateMachineTestComponent>(GetTransientPackage(), NAME_None, RF_ArchetypeObject | RF_Public);
+		Component->SetStateMachineClass(NewBP->GetGeneratedClass());
+		Component->TestContext = Context;
+		Component->InitializationPriority = Priority;
+		return Component;
+	};
+
+	USMStateMachineTestComponent* LowPriority = CreateComponent(0);
+	USMStateMachineTestComponent* HighPriority = CreateComponent(10);
+	USMStateMachineTestComponent* Cancelled = CreateComponent(5);
+
+	LowPriority->InitializeDeferred(true);
+	HighPriority->InitializeDeferred();
+	Cancelled->InitializeDeferred(true);
+
+	TestEqual("Components queued", Queue.Num(), StartingQueueSize + 3);
+	TestTrue("Initialization pending", HighPriority->IsInitializationPending());
+	TestNull("Instance not created yet", HighPriority->GetInstance());
+
+	// Calls while pending are safe and applied after initializing.
+	HighPriority->Update(1.f);
+	HighPriority->Start();
+	Cancelled->Shutdown();
+	TestFalse("Shutdown removed from queue", Queue.Contains(Cancelled));
+	TestEqual("One removed", Queue.Num(), StartingQueueSize + 2);
+
+	// A zero budget processes exactly one component.
+	TestEqual("One processed", Queue.ProcessQueue(0.0), 1);
+	TestFalse("Higher priority initialized first", HighPriority->IsInitializationPending());
+	TestTrue("Lower priority still pending", LowPriority->IsInitializationPending());
+	if (TestNotNull("Instance created", HighPriority->GetInstance()))
+	{
+		TestTrue("Initialized", HighPriority->GetInstance()->IsInitialized());
+		TestTrue("Start called while pending was applied", HighPriority->GetInstance()->IsActive());
+	}
+
+	Queue.Flush();
+	TestFalse("Flushed", LowPriority->IsInitializationPending());
+	if (TestNotNull("Instance created", LowPriority->GetInstance()))
+	{
+		TestTrue("Started when initialized", LowPriority->GetInstance()->IsActive());
+	}
+	TestNull("Cancelled never initialized", Cancelled->GetInstance());
+
+	// Explicit initialization takes over from the queue.
+	USMStateMachineTestComponent* Explicit = CreateComponent(0);
+	Explicit->InitializeDeferred();
+	Explicit->Initialize(Context);
+	TestFalse("Explicit initialize removed from queue", Queue.Contains(Explicit));
+	TestNotNull("Explicitly initialized", Explicit->GetInstance());
+
+	HighPriority->Shutdown();
+	LowPriority->Shutdown();
+	Explicit->Shutdown();
+
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * Verify a component preload which completes immediately assigns the requested class.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FComponentPreloadTest, "SMTests.ComponentPreload", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FComponentPreloadTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 2, &LastStatePin);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMTestContext* Context = NewObject<USMTestContext>();
+	USMStateMachineTestComponent* Component = NewObject<USMStateMachineTestComponent>(GetTransientPackage(), NAME_None, RF_ArchetypeObject | RF_Public);
+	Component->TestContext = Context;
+
+	// An unset class completes before the request is returned.
+	Component->PreloadStateMachineClass(TSoftClassPtr<USMInstance>());
+	TestFalse("Null class preload complete", Component->IsPreloadingStateMachineClass());
+	TestNull("Null class not assigned", Component->StateMachineClass.Get());
+
+	// A resident class may complete immediately or on a later frame, but never applies a previous request.
+	UClass* LoadedClass = NewBP->GetGeneratedClass();
+	Component->PreloadStateMachineClass(TSoftClassPtr<USMInstance>(LoadedClass));
+	if (Component->IsPreloadingStateMachineClass())
+	{
+		Component->Initialize(Context);
+		TestNull("Initialize deferred while preloading", Component->GetInstance());
+	}
+	else
+	{
+		TestEqual("Loaded class assigned", Component->StateMachineClass.Get(), LoadedClass);
+	}
+
+	// Preloading a null class after a loaded one leaves the loaded class in place.
+	Component->SetStateMachineClass(LoadedClass);
+	Component->PreloadStateMachineClass(TSoftClassPtr<USMInstance>());
+	TestFalse("Replacement preload complete", Component->IsPreloadingStateMachineClass());
+	TestEqual("Previous request not applied", Component->StateMachineClass.Get(), LoadedClass);
+
+	Component->Shutdown();
+
+	return NewAsset.DeleteAsset(this);
+}
+
 #endif
 
 #endif //WITH_DEV_AUTOMATION_TESTS
\ No newline at end of file
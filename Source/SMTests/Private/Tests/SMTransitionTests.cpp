@@ -22,6 +22,8 @@
 #include "Graph/Nodes/RootNodes/SMGraphK2Node_TransitionEnteredNode.h"
 #include "Graph/Nodes/Helpers/SMGraphK2Node_FunctionNodes.h"
 
+#include "Async/ParallelFor.h"
+
 
 #if WITH_DEV_AUTOMATION_TESTS
 
@@ -789,6 +791,70 @@ bool FTransitionSettingsTest::RunTest(const FString& Parameters)
 	return true;
 }
 
+/**
+ * Post events from multiple threads and check transitions only evaluate when a matching event is drained.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTransitionPostedEventsTest, "SMTests.TransitionPostedEvents", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FTransitionPostedEventsTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 2, &LastStatePin);
+
+	USMGraphNode_TransitionEdge* TransitionEdge =
+		CastChecked<USMGraphNode_TransitionEdge>(Cast<USMGraphNode_StateNode>(LastStatePin->GetOwningNode())->GetInputPin()->LinkedTo[0]->GetOwningNode());
+	TestHelpers::SetNodeClass(this, TransitionEdge, USMTransitionEventTestInstance::StaticClass());
+
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMTestContext* Context = NewObject<USMTestContext>();
+	USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+	Instance->Start();
+
+	USMTransitionEventTestInstance* TransitionInstance = CastChecked<USMTransitionEventTestInstance>(
+		CastChecked<USMStateInstance_Base>(Instance->GetSingleActiveState()->GetNodeInstance())->GetTransitionByIndex(0));
+
+	const int32 NumEvents = 32;
+
+	Instance->Update(1.f);
+	TestEqual("Transition not evaluated without events", TransitionInstance->TimesEvaluated, 0);
+
+	ParallelFor(NumEvents, [Instance](int32 Index)
+	{
+		Instance->PostEvent("OtherEvent");
+	});
+
+	Instance->Update(1.f);
+	TestEqual("Transition not evaluated for unrelated events", TransitionInstance->TimesEvaluated, 0);
+	TestEqual("Events cleared after update", Instance->GetCurrentEvents().Num(), 0);
+	TestFalse("State machine not finished", Instance->IsInEndState());
+
+	ParallelFor(NumEvents, [Instance, Context](int32 Index)
+	{
+		Instance->PostEvent(Index % 2 == 0 ? USMTransitionEventTestInstance::TriggerEventName : FName("OtherEvent"), Context);
+	});
+
+	Instance->Update(1.f);
+	TestEqual("Transition evaluated once for all matching events", TransitionInstance->TimesEvaluated, 1);
+	TestEqual("Payload read from event", TransitionInstance->TriggeringPayload, Cast<UObject>(Context));
+	TestEqual("Events cleared after update", Instance->GetCurrentEvents().Num(), 0);
+	TestTrue("State machine finished", Instance->IsInEndState());
+
+	Instance->Shutdown();
+
+	return NewAsset.DeleteAsset(this);
+}
+
 #endif
 
 #endif //WITH_DEV_AUTOMATION_TESTS
\ No newline at end of file
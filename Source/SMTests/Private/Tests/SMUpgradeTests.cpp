@@ -8,6 +8,8 @@
 #include "SMTestContext.h"
 #include "Graph/SMConduitGraph.h"
 #include "Kismet2/KismetEditorUtilities.h"
+#include "AssetRegistryModule.h"
+#include "Misc/PackageName.h"
 #include "Graph/SMGraph.h"
 #include "Graph/SMStateGraph.h"
 #include "Graph/SMIntermediateGraph.h"
@@ -1251,6 +1253,76 @@ bool FSMPinConversionTest::RunTest(const FString& Parameters)
 	return NewAsset.DeleteAsset(this);
 }
 
+
+/**
+ * Find out of date assets and update them as they load instead of on startup.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FUpdateBlueprintVersionOnLoadTest, "SMTests.UpdateBlueprintVersionOnLoad", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FUpdateBlueprintVersionOnLoadTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewSMAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewSMAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewSMAsset.GetObjectAs<USMBlueprint>();
+
+	FAssetHandler NewNodeAsset;
+	TestHelpers::TryCreateNewNodeAsset(this, NewNodeAsset, USMStateInstance::StaticClass(), false);
+	USMNodeBlueprint* NewNodeBP = NewNodeAsset.GetObjectAs<USMNodeBlueprint>();
+
+	// The state machine uses the node blueprint so loading it updates the node blueprint first.
+	{
+		USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+		UEdGraphPin* LastStatePin = nullptr;
+		TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &LastStatePin, NewNodeBP->GeneratedClass);
+		FKismetEditorUtilities::CompileBlueprint(NewBP);
+	}
+
+	NewBP->AssetVersion = 0;
+	NewSMAsset.SaveAsset(this);
+
+	NewNodeBP->AssetVersion = 0;
+	NewNodeAsset.SaveAsset(this);
+
+	const FName PackagePath = *FPackageName::GetLongPackagePath(NewBP->GetOutermost()->GetName());
+
+	TArray<FAssetData> AssetsToUpdate;
+	bool bHasNewerAssets = false;
+	FSMVersionUtils::FindAssetsToUpdate(AssetsToUpdate, bHasNewerAssets, PackagePath);
+
+	const int32 SMIndex = AssetsToUpdate.IndexOfByPredicate([&](const FAssetData& Asset) { return Asset.GetAsset() == NewBP; });
+	const int32 NodeIndex = AssetsToUpdate.IndexOfByPredicate([&](const FAssetData& Asset) { return Asset.GetAsset() == NewNodeBP; });
+	TestNotEqual("SM asset found for update", SMIndex, INDEX_NONE);
+	TestNotEqual("Node asset found for update", NodeIndex, INDEX_NONE);
+	TestTrue("Node asset updates before SM asset", NodeIndex < SMIndex);
+	TestFalse("No newer assets", bHasNewerAssets);
+
+	FSMVersionUtils::UpdateLoadedAssetToNewVersion(NewBP);
+	TestTrue("SM Asset dirty after update", NewBP->GetOutermost()->IsDirty());
+	TestTrue("SM Asset up to date", FSMVersionUtils::IsAssetUpToDate(NewBP));
+	TestTrue("Node Asset used by the SM up to date", FSMVersionUtils::IsAssetUpToDate(NewNodeBP));
+
+	FSMVersionUtils::UpdateLoadedAssetToNewVersion(NewNodeBP);
+	TestTrue("Node Asset still up to date", FSMVersionUtils::IsAssetUpToDate(NewNodeBP));
+
+	TestFalse("Up to date asset not updated again", FSMVersionUtils::UpdateBlueprintToNewVersion(NewBP));
+
+	NewSMAsset.SaveAsset(this);
+	NewNodeAsset.SaveAsset(this);
+
+	AssetsToUpdate.Reset();
+	FSMVersionUtils::FindAssetsToUpdate(AssetsToUpdate, bHasNewerAssets, PackagePath);
+	TestFalse("Saved SM asset no longer needs an update", AssetsToUpdate.ContainsByPredicate([&](const FAssetData& Asset) { return Asset.GetAsset() == NewBP; }));
+	TestFalse("Saved node asset no longer needs an update", AssetsToUpdate.ContainsByPredicate([&](const FAssetData& Asset) { return Asset.GetAsset() == NewNodeBP; }));
+
+	NewNodeAsset.DeleteAsset(this);
+	return NewSMAsset.DeleteAsset(this);
+}
+
 #endif
 
 #endif //WITH_DEV_AUTOMATION_TESTS
\ No newline at end of file
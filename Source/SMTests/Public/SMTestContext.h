@@ -6,6 +6,9 @@
 #include "SMStateInstance.h"
 #include "SMConduitInstance.h"
 #include "SMStateMachineComponent.h"
+#include "SMInstance.h"
+#include "SMState.h"
+#include "SMTransition.h"
 #include "Properties/SMTextGraphProperty.h"
 #include "SMTestContext.generated.h"
 
@@ -415,6 +418,24 @@ protected:
 	virtual bool CanEnterTransition_Implementation() const override { return bCanTransition; }
 };
 
+UCLASS(Blueprintable)
+class USMTransitionEventTestInstance : public USMTransitionInstance
+{
+public:
+	GENERATED_BODY()
+
+	USMTransitionEventTestInstance();
+
+	static const FName TriggerEventName;
+
+	/** Payload of the event which allowed evaluation. */
+	mutable UObject* TriggeringPayload = nullptr;
+
+	mutable int32 TimesEvaluated = 0;
+protected:
+	virtual bool CanEnterTransition_Implementation() const override;
+};
+
 UCLASS(Blueprintable)
 class USMTextGraphState : public USMStateInstance
 {
@@ -470,4 +491,46 @@ public:
 	void SetTickInterval(bool bAllowOverride, float TickInterval);
 
 	void ImportDeprecatedProperties_Public();
-};
\ No newline at end of file
+
+	virtual UObject* GetContextForInitialization_Implementation() const override;
+
+	/** Used as the initialization context since test components have no owner. */
+	UPROPERTY()
+	UObject* TestContext;
+};
+/**
+ * A native state machine written the way the native code generator writes one: a root state machine with two states and a
+ * transition whose result runs on the blueprint VM. MatchBlueprintNodes gives it the nodes of a blueprint reparented to it,
+ * as if it had been generated from that blueprint.
+ */
+UCLASS()
+class USMTestNativeStateMachine : public USMInstance
+{
+	GENERATED_BODY()
+
+public:
+	USMTestNativeStateMachine();
+
+	/** Copy the node values of blueprint class defaults to the native nodes of these defaults, keeping the native function handlers. */
+	void MatchBlueprintNodes(const USMInstance* BlueprintDefaults);
+
+	/** Times the native transition ran its result. */
+	UPROPERTY()
+	int32 NumNativeEvaluations;
+
+private:
+	UFUNCTION()
+	void Evaluate_Transition();
+
+	UPROPERTY()
+	FSMStateMachine Root;
+
+	UPROPERTY()
+	FSMState FirstState;
+
+	UPROPERTY()
+	FSMState SecondState;
+
+	UPROPERTY()
+	FSMTransition Transition;
+};